@@ -4,8 +4,30 @@ export 'package:nsd_platform_interface/nsd_platform_interface.dart'
     show Service;
 export 'package:nsd_platform_interface/nsd_platform_interface.dart'
     show Discovery;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show ServiceTypeEnumeration;
 export 'package:nsd_platform_interface/nsd_platform_interface.dart'
     show Registration;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show Resolution;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show RawTxt;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show RegistrationResult;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show DiscoverySnapshot;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show DiscoveryChanges;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show NsdMetrics;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show OperationMetrics;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show CallbackMetrics;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show LatencySummary;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show ResolveCacheMetrics;
 export 'package:nsd_platform_interface/nsd_platform_interface.dart'
     show ErrorCause;
 export 'package:nsd_platform_interface/nsd_platform_interface.dart'
@@ -14,6 +36,12 @@ export 'package:nsd_platform_interface/nsd_platform_interface.dart'
     show LogTopic;
 export 'package:nsd_platform_interface/nsd_platform_interface.dart'
     show IpLookupType;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show MdnsBackend;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show EventTransport;
+export 'package:nsd_platform_interface/nsd_platform_interface.dart'
+    show InterfaceSelection;
 export 'package:nsd_platform_interface/nsd_platform_interface.dart'
     show ServiceStatus;
 export 'package:nsd_platform_interface/nsd_platform_interface.dart'
@@ -25,11 +53,37 @@ export 'package:nsd_platform_interface/nsd_platform_interface.dart'
 /// connecting to them, but in many use cases the service host will be
 /// cruicial to decide on a service. For this reason, [autoResolve] is on by
 /// default and discovered services will be fully resolved.
+///
+/// On busy networks, found and lost events can be delivered in batches by
+/// setting [batchInterval] and / or [batchSize]: the native side then
+/// collects changes for the given interval or until the given number of
+/// changes has accumulated, and sends them in a single message. This is
+/// currently supported on Windows; other platforms ignore these parameters
+/// and deliver each change individually.
+///
+/// Several service types can be browsed under a single discovery by passing
+/// [additionalServiceTypes]. The discovered services of all types are
+/// collected in the same [Discovery], and each one carries its type. This is
+/// currently supported on Windows only.
+///
+/// On multi-homed hosts, [interfaces] restricts the discovery to selected
+/// network interfaces or runs it on all of them in parallel. Services found on
+/// several interfaces are reported once, and [Service.interfaceIndex] tells
+/// where they were found. This is currently supported on Windows only.
 Future<Discovery> startDiscovery(String serviceType,
         {bool autoResolve = true,
-        IpLookupType ipLookupType = IpLookupType.none}) async =>
+        IpLookupType ipLookupType = IpLookupType.none,
+        Duration? batchInterval,
+        int? batchSize,
+        List<String> additionalServiceTypes = const [],
+        InterfaceSelection interfaces = InterfaceSelection.any}) async =>
     NsdPlatformInterface.instance.startDiscovery(serviceType,
-        autoResolve: autoResolve, ipLookupType: ipLookupType);
+        autoResolve: autoResolve,
+        ipLookupType: ipLookupType,
+        batchInterval: batchInterval,
+        batchSize: batchSize,
+        additionalServiceTypes: additionalServiceTypes,
+        interfaces: interfaces);
 
 /// Stops the specified discovery.
 ///
@@ -41,13 +95,66 @@ Future<void> stopDiscovery(Discovery discovery) {
   return NsdPlatformInterface.instance.stopDiscovery(discovery);
 }
 
+/// Returns the services of a running discovery with the version they are
+/// current as of; Windows only.
+///
+/// Lets a widget that attaches late, or a restarted isolate, rebuild its state
+/// without restarting the discovery. The native side is queried in pages of
+/// [pageSize] services.
+Future<DiscoverySnapshot> getServices(Discovery discovery,
+        {int pageSize = defaultPageSize}) =>
+    NsdPlatformInterface.instance.getServices(discovery, pageSize: pageSize);
+
+/// Returns what changed in a running discovery since [version], as returned
+/// by [getServices] or an earlier call; Windows only.
+///
+/// Lost services are remembered for a while only. Throws an [NsdError] with
+/// [ErrorCause.illegalArgument] if changes since [version] are no longer
+/// available, call [getServices] then.
+Future<DiscoveryChanges> getChangesSince(Discovery discovery, int version,
+        {int pageSize = defaultPageSize}) =>
+    NsdPlatformInterface.instance
+        .getChangesSince(discovery, version, pageSize: pageSize);
+
+/// Starts an enumeration of the service types on the network.
+///
+/// Each type, e.g. "_http._tcp", is reported once in the returned
+/// [ServiceTypeEnumeration]. On Windows, each type comes with the number of
+/// its instances, which is kept up to date while the enumeration is running;
+/// other platforms report 0.
+Future<ServiceTypeEnumeration> startServiceTypeEnumeration() async =>
+    NsdPlatformInterface.instance.startServiceTypeEnumeration();
+
+/// Stops the specified service type enumeration.
+Future<void> stopServiceTypeEnumeration(ServiceTypeEnumeration enumeration) =>
+    NsdPlatformInterface.instance.stopServiceTypeEnumeration(enumeration);
+
 /// Resolves a service.
 ///
 /// Unlike registration, resolving is usually quite fast.
 ///
 /// This method always returns a fresh [Service] instance.
-Future<Service> resolve(Service service) async =>
-    NsdPlatformInterface.instance.resolve(service);
+///
+/// If [ipLookupType] is set, the returned service contains the IP addresses
+/// of the service host. Windows returns them natively, other platforms look
+/// them up after resolving.
+///
+/// On Windows, resolves that take longer than [timeout] fail with
+/// [ErrorCause.timeout]; a default timeout applies if none is given.
+///
+/// The returned [Resolution] completes with the resolved service and can be
+/// passed to [cancelResolve].
+Resolution resolve(Service service,
+        {IpLookupType ipLookupType = IpLookupType.none, Duration? timeout}) =>
+    NsdPlatformInterface.instance
+        .resolve(service, ipLookupType: ipLookupType, timeout: timeout);
+
+/// Cancels the specified resolve.
+///
+/// It fails with [ErrorCause.cancelled], other resolves of the same service
+/// carry on. Resolves that have completed already are not affected.
+Future<void> cancelResolve(Resolution resolution) =>
+    NsdPlatformInterface.instance.cancelResolve(resolution);
 
 /// Registers a service.
 ///
@@ -69,6 +176,74 @@ Future<Registration> register(Service service) async =>
 Future<void> unregister(Registration registration) async =>
     NsdPlatformInterface.instance.unregister(registration);
 
+/// Registers a list of services.
+///
+/// A limited number of registrations run at a time. The returned results are
+/// in the order of [services]; a service that fails doesn't affect the
+/// others. On Windows, the whole list is handed over to the native side in
+/// one call.
+Future<List<RegistrationResult>> registerMany(List<Service> services) =>
+    NsdPlatformInterface.instance.registerMany(services);
+
+/// Unregisters a list of services.
+///
+/// Works like [registerMany]: the returned results are in the order of
+/// [registrations], each with an error if unregistering it failed.
+Future<List<RegistrationResult>> unregisterMany(
+        List<Registration> registrations) =>
+    NsdPlatformInterface.instance.unregisterMany(registrations);
+
+/// Selects the mDNS implementation for discoveries, resolves and
+/// registrations started from now on.
+///
+/// On Windows, the plugin falls back to its built-in querier and responder on
+/// versions older than Windows 10, build 18362, which lack the DNS-SD API.
+/// The built-in responder suits hosts that register many services; it doesn't
+/// probe for name conflicts, so service names must be unique.
+Future<void> setMdnsBackend(MdnsBackend backend) =>
+    NsdPlatformInterface.instance.setMdnsBackend(backend);
+
+/// Selects how events reach the app.
+///
+/// With [EventTransport.nativePort] (Windows only), the plugin posts
+/// discovery, resolve and registration events directly to a Dart port over
+/// FFI instead of sending them over the platform channel, which skips the
+/// channel's message encoding and dispatch for every event. Events are still
+/// sent from the platform thread, in the same order as over the channel, and
+/// handled in the UI isolate. Switching back to
+/// [EventTransport.methodChannel] is always possible.
+Future<void> setEventTransport(EventTransport transport) =>
+    NsdPlatformInterface.instance.setEventTransport(transport);
+
+/// Returns counters and latency percentiles the plugin keeps natively, for
+/// the whole plugin or for a single [discovery]; Windows only.
+///
+/// Latencies cover how long it takes a discovery to report its first service,
+/// and how long resolves, registrations and unregistrations take; callbacks
+/// are counted by native status code, resolves answered from the cache as
+/// hits and misses. With [reset], what has been returned is cleared, for the
+/// plugin and for a discovery separately.
+Future<NsdMetrics> getMetrics({Discovery? discovery, bool reset = false}) =>
+    NsdPlatformInterface.instance
+        .getMetrics(discovery: discovery, reset: reset);
+
+/// Starts recording a native trace of method calls, DNS API calls, callbacks
+/// and events sent to Dart, or stops recording; Windows only.
+///
+/// Starting discards what has been recorded. At most [capacity] events are
+/// kept, older ones are overwritten. Recording is cheap, but not free, so it
+/// is off by default.
+Future<void> setTracing(bool enabled, {int? capacity}) =>
+    NsdPlatformInterface.instance.setTracing(enabled, capacity: capacity);
+
+/// Returns the recorded trace as Chrome trace event JSON; Windows only.
+///
+/// Open it with chrome://tracing or https://ui.perfetto.dev to see where time
+/// goes, e.g. between starting a discovery and its first service. With
+/// [clear], the returned events are discarded.
+Future<String> dumpTrace({bool clear = false}) =>
+    NsdPlatformInterface.instance.dumpTrace(clear: clear);
+
 /// Enables logging for the specified topic.
 ///
 void enableLogging(LogTopic logTopic) =>
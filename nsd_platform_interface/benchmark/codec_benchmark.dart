@@ -0,0 +1,68 @@
+// Decoding cost of a discovered service, as event record (Windows) and as map
+// (other platforms), from the message bytes to the Service object.
+//
+// Run with: flutter test benchmark/codec_benchmark.dart
+
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:nsd_platform_interface/src/codec.dart';
+import 'package:nsd_platform_interface/src/serialization.dart';
+
+const iterations = 100000;
+
+void main() {
+  test('Decode discovered service', () {
+    const codec = NsdMessageCodec();
+
+    final record = _readGoldenEventRecord('discovered');
+    final map = const StandardMessageCodec().encodeMessage({
+      'handle': 'h1',
+      'service.name': 'Printer',
+      'service.type': '_ipp._tcp',
+      'service.host': 'printer.local',
+      'service.port': 631,
+      'service.txt.raw': Uint8List.fromList([5, ...'rp=ip'.codeUnits]),
+      'service.addresses': ['192.168.1.23', 'fe80::1'],
+      'service.interfaceIndex': 3,
+      'service.resolved': true,
+    })!;
+
+    _report('record', record.lengthInBytes,
+        () => deserializeService(codec.decodeMessage(record)));
+    _report('map', map.lengthInBytes,
+        () => deserializeService(codec.decodeMessage(map)));
+  });
+}
+
+ByteData _readGoldenEventRecord(String name) {
+  final line = File('test/golden/event_records.txt')
+      .readAsLinesSync()
+      .firstWhere((line) => line.startsWith('$name:'));
+  return Uint8List.fromList(line
+          .substring(name.length + 1)
+          .trim()
+          .split(' ')
+          .map((byte) => int.parse(byte, radix: 16))
+          .toList())
+      .buffer
+      .asByteData();
+}
+
+void _report(String name, int bytes, Object? Function() decode) {
+  for (var i = 0; i < iterations ~/ 10; i++) {
+    decode(); // warm up
+  }
+
+  final stopwatch = Stopwatch()..start();
+  for (var i = 0; i < iterations; i++) {
+    decode();
+  }
+  stopwatch.stop();
+
+  final nsPerEvent = stopwatch.elapsedMicroseconds * 1000 / iterations;
+  // ignore: avoid_print
+  print('$name: ${nsPerEvent.toStringAsFixed(0)} ns/event, $bytes bytes/event');
+}
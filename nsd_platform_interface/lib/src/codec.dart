@@ -0,0 +1,141 @@
+import 'dart:io';
+import 'dart:typed_data';
+
+import 'package:flutter/foundation.dart' show ReadBuffer;
+import 'package:flutter/services.dart';
+
+import 'nsd_platform_interface.dart';
+import 'utilities.dart';
+
+/// Keys of the event records sent by the Windows plugin, indexed by tag; must
+/// match the order of `EventKey` in nsd_codec.h.
+const eventRecordKeys = [
+  'handle',
+  'service.name',
+  'service.type',
+  'service.host',
+  'service.port',
+  'service.txt.raw',
+  'service.addresses',
+  'service.interfaceIndex',
+  'service.resolved',
+  'service.status',
+  'service.changes',
+  'service.types',
+  'error.cause',
+  'error.message',
+  'results',
+  'event',
+];
+
+/// Arguments of a message from the Windows plugin, decoded straight into the
+/// objects the handlers need instead of a map with string keys.
+///
+/// The deserialize functions in serialization.dart accept records as well as
+/// maps, so handlers work the same on all platforms.
+class EventRecord {
+  final String? handle;
+  final Service? service;
+  final bool resolved;
+  final ServiceStatus? status;
+  final List<EventRecord>? changes;
+  final Map<String, int?>? serviceTypes;
+  final NsdError? error;
+  final List<EventRecord>? results;
+  final String? event; // method name, on a discovery's event channel
+
+  const EventRecord(
+      {this.handle,
+      this.service,
+      this.resolved = false,
+      this.status,
+      this.changes,
+      this.serviceTypes,
+      this.error,
+      this.results,
+      this.event});
+
+  /// Creates a record from its values, indexed by tag (see [eventRecordKeys]);
+  /// null for keys that aren't present.
+  factory EventRecord.fromValues(List<dynamic> values) {
+    final cause = values[12] as String?;
+    final message = values[13] as String?;
+    final status = values[9] as String?;
+
+    return EventRecord(
+      handle: values[0] as String?,
+      service: _createService(values),
+      resolved: values[8] == true,
+      status: status != null
+          ? enumValueFromString(ServiceStatus.values, status)
+          : null,
+      changes: (values[10] as List<Object?>?)?.cast<EventRecord>(),
+      serviceTypes: values[11] != null
+          ? Map<String, int?>.from(values[11] as Map<Object?, Object?>)
+          : null,
+      error: cause != null && message != null
+          ? NsdError(enumValueFromString(ErrorCause.values, cause)!, message)
+          : null,
+      results: (values[14] as List<Object?>?)?.cast<EventRecord>(),
+      event: values[15] as String?,
+    );
+  }
+
+  // tags 1 to 7 are the service fields
+  static Service? _createService(List<dynamic> values) {
+    if (values.getRange(1, 8).every((value) => value == null)) {
+      return null;
+    }
+
+    final txt = values[5] as Uint8List?;
+    final addresses = values[6] as List<Object?>?;
+
+    return Service(
+        name: values[1] as String?,
+        type: values[2] as String?,
+        host: values[3] as String?,
+        port: values[4] as int?,
+        txt: txt != null ? RawTxt(txt) : null,
+        addresses: addresses
+            ?.map((address) => InternetAddress(address as String))
+            .toList(),
+        interfaceIndex: values[7] as int?);
+  }
+
+  @override
+  String toString() =>
+      'EventRecord (handle: $handle, service: $service, resolved: $resolved, '
+      'status: $status, changes: $changes, serviceTypes: $serviceTypes, '
+      'error: $error, results: $results, event: $event)';
+}
+
+/// Standard codec that also decodes event records: instead of a map with
+/// string keys, the native side sends a bit set of the keys that are present
+/// (16 bit, little endian), followed by their values in tag order.
+///
+/// Messages to the native side are plain standard codec.
+class NsdMessageCodec extends StandardMessageCodec {
+  static const eventRecordType = 128;
+
+  const NsdMessageCodec();
+
+  @override
+  dynamic readValueOfType(int type, ReadBuffer buffer) {
+    if (type != eventRecordType) {
+      return super.readValueOfType(type, buffer);
+    }
+
+    final keys = buffer.getUint8() | (buffer.getUint8() << 8);
+    if (keys >> eventRecordKeys.length != 0) {
+      throw FormatException('Unknown event record keys: $keys');
+    }
+
+    final values = List<dynamic>.filled(eventRecordKeys.length, null);
+    for (var tag = 0; tag < eventRecordKeys.length; tag++) {
+      if (keys & (1 << tag) != 0) {
+        values[tag] = readValue(buffer);
+      }
+    }
+    return EventRecord.fromValues(values);
+  }
+}
@@ -0,0 +1,94 @@
+import 'dart:ffi';
+import 'dart:isolate';
+
+import 'package:flutter/services.dart';
+
+import 'codec.dart';
+
+// container tags of messages posted by the Windows plugin, see event_port.h
+const _listTag = 0;
+const _mapTag = 1;
+const _recordTag = 2;
+
+const _libraryName = 'nsd_windows_plugin.dll';
+
+typedef _InitializeDartApiNative = IntPtr Function(Pointer<Void>);
+typedef _InitializeDartApi = int Function(Pointer<Void>);
+
+/// Receives events that the native side posts with `Dart_PostCObject`
+/// instead of invoking methods on the channel.
+///
+/// Messages skip the platform channel and the codec; large byte arrays (TXT
+/// blobs) arrive as external typed data without being copied. The plugin
+/// still posts from the platform thread, once it has updated its state, and
+/// the events are handled in the isolate that opened the port.
+class NativeEventPort {
+  NativeEventPort._(this._receivePort);
+
+  final ReceivePort _receivePort;
+
+  /// The port to hand over to the native side.
+  int get nativePort => _receivePort.sendPort.nativePort;
+
+  /// Opens a port that passes each event to [onEvent], or returns null if the
+  /// native library can't post to ports.
+  static NativeEventPort? open(void Function(MethodCall) onEvent) {
+    try {
+      final library = DynamicLibrary.open(_libraryName);
+      final initializeDartApi =
+          library.lookupFunction<_InitializeDartApiNative, _InitializeDartApi>(
+              'NsdWindowsPluginCApiInitializeDartApi');
+
+      if (initializeDartApi(NativeApi.initializeApiDLData) != 0) {
+        return null;
+      }
+    } on ArgumentError {
+      return null; // library or function missing
+    }
+
+    final receivePort = ReceivePort('com.haberey/nsd events');
+    receivePort.listen((message) => onEvent(decodePortEvent(message)));
+    return NativeEventPort._(receivePort);
+  }
+}
+
+/// Decodes a message posted to a [NativeEventPort] into the method call the
+/// method channel would have delivered, with the same [EventRecord]
+/// arguments.
+MethodCall decodePortEvent(dynamic message) {
+  final elements = message as List<dynamic>;
+  return MethodCall(elements[0] as String, _decodePortValue(elements[1]));
+}
+
+dynamic _decodePortValue(dynamic value) {
+  if (value is! List) {
+    return value; // null, bool, int, double, String or Uint8List
+  }
+
+  switch (value[0] as int) {
+    case _listTag:
+      return [for (final element in value.skip(1)) _decodePortValue(element)];
+    case _mapTag:
+      return {
+        for (var i = 1; i < value.length; i += 2)
+          _decodePortValue(value[i]): _decodePortValue(value[i + 1])
+      };
+    case _recordTag:
+      final keys = value[1] as int;
+      if (keys >> eventRecordKeys.length != 0) {
+        throw FormatException('Unknown event record keys: $keys');
+      }
+
+      final values = List<dynamic>.filled(eventRecordKeys.length, null);
+      var next = 2;
+
+      for (var tag = 0; tag < eventRecordKeys.length; tag++) {
+        if (keys & (1 << tag) != 0) {
+          values[tag] = _decodePortValue(value[next++]);
+        }
+      }
+      return EventRecord.fromValues(values);
+    default:
+      throw ArgumentError.value(value[0], 'tag', 'Unknown container tag');
+  }
+}
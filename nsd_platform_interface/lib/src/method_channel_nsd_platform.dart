@@ -1,10 +1,13 @@
 import 'dart:async';
 import 'dart:io';
+import 'dart:math';
 
 import 'package:flutter/services.dart';
 import 'package:nsd_platform_interface/src/utilities.dart';
 import 'package:uuid/uuid.dart';
 
+import 'codec.dart';
+import 'event_port.dart';
 import 'logging.dart';
 import 'nsd_platform_interface.dart';
 import 'serialization.dart';
@@ -13,6 +16,17 @@ typedef _Handler = void Function(dynamic);
 
 const _uuid = Uuid();
 
+// special type for enumeration of services, see https://datatracker.ietf.org/doc/html/rfc6763#section-9
+const _serviceEnumerationType = '_services._dns-sd._udp';
+
+// event channel of a discovery is this plus its handle (Windows)
+const _discoveryChannelPrefix = 'com.haberey/nsd/discovery/';
+
+const _codec = StandardMethodCodec(NsdMessageCodec());
+
+// registrations in flight when native code can't register lists of services
+const _maxRunningRegistrations = 16;
+
 const _ipLookupTypeToInternetAddressType = {
   IpLookupType.none: null,
   IpLookupType.v4: InternetAddressType.IPv4,
@@ -22,10 +36,49 @@ const _ipLookupTypeToInternetAddressType = {
 
 /// Implementation of [NsdPlatformInterface] that uses a method channel to communicate with native side.
 class MethodChannelNsdPlatform extends NsdPlatformInterface {
-  final _methodChannel = const MethodChannel('com.haberey/nsd');
+  final _methodChannel = const MethodChannel('com.haberey/nsd', _codec);
   final _handlers = <String, Map<String, _Handler>>{};
+  final _discoveryStreams = <String, StreamSubscription<dynamic>>{};
+  final _pendingResolves = <String, Completer<Service>>{};
 
   var _disableServiceTypeValidation = false;
+  NativeEventPort? _eventPort; // kept open once created, see setEventTransport
+
+  /// True if the native side can browse several service types under one
+  /// handle; can be overridden for testing.
+  bool supportsMultipleServiceTypes = Platform.isWindows;
+
+  /// True if the native side can browse on selected network interfaces; can
+  /// be overridden for testing.
+  bool supportsInterfaceSelection = Platform.isWindows;
+
+  /// True if the native side has a built-in mDNS querier; can be overridden
+  /// for testing.
+  bool supportsMdnsBackendSelection = Platform.isWindows;
+
+  /// True if the native side registers lists of services in one call; can be
+  /// overridden for testing.
+  bool supportsBulkRegistration = Platform.isWindows;
+
+  /// True if the native side delivers the events of each discovery on an event
+  /// channel of its own; can be overridden for testing.
+  bool supportsDiscoveryStreams = Platform.isWindows;
+
+  /// True if the native side keeps a versioned journal of each discovery's
+  /// services; can be overridden for testing.
+  bool supportsDiscoveryJournal = Platform.isWindows;
+
+  /// True if the native side keeps latency histograms and counters; can be
+  /// overridden for testing.
+  bool supportsMetrics = Platform.isWindows;
+
+  /// True if the native side can record a trace; can be overridden for
+  /// testing.
+  bool supportsTracing = Platform.isWindows;
+
+  /// True if the native side can post events to a native port; can be
+  /// overridden for testing.
+  bool supportsNativeEventPort = Platform.isWindows;
 
   MethodChannelNsdPlatform() {
     _methodChannel.setMethodCallHandler(handleMethodCall);
@@ -34,8 +87,23 @@ class MethodChannelNsdPlatform extends NsdPlatformInterface {
   @override
   Future<Discovery> startDiscovery(String serviceType,
       {bool autoResolve = true,
-      IpLookupType ipLookupType = IpLookupType.none}) async {
+      IpLookupType ipLookupType = IpLookupType.none,
+      Duration? batchInterval,
+      int? batchSize,
+      List<String> additionalServiceTypes = const [],
+      InterfaceSelection interfaces = InterfaceSelection.any}) async {
     assertValidServiceType(serviceType);
+    additionalServiceTypes.forEach(assertValidServiceType);
+
+    if (additionalServiceTypes.isNotEmpty && !supportsMultipleServiceTypes) {
+      throw NsdError(ErrorCause.operationNotSupported,
+          'Multiple service types are only supported on Windows');
+    }
+
+    if (!interfaces.isAny && !supportsInterfaceSelection) {
+      throw NsdError(ErrorCause.operationNotSupported,
+          'Interface selection is only supported on Windows');
+    }
 
     if (isIpLookupEnabled(ipLookupType) && autoResolve == false) {
       throw NsdError(ErrorCause.illegalArgument,
@@ -56,32 +124,129 @@ class MethodChannelNsdPlatform extends NsdPlatformInterface {
       completer.completeError(deserializeError(arguments)!);
     });
 
-    _setHandler(handle, 'onServiceDiscovered', (arguments) async {
+    Future<void> onServiceFound(dynamic arguments) async {
       var service = deserializeService(arguments)!;
       if (autoResolve) {
-        service = await resolve(service);
-
-        if (isIpLookupEnabled(ipLookupType) && service.addresses == null) {
+        // native code may have resolved the service already (Windows)
+        if (!deserializeServiceResolved(arguments)) {
+          service = await resolve(service, ipLookupType: ipLookupType);
+        } else if (isIpLookupEnabled(ipLookupType) &&
+            service.addresses == null) {
           service = await performIpLookup(service, ipLookupType);
         }
       }
       discovery.add(service);
-    });
+    }
+
+    _setHandler(handle, 'onServiceDiscovered', onServiceFound);
 
     _setHandler(handle, 'onServiceLost',
         (arguments) => discovery.remove(deserializeService(arguments)!));
 
-    return invoke('startDiscovery', {
+    // batched delivery: one message contains all changes of a batch window
+    _setHandler(handle, 'onServicesChanged', (arguments) async {
+      final changes = deserializeServiceChanges(arguments)!;
+      await Future.wait(changes.map((change) async {
+        if (deserializeServiceStatus(change) == ServiceStatus.found) {
+          await onServiceFound(change);
+        } else {
+          discovery.remove(deserializeService(change)!);
+        }
+      }));
+    });
+
+    return _invokeStartDiscovery(handle, {
       ...serializeHandle(handle),
-      ...serializeServiceType(serviceType)
+      ...serializeServiceType(serviceType),
+      if (additionalServiceTypes.isNotEmpty)
+        ...serializeServiceTypes([serviceType, ...additionalServiceTypes]),
+      ...serializeAutoResolve(autoResolve),
+      ...serializeIpLookupType(ipLookupType),
+      ...serializeInterfaces(interfaces),
+      ...serializeBatching(batchInterval, batchSize)
     }).then((value) => completer.future);
   }
 
   @override
-  Future<void> stopDiscovery(Discovery discovery) async {
+  Future<void> stopDiscovery(Discovery discovery) =>
+      _stopDiscovery(discovery.id);
+
+  @override
+  Future<ServiceTypeEnumeration> startServiceTypeEnumeration() async {
+    final handle = _uuid.v4();
+    final enumeration = ServiceTypeEnumeration(handle);
+
+    final completer = Completer<ServiceTypeEnumeration>();
+    _attachDummyCallback(completer.future);
+
+    _setHandler(handle, 'onDiscoveryStartSuccessful',
+        (arguments) => completer.complete(enumeration));
+
+    _setHandler(handle, 'onDiscoveryStartFailed', (arguments) {
+      discardHandlers(handle);
+      completer.completeError(deserializeError(arguments)!);
+    });
+
+    // native type enumeration (Windows): distinct types with instance counts
+    _setHandler(handle, 'onServiceTypesChanged', (arguments) {
+      enumeration.update(deserializeServiceTypeCounts(arguments)!);
+    });
+
+    // plain browse elsewhere: each record names a type, e.g. name "_http"
+    // and type "_tcp.local", instances aren't counted
+    _setHandler(handle, 'onServiceDiscovered', (arguments) {
+      final type = toEnumeratedServiceType(deserializeService(arguments)!);
+      if (type != null && !enumeration.serviceTypes.containsKey(type)) {
+        enumeration.update({type: 0});
+      }
+    });
+
+    _setHandler(handle, 'onServiceLost', (arguments) {
+      final type = toEnumeratedServiceType(deserializeService(arguments)!);
+      if (type != null) {
+        enumeration.update({type: null});
+      }
+    });
+
+    return _invokeStartDiscovery(handle, {
+      ...serializeHandle(handle),
+      ...serializeServiceType(_serviceEnumerationType),
+      ...serializeAutoResolve(false),
+      ...serializeEnumerateTypes(true),
+    }).then((value) => completer.future);
+  }
+
+  @override
+  Future<void> stopServiceTypeEnumeration(
+          ServiceTypeEnumeration enumeration) =>
+      _stopDiscovery(enumeration.id);
+
+  // with discovery streams, the handlers are looked up once and events go
+  // straight to them instead of through handleMethodCall
+  Future<void> _invokeStartDiscovery(
+      String handle, Map<String, dynamic> arguments) async {
+    if (!supportsDiscoveryStreams) {
+      await invoke('startDiscovery', arguments);
+      return;
+    }
+
+    await invoke(
+        'startDiscovery', {...arguments, ...serializeDiscoveryStream(true)});
+
+    final handlers = _handlers[handle]!;
+    _discoveryStreams[handle] =
+        EventChannel('$_discoveryChannelPrefix$handle', _codec)
+            .receiveBroadcastStream()
+            .listen((event) {
+      final method = deserializeEvent(event)!;
+      log(this, LogTopic.calls, () => 'Callback: $method $event');
+      handlers[method]?.call(event);
+    });
+  }
+
+  Future<void> _stopDiscovery(String handle) async {
     final completer = Completer<void>();
     _attachDummyCallback(completer.future);
-    final handle = discovery.id;
 
     _setHandler(handle, 'onDiscoveryStopSuccessful', (arguments) {
       discardHandlers(handle);
@@ -93,26 +258,55 @@ class MethodChannelNsdPlatform extends NsdPlatformInterface {
       completer.completeError(deserializeError(arguments)!);
     });
 
+    // cancelling the subscription stops the discovery natively, pending
+    // changes and the outcome are then reported through the method channel
+    final subscription = _discoveryStreams.remove(handle);
+    if (subscription != null) {
+      await subscription.cancel();
+      return completer.future;
+    }
+
     return invoke('stopDiscovery', {...serializeHandle(handle)})
         .then((value) => completer.future);
   }
 
   @override
-  Future<Service> resolve(Service service) async {
-    assertValidServiceType(service.type);
-
+  Resolution resolve(Service service,
+      {IpLookupType ipLookupType = IpLookupType.none, Duration? timeout}) {
     final handle = _uuid.v4();
+    return Resolution(
+        handle,
+        service,
+        _resolve(handle, service,
+            ipLookupType: ipLookupType, timeout: timeout));
+  }
+
+  Future<Service> _resolve(String handle, Service service,
+      {required IpLookupType ipLookupType, Duration? timeout}) async {
+    assertValidServiceType(service.type);
 
     final completer = Completer<Service>();
     _attachDummyCallback(completer.future);
 
+    _pendingResolves[handle] = completer;
+    unawaited(completer.future
+        .then<void>((value) => null)
+        .onError((error, stackTrace) => null)
+        .whenComplete(() => _pendingResolves.remove(handle)));
+
     _setHandler(handle, 'onResolveSuccessful', (arguments) {
       discardHandlers(handle);
       // merge received service info into requested service info b/c some
       // properties may have been updated, but the received service info isn't
       // always complete, e.g. NetService only returns the name
       final merged = merge(service, deserializeService(arguments)!);
-      completer.complete(merged);
+
+      // native code returns addresses on Windows, look them up elsewhere
+      if (isIpLookupEnabled(ipLookupType) && merged.addresses == null) {
+        completer.complete(performIpLookup(merged, ipLookupType));
+      } else {
+        completer.complete(merged);
+      }
     });
 
     _setHandler(handle, 'onResolveFailed', (arguments) {
@@ -123,9 +317,29 @@ class MethodChannelNsdPlatform extends NsdPlatformInterface {
     return invoke('resolve', {
       ...serializeHandle(handle),
       ...serializeService(service),
+      ...serializeIpLookupType(ipLookupType),
+      ...serializeResolveTimeout(timeout),
     }).then((value) => completer.future);
   }
 
+  @override
+  Future<void> cancelResolve(Resolution resolution) async {
+    final handle = resolution.id;
+
+    final completer = _pendingResolves.remove(handle);
+    if (completer == null) {
+      return; // completed already
+    }
+
+    discardHandlers(handle);
+    completer.completeError(
+        NsdError(ErrorCause.cancelled, 'Resolve was cancelled'));
+
+    // native code may not support cancelling, the result is discarded anyway
+    await invoke('cancelResolve', serializeHandle(handle))
+        .catchError((e) => null);
+  }
+
   @override
   Future<Registration> register(Service service) async {
     assertValidServiceType(service.type);
@@ -173,6 +387,94 @@ class MethodChannelNsdPlatform extends NsdPlatformInterface {
         .then((value) => completer.future);
   }
 
+  @override
+  Future<List<RegistrationResult>> registerMany(List<Service> services) async {
+    for (final service in services) {
+      assertValidServiceType(service.type);
+    }
+
+    if (!supportsBulkRegistration) {
+      return _mapBounded(
+          services,
+          (service) => register(service).then(
+              (registration) =>
+                  RegistrationResult(service, registration: registration),
+              onError: (e) =>
+                  RegistrationResult(service, error: _asNsdError(e))));
+    }
+
+    final handle = _uuid.v4();
+    final registrations = [
+      for (final service in services) (_uuid.v4(), service)
+    ];
+    final completer = Completer<List<RegistrationResult>>();
+    _attachDummyCallback(completer.future);
+
+    _setHandler(handle, 'onRegisterManyComplete', (arguments) {
+      discardHandlers(handle);
+      final results = deserializeRegistrationResults(arguments)!;
+
+      completer.complete([
+        for (final (index, (serviceHandle, service)) in registrations.indexed)
+          _toRegistrationResult(serviceHandle, service, results[index])
+      ]);
+    });
+
+    return invoke('registerMany', {
+      ...serializeHandle(handle),
+      ...serializeRegistrations(registrations),
+    }).then((value) => completer.future);
+  }
+
+  RegistrationResult _toRegistrationResult(
+      String handle, Service service, dynamic result) {
+    final error = deserializeError(result);
+    if (error != null) {
+      return RegistrationResult(service, error: error);
+    }
+
+    // see register()
+    final merged = merge(service, deserializeService(result)!);
+    return RegistrationResult(service,
+        registration: Registration(handle, merged));
+  }
+
+  @override
+  Future<List<RegistrationResult>> unregisterMany(
+      List<Registration> registrations) async {
+    if (!supportsBulkRegistration) {
+      return _mapBounded(
+          registrations,
+          (registration) => unregister(registration).then(
+              (value) => RegistrationResult(registration.service,
+                  registration: registration),
+              onError: (e) => RegistrationResult(registration.service,
+                  registration: registration, error: _asNsdError(e))));
+    }
+
+    final handle = _uuid.v4();
+    final completer = Completer<List<RegistrationResult>>();
+    _attachDummyCallback(completer.future);
+
+    _setHandler(handle, 'onUnregisterManyComplete', (arguments) {
+      discardHandlers(handle);
+      final results = deserializeRegistrationResults(arguments)!;
+
+      completer.complete([
+        for (final (index, registration) in registrations.indexed)
+          RegistrationResult(registration.service,
+              registration: registration,
+              error: deserializeError(results[index]))
+      ]);
+    });
+
+    return invoke('unregisterMany', {
+      ...serializeHandle(handle),
+      ...serializeHandles(
+          registrations.map((registration) => registration.id).toList()),
+    }).then((value) => completer.future);
+  }
+
   Future<dynamic> handleMethodCall(MethodCall methodCall) async {
     final method = methodCall.method;
     final arguments = methodCall.arguments;
@@ -196,10 +498,10 @@ class MethodChannelNsdPlatform extends NsdPlatformInterface {
     return _handlers[handle]?[method];
   }
 
-  Future<void> invoke(String method, [dynamic arguments]) {
+  Future<T?> invoke<T>(String method, [dynamic arguments]) {
     log(this, LogTopic.calls, () => 'Call: $method $arguments');
     return _methodChannel
-        .invokeMethod(method, arguments)
+        .invokeMethod<T>(method, arguments)
         .catchError((e) => throw toNsdError(e));
   }
 
@@ -221,6 +523,149 @@ class MethodChannelNsdPlatform extends NsdPlatformInterface {
     _disableServiceTypeValidation = value;
   }
 
+  @override
+  Future<void> setMdnsBackend(MdnsBackend backend) async {
+    if (!supportsMdnsBackendSelection) {
+      if (backend == MdnsBackend.system) {
+        return; // the only one there is
+      }
+      throw NsdError(ErrorCause.operationNotSupported,
+          'The built-in mDNS backend is only supported on Windows');
+    }
+
+    await invoke('setBackend', serializeMdnsBackend(backend));
+  }
+
+  @override
+  Future<void> setEventTransport(EventTransport transport) async {
+    if (transport == EventTransport.methodChannel) {
+      if (supportsNativeEventPort) {
+        await invoke('setEventPort', serializeEventPort(null));
+      }
+      return; // the port stays open for events that were posted before
+    }
+
+    if (!supportsNativeEventPort) {
+      throw NsdError(ErrorCause.operationNotSupported,
+          'Native port events are only supported on Windows');
+    }
+
+    final eventPort = _eventPort ??= NativeEventPort.open(_handlePortEvent);
+    if (eventPort == null) {
+      throw NsdError(ErrorCause.operationNotSupported,
+          'Native library doesn\'t support native port events');
+    }
+
+    await invoke('setEventPort', serializeEventPort(eventPort.nativePort));
+  }
+
+  // there is no native side to reply to, so errors are only logged
+  void _handlePortEvent(MethodCall methodCall) {
+    handleMethodCall(methodCall).catchError((e) {
+      log(this, LogTopic.errors, () => 'Event ${methodCall.method}: $e');
+    });
+  }
+
+  @override
+  Future<DiscoverySnapshot> getServices(Discovery discovery,
+      {int pageSize = defaultPageSize}) async {
+    final changes = await _getServiceChanges(discovery.id, 0, pageSize);
+    return DiscoverySnapshot(changes.version, changes.found);
+  }
+
+  @override
+  Future<DiscoveryChanges> getChangesSince(Discovery discovery, int version,
+          {int pageSize = defaultPageSize}) =>
+      _getServiceChanges(discovery.id, version, pageSize);
+
+  // pages through the native journal; services that change while paging move
+  // to a later page, so the result is consistent as of its version
+  Future<DiscoveryChanges> _getServiceChanges(
+      String handle, int since, int pageSize) async {
+    if (!supportsDiscoveryJournal) {
+      throw NsdError(ErrorCause.operationNotSupported,
+          'Service snapshots are only supported on Windows');
+    }
+
+    final found = <String, Service>{};
+    final lost = <String, Service>{};
+    var version = since;
+
+    while (true) {
+      final page = await invoke<Object>('getServiceChanges', {
+        ...serializeHandle(handle),
+        ...serializeJournalPage(version, pageSize),
+      });
+
+      // lost services before the version have been forgotten, possibly
+      // while paging
+      if (deserializeJournalSnapshotRequired(page)) {
+        if (since > 0) {
+          throw NsdError(ErrorCause.illegalArgument,
+              'Changes since version $since are no longer available');
+        }
+
+        found.clear(); // snapshot, start over
+        lost.clear();
+        version = 0;
+        continue;
+      }
+
+      for (final change in deserializeServiceChanges(page)!) {
+        final service = deserializeService(change)!;
+        final key = '${service.name}.${service.type}'.toLowerCase();
+
+        if (deserializeServiceStatus(change) == ServiceStatus.found) {
+          lost.remove(key);
+          found[key] = service;
+        } else {
+          found.remove(key);
+          lost[key] = service;
+        }
+      }
+
+      version = deserializeJournalNext(page)!;
+      if (!deserializeJournalMore(page)) {
+        return DiscoveryChanges(
+            version, found.values.toList(), lost.values.toList());
+      }
+    }
+  }
+
+  @override
+  Future<NsdMetrics> getMetrics(
+      {Discovery? discovery, bool reset = false}) async {
+    if (!supportsMetrics) {
+      throw NsdError(ErrorCause.operationNotSupported,
+          'Metrics are only supported on Windows');
+    }
+
+    final metrics = await invoke<Object>('getMetrics', {
+      if (discovery != null) ...serializeHandle(discovery.id),
+      ...serializeMetricsReset(reset),
+    });
+    return deserializeMetrics(metrics);
+  }
+
+  @override
+  Future<void> setTracing(bool enabled, {int? capacity}) async {
+    _assertTracingSupported();
+    await invoke('setTracing', serializeTracing(enabled, capacity));
+  }
+
+  @override
+  Future<String> dumpTrace({bool clear = false}) async {
+    _assertTracingSupported();
+    return (await invoke<String>('dumpTrace', serializeTraceClear(clear)))!;
+  }
+
+  void _assertTracingSupported() {
+    if (!supportsTracing) {
+      throw NsdError(ErrorCause.operationNotSupported,
+          'Tracing is only supported on Windows');
+    }
+  }
+
   void assertValidServiceType(String? serviceType) {
     if (!_disableServiceTypeValidation && !isValidServiceType(serviceType)) {
       throw NsdError(ErrorCause.illegalArgument,
@@ -242,6 +687,33 @@ Future<Service> performIpLookup(
   return merge(service, Service(addresses: addresses));
 }
 
+// runs the action for all items with a limited number in flight; the results
+// are in item order
+Future<List<R>> _mapBounded<T, R>(
+    List<T> items, Future<R> Function(T) action) async {
+  final results = List<R?>.filled(items.length, null);
+  var next = 0;
+
+  Future<void> worker() async {
+    while (next < items.length) {
+      final index = next++;
+      results[index] = await action(items[index]);
+    }
+  }
+
+  await Future.wait([
+    for (var i = 0; i < min(_maxRunningRegistrations, items.length); i++)
+      worker()
+  ]);
+  return results.cast<R>();
+}
+
+NsdError _asNsdError(Object e) => e is NsdError
+    ? e
+    : e is Exception
+        ? toNsdError(e)
+        : NsdError(ErrorCause.internalError, e.toString());
+
 // prevent the future from throwing uncaught error due to missing callback
 // https://stackoverflow.com/a/66481566/8707976
 void _attachDummyCallback<T>(Future<T> future) => unawaited(
@@ -252,13 +724,23 @@ bool isValidServiceType(String? type) {
     return false;
   }
 
-  if (type == '_services._dns-sd._udp') {
-    return true; // special type for enumeration of services, see https://datatracker.ietf.org/doc/html/rfc6763#section-9 (issue #8)
+  if (type == _serviceEnumerationType) {
+    return true; // issue #8
   }
 
   return RegExp(r'^_[a-zA-Z0-9-]{1,15}._(tcp|udp)').hasMatch(type);
 }
 
+// "_http" + "_tcp.local" -> "_http._tcp"
+String? toEnumeratedServiceType(Service service) {
+  final name = service.name;
+  final protocol = service.type?.split('.').first;
+  if (name == null || protocol == null || protocol.isEmpty) {
+    return null;
+  }
+  return '$name.$protocol';
+}
+
 InternetAddressType? getInternetAddressType(IpLookupType ipLookupType) {
   return _ipLookupTypeToInternetAddressType[ipLookupType];
 }
@@ -1,5 +1,8 @@
 import 'dart:async';
+import 'dart:collection' show UnmodifiableMapBase;
+import 'dart:convert';
 import 'dart:io';
+import 'dart:math';
 
 import 'package:collection/collection.dart';
 import 'package:flutter/foundation.dart';
@@ -24,25 +27,69 @@ abstract class NsdPlatformInterface extends PlatformInterface {
   }
 
   Future<Discovery> startDiscovery(String serviceType,
-      {bool autoResolve = true, IpLookupType ipLookupType = IpLookupType.none});
+      {bool autoResolve = true,
+      IpLookupType ipLookupType = IpLookupType.none,
+      Duration? batchInterval,
+      int? batchSize,
+      List<String> additionalServiceTypes = const [],
+      InterfaceSelection interfaces = InterfaceSelection.any});
 
   Future<void> stopDiscovery(Discovery discovery);
 
-  Future<Service> resolve(Service service);
+  Future<ServiceTypeEnumeration> startServiceTypeEnumeration();
+
+  Future<void> stopServiceTypeEnumeration(
+      ServiceTypeEnumeration enumeration);
+
+  Resolution resolve(Service service,
+      {IpLookupType ipLookupType = IpLookupType.none, Duration? timeout});
+
+  Future<void> cancelResolve(Resolution resolution);
 
   Future<Registration> register(Service service);
 
   Future<void> unregister(Registration registration);
 
+  Future<List<RegistrationResult>> registerMany(List<Service> services);
+
+  Future<List<RegistrationResult>> unregisterMany(
+      List<Registration> registrations);
+
   void enableLogging(LogTopic logTopic);
 
   void disableServiceTypeValidation(bool value);
+
+  Future<void> setMdnsBackend(MdnsBackend backend);
+
+  Future<void> setEventTransport(EventTransport transport);
+
+  Future<DiscoverySnapshot> getServices(Discovery discovery,
+      {int pageSize = defaultPageSize});
+
+  Future<DiscoveryChanges> getChangesSince(Discovery discovery, int version,
+      {int pageSize = defaultPageSize});
+
+  Future<NsdMetrics> getMetrics({Discovery? discovery, bool reset = false});
+
+  Future<void> setTracing(bool enabled, {int? capacity});
+
+  Future<String> dumpTrace({bool clear = false});
 }
 
+/// Services fetched per call to the native side by [NsdPlatformInterface.getServices]
+/// and [NsdPlatformInterface.getChangesSince].
+const defaultPageSize = 256;
+
 /// Represents a network service.
 class Service {
   const Service(
-      {this.name, this.type, this.host, this.port, this.txt, this.addresses});
+      {this.name,
+      this.type,
+      this.host,
+      this.port,
+      this.txt,
+      this.addresses,
+      this.interfaceIndex});
 
   final String? name;
   final String? type;
@@ -50,19 +97,88 @@ class Service {
   final int? port;
   final List<InternetAddress>? addresses;
 
+  /// The [NetworkInterface.index] of the interface the service was found on,
+  /// if known (Windows).
+  ///
+  /// Resolving and registering use this interface if it is set.
+  final int? interfaceIndex;
+
   /// Represents DNS TXT records.
   ///
   /// Keys MUST be printable US-ASCII values excluding '=', MUST be minimum 1
   /// and SHOULD be maximum 9 characters long.
   ///
   /// Values are opaque binary data (macOS, iOS) but some OS require the data
-  /// to be convertible to UTF-8 (Android). Null is a valid value.
-  /// Empty lists will be interpreted as null (macOS, iOS, Android).
+  /// to be convertible to UTF-8 (Android, Windows with [MdnsBackend.system]).
+  /// Null is a valid value. Empty lists will be interpreted as null.
+  ///
+  /// On Windows, received TXT data is a [RawTxt], parsed on first access.
   final Map<String, Uint8List?>? txt;
 
   @override
   String toString() =>
-      'Service (name: $name, service type: $type, hostname: $host, port: $port, txt: $txt, addresses: $addresses)';
+      'Service (name: $name, service type: $type, hostname: $host, port: $port, txt: $txt, addresses: $addresses, interface: $interfaceIndex)';
+}
+
+/// TXT entries in DNS wire format (length prefixed "key=value" strings, see
+/// RFC 6763 section 6), as received from the native side (Windows).
+///
+/// The entries are parsed on first access. Values are opaque bytes, returned
+/// as views into [bytes]; empty values are returned as null, like on the
+/// other platforms.
+class RawTxt extends UnmodifiableMapBase<String, Uint8List?> {
+  /// The TXT record data.
+  final Uint8List bytes;
+
+  Map<String, Uint8List?>? _entries;
+
+  // TODO hide this
+  RawTxt(this.bytes);
+
+  Map<String, Uint8List?> get _parsed => _entries ??= _parseTxt(bytes);
+
+  @override
+  Uint8List? operator [](Object? key) => _parsed[key];
+
+  @override
+  bool containsKey(Object? key) => _parsed.containsKey(key);
+
+  @override
+  Iterable<String> get keys => _parsed.keys;
+
+  @override
+  int get length => _parsed.length;
+}
+
+// only the first occurrence of a key counts, strings without key are ignored,
+// see https://datatracker.ietf.org/doc/html/rfc6763#section-6.4
+Map<String, Uint8List?> _parseTxt(Uint8List bytes) {
+  const separator = 0x3D; // '='
+  final entries = <String, Uint8List?>{};
+
+  for (var offset = 0; offset < bytes.length;) {
+    final start = offset + 1;
+    final end = min(start + bytes[offset], bytes.length);
+
+    var keyEnd = start;
+    while (keyEnd < end && bytes[keyEnd] != separator) {
+      keyEnd++;
+    }
+
+    if (keyEnd > start) {
+      final key = utf8.decode(Uint8List.sublistView(bytes, start, keyEnd),
+          allowMalformed: true);
+      entries.putIfAbsent(
+          key,
+          () => keyEnd + 1 < end
+              ? Uint8List.sublistView(bytes, keyEnd + 1, end)
+              : null);
+    }
+
+    offset = end;
+  }
+
+  return entries;
 }
 
 /// Returns true if the two [Service] instances refer to the same service.
@@ -76,7 +192,8 @@ Service merge(Service existing, Service incoming) => Service(
     host: incoming.host ?? existing.host,
     port: incoming.port ?? existing.port,
     txt: incoming.txt ?? existing.txt,
-    addresses: incoming.addresses ?? existing.addresses);
+    addresses: incoming.addresses ?? existing.addresses,
+    interfaceIndex: incoming.interfaceIndex ?? existing.interfaceIndex);
 
 /// Indicates the cause of an [NsdError].
 enum ErrorCause {
@@ -103,6 +220,12 @@ enum ErrorCause {
 
   /// A security issue, for example a missing permission.
   securityIssue,
+
+  /// The operation didn't complete in time.
+  timeout,
+
+  /// The operation was cancelled by the client.
+  cancelled,
 }
 
 /// Represents an error that occurred during an NSD operation.
@@ -192,6 +315,183 @@ class Discovery with ChangeNotifier {
   String toString() => 'Discovery (id: $id, services: $services)';
 }
 
+/// Represents a service type enumeration.
+///
+/// It is also a [ChangeNotifier] so it can be used with a [ChangeNotifierProvider]
+/// in the same way as a [Discovery].
+class ServiceTypeEnumeration with ChangeNotifier {
+  final String id;
+
+  final Map<String, int> _serviceTypes = {};
+
+  /// The service types found on the network, e.g. "_http._tcp", with the
+  /// number of their instances.
+  ///
+  /// This is updated while the enumeration is running.
+  Map<String, int> get serviceTypes => Map.unmodifiable(_serviceTypes);
+
+  // TODO hide this
+  ServiceTypeEnumeration(this.id);
+
+  // TODO hide this
+  void update(Map<String, int?> changes) {
+    for (final change in changes.entries) {
+      final count = change.value;
+      if (count == null) {
+        _serviceTypes.remove(change.key);
+      } else {
+        _serviceTypes[change.key] = count;
+      }
+    }
+    notifyListeners();
+  }
+
+  @override
+  String toString() =>
+      'ServiceTypeEnumeration (id: $id, service types: $serviceTypes)';
+}
+
+/// The services of a running discovery as of [version].
+class DiscoverySnapshot {
+  /// Pass this to [NsdPlatformInterface.getChangesSince] to get what changed
+  /// afterwards.
+  final int version;
+
+  final List<Service> services;
+
+  // TODO hide this
+  DiscoverySnapshot(this.version, this.services);
+
+  @override
+  String toString() =>
+      'DiscoverySnapshot (version: $version, services: $services)';
+}
+
+/// What changed in a running discovery up to [version].
+class DiscoveryChanges {
+  final int version;
+
+  /// Services that were found or updated.
+  final List<Service> found;
+
+  final List<Service> lost;
+
+  // TODO hide this
+  DiscoveryChanges(this.version, this.found, this.lost);
+
+  @override
+  String toString() =>
+      'DiscoveryChanges (version: $version, found: $found, lost: $lost)';
+}
+
+/// Latency distribution, taken from a histogram whose buckets are at most
+/// 12.5% wide, so percentiles are upper bounds within that precision.
+class LatencySummary {
+  final int count;
+  final Duration min;
+  final Duration max;
+  final Duration mean;
+  final Duration p50;
+  final Duration p90;
+  final Duration p99;
+
+  // TODO hide this
+  LatencySummary(this.count, this.min, this.max, this.mean, this.p50,
+      this.p90, this.p99);
+
+  @override
+  String toString() =>
+      'LatencySummary (count: $count, min: $min, max: $max, mean: $mean, '
+      'p50: $p50, p90: $p90, p99: $p99)';
+}
+
+/// Completions of an operation, e.g. resolves, and how long they took.
+class OperationMetrics {
+  final int count;
+  final int failures;
+
+  /// Completions by native status code, 0 being success; statuses beyond the
+  /// first few distinct ones are only counted in [count] and [failures].
+  final Map<int, int> statuses;
+
+  final LatencySummary latency;
+
+  // TODO hide this
+  OperationMetrics(this.count, this.failures, this.statuses, this.latency);
+
+  @override
+  String toString() =>
+      'OperationMetrics (count: $count, failures: $failures, '
+      'statuses: $statuses, latency: $latency)';
+}
+
+/// Results the native side received for one kind of callback.
+class CallbackMetrics {
+  final int count;
+  final int failures;
+
+  /// Callbacks by native status code, see [OperationMetrics.statuses].
+  final Map<int, int> statuses;
+
+  /// Callbacks that were discarded natively, e.g. failed browse callbacks or
+  /// records that didn't name a service.
+  final int dropped;
+
+  // TODO hide this
+  CallbackMetrics(this.count, this.failures, this.statuses, this.dropped);
+
+  @override
+  String toString() =>
+      'CallbackMetrics (count: $count, failures: $failures, '
+      'statuses: $statuses, dropped: $dropped)';
+}
+
+/// Lookups of the native resolve cache.
+class ResolveCacheMetrics {
+  /// Answered from a fresh entry.
+  final int hits;
+
+  /// Answered from an expired entry, which is refreshed in the background.
+  final int staleHits;
+
+  /// Resolved over the network, including cached entries that lacked the
+  /// requested address families.
+  final int misses;
+
+  // TODO hide this
+  ResolveCacheMetrics(this.hits, this.staleHits, this.misses);
+
+  @override
+  String toString() => 'ResolveCacheMetrics (hits: $hits, '
+      'stale hits: $staleHits, misses: $misses)';
+}
+
+/// Native instrumentation, see [NsdPlatformInterface.getMetrics].
+class NsdMetrics {
+  /// By operation: browseFirstResult, resolve, register and unregister;
+  /// operations that haven't completed yet are missing.
+  final Map<String, OperationMetrics> operations;
+
+  /// By callback kind, e.g. serviceDiscovered or serviceResolved.
+  final Map<String, CallbackMetrics> callbacks;
+
+  /// How long callback results wait for the platform thread; not tracked per
+  /// discovery.
+  final LatencySummary? drainDelay;
+
+  /// Resolves answered from the cache; not tracked per discovery.
+  final ResolveCacheMetrics? resolveCache;
+
+  // TODO hide this
+  NsdMetrics(
+      this.operations, this.callbacks, this.drainDelay, this.resolveCache);
+
+  @override
+  String toString() =>
+      'NsdMetrics (operations: $operations, callbacks: $callbacks, '
+      'drain delay: $drainDelay, resolve cache: $resolveCache)';
+}
+
 /// Represents a registration.
 class Registration {
   final String id;
@@ -204,6 +504,65 @@ class Registration {
   String toString() => 'Registration (id: $id, service: $service)';
 }
 
+/// A single resolve request.
+///
+/// Completes with the resolved service like the [Future] it is, and
+/// identifies the request when cancelling it.
+class Resolution implements Future<Service> {
+  final String id;
+  final Service service;
+  final Future<Service> _result;
+
+  // TODO hide this
+  Resolution(this.id, this.service, this._result);
+
+  @override
+  Future<R> then<R>(FutureOr<R> Function(Service value) onValue,
+          {Function? onError}) =>
+      _result.then(onValue, onError: onError);
+
+  @override
+  Future<Service> catchError(Function onError,
+          {bool Function(Object error)? test}) =>
+      _result.catchError(onError, test: test);
+
+  @override
+  Future<Service> whenComplete(FutureOr<void> Function() action) =>
+      _result.whenComplete(action);
+
+  @override
+  Future<Service> timeout(Duration timeLimit,
+          {FutureOr<Service> Function()? onTimeout}) =>
+      _result.timeout(timeLimit, onTimeout: onTimeout);
+
+  @override
+  Stream<Service> asStream() => _result.asStream();
+
+  @override
+  String toString() => 'Resolution (id: $id, service: $service)';
+}
+
+/// The outcome for one service of a bulk registration or unregistration.
+class RegistrationResult {
+  /// The service as passed in.
+  final Service service;
+
+  /// The registration; null if registering failed.
+  final Registration? registration;
+
+  /// The reason registering or unregistering failed; null on success.
+  final NsdError? error;
+
+  // TODO hide this
+  RegistrationResult(this.service, {this.registration, this.error});
+
+  bool get isSuccessful => error == null;
+
+  @override
+  String toString() =>
+      'RegistrationResult (service: $service, registration: $registration, error: $error)';
+}
+
 /// Represents available log topics.
 enum LogTopic {
   /// Logs calls to the native side and callbacks to the platform side.
@@ -213,6 +572,47 @@ enum LogTopic {
   errors
 }
 
+/// Selects the network interfaces a discovery runs on.
+///
+/// Interfaces are identified by [NetworkInterface.index]. Services found on
+/// several interfaces are reported once.
+class InterfaceSelection {
+  const InterfaceSelection._(this.allInterfaces, this.indexes);
+
+  /// Uses the given interfaces in parallel.
+  const InterfaceSelection.indexes(List<int> indexes) : this._(false, indexes);
+
+  /// Lets the operating system choose the interfaces.
+  static const any = InterfaceSelection._(false, []);
+
+  /// Uses every interface that is up, except loopback, in parallel.
+  static const all = InterfaceSelection._(true, []);
+
+  final bool allInterfaces;
+  final List<int> indexes;
+
+  bool get isAny => !allInterfaces && indexes.isEmpty;
+}
+
+/// Selects the mDNS implementation used for discovery and resolving.
+enum MdnsBackend {
+  /// The operating system's DNS-SD API.
+  system,
+
+  /// The plugin's own mDNS querier and responder; Windows only.
+  builtIn,
+}
+
+/// Selects how the native side delivers events (discovered services, resolve
+/// and registration results).
+enum EventTransport {
+  /// The platform channel, like method call results.
+  methodChannel,
+
+  /// A native port the plugin posts to directly over FFI; Windows only.
+  nativePort,
+}
+
 /// Configures IP lookup.
 ///
 /// Since IP lookup is performed using the service host name,
@@ -1,6 +1,7 @@
 import 'dart:io';
 import 'dart:typed_data';
 
+import 'codec.dart';
 import 'nsd_platform_interface.dart';
 import 'utilities.dart';
 
@@ -10,6 +11,9 @@ String? deserializeString(dynamic arguments, String key) =>
 Map<String, dynamic> serializeServiceType(String value) =>
     {'service.type': value};
 
+Map<String, dynamic> serializeServiceTypes(List<String> value) =>
+    {'service.types': value};
+
 Map<String, dynamic> serializeErrorCause(ErrorCause value) =>
     {'error.cause': value.name};
 
@@ -29,6 +33,10 @@ String? deserializeErrorMessage(dynamic arguments) =>
     deserializeString(arguments, 'error.message');
 
 NsdError? deserializeError(dynamic arguments) {
+  if (arguments is EventRecord) {
+    return arguments.error;
+  }
+
   final cause = deserializeErrorCause(arguments);
   final message = deserializeErrorMessage(arguments);
   if (cause == null || message == null) {
@@ -42,31 +50,46 @@ Map<String, dynamic> serializeService(Service service) => {
       'service.type': service.type,
       'service.host': service.host,
       'service.port': service.port,
-      'service.txt': service.txt
+      'service.txt': service.txt,
+      if (service.interfaceIndex != null)
+        'service.interfaceIndex': service.interfaceIndex,
     };
 
 Service? deserializeService(dynamic arguments) {
+  if (arguments is EventRecord) {
+    return arguments.service; // Windows
+  }
+
   final data = Map<String, dynamic>.from(arguments);
 
   final name = data['service.name'] as String?;
   final type = data['service.type'] as String?;
   final host = data['service.host'] as String?;
   final port = data['service.port'] as int?;
-  final addresses = data['service.addresses'] as String?;
-  final txt = data['service.txt'] != null
-      ? Map<String, Uint8List?>.from(data['service.txt'])
-      : null;
+  final addresses = data['service.addresses']; // single string or list
+  final interfaceIndex = data['service.interfaceIndex'] as int?;
+  final rawTxt = data['service.txt.raw'] as Uint8List?; // Windows
+  final txt = rawTxt != null
+      ? RawTxt(rawTxt)
+      : data['service.txt'] != null
+          ? Map<String, Uint8List?>.from(data['service.txt'])
+          : null;
 
   if (name == null &&
       type == null &&
       host == null &&
       port == null &&
       addresses == null &&
-      txt == null) {
+      txt == null &&
+      interfaceIndex == null) {
     return null;
   }
 
-  final inetAddresses = addresses != null ? [InternetAddress(addresses)] : null;
+  final inetAddresses = switch (addresses) {
+    null => null,
+    String() => [InternetAddress(addresses)],
+    _ => List<String>.from(addresses).map(InternetAddress.new).toList(),
+  };
 
   return Service(
       name: name,
@@ -74,12 +97,212 @@ Service? deserializeService(dynamic arguments) {
       host: host,
       port: port,
       addresses: inetAddresses,
-      txt: txt);
+      txt: txt,
+      interfaceIndex: interfaceIndex);
+}
+
+Map<String, dynamic> serializeServiceStatus(ServiceStatus value) =>
+    {'service.status': value.name};
+
+ServiceStatus? deserializeServiceStatus(dynamic arguments) {
+  if (arguments is EventRecord) {
+    return arguments.status;
+  }
+
+  final statusString = deserializeString(arguments, 'service.status');
+  if (statusString == null) {
+    return null;
+  }
+
+  return enumValueFromString(ServiceStatus.values, statusString);
+}
+
+Map<String, dynamic> serializeServiceChanges(
+        List<(Service, ServiceStatus)> changes) =>
+    {
+      'service.changes': changes
+          .map((change) => {
+                ...serializeService(change.$1),
+                ...serializeServiceStatus(change.$2)
+              })
+          .toList()
+    };
+
+// returns the serialized changes, each one can be passed to deserializeService()
+// and deserializeServiceStatus()
+List<dynamic>? deserializeServiceChanges(dynamic arguments) {
+  if (arguments is EventRecord) {
+    return arguments.changes;
+  }
+
+  final changes = Map<String, dynamic>.from(arguments)['service.changes'];
+  if (changes == null) {
+    return null;
+  }
+
+  return List<dynamic>.from(changes);
+}
+
+Map<String, dynamic> serializeServiceResolved(bool value) =>
+    {'service.resolved': value};
+
+bool deserializeServiceResolved(dynamic arguments) => arguments is EventRecord
+    ? arguments.resolved
+    : Map<String, dynamic>.from(arguments)['service.resolved'] == true;
+
+Map<String, dynamic> serializeAutoResolve(bool value) =>
+    {'discovery.autoResolve': value};
+
+Map<String, dynamic> serializeEnumerateTypes(bool value) =>
+    {'discovery.enumerateTypes': value};
+
+Map<String, dynamic> serializeJournalPage(int since, int size) =>
+    {'journal.since': since, 'page.size': size};
+
+int? deserializeJournalNext(dynamic arguments) =>
+    Map<String, dynamic>.from(arguments)['journal.next'];
+
+bool deserializeJournalMore(dynamic arguments) =>
+    Map<String, dynamic>.from(arguments)['journal.more'] == true;
+
+bool deserializeJournalSnapshotRequired(dynamic arguments) =>
+    Map<String, dynamic>.from(arguments)['journal.snapshotRequired'] == true;
+
+Map<String, dynamic> serializeTracing(bool enabled, int? capacity) => {
+      'trace.enabled': enabled,
+      if (capacity != null) 'trace.capacity': capacity,
+    };
+
+Map<String, dynamic> serializeTraceClear(bool value) => {'trace.clear': value};
+
+Map<String, dynamic> serializeMetricsReset(bool value) =>
+    {'metrics.reset': value};
+
+// native latencies are in microseconds
+NsdMetrics deserializeMetrics(dynamic arguments) {
+  final metrics = Map<String, dynamic>.from(arguments);
+  final drainDelay = metrics['drainDelay'];
+  final resolveCache = metrics['resolveCache'];
+
+  return NsdMetrics(
+    _deserializeMetricsMap(metrics['operations'], (operation) {
+      return OperationMetrics(
+          operation['count'],
+          operation['failures'],
+          _deserializeStatuses(operation['statuses']),
+          _deserializeLatency(operation['latency']));
+    }),
+    _deserializeMetricsMap(metrics['callbacks'], (callback) {
+      return CallbackMetrics(callback['count'], callback['failures'],
+          _deserializeStatuses(callback['statuses']), callback['dropped']);
+    }),
+    drainDelay != null ? _deserializeLatency(drainDelay) : null,
+    resolveCache != null
+        ? ResolveCacheMetrics(resolveCache['hits'], resolveCache['staleHits'],
+            resolveCache['misses'])
+        : null,
+  );
+}
+
+Map<String, T> _deserializeMetricsMap<T>(
+        dynamic entries, T Function(Map<String, dynamic>) deserialize) =>
+    Map<String, dynamic>.from(entries ?? {}).map((name, entry) =>
+        MapEntry(name, deserialize(Map<String, dynamic>.from(entry))));
+
+Map<int, int> _deserializeStatuses(dynamic statuses) =>
+    Map<int, int>.from(statuses ?? {});
+
+LatencySummary _deserializeLatency(dynamic arguments) {
+  final latency = Map<String, dynamic>.from(arguments);
+  Duration micros(String key) => Duration(microseconds: latency[key]);
+
+  return LatencySummary(latency['count'], micros('min'), micros('max'),
+      micros('mean'), micros('p50'), micros('p90'), micros('p99'));
+}
+
+Map<String, dynamic> serializeDiscoveryStream(bool value) =>
+    {'discovery.stream': value};
+
+String? deserializeEvent(dynamic arguments) => arguments is EventRecord
+    ? arguments.event
+    : deserializeString(arguments, 'event');
+
+Map<String, dynamic> serializeServiceTypeCounts(Map<String, int?> value) =>
+    {'service.types': value};
+
+// returns the changed service types with their instance counts, null if the
+// type was lost
+Map<String, int?>? deserializeServiceTypeCounts(dynamic arguments) {
+  if (arguments is EventRecord) {
+    return arguments.serviceTypes;
+  }
+
+  final types = Map<String, dynamic>.from(arguments)['service.types'];
+  if (types == null) {
+    return null;
+  }
+
+  return Map<String, int?>.from(types);
+}
+
+Map<String, dynamic> serializeInterfaces(InterfaceSelection value) => {
+      if (value.allInterfaces)
+        'network.interfaces': 'all'
+      else if (value.indexes.isNotEmpty)
+        'network.interfaces': value.indexes,
+    };
+
+Map<String, dynamic> serializeMdnsBackend(MdnsBackend value) =>
+    {'backend': value.name};
+
+Map<String, dynamic> serializeEventPort(int? value) => {'event.port': value};
+
+Map<String, dynamic> serializeIpLookupType(IpLookupType value) =>
+    {'ip.lookupType': value.name};
+
+Map<String, dynamic> serializeResolveTimeout(Duration? value) => {
+      if (value != null) 'resolve.timeout': value.inMilliseconds,
+    };
+
+Map<String, dynamic> serializeBatching(Duration? interval, int? size) => {
+      if (interval != null) 'discovery.batch.interval': interval.inMilliseconds,
+      if (size != null) 'discovery.batch.size': size,
+    };
+
+// each registration carries its own handle, see serializeHandle()
+Map<String, dynamic> serializeRegistrations(
+        List<(String, Service)> registrations) =>
+    {
+      'registrations': registrations
+          .map((registration) => {
+                ...serializeHandle(registration.$1),
+                ...serializeService(registration.$2)
+              })
+          .toList()
+    };
+
+Map<String, dynamic> serializeHandles(List<String> value) =>
+    {'handles': value};
+
+// returns the results in request order, each one can be passed to
+// deserializeError() and deserializeService()
+List<dynamic>? deserializeRegistrationResults(dynamic arguments) {
+  if (arguments is EventRecord) {
+    return arguments.results;
+  }
+
+  final results = Map<String, dynamic>.from(arguments)['results'];
+  if (results == null) {
+    return null;
+  }
+
+  return List<dynamic>.from(results);
 }
 
 Map<String, dynamic> serializeHandle(String value) => {
       'handle': value,
     };
 
-String? deserializeHandle(dynamic arguments) =>
-    deserializeString(arguments, 'handle');
+String? deserializeHandle(dynamic arguments) => arguments is EventRecord
+    ? arguments.handle
+    : deserializeString(arguments, 'handle');
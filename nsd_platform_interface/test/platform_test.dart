@@ -1,9 +1,13 @@
 import 'dart:async';
 import 'dart:collection';
 import 'dart:convert';
+import 'dart:io';
 
+import 'package:flutter/foundation.dart' show WriteBuffer;
 import 'package:flutter/services.dart';
 import 'package:flutter_test/flutter_test.dart';
+import 'package:nsd_platform_interface/src/codec.dart';
+import 'package:nsd_platform_interface/src/event_port.dart';
 import 'package:nsd_platform_interface/src/method_channel_nsd_platform.dart';
 import 'package:nsd_platform_interface/src/nsd_platform_interface.dart';
 import 'package:nsd_platform_interface/src/serialization.dart';
@@ -280,6 +284,196 @@ void main() {
       expect(discovery.services.length, 0);
     });
 
+    test('Batching parameters are passed to native code', () async {
+      late dynamic capturedArguments;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedArguments = arguments;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      await nsd.startDiscovery('_foo._tcp',
+          autoResolve: false,
+          batchInterval: const Duration(milliseconds: 500),
+          batchSize: 100);
+
+      expect(capturedArguments['discovery.batch.interval'], 500);
+      expect(capturedArguments['discovery.batch.size'], 100);
+    });
+
+    test('Multiple service types are passed to native code', () async {
+      late dynamic capturedArguments;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedArguments = arguments;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      nsd.supportsMultipleServiceTypes = true;
+      await nsd.startDiscovery('_foo._tcp',
+          autoResolve: false, additionalServiceTypes: ['_bar._tcp']);
+
+      expect(capturedArguments['service.type'], '_foo._tcp');
+      expect(capturedArguments['service.types'], ['_foo._tcp', '_bar._tcp']);
+    });
+
+    test('Multiple service types fail without native support', () async {
+      nsd.supportsMultipleServiceTypes = false;
+
+      expect(
+          nsd.startDiscovery('_foo._tcp',
+              additionalServiceTypes: ['_bar._tcp']),
+          throwsA(isA<NsdError>().having((e) => e.cause, 'error cause',
+              ErrorCause.operationNotSupported)));
+    });
+
+    test('Interface selection is passed to native code', () async {
+      late String capturedHandle;
+      late dynamic capturedArguments;
+      nsd.supportsInterfaceSelection = true;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        capturedArguments = arguments;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      final discovery = await nsd.startDiscovery('_foo._tcp',
+          autoResolve: false,
+          interfaces: const InterfaceSelection.indexes([3, 7]));
+
+      expect(capturedArguments['network.interfaces'], [3, 7]);
+
+      await mockReply('onServiceDiscovered', {
+        ...serializeHandle(capturedHandle),
+        ...serializeService(const Service(
+            name: 'Some name', type: '_foo._tcp', interfaceIndex: 7))
+      });
+
+      expect(discovery.services.single.interfaceIndex, 7);
+    });
+
+    test('Interface selection fails without native support', () async {
+      nsd.supportsInterfaceSelection = false;
+
+      expect(
+          nsd.startDiscovery('_foo._tcp', interfaces: InterfaceSelection.all),
+          throwsA(isA<NsdError>().having((e) => e.cause, 'error cause',
+              ErrorCause.operationNotSupported)));
+    });
+
+    test('Service type enumeration reports types with instance counts',
+        () async {
+      late String capturedHandle;
+      late dynamic capturedArguments;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        capturedArguments = arguments;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      final enumeration = await nsd.startServiceTypeEnumeration();
+
+      expect(capturedArguments['service.type'], '_services._dns-sd._udp');
+      expect(capturedArguments['discovery.enumerateTypes'], true);
+
+      await mockReply('onServiceTypesChanged', {
+        ...serializeHandle(capturedHandle),
+        ...serializeServiceTypeCounts({'_http._tcp': 2, '_ipp._tcp': 1})
+      });
+
+      await mockReply('onServiceTypesChanged', {
+        ...serializeHandle(capturedHandle),
+        ...serializeServiceTypeCounts({'_ipp._tcp': null})
+      });
+
+      expect(enumeration.serviceTypes, {'_http._tcp': 2});
+    });
+
+    test('Service type enumeration maps browsed records to types', () async {
+      late String capturedHandle;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      final enumeration = await nsd.startServiceTypeEnumeration();
+
+      await mockReply('onServiceDiscovered', {
+        ...serializeHandle(capturedHandle),
+        ...serializeService(const Service(name: '_http', type: '_tcp.local'))
+      });
+
+      expect(enumeration.serviceTypes, {'_http._tcp': 0});
+    });
+
+    test('Client is notified of batched changes', () async {
+      late String capturedHandle;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      final discovery = await nsd.startDiscovery('_foo._tcp',
+          autoResolve: false, batchSize: 3);
+
+      const foo = Service(name: 'Foo', type: '_foo._tcp');
+      const bar = Service(name: 'Bar', type: '_foo._tcp');
+
+      await mockReply('onServicesChanged', {
+        ...serializeHandle(capturedHandle),
+        ...serializeServiceChanges(
+            [(foo, ServiceStatus.found), (bar, ServiceStatus.found)])
+      });
+
+      expect(discovery.services.length, 2);
+
+      await mockReply('onServicesChanged', {
+        ...serializeHandle(capturedHandle),
+        ...serializeServiceChanges([(foo, ServiceStatus.lost)])
+      });
+
+      expect(discovery.services.length, 1);
+      expect(discovery.services.elementAt(0).name, 'Bar');
+    });
+
+    test('Natively resolved services are not resolved again', () async {
+      late String capturedHandle;
+      var resolveCalled = false;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      mockHandlers['resolve'] = (handle, arguments) {
+        resolveCalled = true;
+      };
+
+      final discovery = await nsd.startDiscovery('_foo._tcp');
+
+      await mockReply('onServiceDiscovered', {
+        ...serializeHandle(capturedHandle),
+        ...serializeService(const Service(
+            name: 'Foo', type: '_foo._tcp', host: 'foo.local', port: 42)),
+        'service.addresses': ['192.168.0.1', 'fe80::1'],
+        ...serializeServiceResolved(true),
+      });
+
+      expect(resolveCalled, false);
+      expect(discovery.services.length, 1);
+
+      final service = discovery.services.elementAt(0);
+      expect(service.host, 'foo.local');
+      expect(service.addresses, [
+        InternetAddress('192.168.0.1'),
+        InternetAddress('fe80::1'),
+      ]);
+    });
+
     test('Callback is notified if service is discovered', () async {
       late String capturedHandle;
 
@@ -365,6 +559,291 @@ void main() {
     });
   });
 
+  group('$MethodChannelNsdPlatform discovery streams', () {
+    test('Events are delivered on the discovery stream', () async {
+      nsd.supportsDiscoveryStreams = true;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        expect(arguments['discovery.stream'], true);
+        mockDiscoveryStream(handle, onListen: (events) {
+          events.success({
+            ...serializeHandle(handle),
+            'event': 'onDiscoveryStartSuccessful',
+          });
+          events.success({
+            ...serializeHandle(handle),
+            ...serializeService(const Service(name: 'Foo', type: '_foo._tcp')),
+            'event': 'onServiceDiscovered',
+          });
+        });
+      };
+
+      final discovery =
+          await nsd.startDiscovery('_foo._tcp', autoResolve: false);
+      await Future<void>.delayed(Duration.zero);
+
+      expect(discovery.services.map((service) => service.name), ['Foo']);
+    });
+
+    test('Stopping cancels the discovery stream', () async {
+      nsd.supportsDiscoveryStreams = true;
+      var cancelled = false;
+
+      // pending changes and the outcome arrive on the method channel
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        mockDiscoveryStream(handle,
+            onListen: (events) => events.success({
+                  ...serializeHandle(handle),
+                  'event': 'onDiscoveryStartSuccessful',
+                }),
+            onCancel: () {
+              cancelled = true;
+              mockReply('onServiceDiscovered', {
+                ...serializeHandle(handle),
+                ...serializeService(
+                    const Service(name: 'Foo', type: '_foo._tcp')),
+              }).then((value) => mockReply(
+                  'onDiscoveryStopSuccessful', serializeHandle(handle)));
+            });
+      };
+
+      mockHandlers['stopDiscovery'] = (handle, arguments) =>
+          fail('Discovery streams are stopped by cancelling them');
+
+      final discovery =
+          await nsd.startDiscovery('_foo._tcp', autoResolve: false);
+      await nsd.stopDiscovery(discovery);
+
+      expect(cancelled, true);
+      expect(discovery.services.map((service) => service.name), ['Foo']);
+    });
+
+    test('Stopping the discovery stream reports failures', () async {
+      nsd.supportsDiscoveryStreams = true;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        mockDiscoveryStream(handle,
+            onListen: (events) => events.success({
+                  ...serializeHandle(handle),
+                  'event': 'onDiscoveryStartSuccessful',
+                }),
+            onCancel: () => mockReply('onDiscoveryStopFailed', {
+                  ...serializeHandle(handle),
+                  ...serializeErrorCause(ErrorCause.internalError),
+                  ...serializeErrorMessage('cancel failed'),
+                }));
+      };
+
+      final matcher = isA<NsdError>()
+          .having((e) => e.cause, 'error cause', ErrorCause.internalError)
+          .having((e) => e.message, 'error message', contains('cancel failed'));
+
+      final discovery =
+          await nsd.startDiscovery('_foo._tcp', autoResolve: false);
+
+      expect(nsd.stopDiscovery(discovery), throwsA(matcher));
+    });
+  });
+
+  group('$MethodChannelNsdPlatform discovery journal', () {
+    test('Snapshot is assembled from pages', () async {
+      nsd.supportsDiscoveryJournal = true;
+
+      Map<String, dynamic> change(String name, ServiceStatus status) => {
+            ...serializeService(Service(name: name, type: '_foo._tcp')),
+            ...serializeServiceStatus(status),
+          };
+
+      // Foo is lost while the second page is requested
+      mockHandlers['getServiceChanges'] = (handle, arguments) =>
+          arguments['journal.since'] == 0
+              ? {
+                  'service.changes': [
+                    change('Foo', ServiceStatus.found),
+                    change('Bar', ServiceStatus.found),
+                  ],
+                  'journal.next': 2,
+                  'journal.more': true,
+                }
+              : {
+                  'service.changes': [change('Foo', ServiceStatus.lost)],
+                  'journal.next': 3,
+                  'journal.more': false,
+                };
+
+      final snapshot = await nsd.getServices(Discovery('foo'), pageSize: 2);
+
+      expect(snapshot.version, 3);
+      expect(snapshot.services.map((service) => service.name), ['Bar']);
+    });
+
+    test('Changes since dropped versions fail', () async {
+      nsd.supportsDiscoveryJournal = true;
+
+      mockHandlers['getServiceChanges'] = (handle, arguments) => {
+            'service.changes': [],
+            'journal.next': 5,
+            'journal.more': false,
+            'journal.snapshotRequired': true,
+          };
+
+      expect(
+          nsd.getChangesSince(Discovery('foo'), 5),
+          throwsA(isA<NsdError>().having((e) => e.cause, 'error cause',
+              ErrorCause.illegalArgument)));
+    });
+
+    test('Snapshot starts over if versions are dropped while paging',
+        () async {
+      nsd.supportsDiscoveryJournal = true;
+      final requested = <int>[];
+
+      // Foo's tombstone is dropped before the second page is requested
+      mockHandlers['getServiceChanges'] = (handle, arguments) {
+        final since = arguments['journal.since'] as int;
+        requested.add(since);
+        return switch (requested.length) {
+          1 => {
+              'service.changes': [
+                {
+                  ...serializeService(
+                      const Service(name: 'Foo', type: '_foo._tcp')),
+                  ...serializeServiceStatus(ServiceStatus.found),
+                }
+              ],
+              'journal.next': 1,
+              'journal.more': true,
+            },
+          2 => {
+              'service.changes': [],
+              'journal.next': 1,
+              'journal.more': false,
+              'journal.snapshotRequired': true,
+            },
+          _ => {
+              'service.changes': [],
+              'journal.next': 7,
+              'journal.more': false,
+            },
+        };
+      };
+
+      final snapshot = await nsd.getServices(Discovery('foo'), pageSize: 1);
+
+      expect(requested, [0, 1, 0]);
+      expect(snapshot.version, 7);
+      expect(snapshot.services, isEmpty);
+    });
+  });
+
+  group('$MethodChannelNsdPlatform metrics', () {
+    test('Metrics are decoded from the native reply', () async {
+      nsd.supportsMetrics = true;
+
+      dynamic capturedArguments;
+      mockHandlers['getMetrics'] = (handle, arguments) {
+        capturedArguments = arguments;
+        return {
+          'operations': {
+            'browseFirstResult': {
+              'count': 1,
+              'failures': 0,
+              'statuses': {0: 1},
+              'statuses.other': 0,
+              'latency': {
+                'count': 1,
+                'min': 1500,
+                'max': 1500,
+                'mean': 1500,
+                'p50': 1500,
+                'p90': 1500,
+                'p99': 1500,
+              },
+            },
+          },
+          'callbacks': {
+            'serviceDiscovered': {
+              'count': 3,
+              'failures': 1,
+              'statuses': {0: 2, 1460: 1},
+              'statuses.other': 0,
+              'dropped': 1,
+            },
+          },
+        };
+      };
+
+      final metrics =
+          await nsd.getMetrics(discovery: Discovery('foo'), reset: true);
+
+      expect(capturedArguments, {'handle': 'foo', 'metrics.reset': true});
+      expect(metrics.operations['browseFirstResult']!.latency.p99,
+          const Duration(microseconds: 1500));
+      expect(metrics.callbacks['serviceDiscovered']!.statuses, {0: 2, 1460: 1});
+      expect(metrics.callbacks['serviceDiscovered']!.dropped, 1);
+      expect(metrics.drainDelay, isNull);
+      expect(metrics.resolveCache, isNull);
+    });
+
+    test('Resolve cache metrics are decoded', () async {
+      nsd.supportsMetrics = true;
+
+      mockHandlers['getMetrics'] = (handle, arguments) => {
+            'operations': {},
+            'callbacks': {},
+            'resolveCache': {'hits': 3, 'staleHits': 1, 'misses': 2},
+          };
+
+      final resolveCache = (await nsd.getMetrics()).resolveCache!;
+
+      expect(resolveCache.hits, 3);
+      expect(resolveCache.staleHits, 1);
+      expect(resolveCache.misses, 2);
+    });
+
+    test('Metrics are not supported on other platforms', () async {
+      nsd.supportsMetrics = false;
+
+      expect(
+          nsd.getMetrics(),
+          throwsA(isA<NsdError>().having((e) => e.cause, 'error cause',
+              ErrorCause.operationNotSupported)));
+    });
+  });
+
+  group('$MethodChannelNsdPlatform tracing', () {
+    test('Trace is dumped as returned by native code', () async {
+      nsd.supportsTracing = true;
+
+      final calls = <MethodCall>[];
+      const trace = '{"traceEvents":[]}';
+
+      // tracing calls carry no handle
+      TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+          .setMockMethodCallHandler(methodChannel, (methodCall) async {
+        calls.add(methodCall);
+        return methodCall.method == 'dumpTrace' ? trace : null;
+      });
+
+      await nsd.setTracing(true, capacity: 1000);
+      expect(await nsd.dumpTrace(clear: true), trace);
+
+      expect(calls.map((call) => call.method), ['setTracing', 'dumpTrace']);
+      expect(
+          calls[0].arguments, {'trace.enabled': true, 'trace.capacity': 1000});
+      expect(calls[1].arguments, {'trace.clear': true});
+    });
+
+    test('Tracing is not supported on other platforms', () async {
+      nsd.supportsTracing = false;
+
+      expect(
+          nsd.dumpTrace(),
+          throwsA(isA<NsdError>().having((e) => e.cause, 'error cause',
+              ErrorCause.operationNotSupported)));
+    });
+  });
+
   group('$MethodChannelNsdPlatform resolve', () {
     test('Resolve succeeds if native code reports success', () async {
       mockHandlers['resolve'] = (handle, arguments) {
@@ -391,6 +870,26 @@ void main() {
       expect(result.txt, {'string': utf8encoder.convert('κόσμε')});
     });
 
+    test('Resolve uses addresses returned by native code', () async {
+      late dynamic capturedArguments;
+
+      mockHandlers['resolve'] = (handle, arguments) {
+        capturedArguments = arguments;
+        mockReply('onResolveSuccessful', {
+          ...serializeHandle(handle),
+          ...serializeService(const Service(
+              name: 'Some name', type: '_foo._tcp', host: 'bar', port: 42)),
+          'service.addresses': ['192.168.0.1'],
+        });
+      };
+
+      const service = Service(name: 'Some name', type: '_foo._tcp');
+      final result = await nsd.resolve(service, ipLookupType: IpLookupType.v4);
+
+      expect(capturedArguments['ip.lookupType'], 'v4');
+      expect(result.addresses, [InternetAddress('192.168.0.1')]);
+    });
+
     test('Resolve fails if native code reports failure', () async {
       mockHandlers['resolve'] = (handle, arguments) {
         // return service info with name only
@@ -410,6 +909,40 @@ void main() {
       expect(nsd.resolve(service), throwsA(matcher));
     });
 
+    test('Resolve fails if it is cancelled', () async {
+      final cancelledHandles = <String>[];
+      final resolveHandles = <String>[];
+
+      // never answer, the resolves stay pending
+      mockHandlers['resolve'] = (handle, arguments) {
+        resolveHandles.add(handle);
+      };
+
+      mockHandlers['cancelResolve'] = (handle, arguments) {
+        cancelledHandles.add(handle);
+      };
+
+      const service = Service(name: 'Some name', type: '_foo._tcp');
+      final cancelled = nsd.resolve(service);
+      final other = nsd.resolve(service);
+
+      final matcher = isA<NsdError>()
+          .having((e) => e.cause, 'error cause', ErrorCause.cancelled);
+      final expectation = expectLater(cancelled, throwsA(matcher));
+
+      await nsd.cancelResolve(cancelled);
+      await expectation;
+
+      // the other resolve of the same service carries on
+      expect(cancelledHandles, [cancelled.id]);
+      expect(resolveHandles, [cancelled.id, other.id]);
+
+      await mockReply('onResolveSuccessful',
+          {...serializeHandle(other.id), ...serializeService(service)});
+
+      expect((await other).name, service.name);
+    });
+
     test('Resolve fails if service type is invalid', () async {
       const service = Service(name: 'Some name', type: 'foo');
 
@@ -515,6 +1048,66 @@ void main() {
 
       expect(nsd.unregister(registration), throwsA(matcher));
     });
+
+    test('Bulk registration reports one result per service', () async {
+      nsd.supportsBulkRegistration = true;
+
+      // simulate the native side registering the whole list in one call
+      mockHandlers['registerMany'] = (handle, arguments) {
+        final registrations =
+            List<dynamic>.from(Map.from(arguments)['registrations']);
+        mockReply('onRegisterManyComplete', {
+          ...serializeHandle(handle),
+          'results': registrations
+              .map((registration) => Map<String, dynamic>.from(registration))
+              .toList(),
+        });
+      };
+
+      for (final count in [1, 100, 1000]) {
+        final services = [
+          for (var i = 0; i < count; i++)
+            Service(name: 'Some name $i', type: '_foo._tcp', port: 1000 + i)
+        ];
+
+        final results = await nsd.registerMany(services);
+
+        expect(results.length, count);
+        expect(results.every((result) => result.isSuccessful), isTrue);
+        expect(
+            results.last.registration!.service.name, 'Some name ${count - 1}');
+        expect(results.map((result) => result.registration!.id).toSet().length,
+            count);
+      }
+    });
+
+    test('Bulk unregistration reports failures per service', () async {
+      nsd.supportsBulkRegistration = true;
+
+      mockHandlers['unregisterMany'] = (handle, arguments) {
+        final handles = List<String>.from(Map.from(arguments)['handles']);
+        mockReply('onUnregisterManyComplete', {
+          ...serializeHandle(handle),
+          'results': [
+            serializeHandle(handles[0]),
+            {
+              ...serializeHandle(handles[1]),
+              ...serializeErrorCause(ErrorCause.illegalArgument),
+              ...serializeErrorMessage('Unknown handle')
+            },
+          ],
+        });
+      };
+
+      final results = await nsd.unregisterMany([
+        Registration('a', const Service(name: 'A', type: '_foo._tcp')),
+        Registration('b', const Service(name: 'B', type: '_foo._tcp')),
+      ]);
+
+      expect(results[0].isSuccessful, isTrue);
+      expect(results[1].error?.cause, ErrorCause.illegalArgument);
+      expect(results[1].registration?.id, 'b');
+    });
   });
 
   group('$MethodChannelNsdPlatform native code api', () {
@@ -535,6 +1128,193 @@ void main() {
     });
   });
 
+  group('$NsdMessageCodec', () {
+    const recordCodec = StandardMethodCodec(_EventRecordEncoder());
+
+    test('Event records are decoded into services', () async {
+      late String capturedHandle;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      final discovery =
+          await nsd.startDiscovery('_foo._tcp', autoResolve: false);
+
+      await mockReply(
+          'onServiceDiscovered',
+          _EventRecord({
+            ...serializeHandle(capturedHandle),
+            'service.name': 'Some name',
+            'service.type': '_foo._tcp',
+            'service.port': 56000,
+            'service.txt.raw':
+                Uint8List.fromList([3, ...utf8encoder.convert('a=b')]),
+          }),
+          codec: recordCodec);
+
+      final service = discovery.services.single;
+      expect(service.name, 'Some name');
+      expect(service.port, 56000);
+      expect(service.txt?['a'], utf8encoder.convert('b'));
+    });
+
+    test('Lists of event records are decoded', () async {
+      late String capturedHandle;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      final discovery = await nsd.startDiscovery('_foo._tcp',
+          autoResolve: false, batchSize: 2);
+
+      await mockReply(
+          'onServicesChanged',
+          _EventRecord({
+            ...serializeHandle(capturedHandle),
+            'service.changes': [
+              for (final name in ['Foo', 'Bar'])
+                _EventRecord({
+                  'service.name': name,
+                  'service.type': '_foo._tcp',
+                  ...serializeServiceStatus(ServiceStatus.found),
+                })
+            ],
+          }),
+          codec: recordCodec);
+
+      expect(discovery.services.map((service) => service.name),
+          unorderedEquals(['Foo', 'Bar']));
+    });
+
+    // same bytes as the C++ codec test, see test/golden/event_records.txt
+    test('Golden event records are decoded', () async {
+      final records = _readGoldenEventRecords();
+
+      final discovered = records['discovered']!;
+      expect(discovered.handle, 'h1');
+      expect(discovered.resolved, isTrue);
+      final service = discovered.service!;
+      expect(service.name, 'Printer');
+      expect(service.type, '_ipp._tcp');
+      expect(service.host, 'printer.local');
+      expect(service.port, 631);
+      expect(service.txt, isA<RawTxt>());
+      expect(service.txt?['rp'], utf8encoder.convert('ip'));
+      expect(service.addresses,
+          [InternetAddress('192.168.1.23'), InternetAddress('fe80::1')]);
+      expect(service.interfaceIndex, 3);
+
+      final failed = records['failed']!;
+      expect(failed.handle, 'h2');
+      expect(failed.service, isNull);
+      expect(failed.error?.cause, ErrorCause.timeout);
+      expect(failed.error?.message, 'Timed out');
+
+      final changes = records['changes']!.changes!;
+      expect(changes.map((change) => change.service?.name),
+          ['Printer', 'Scanner']);
+      expect(changes.map((change) => change.status),
+          [ServiceStatus.found, ServiceStatus.lost]);
+
+      expect(records['types']!.serviceTypes,
+          {'_http._tcp': 2, '_ipp._tcp': null});
+
+      final results = records['results']!.results!;
+      expect(results.map((result) => result.handle), ['a', 'b']);
+      expect(results[0].error, isNull);
+      expect(results[0].service?.port, 631);
+      expect(results[0].service?.txt, isEmpty);
+      expect(results[1].service, isNull);
+      expect(results[1].error?.cause, ErrorCause.illegalArgument);
+
+      final streamed = records['streamed']!;
+      expect(streamed.event, 'onServiceLost');
+      expect(streamed.service?.name, 'Printer');
+    });
+
+    test('Unknown event record keys are rejected', () async {
+      final bytes = Uint8List.fromList(
+          [NsdMessageCodec.eventRecordType, 0x00, 0x80]); // key 15
+      expect(
+          () => const NsdMessageCodec()
+              .decodeMessage(bytes.buffer.asByteData()),
+          throwsFormatException);
+    });
+  });
+
+  group('$NativeEventPort', () {
+    test('Port events are decoded like channel events', () async {
+      late String capturedHandle;
+
+      mockHandlers['startDiscovery'] = (handle, arguments) {
+        capturedHandle = handle;
+        mockReply('onDiscoveryStartSuccessful', serializeHandle(handle));
+      };
+
+      final discovery = await nsd.startDiscovery('_foo._tcp',
+          autoResolve: false, batchSize: 2);
+
+      // [method, record]; lists, maps and records start with a container tag
+      await nsd.handleMethodCall(decodePortEvent([
+        'onServicesChanged',
+        [
+          2, // record
+          1 | 1 << 10, // handle, service.changes
+          capturedHandle,
+          [
+            0, // list
+            for (final name in ['Foo', 'Bar'])
+              [
+                2, // record
+                1 << 1 | 1 << 2 | 1 << 5 | 1 << 9, // name, type, txt, status
+                name,
+                '_foo._tcp',
+                Uint8List.fromList([3, ...utf8encoder.convert('a=b')]),
+                serializeServiceStatus(ServiceStatus.found)['service.status'],
+              ]
+          ],
+        ],
+      ]));
+
+      expect(discovery.services.map((service) => service.name),
+          unorderedEquals(['Foo', 'Bar']));
+      expect(discovery.services.first.txt?['a'], utf8encoder.convert('b'));
+    });
+
+    test('Port records are decoded into event records', () async {
+      final call = decodePortEvent([
+        'onResolveFailed',
+        [
+          2, // record
+          1 | 1 << 12 | 1 << 13, // handle, error.cause, error.message
+          'h2',
+          'timeout',
+          'Timed out',
+        ],
+      ]);
+
+      final record = call.arguments as EventRecord;
+      expect(record.handle, 'h2');
+      expect(record.service, isNull);
+      expect(record.error?.cause, ErrorCause.timeout);
+      expect(() => decodePortEvent(['onResolveFailed', [2, 1 << 15]]),
+          throwsFormatException);
+    });
+
+    test('Native port transport fails without native support', () async {
+      nsd.supportsNativeEventPort = false;
+
+      expect(
+          nsd.setEventTransport(EventTransport.nativePort),
+          throwsA(isA<NsdError>().having((e) => e.cause, 'error cause',
+              ErrorCause.operationNotSupported)));
+    });
+  });
+
   group('$NsdPlatformInterface', () {
     test('Verify default platform', () async {
       expect(NsdPlatformInterface.instance, isA<MethodChannelNsdPlatform>());
@@ -574,6 +1354,35 @@ void main() {
     });
   });
 
+  group('$RawTxt', () {
+    test('Binary values survive deserialization', () async {
+      final value = Uint8List.fromList([0, 128, 255, 61]); // not UTF-8
+      final bytes = Uint8List.fromList([
+        ...[4 + value.length, ...utf8encoder.convert('bin='), ...value],
+        ...[4, ...utf8encoder.convert('flag')],
+        ...[6, ...utf8encoder.convert('empty=')],
+        ...[6, ...utf8encoder.convert('flag=x')], // duplicate, ignored
+        ...[2, ...utf8encoder.convert('=x')], // no key, ignored
+      ]);
+
+      final service = deserializeService({'service.txt.raw': bytes})!;
+      final txt = service.txt!;
+
+      expect(txt, isA<RawTxt>());
+      expect(txt.keys, ['bin', 'flag', 'empty']);
+      expect(txt['bin'], value);
+      expect(txt.containsKey('flag'), isTrue);
+      expect(txt['flag'], isNull);
+      expect(txt['empty'], isNull);
+    });
+
+    test('Truncated data is clipped', () async {
+      final bytes = Uint8List.fromList([9, ...utf8encoder.convert('key=va')]);
+
+      expect(RawTxt(bytes)['key'], utf8encoder.convert('va'));
+    });
+  });
+
   group('$Discovery', () {
     test('Attributes are contained in text rendering', () async {
       const service = Service(name: 'Some name', type: '_foo._tcp');
@@ -598,8 +1407,8 @@ void main() {
   });
 }
 
-Future<dynamic> mockReply(String method, dynamic arguments) async {
-  const codec = StandardMethodCodec();
+Future<dynamic> mockReply(String method, dynamic arguments,
+    {MethodCodec codec = const StandardMethodCodec()}) async {
   final dataIn = codec.encodeMethodCall(MethodCall(method, arguments));
 
   final completer = Completer<ByteData?>();
@@ -613,3 +1422,65 @@ Future<dynamic> mockReply(String method, dynamic arguments) async {
     return codec.decodeEnvelope(envelope);
   }
 }
+
+void mockDiscoveryStream(String handle,
+    {required void Function(MockStreamHandlerEventSink events) onListen,
+    void Function()? onCancel}) {
+  TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger
+      .setMockStreamHandler(
+          EventChannel('$channelName/discovery/$handle'),
+          MockStreamHandler.inline(
+              onListen: (arguments, events) => onListen(events),
+              onCancel: (arguments) => onCancel?.call()));
+}
+
+// golden event records by name, decoded
+Map<String, EventRecord> _readGoldenEventRecords() {
+  final records = <String, EventRecord>{};
+  for (final line in File('test/golden/event_records.txt').readAsLinesSync()) {
+    final colon = line.indexOf(':');
+    if (line.startsWith('#') || colon < 0) {
+      continue;
+    }
+
+    final bytes = Uint8List.fromList(line
+        .substring(colon + 1)
+        .trim()
+        .split(' ')
+        .map((byte) => int.parse(byte, radix: 16))
+        .toList());
+    records[line.substring(0, colon)] =
+        const NsdMessageCodec().decodeMessage(bytes.buffer.asByteData());
+  }
+  return records;
+}
+
+// event record as sent by the Windows plugin, see NsdMessageCodec
+class _EventRecord {
+  final Map<String, dynamic> values;
+
+  const _EventRecord(this.values);
+}
+
+class _EventRecordEncoder extends StandardMessageCodec {
+  const _EventRecordEncoder();
+
+  @override
+  void writeValue(WriteBuffer buffer, dynamic value) {
+    if (value is! _EventRecord) {
+      super.writeValue(buffer, value);
+      return;
+    }
+
+    final tags = value.values.keys.map(eventRecordKeys.indexOf).toList()
+      ..sort();
+    final keys = tags.fold(0, (keys, tag) => keys | (1 << tag));
+
+    buffer.putUint8(NsdMessageCodec.eventRecordType);
+    buffer.putUint8(keys & 0xFF);
+    buffer.putUint8(keys >> 8);
+    for (final tag in tags) {
+      writeValue(buffer, value.values[eventRecordKeys[tag]]);
+    }
+  }
+}
@@ -0,0 +1,111 @@
+#include "address_resolution.h"
+#include "service_table.h"
+
+#include <algorithm>
+
+namespace nsd_windows {
+
+	namespace {
+
+		bool IsRequested(const AddressFamily family, const IpLookupType lookupType) {
+			switch (lookupType) {
+			case IpLookupType::V4:
+				return family == AddressFamily::V4;
+			case IpLookupType::V6:
+				return family == AddressFamily::V6;
+			default:
+				return true;
+			}
+		}
+
+		bool Contains(const std::vector<std::string>& addresses, const std::string& address) {
+			return std::find(addresses.begin(), addresses.end(), address) != addresses.end();
+		}
+	}
+
+	std::optional<IpLookupType> ParseIpLookupType(const std::string_view value)
+	{
+		if (value == "none") {
+			return IpLookupType::NONE;
+		}
+		if (value == "v4") {
+			return IpLookupType::V4;
+		}
+		if (value == "v6") {
+			return IpLookupType::V6;
+		}
+		if (value == "any") {
+			return IpLookupType::ANY;
+		}
+		return std::nullopt;
+	}
+
+	IpLookupType CombineIpLookupTypes(const IpLookupType a, const IpLookupType b)
+	{
+		if (a == b || b == IpLookupType::NONE) {
+			return a;
+		}
+		if (a == IpLookupType::NONE) {
+			return b;
+		}
+		return IpLookupType::ANY; // V4 + V6 or either + ANY
+	}
+
+	AddressFamily GetAddressFamily(const std::string_view address)
+	{
+		return (address.find(':') != std::string_view::npos) ? AddressFamily::V6 : AddressFamily::V4;
+	}
+
+	std::vector<std::string> ExtractAddresses(const std::vector<AddressRecord>& records, const std::string_view hostName, const IpLookupType lookupType)
+	{
+		std::vector<std::string> addresses;
+
+		for (const auto& record : records) {
+			if (EqualsDnsName(record.owner, hostName) && IsRequested(record.family, lookupType) && !Contains(addresses, record.address)) {
+				addresses.push_back(record.address);
+			}
+		}
+		return addresses;
+	}
+
+	std::vector<std::string> FilterAddresses(const std::vector<std::string>& addresses, const IpLookupType lookupType)
+	{
+		std::vector<std::string> filtered;
+
+		for (const auto& address : addresses) {
+			if (IsRequested(GetAddressFamily(address), lookupType)) {
+				filtered.push_back(address);
+			}
+		}
+		return filtered;
+	}
+
+	void MergeAddresses(std::vector<std::string>& target, const std::vector<std::string>& source)
+	{
+		for (const auto& address : source) {
+			if (!Contains(target, address)) {
+				target.push_back(address);
+			}
+		}
+	}
+
+	std::vector<AddressFamily> GetMissingAddressFamilies(const std::vector<std::string>& addresses, const IpLookupType lookupType)
+	{
+		auto hasFamily = [&addresses](const AddressFamily family) -> bool {
+			return std::any_of(addresses.begin(), addresses.end(), [family](const std::string& address) -> bool {
+				return GetAddressFamily(address) == family;
+				});
+		};
+
+		switch (lookupType) {
+		case IpLookupType::V4:
+			return hasFamily(AddressFamily::V4) ? std::vector<AddressFamily>() : std::vector<AddressFamily>{ AddressFamily::V4 };
+		case IpLookupType::V6:
+			return hasFamily(AddressFamily::V6) ? std::vector<AddressFamily>() : std::vector<AddressFamily>{ AddressFamily::V6 };
+		case IpLookupType::ANY:
+			return addresses.empty() ? std::vector<AddressFamily>{ AddressFamily::V4, AddressFamily::V6 } : std::vector<AddressFamily>();
+		default:
+			return {};
+		}
+	}
+}
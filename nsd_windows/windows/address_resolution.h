@@ -0,0 +1,51 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nsd_windows {
+
+	// mirrors IpLookupType on the dart side
+	enum class IpLookupType {
+		NONE,
+		V4,
+		V6,
+		ANY
+	};
+
+	enum class AddressFamily {
+		V4,
+		V6
+	};
+
+	// address record independent of the DNS API, so the logic below can be exercised with canned records
+	struct AddressRecord {
+
+		std::string owner; // host name the address belongs to
+		AddressFamily family;
+		std::string address; // textual representation, see ip_address.h
+	};
+
+	// accepts the dart enum names ("none", "v4", "v6", "any")
+	std::optional<IpLookupType> ParseIpLookupType(const std::string_view value);
+
+	// lookup type that satisfies both
+	IpLookupType CombineIpLookupTypes(const IpLookupType a, const IpLookupType b);
+
+	AddressFamily GetAddressFamily(const std::string_view address);
+
+	// addresses owned by the given host, in record order and without duplicates;
+	// IpLookupType::NONE doesn't restrict the families
+	std::vector<std::string> ExtractAddresses(const std::vector<AddressRecord>& records, const std::string_view hostName, const IpLookupType lookupType);
+
+	// removes addresses of families the lookup type doesn't ask for
+	std::vector<std::string> FilterAddresses(const std::vector<std::string>& addresses, const IpLookupType lookupType);
+
+	// appends the addresses that target doesn't contain yet
+	void MergeAddresses(std::vector<std::string>& target, const std::vector<std::string>& source);
+
+	// families that have to be queried because the known addresses don't satisfy the lookup type
+	std::vector<AddressFamily> GetMissingAddressFamilies(const std::vector<std::string>& addresses, const IpLookupType lookupType);
+}
@@ -0,0 +1,279 @@
+#include "dns_message.h"
+#include "dns_message_view.h"
+#include "nsd_error.h"
+#include "service_table.h"
+
+#include <cctype>
+#include <map>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr size_t kMaxLabelLength = 63;
+		constexpr uint16_t kMaxCompressionOffset = 0x3FFF;
+
+		// value of the \DDD escape starting at the backslash at i, which may exceed a byte; -1 if there is none
+		int GetDecimalEscape(const std::string_view name, const size_t i)
+		{
+			if (name[i] != '\\' || i + 3 >= name.size()) {
+				return -1;
+			}
+
+			int value = 0;
+			for (size_t j = i + 1; j <= i + 3; j++) {
+				if (!isdigit(static_cast<unsigned char>(name[j]))) {
+					return -1;
+				}
+				value = value * 10 + (name[j] - '0');
+			}
+			return value;
+		}
+
+		class Writer {
+		public:
+
+			std::vector<uint8_t> buffer;
+
+			void WriteU16(const uint16_t value) {
+				buffer.push_back(static_cast<uint8_t>(value >> 8));
+				buffer.push_back(static_cast<uint8_t>(value));
+			}
+
+			void WriteU32(const uint32_t value) {
+				WriteU16(static_cast<uint16_t>(value >> 16));
+				WriteU16(static_cast<uint16_t>(value));
+			}
+
+			void WriteBytes(const std::vector<uint8_t>& bytes) {
+				buffer.insert(buffer.end(), bytes.begin(), bytes.end());
+			}
+
+			void WriteName(const std::string_view name) {
+
+				const auto labels = SplitDnsName(name);
+
+				for (size_t i = 0; i < labels.size(); i++) {
+
+					std::string suffix;
+					for (size_t j = i; j < labels.size(); j++) {
+						suffix += ToLowerDnsName(EscapeDnsLabel(labels[j])) + '.';
+					}
+
+					auto it = suffixes.find(suffix);
+					if (it != suffixes.end()) {
+						WriteU16(static_cast<uint16_t>(0xC000 | it->second));
+						return;
+					}
+
+					if (buffer.size() <= kMaxCompressionOffset) {
+						suffixes[suffix] = static_cast<uint16_t>(buffer.size());
+					}
+
+					const auto& label = labels[i];
+					if (label.empty() || label.size() > kMaxLabelLength) {
+						throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Invalid DNS label: " + label);
+					}
+
+					buffer.push_back(static_cast<uint8_t>(label.size()));
+					buffer.insert(buffer.end(), label.begin(), label.end());
+				}
+
+				buffer.push_back(0);
+			}
+
+		private:
+
+			std::map<std::string, uint16_t> suffixes; // lower case suffix -> offset, for compression
+		};
+
+		void WriteRecord(Writer& writer, const DnsRecord& record) {
+
+			writer.WriteName(record.name);
+			writer.WriteU16(static_cast<uint16_t>(record.type));
+			writer.WriteU16(record.rrclass | (record.cacheFlush ? kMdnsClassFlag : 0));
+			writer.WriteU32(record.ttl);
+
+			const auto lengthOffset = writer.buffer.size();
+			writer.WriteU16(0); // rdata length, patched below
+
+			switch (record.type) {
+			case DnsType::PTR:
+				writer.WriteName(record.target);
+				break;
+
+			case DnsType::SRV:
+				writer.WriteU16(record.priority);
+				writer.WriteU16(record.weight);
+				writer.WriteU16(record.port);
+				writer.WriteName(record.target); // compression is allowed here in mDNS, see https://datatracker.ietf.org/doc/html/rfc6762#section-18.14
+				break;
+
+			default:
+				writer.WriteBytes(record.data);
+				break;
+			}
+
+			const auto length = writer.buffer.size() - lengthOffset - 2;
+			writer.buffer[lengthOffset] = static_cast<uint8_t>(length >> 8);
+			writer.buffer[lengthOffset + 1] = static_cast<uint8_t>(length);
+		}
+	}
+
+	bool DnsRecord::IsSameRecord(const DnsRecord& other) const
+	{
+		return
+			type == other.type &&
+			rrclass == other.rrclass &&
+			EqualsDnsName(name, other.name) &&
+			EqualsDnsName(target, other.target) &&
+			priority == other.priority &&
+			weight == other.weight &&
+			port == other.port &&
+			data == other.data;
+	}
+
+	size_t EstimateDnsRecordSize(const DnsRecord& record)
+	{
+		return record.name.size() + 2 + 10 + record.target.size() + 2 + 6 + record.data.size();
+	}
+
+	bool DnsMessage::IsResponse() const
+	{
+		return (flags & kDnsFlagResponse) != 0;
+	}
+
+	std::optional<DnsMessage> ParseDnsMessage(const uint8_t* data, const size_t size)
+	{
+		auto view = DnsMessageView::Parse(data, size);
+		if (!view.has_value()) {
+			return std::nullopt;
+		}
+
+		DnsMessage message;
+		message.id = view->GetId();
+		message.flags = view->GetFlags();
+
+		for (const auto& question : view->GetQuestions()) {
+			message.questions.push_back({ question.name.ToString(), question.type, question.unicastResponse });
+		}
+
+		for (const auto& record : view->GetAnswers()) {
+			message.answers.push_back(record.ToRecord());
+		}
+
+		for (const auto& record : view->GetAuthorities()) {
+			message.authorities.push_back(record.ToRecord());
+		}
+
+		for (const auto& record : view->GetAdditionals()) {
+			message.additionals.push_back(record.ToRecord());
+		}
+
+		return message;
+	}
+
+	std::vector<uint8_t> SerializeDnsMessage(const DnsMessage& message)
+	{
+		Writer writer;
+
+		writer.WriteU16(message.id);
+		writer.WriteU16(message.flags);
+		writer.WriteU16(static_cast<uint16_t>(message.questions.size()));
+		writer.WriteU16(static_cast<uint16_t>(message.answers.size()));
+		writer.WriteU16(static_cast<uint16_t>(message.authorities.size()));
+		writer.WriteU16(static_cast<uint16_t>(message.additionals.size()));
+
+		for (const auto& question : message.questions) {
+			writer.WriteName(question.name);
+			writer.WriteU16(static_cast<uint16_t>(question.type));
+			writer.WriteU16(kDnsClassIn | (question.unicastResponse ? kMdnsClassFlag : 0));
+		}
+
+		for (const auto* section : { &message.answers, &message.authorities, &message.additionals }) {
+			for (const auto& record : *section) {
+				WriteRecord(writer, record);
+			}
+		}
+
+		return writer.buffer;
+	}
+
+	std::vector<std::string> SplitDnsName(const std::string_view name)
+	{
+		std::vector<std::string> labels;
+		std::string label;
+
+		for (size_t i = 0; i < name.size(); i++) {
+
+			const auto c = name[i];
+			const auto value = GetDecimalEscape(name, i);
+
+			if (value >= 0 && value <= 0xFF) {
+				label += static_cast<char>(value); // \DDD
+				i += 3;
+			}
+			else if (c == '\\' && i + 1 < name.size()) {
+				label += name[++i];
+			}
+			else if (c == '.') {
+				labels.push_back(std::move(label));
+				label.clear();
+			}
+			else {
+				label += c;
+			}
+		}
+
+		if (!label.empty()) {
+			labels.push_back(std::move(label)); // a trailing dot denotes the root
+		}
+		return labels;
+	}
+
+	std::optional<std::string> UnescapeDnsLabel(const std::string_view label)
+	{
+		if (label.find('\\') == std::string_view::npos) {
+			return std::string(label);
+		}
+
+		std::string unescaped;
+		unescaped.reserve(label.size());
+
+		for (size_t i = 0; i < label.size(); i++) {
+
+			const auto c = label[i];
+			const auto value = GetDecimalEscape(label, i);
+
+			if (value > 0xFF) {
+				return std::nullopt; // doesn't fit into an octet
+			}
+
+			if (value >= 0) {
+				unescaped += static_cast<char>(value); // \DDD
+				i += 3;
+			}
+			else if (c == '\\' && i + 1 < label.size()) {
+				unescaped += label[++i];
+			}
+			else {
+				unescaped += c;
+			}
+		}
+		return unescaped;
+	}
+
+	std::string EscapeDnsLabel(const std::string_view label)
+	{
+		std::string escaped;
+		escaped.reserve(label.size());
+
+		for (const auto c : label) {
+			if (c == '.' || c == '\\') {
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+}
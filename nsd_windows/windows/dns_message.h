@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nsd_windows {
+
+	// record types used by DNS-SD, see https://datatracker.ietf.org/doc/html/rfc6763
+	enum class DnsType : uint16_t {
+		A = 1,
+		PTR = 12,
+		TXT = 16,
+		AAAA = 28,
+		SRV = 33,
+		NSEC = 47,
+		ANY = 255,
+	};
+
+	constexpr uint16_t kDnsClassIn = 1;
+
+	// top bit of the class field: "cache flush" in records, "unicast response" in questions,
+	// see https://datatracker.ietf.org/doc/html/rfc6762#section-10.2
+	constexpr uint16_t kMdnsClassFlag = 0x8000;
+
+	constexpr uint16_t kDnsFlagResponse = 0x8000;
+
+	struct DnsQuestion {
+
+		std::string name; // presentation format, see SplitDnsName()
+		DnsType type;
+		bool unicastResponse = false;
+	};
+
+	struct DnsRecord {
+
+		std::string name; // presentation format, see SplitDnsName()
+		DnsType type;
+		uint16_t rrclass = kDnsClassIn; // without the cache flush bit
+		bool cacheFlush = false;
+		uint32_t ttl = 0; // seconds
+
+		std::string target; // PTR, SRV
+		uint16_t priority = 0; // SRV
+		uint16_t weight = 0; // SRV
+		uint16_t port = 0; // SRV
+		std::vector<uint8_t> data; // TXT rdata as is, A / AAAA address bytes, raw rdata of other types
+
+		// same name, type, class and rdata; the TTL doesn't count
+		bool IsSameRecord(const DnsRecord& other) const;
+	};
+
+	struct DnsMessage {
+
+		uint16_t id = 0; // zero for multicast, see https://datatracker.ietf.org/doc/html/rfc6762#section-18.1
+		uint16_t flags = 0;
+		std::vector<DnsQuestion> questions;
+		std::vector<DnsRecord> answers;
+		std::vector<DnsRecord> authorities;
+		std::vector<DnsRecord> additionals;
+
+		bool IsResponse() const;
+	};
+
+	constexpr size_t kDnsHeaderSize = 12;
+
+	// upper bound of the wire size of a record, compression only makes it smaller
+	size_t EstimateDnsRecordSize(const DnsRecord& record);
+
+	// returns nullopt if the message is malformed; copies everything, see DnsMessageView for parsing in place
+	std::optional<DnsMessage> ParseDnsMessage(const uint8_t* data, const size_t size);
+
+	// repeated name suffixes are compressed
+	std::vector<uint8_t> SerializeDnsMessage(const DnsMessage& message);
+
+	// names are kept in presentation format, dots and backslashes within labels are escaped with a backslash,
+	// e.g. "My\.Printer._http._tcp.local" (see https://datatracker.ietf.org/doc/html/rfc1035#section-5.1);
+	// SplitDnsName() takes a \DDD escape beyond 255 as an escaped digit followed by two digits
+	std::vector<std::string> SplitDnsName(const std::string_view name);
+	std::string EscapeDnsLabel(const std::string_view label);
+
+	// returns nullopt if a \DDD escape is beyond 255; only for names from the built-in mDNS querier and
+	// responder, the Windows DNS API doesn't escape names
+	std::optional<std::string> UnescapeDnsLabel(const std::string_view label);
+}
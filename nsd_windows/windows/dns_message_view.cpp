@@ -0,0 +1,447 @@
+#include "dns_message_view.h"
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr size_t kMaxNameLength = 255; // wire format, see https://datatracker.ietf.org/doc/html/rfc1035#section-2.3.4
+		constexpr int kMaxCompressionJumps = 32;
+
+		uint16_t GetU16(const uint8_t* data) {
+			return static_cast<uint16_t>((data[0] << 8) | data[1]);
+		}
+
+		uint32_t GetU32(const uint8_t* data) {
+			return (static_cast<uint32_t>(GetU16(data)) << 16) | GetU16(data + 2);
+		}
+
+		char ToLowerAscii(const char c) {
+			return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+		}
+
+		bool IsDigit(const char c) {
+			return c >= '0' && c <= '9';
+		}
+
+		// validates the name at offset and returns where it ends in place; follows compression pointers,
+		// see https://datatracker.ietf.org/doc/html/rfc1035#section-4.1.4
+		bool SkipName(const uint8_t* data, const size_t size, const size_t offset, size_t& end) {
+
+			auto position = offset;
+			auto jumped = false;
+			auto jumps = 0;
+			size_t length = 1; // terminating zero
+
+			while (true) {
+
+				if (position >= size) {
+					return false;
+				}
+
+				const auto labelLength = data[position];
+
+				if ((labelLength & 0xC0) == 0xC0) {
+
+					if (position + 1 >= size) {
+						return false;
+					}
+
+					const size_t pointer = ((labelLength & 0x3F) << 8) | data[position + 1];
+
+					// pointers must point backwards past the header; together with the jump limit this rules out loops
+					if (pointer >= position || pointer < kDnsHeaderSize || ++jumps > kMaxCompressionJumps) {
+						return false;
+					}
+
+					if (!jumped) {
+						end = position + 2;
+						jumped = true;
+					}
+
+					position = pointer;
+					continue;
+				}
+
+				if ((labelLength & 0xC0) != 0) {
+					return false; // extended label types aren't used by mDNS
+				}
+
+				position++;
+
+				if (labelLength == 0) {
+					break;
+				}
+
+				length += labelLength + 1;
+				if (position + labelLength > size || length > kMaxNameLength) {
+					return false;
+				}
+				position += labelLength;
+			}
+
+			if (!jumped) {
+				end = position;
+			}
+			return true;
+		}
+
+		bool ValidateStrings(const uint8_t* data, const size_t size) {
+			size_t offset = 0;
+			while (offset < size) {
+				offset += 1 + data[offset];
+			}
+			return offset == size;
+		}
+
+		bool ValidateNsec(const uint8_t* packet, const size_t size, const size_t offset, const size_t rdataEnd) {
+
+			size_t position;
+			if (!SkipName(packet, size, offset, position) || position > rdataEnd) {
+				return false;
+			}
+
+			// window blocks: window number, bitmap length (1..32), bitmap
+			while (position < rdataEnd) {
+				if (position + 2 > rdataEnd) {
+					return false;
+				}
+				const auto length = packet[position + 1];
+				if (length == 0 || length > 32 || position + 2 + length > rdataEnd) {
+					return false;
+				}
+				position += 2 + length;
+			}
+			return true;
+		}
+
+		bool ValidateRdata(const DnsRecordView& record, const size_t size) {
+
+			const auto end = record.rdataOffset + record.rdataSize;
+			size_t nameEnd;
+
+			switch (record.type) {
+			case DnsType::PTR:
+				return SkipName(record.packet, size, record.rdataOffset, nameEnd) && nameEnd == end;
+
+			case DnsType::SRV:
+				return record.rdataSize > 6 && SkipName(record.packet, size, record.rdataOffset + 6, nameEnd) && nameEnd == end;
+
+			case DnsType::A:
+				return record.rdataSize == 4;
+
+			case DnsType::AAAA:
+				return record.rdataSize == 16;
+
+			case DnsType::TXT:
+				return ValidateStrings(record.GetRdata(), record.rdataSize);
+
+			case DnsType::NSEC:
+				return ValidateNsec(record.packet, size, record.rdataOffset, end);
+
+			default:
+				return true; // kept as raw rdata
+			}
+		}
+	}
+
+	DnsNameView::Iterator::Iterator(const uint8_t* packet, const size_t position) : packet(packet), position(position)
+	{
+		FollowPointers();
+	}
+
+	void DnsNameView::Iterator::FollowPointers()
+	{
+		while ((packet[position] & 0xC0) == 0xC0) {
+			position = ((packet[position] & 0x3F) << 8) | packet[position + 1];
+		}
+
+		if (packet[position] == 0) {
+			position = 0;
+		}
+	}
+
+	std::string_view DnsNameView::Iterator::operator*() const
+	{
+		return std::string_view(reinterpret_cast<const char*>(packet + position + 1), packet[position]);
+	}
+
+	DnsNameView::Iterator& DnsNameView::Iterator::operator++()
+	{
+		position += 1 + packet[position];
+		FollowPointers();
+		return *this;
+	}
+
+	DnsNameView::Iterator DnsNameView::begin() const
+	{
+		return packet == nullptr ? Iterator() : Iterator(packet, offset);
+	}
+
+	DnsNameView::Iterator DnsNameView::end() const
+	{
+		return Iterator();
+	}
+
+	bool DnsNameView::Equals(const std::string_view name) const
+	{
+		size_t i = 0;
+
+		for (const auto label : *this) {
+
+			for (const auto expected : label) {
+
+				if (i >= name.size() || name[i] == '.') {
+					return false;
+				}
+
+				char c = name[i++];
+
+				if (c == '\\' && i + 2 < name.size() && IsDigit(name[i]) && IsDigit(name[i + 1]) && IsDigit(name[i + 2])) {
+					c = static_cast<char>((name[i] - '0') * 100 + (name[i + 1] - '0') * 10 + (name[i + 2] - '0')); // \DDD
+					i += 3;
+				}
+				else if (c == '\\' && i < name.size()) {
+					c = name[i++];
+				}
+
+				if (ToLowerAscii(c) != ToLowerAscii(expected)) {
+					return false;
+				}
+			}
+
+			if (i < name.size()) {
+				if (name[i] != '.') {
+					return false; // the label goes on
+				}
+				i++;
+			}
+		}
+
+		return i == name.size();
+	}
+
+	void DnsNameView::AppendTo(std::string& name) const
+	{
+		auto first = true;
+
+		for (const auto label : *this) {
+
+			if (!first) {
+				name += '.';
+			}
+			first = false;
+
+			for (const auto c : label) {
+				if (c == '.' || c == '\\') {
+					name += '\\';
+				}
+				name += c;
+			}
+		}
+	}
+
+	std::string DnsNameView::ToString() const
+	{
+		std::string name;
+		AppendTo(name);
+		return name;
+	}
+
+	bool DnsNsecView::HasType(const DnsType type) const
+	{
+		const auto value = static_cast<uint16_t>(type);
+		const auto window = value >> 8;
+		const auto bit = value & 0xFF;
+
+		for (size_t position = 0; position < bitmapsSize; position += 2 + bitmaps[position + 1]) {
+
+			if (bitmaps[position] != window) {
+				continue;
+			}
+
+			const auto length = bitmaps[position + 1];
+			if (static_cast<size_t>(bit / 8) >= length) {
+				return false;
+			}
+
+			return (bitmaps[position + 2 + bit / 8] & (0x80 >> (bit % 8))) != 0;
+		}
+		return false;
+	}
+
+	DnsNameView DnsRecordView::GetPtrTarget() const
+	{
+		return DnsNameView(packet, rdataOffset);
+	}
+
+	DnsSrvView DnsRecordView::GetSrv() const
+	{
+		const auto rdata = GetRdata();
+
+		DnsSrvView srv;
+		srv.priority = GetU16(rdata);
+		srv.weight = GetU16(rdata + 2);
+		srv.port = GetU16(rdata + 4);
+		srv.target = DnsNameView(packet, rdataOffset + 6);
+		return srv;
+	}
+
+	DnsStringsView DnsRecordView::GetTxt() const
+	{
+		return DnsStringsView(GetRdata(), rdataSize);
+	}
+
+	DnsNsecView DnsRecordView::GetNsec() const
+	{
+		// the next name isn't compressed, see https://datatracker.ietf.org/doc/html/rfc4034#section-4.1.1
+		size_t position = rdataOffset;
+		while (packet[position] != 0 && (packet[position] & 0xC0) != 0xC0) {
+			position += 1 + packet[position];
+		}
+		position += packet[position] == 0 ? 1 : 2; // tolerate compression anyway
+
+		DnsNsecView nsec;
+		nsec.nextName = DnsNameView(packet, rdataOffset);
+		nsec.bitmaps = packet + position;
+		nsec.bitmapsSize = rdataOffset + rdataSize - position;
+		return nsec;
+	}
+
+	DnsRecord DnsRecordView::ToRecord() const
+	{
+		DnsRecord record;
+		record.name = name.ToString();
+		record.type = type;
+		record.rrclass = rrclass;
+		record.cacheFlush = cacheFlush;
+		record.ttl = ttl;
+
+		switch (type) {
+		case DnsType::PTR:
+			record.target = GetPtrTarget().ToString();
+			break;
+
+		case DnsType::SRV: {
+			const auto srv = GetSrv();
+			record.priority = srv.priority;
+			record.weight = srv.weight;
+			record.port = srv.port;
+			record.target = srv.target.ToString();
+			break;
+		}
+
+		default:
+			record.data.assign(GetRdata(), GetRdata() + rdataSize);
+			break;
+		}
+
+		return record;
+	}
+
+	bool ReadDnsQuestionView(const uint8_t* packet, const size_t size, const size_t offset, DnsQuestionView& question, size_t& next)
+	{
+		size_t position;
+		if (!SkipName(packet, size, offset, position) || position + 4 > size) {
+			return false;
+		}
+
+		const auto qclass = GetU16(packet + position + 2);
+
+		question.name = DnsNameView(packet, offset);
+		question.type = static_cast<DnsType>(GetU16(packet + position));
+		question.unicastResponse = (qclass & kMdnsClassFlag) != 0;
+		next = position + 4;
+		return true;
+	}
+
+	bool ReadDnsRecordView(const uint8_t* packet, const size_t size, const size_t offset, DnsRecordView& record, size_t& next)
+	{
+		size_t position;
+		if (!SkipName(packet, size, offset, position) || position + 10 > size) {
+			return false;
+		}
+
+		const auto rrclass = GetU16(packet + position + 2);
+
+		record.name = DnsNameView(packet, offset);
+		record.type = static_cast<DnsType>(GetU16(packet + position));
+		record.rrclass = rrclass & ~kMdnsClassFlag;
+		record.cacheFlush = (rrclass & kMdnsClassFlag) != 0;
+		record.ttl = GetU32(packet + position + 4);
+		record.packet = packet;
+		record.rdataSize = GetU16(packet + position + 8);
+		record.rdataOffset = position + 10;
+
+		next = record.rdataOffset + record.rdataSize;
+		return next <= size;
+	}
+
+	std::optional<DnsMessageView> DnsMessageView::Parse(const uint8_t* data, const size_t size)
+	{
+		if (size < kDnsHeaderSize) {
+			return std::nullopt;
+		}
+
+		DnsMessageView message(data, size);
+		size_t offset = kDnsHeaderSize;
+
+		for (auto section = 0; section < 4; section++) {
+
+			message.counts[section] = GetU16(data + 4 + section * 2);
+			message.offsets[section] = offset;
+
+			for (auto i = 0; i < message.counts[section]; i++) {
+
+				if (section == 0) {
+					DnsQuestionView question;
+					if (!ReadDnsQuestionView(data, size, offset, question, offset)) {
+						return std::nullopt;
+					}
+					continue;
+				}
+
+				DnsRecordView record;
+				if (!ReadDnsRecordView(data, size, offset, record, offset) || !ValidateRdata(record, size)) {
+					return std::nullopt;
+				}
+			}
+		}
+
+		return message;
+	}
+
+	uint16_t DnsMessageView::GetId() const
+	{
+		return GetU16(data);
+	}
+
+	uint16_t DnsMessageView::GetFlags() const
+	{
+		return GetU16(data + 2);
+	}
+
+	bool DnsMessageView::IsResponse() const
+	{
+		return (GetFlags() & kDnsFlagResponse) != 0;
+	}
+
+	DnsSectionView<DnsQuestionView> DnsMessageView::GetQuestions() const
+	{
+		return DnsSectionView<DnsQuestionView>(data, size, offsets[0], counts[0]);
+	}
+
+	DnsSectionView<DnsRecordView> DnsMessageView::GetAnswers() const
+	{
+		return DnsSectionView<DnsRecordView>(data, size, offsets[1], counts[1]);
+	}
+
+	DnsSectionView<DnsRecordView> DnsMessageView::GetAuthorities() const
+	{
+		return DnsSectionView<DnsRecordView>(data, size, offsets[2], counts[2]);
+	}
+
+	DnsSectionView<DnsRecordView> DnsMessageView::GetAdditionals() const
+	{
+		return DnsSectionView<DnsRecordView>(data, size, offsets[3], counts[3]);
+	}
+}
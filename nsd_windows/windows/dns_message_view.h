@@ -0,0 +1,249 @@
+#pragma once
+
+#include "dns_message.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace nsd_windows {
+
+	// non-owning views into a received packet, see DnsMessageView::Parse(); they don't allocate and stay valid
+	// as long as the packet buffer does
+
+	// a possibly compressed name; labels are returned as they are on the wire, without escaping
+	class DnsNameView {
+	public:
+
+		class Iterator {
+		public:
+
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = std::string_view;
+
+			Iterator() = default; // end
+
+			std::string_view operator*() const;
+			Iterator& operator++();
+			bool operator==(const Iterator& other) const { return position == other.position; }
+			bool operator!=(const Iterator& other) const { return position != other.position; }
+
+		private:
+
+			friend class DnsNameView;
+
+			Iterator(const uint8_t* packet, const size_t position);
+			void FollowPointers();
+
+			const uint8_t* packet = nullptr;
+			size_t position = 0; // of the current label's length byte, zero at the end (the header is never part of a name)
+		};
+
+		DnsNameView() = default;
+		DnsNameView(const uint8_t* packet, const size_t offset) : packet(packet), offset(offset) {} // name must be validated
+
+		Iterator begin() const;
+		Iterator end() const;
+
+		// case-insensitive, against a name in presentation format (see SplitDnsName())
+		bool Equals(const std::string_view name) const;
+
+		// presentation format, see SplitDnsName()
+		void AppendTo(std::string& name) const;
+		std::string ToString() const;
+
+	private:
+
+		const uint8_t* packet = nullptr;
+		size_t offset = 0;
+	};
+
+	// length prefixed strings, e.g. TXT rdata (see https://datatracker.ietf.org/doc/html/rfc1035#section-3.3.14)
+	class DnsStringsView {
+	public:
+
+		class Iterator {
+		public:
+
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const std::string_view*;
+			using reference = std::string_view;
+
+			Iterator(const uint8_t* position) : position(position) {}
+
+			std::string_view operator*() const { return std::string_view(reinterpret_cast<const char*>(position + 1), *position); }
+			Iterator& operator++() { position += 1 + *position; return *this; }
+			bool operator==(const Iterator& other) const { return position == other.position; }
+			bool operator!=(const Iterator& other) const { return position != other.position; }
+
+		private:
+
+			const uint8_t* position;
+		};
+
+		DnsStringsView(const uint8_t* data, const size_t size) : data(data), size(size) {} // strings must be validated
+
+		Iterator begin() const { return Iterator(data); }
+		Iterator end() const { return Iterator(data + size); }
+
+	private:
+
+		const uint8_t* data;
+		size_t size;
+	};
+
+	struct DnsSrvView {
+
+		uint16_t priority = 0;
+		uint16_t weight = 0;
+		uint16_t port = 0;
+		DnsNameView target;
+	};
+
+	// see https://datatracker.ietf.org/doc/html/rfc4034#section-4.1, mDNS uses it to assert non-existence
+	// (see https://datatracker.ietf.org/doc/html/rfc6762#section-6.1)
+	struct DnsNsecView {
+
+		DnsNameView nextName;
+		const uint8_t* bitmaps = nullptr;
+		size_t bitmapsSize = 0;
+
+		bool HasType(const DnsType type) const;
+	};
+
+	struct DnsQuestionView {
+
+		DnsNameView name;
+		DnsType type = DnsType::ANY;
+		bool unicastResponse = false;
+	};
+
+	// the rdata accessors must only be used for the matching type; the parser validated the rdata for them
+	struct DnsRecordView {
+
+		DnsNameView name;
+		DnsType type = DnsType::ANY;
+		uint16_t rrclass = kDnsClassIn; // without the cache flush bit
+		bool cacheFlush = false;
+		uint32_t ttl = 0; // seconds
+
+		const uint8_t* packet = nullptr;
+		size_t rdataOffset = 0;
+		uint16_t rdataSize = 0;
+
+		const uint8_t* GetRdata() const { return packet + rdataOffset; }
+
+		DnsNameView GetPtrTarget() const;
+		DnsSrvView GetSrv() const;
+		DnsStringsView GetTxt() const;
+		DnsNsecView GetNsec() const;
+		const uint8_t* GetAddress() const { return GetRdata(); } // A (4 bytes) or AAAA (16 bytes)
+
+		// copies the record, see ParseDnsMessage()
+		DnsRecord ToRecord() const;
+	};
+
+	// one section of a message; iterating decodes the entries in place
+	template <typename View>
+	class DnsSectionView {
+	public:
+
+		class Iterator {
+		public:
+
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = View;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const View*;
+			using reference = const View&;
+
+			Iterator(const uint8_t* packet, const size_t size, const size_t offset, const size_t remaining)
+				: packet(packet), size(size), remaining(remaining) { Read(offset); }
+
+			const View& operator*() const { return current; }
+			const View* operator->() const { return &current; }
+			Iterator& operator++() { remaining--; Read(next); return *this; }
+			bool operator==(const Iterator& other) const { return remaining == other.remaining; }
+			bool operator!=(const Iterator& other) const { return remaining != other.remaining; }
+
+		private:
+
+			const uint8_t* packet;
+			size_t size;
+			size_t remaining;
+			size_t next = 0;
+			View current;
+
+			void Read(const size_t offset);
+		};
+
+		DnsSectionView(const uint8_t* packet, const size_t size, const size_t offset, const size_t count)
+			: packet(packet), size(size), offset(offset), count(count) {}
+
+		Iterator begin() const { return Iterator(packet, size, offset, count); }
+		Iterator end() const { return Iterator(packet, size, offset, 0); }
+		size_t Size() const { return count; }
+
+	private:
+
+		const uint8_t* packet;
+		size_t size;
+		size_t offset;
+		size_t count;
+	};
+
+	// parses a message in place: Parse() validates it once, the sections are decoded while iterating;
+	// nothing is allocated
+	class DnsMessageView {
+	public:
+
+		// returns nullopt if the message is malformed
+		static std::optional<DnsMessageView> Parse(const uint8_t* data, const size_t size);
+
+		uint16_t GetId() const;
+		uint16_t GetFlags() const;
+		bool IsResponse() const;
+
+		DnsSectionView<DnsQuestionView> GetQuestions() const;
+		DnsSectionView<DnsRecordView> GetAnswers() const;
+		DnsSectionView<DnsRecordView> GetAuthorities() const;
+		DnsSectionView<DnsRecordView> GetAdditionals() const;
+
+	private:
+
+		DnsMessageView(const uint8_t* data, const size_t size) : data(data), size(size) {}
+
+		const uint8_t* data;
+		size_t size;
+		uint16_t counts[4] = {}; // questions, answers, authorities, additionals
+		size_t offsets[4] = {}; // where the sections start
+	};
+
+	// decode the entry at offset and return the offset of the next one, false if the entry is malformed
+	bool ReadDnsQuestionView(const uint8_t* packet, const size_t size, const size_t offset, DnsQuestionView& question, size_t& next);
+	bool ReadDnsRecordView(const uint8_t* packet, const size_t size, const size_t offset, DnsRecordView& record, size_t& next);
+
+	template <>
+	inline void DnsSectionView<DnsQuestionView>::Iterator::Read(const size_t offset)
+	{
+		if (remaining > 0) {
+			ReadDnsQuestionView(packet, size, offset, current, next);
+		}
+	}
+
+	template <>
+	inline void DnsSectionView<DnsRecordView>::Iterator::Read(const size_t offset)
+	{
+		if (remaining > 0) {
+			ReadDnsRecordView(packet, size, offset, current, next);
+		}
+	}
+}
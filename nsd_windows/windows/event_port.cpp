@@ -0,0 +1,237 @@
+#include "event_port.h"
+
+#include <dart_version.h>
+#include <internal/dart_api_dl_impl.h>
+
+#include <any>
+#include <cstring>
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using PostCObjectFunction = bool (*)(Dart_Port port, Dart_CObject* message);
+
+		std::atomic<PostCObjectFunction> postCObject{ nullptr };
+
+		void FinalizeExternalBytes(void* isolateCallbackData, void* peer)
+		{
+			delete static_cast<std::vector<uint8_t>*>(peer);
+		}
+
+		// the objects of one message; dart copies everything but external typed data while posting,
+		// so they only need to live until then
+		class MessageBuilder {
+		public:
+
+			MessageBuilder() = default;
+
+			~MessageBuilder() {
+				if (committed) {
+					return; // external byte arrays belong to dart now
+				}
+				for (auto& [value, bytes] : externals) {
+					*value = flutter::EncodableValue(std::move(*bytes));
+					delete bytes;
+				}
+			}
+
+			MessageBuilder(const MessageBuilder&) = delete; // disallow copy
+			MessageBuilder& operator=(const MessageBuilder&) = delete; // disallow assign
+
+			// null if the value (or one of its elements) has no dart representation
+			Dart_CObject* Add(flutter::EncodableValue& value) {
+
+				if (value.IsNull()) {
+					return &AddObject(Dart_CObject_kNull);
+				}
+				if (auto boolean = std::get_if<bool>(&value)) {
+					auto& object = AddObject(Dart_CObject_kBool);
+					object.value.as_bool = *boolean;
+					return &object;
+				}
+				if (auto integer = std::get_if<int32_t>(&value)) {
+					return AddInt32(*integer);
+				}
+				if (auto integer = std::get_if<int64_t>(&value)) {
+					auto& object = AddObject(Dart_CObject_kInt64);
+					object.value.as_int64 = *integer;
+					return &object;
+				}
+				if (auto number = std::get_if<double>(&value)) {
+					auto& object = AddObject(Dart_CObject_kDouble);
+					object.value.as_double = *number;
+					return &object;
+				}
+				if (auto string = std::get_if<std::string>(&value)) {
+					return AddString(*string);
+				}
+				if (auto bytes = std::get_if<std::vector<uint8_t>>(&value)) {
+					return AddBytes(value, *bytes);
+				}
+				if (auto list = std::get_if<flutter::EncodableList>(&value)) {
+					std::vector<Dart_CObject*> elements{ AddInt32(EventPort::kListTag) };
+					for (auto& element : *list) {
+						elements.push_back(Add(element));
+					}
+					return AddArray(std::move(elements));
+				}
+				if (auto map = std::get_if<flutter::EncodableMap>(&value)) {
+					std::vector<Dart_CObject*> elements{ AddInt32(EventPort::kMapTag) };
+					for (auto& [key, element] : *map) {
+						auto name = std::get_if<std::string>(&key);
+						elements.push_back(name != nullptr ? AddString(*name) : nullptr); // keys are never moved from, so only strings
+						elements.push_back(Add(element));
+					}
+					return AddArray(std::move(elements));
+				}
+				if (auto custom = std::get_if<flutter::CustomEncodableValue>(&value)) {
+					auto record = std::any_cast<EventRecord>(&static_cast<std::any&>(*custom));
+					return record != nullptr ? AddRecord(*record) : nullptr;
+				}
+				return nullptr; // other typed lists aren't used in events
+			}
+
+			Dart_CObject* AddRecord(EventRecord& record) {
+
+				std::vector<Dart_CObject*> elements{ AddInt32(EventPort::kRecordTag), AddInt32(record.GetKeys()) };
+				for (size_t index = 0; index < static_cast<size_t>(EventKey::COUNT); index++) {
+					auto field = record.Get(static_cast<EventKey>(index));
+					if (field != nullptr) {
+						elements.push_back(Add(*field));
+					}
+				}
+				return AddArray(std::move(elements));
+			}
+
+			Dart_CObject* AddString(const std::string& string) {
+				auto& object = AddObject(Dart_CObject_kString);
+				object.value.as_string = string.c_str(); // copied while posting
+				return &object;
+			}
+
+			// null if one of the elements is null
+			Dart_CObject* AddArray(std::vector<Dart_CObject*> elements) {
+
+				for (auto element : elements) {
+					if (element == nullptr) {
+						return nullptr;
+					}
+				}
+
+				auto& stored = arrays.emplace_back(std::move(elements));
+				auto& object = AddObject(Dart_CObject_kArray);
+				object.value.as_array.length = static_cast<intptr_t>(stored.size());
+				object.value.as_array.values = stored.data();
+				return &object;
+			}
+
+			void Commit() {
+				committed = true;
+			}
+
+		private:
+
+			Dart_CObject& AddObject(const Dart_CObject_Type type) {
+				auto& object = objects.emplace_back();
+				object.type = type;
+				return object;
+			}
+
+			Dart_CObject* AddInt32(const int32_t integer) {
+				auto& object = AddObject(Dart_CObject_kInt32);
+				object.value.as_int32 = integer;
+				return &object;
+			}
+
+			Dart_CObject* AddBytes(flutter::EncodableValue& value, std::vector<uint8_t>& bytes) {
+
+				if (bytes.size() < EventPort::kMinExternalSize) {
+					auto& object = AddObject(Dart_CObject_kTypedData);
+					object.value.as_typed_data.type = Dart_TypedData_kUint8;
+					object.value.as_typed_data.length = static_cast<intptr_t>(bytes.size());
+					object.value.as_typed_data.values = bytes.data(); // copied while posting
+					return &object;
+				}
+
+				// moved out of the event and freed by dart once the Uint8List is garbage collected
+				auto external = new std::vector<uint8_t>(std::move(bytes));
+				externals.emplace_back(&value, external);
+
+				auto& object = AddObject(Dart_CObject_kExternalTypedData);
+				object.value.as_external_typed_data.type = Dart_TypedData_kUint8;
+				object.value.as_external_typed_data.length = static_cast<intptr_t>(external->size());
+				object.value.as_external_typed_data.data = external->data();
+				object.value.as_external_typed_data.peer = external;
+				object.value.as_external_typed_data.callback = &FinalizeExternalBytes;
+				return &object;
+			}
+
+			std::deque<Dart_CObject> objects; // deques, so references stay valid while adding
+			std::deque<std::vector<Dart_CObject*>> arrays;
+			std::vector<std::pair<flutter::EncodableValue*, std::vector<uint8_t>*>> externals; // restored unless committed
+			bool committed = false;
+		};
+	}
+
+	bool EventPort::InitializeDartApi(void* data)
+	{
+		// same lookup as Dart_InitializeApiDL(), see https://github.com/dart-lang/sdk/blob/main/runtime/include/dart_api_dl.c
+		auto api = static_cast<const DartApi*>(data);
+		if (api == nullptr || api->major != DART_API_DL_MAJOR_VERSION) {
+			return false;
+		}
+
+		for (auto entry = api->functions; entry->name != nullptr; entry++) {
+			if (std::strcmp(entry->name, "Dart_PostCObject") == 0) {
+				postCObject = reinterpret_cast<PostCObjectFunction>(entry->function);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool EventPort::IsDartApiInitialized()
+	{
+		return postCObject.load() != nullptr;
+	}
+
+	void EventPort::SetPort(const Dart_Port port)
+	{
+		this->port = port;
+	}
+
+	bool EventPort::IsEnabled() const
+	{
+		return port.load() != ILLEGAL_PORT;
+	}
+
+	bool EventPort::Post(const std::string& method, EventRecord& arguments)
+	{
+		const auto target = port.load();
+		const auto post = postCObject.load();
+
+		if (target == ILLEGAL_PORT || post == nullptr) {
+			return false;
+		}
+
+		MessageBuilder builder;
+		auto message = builder.AddArray({ builder.AddString(method), builder.AddRecord(arguments) });
+
+		if (message == nullptr) {
+			return false;
+		}
+
+		if (!post(target, message)) {
+			auto expected = target;
+			port.compare_exchange_strong(expected, ILLEGAL_PORT); // closed, unless it has been replaced meanwhile
+			return false;
+		}
+
+		builder.Commit();
+		return true;
+	}
+}
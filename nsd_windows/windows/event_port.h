@@ -0,0 +1,54 @@
+#pragma once
+
+#include "nsd_codec.h"
+
+#include <dart_native_api.h>
+
+#include <atomic>
+#include <string>
+
+namespace nsd_windows {
+
+	// delivers events straight to a dart ReceivePort with Dart_PostCObject() instead of the method channel:
+	// no codec, no platform message and no reply, see https://github.com/dart-lang/sdk/blob/main/runtime/include/dart_native_api.h
+	//
+	// messages are arrays [method, arguments]; lists, maps and event records are arrays that start with a
+	// container tag (see kListTag etc.), records continue with the key bits and the values of the present keys
+	// in key order, just like the codec (see event_port.dart in nsd_platform_interface)
+	class EventPort {
+	public:
+
+		static constexpr int32_t kListTag = 0;
+		static constexpr int32_t kMapTag = 1; // followed by key, value, key, value...
+		static constexpr int32_t kRecordTag = 2;
+
+		static constexpr size_t kMinExternalSize = 256; // smaller byte arrays are cheaper to copy than to finalize
+
+		// takes the dart API table (NativeApi.initializeApiDLData), once per process; false if the table
+		// has an incompatible version or lacks Dart_PostCObject()
+		static bool InitializeDartApi(void* data);
+		static bool IsDartApiInitialized();
+
+		EventPort() = default;
+
+		EventPort(const EventPort&) = delete; // disallow copy
+		EventPort& operator=(const EventPort&) = delete; // disallow assign
+
+		void SetPort(const Dart_Port port); // ILLEGAL_PORT disables the port
+		bool IsEnabled() const;
+
+		// false if the event hasn't been posted, e.g. because the port is disabled or the receiving isolate has
+		// closed it (the port is disabled then), and the caller has to fall back to the method channel; byte
+		// arrays are moved out of the arguments and handed over as external typed data, but they are restored
+		// if posting fails
+		//
+		// the plugin posts from the platform thread, after the callback result has been applied to its state:
+		// posting right from the dns callback threads would let an event overtake that state, e.g. an
+		// unregister call for a registration the platform thread hasn't seen complete yet
+		bool Post(const std::string& method, EventRecord& arguments);
+
+	private:
+
+		std::atomic<Dart_Port> port{ ILLEGAL_PORT };
+	};
+}
@@ -3,6 +3,8 @@
 
 #include <flutter_plugin_registrar.h>
 
+#include <stdint.h>
+
 #ifdef FLUTTER_PLUGIN_IMPL
 #define FLUTTER_PLUGIN_EXPORT __declspec(dllexport)
 #else
@@ -16,6 +18,11 @@ extern "C" {
 FLUTTER_PLUGIN_EXPORT void NsdWindowsPluginCApiRegisterWithRegistrar(
     FlutterDesktopPluginRegistrarRef registrar);
 
+// Called over FFI with NativeApi.initializeApiDLData, before events are
+// posted to a native port. Returns 0 on success.
+FLUTTER_PLUGIN_EXPORT intptr_t NsdWindowsPluginCApiInitializeDartApi(
+    void* data);
+
 #if defined(__cplusplus)
 }  // extern "C"
 #endif
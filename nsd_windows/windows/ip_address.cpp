@@ -0,0 +1,65 @@
+#include "ip_address.h"
+
+#include <cstdio>
+
+namespace nsd_windows {
+
+	std::string FormatIp4Address(const uint8_t* bytes)
+	{
+		char buffer[16]; // "255.255.255.255"
+		auto length = std::snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", bytes[0], bytes[1], bytes[2], bytes[3]);
+		return std::string(buffer, length);
+	}
+
+	std::string FormatIp6Address(const uint8_t* bytes)
+	{
+		uint16_t groups[8];
+		for (int i = 0; i < 8; i++) {
+			groups[i] = static_cast<uint16_t>((bytes[2 * i] << 8) | bytes[2 * i + 1]);
+		}
+
+		// the longest run of at least two zero groups is shortened to "::", the first one if there is a tie
+
+		int bestStart = -1;
+		int bestLength = 1;
+
+		for (int i = 0; i < 8;) {
+			if (groups[i] != 0) {
+				i++;
+				continue;
+			}
+
+			int start = i;
+			while (i < 8 && groups[i] == 0) {
+				i++;
+			}
+
+			if (i - start > bestLength) {
+				bestStart = start;
+				bestLength = i - start;
+			}
+		}
+
+		std::string result;
+		result.reserve(39); // "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff"
+
+		for (int i = 0; i < 8; i++) {
+
+			if (i == bestStart) {
+				result += "::";
+				i += bestLength - 1;
+				continue;
+			}
+
+			if (!result.empty() && result.back() != ':') {
+				result += ':';
+			}
+
+			char buffer[5];
+			auto length = std::snprintf(buffer, sizeof(buffer), "%x", groups[i]);
+			result.append(buffer, length);
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace nsd_windows {
+
+	// bytes in network order
+	std::string FormatIp4Address(const uint8_t* bytes);
+
+	// bytes in network order, formatted as recommended by https://datatracker.ietf.org/doc/html/rfc5952#section-4
+	std::string FormatIp6Address(const uint8_t* bytes);
+}
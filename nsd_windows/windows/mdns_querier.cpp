@@ -0,0 +1,346 @@
+#include "mdns_querier.h"
+#include "dns_message_view.h"
+#include "ip_address.h"
+#include "service_table.h"
+
+#include <algorithm>
+#include <tuple>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr uint16_t kDnsFlagOpcodeAndResponseCode = 0x780F; // must be zero, see https://datatracker.ietf.org/doc/html/rfc6762#section-18.3
+
+		// what browses and resolves ask for
+		bool IsCachedType(const DnsType type) {
+			switch (type) {
+			case DnsType::PTR:
+			case DnsType::SRV:
+			case DnsType::TXT:
+			case DnsType::A:
+			case DnsType::AAAA:
+				return true;
+			default:
+				return false;
+			}
+		}
+	}
+
+	MdnsQuerier::MdnsQuerier(MdnsTransport& transport, MdnsQuerierListener& listener, Clock clock, const uint32_t seed)
+		: transport(transport), listener(listener), clock(std::move(clock)), random(seed), cache(seed) {}
+
+	uint64_t MdnsQuerier::Browse(const std::string& serviceType)
+	{
+		const auto id = nextId++;
+
+		// random delay, so that hosts starting up at the same time don't query in lockstep (section 5.2)
+		std::uniform_int_distribution<int64_t> delay(kMinInitialDelay.count(), kMaxInitialDelay.count());
+
+		auto& browse = browses[id];
+		browse.serviceType = serviceType;
+		browse.query.due = clock() + std::chrono::milliseconds(delay(random));
+		return id; // cached instances are reported by the next Poll()
+	}
+
+	void MdnsQuerier::StopBrowse(const uint64_t browseId)
+	{
+		browses.erase(browseId);
+	}
+
+	uint64_t MdnsQuerier::Resolve(const std::string& instanceName)
+	{
+		const auto id = nextId++;
+
+		auto& resolve = resolves[id];
+		resolve.instanceName = instanceName;
+		resolve.query.due = clock(); // answered from the cache by the next Poll() if possible
+		return id;
+	}
+
+	void MdnsQuerier::CancelResolve(const uint64_t resolveId)
+	{
+		resolves.erase(resolveId);
+	}
+
+	void MdnsQuerier::OnPacket(const uint8_t* data, const size_t size)
+	{
+		auto message = DnsMessageView::Parse(data, size);
+		if (!message.has_value() || !message->IsResponse() || (message->GetFlags() & kDnsFlagOpcodeAndResponseCode) != 0) {
+			return;
+		}
+
+		const auto now = clock();
+
+		// the authority section only matters for probing
+		for (const auto& section : { message->GetAnswers(), message->GetAdditionals() }) {
+			for (const auto& record : section) {
+				if (record.rrclass == kDnsClassIn && IsCachedType(record.type)) {
+					cache.Add(record.ToRecord(), now); // only records worth keeping are copied out of the packet
+				}
+			}
+		}
+
+		ReportBrowses();
+		ReportResolves(now);
+	}
+
+	void MdnsQuerier::Poll()
+	{
+		const auto now = clock();
+
+		cache.Expire(now);
+		ReportBrowses();
+		ReportResolves(now);
+
+		DnsMessage query; // all due questions go into one packet
+
+		for (auto& [id, browse] : browses) {
+
+			auto due = browse.query.due <= now;
+
+			// cached answers are refreshed before they expire
+			for (auto cached : cache.Find(browse.serviceType, DnsType::PTR)) {
+				for (auto refresh = cached->GetNextRefresh(); refresh.has_value() && refresh.value() <= now; refresh = cached->GetNextRefresh()) {
+					cached->refreshes++;
+					due = true;
+				}
+			}
+
+			if (!due) {
+				continue;
+			}
+
+			AddQuestion(query, browse.serviceType, DnsType::PTR, now);
+
+			if (browse.query.due <= now) {
+				Advance(browse.query, now);
+			}
+		}
+
+		for (auto& [id, resolve] : resolves) {
+
+			if (resolve.query.due > now) {
+				continue;
+			}
+
+			const auto srv = cache.Find(resolve.instanceName, DnsType::SRV);
+
+			if (srv.empty()) {
+				AddQuestion(query, resolve.instanceName, DnsType::SRV, now);
+			}
+
+			if (cache.Find(resolve.instanceName, DnsType::TXT).empty()) {
+				AddQuestion(query, resolve.instanceName, DnsType::TXT, now);
+			}
+
+			for (const auto* cached : srv) {
+				if (GetAddresses(cached->record.target).empty()) {
+					AddQuestion(query, cached->record.target, DnsType::A, now);
+					AddQuestion(query, cached->record.target, DnsType::AAAA, now);
+				}
+			}
+
+			Advance(resolve.query, now);
+		}
+
+		if (!query.questions.empty()) {
+			transport.Send(SerializeDnsMessage(query));
+		}
+	}
+
+	std::optional<std::chrono::steady_clock::time_point> MdnsQuerier::GetNextDue() const
+	{
+		auto next = cache.GetNextExpiry();
+
+		const auto consider = [&next](const std::chrono::steady_clock::time_point time) {
+			if (!next.has_value() || time < next.value()) {
+				next = time;
+			}
+		};
+
+		for (const auto& [id, browse] : browses) {
+			consider(browse.query.due);
+			for (const auto* cached : cache.Find(browse.serviceType, DnsType::PTR)) {
+				if (auto refresh = cached->GetNextRefresh()) {
+					consider(refresh.value());
+				}
+			}
+		}
+
+		for (const auto& [id, resolve] : resolves) {
+			consider(resolve.query.due);
+			if (resolve.answered.has_value()) {
+				consider(resolve.answered.value() + kAddressGrace);
+			}
+		}
+
+		return next;
+	}
+
+	const MdnsRecordCache& MdnsQuerier::GetCache() const
+	{
+		return cache;
+	}
+
+	void MdnsQuerier::Advance(ContinuousQuery& query, const std::chrono::steady_clock::time_point now)
+	{
+		// the interval starts at one second and at least doubles, up to one hour (section 5.2)
+		if (query.interval == std::chrono::steady_clock::duration::zero()) {
+			query.interval = kFirstInterval;
+		}
+		else {
+			query.interval = std::min<std::chrono::steady_clock::duration>(query.interval * 2, kMaxInterval);
+		}
+		query.due = now + query.interval;
+	}
+
+	void MdnsQuerier::AddQuestion(DnsMessage& query, const std::string& name, const DnsType type, const std::chrono::steady_clock::time_point now)
+	{
+		for (const auto& question : query.questions) {
+			if (question.type == type && EqualsDnsName(question.name, name)) {
+				return;
+			}
+		}
+
+		query.questions.push_back({ name, type });
+
+		auto size = kDnsHeaderSize;
+		for (const auto& question : query.questions) {
+			size += question.name.size() + 2 + 4;
+		}
+		for (const auto& answer : query.answers) {
+			size += EstimateDnsRecordSize(answer);
+		}
+
+		// known answers keep responders from repeating what we know already (section 7.1)
+
+		for (const auto* cached : cache.Find(name, type)) {
+
+			if (!cached->IsKnownAnswer(now)) {
+				continue;
+			}
+
+			auto answer = cached->record;
+			answer.ttl = cached->GetRemainingTtl(now);
+			answer.cacheFlush = false;
+
+			size += EstimateDnsRecordSize(answer);
+			if (size > kMaxQuerySize) {
+				break;
+			}
+
+			query.answers.push_back(std::move(answer));
+		}
+	}
+
+	std::optional<MdnsServiceInstance> MdnsQuerier::GetServiceInstance(const std::string& instanceName) const
+	{
+		const auto srv = cache.Find(instanceName, DnsType::SRV);
+		const auto txt = cache.Find(instanceName, DnsType::TXT);
+
+		if (srv.empty() || txt.empty()) {
+			return std::nullopt;
+		}
+
+		// DNS-SD uses a single SRV and TXT record per instance
+		const auto& srvRecord = srv.front()->record;
+		const auto& txtRecord = txt.front()->record;
+
+		MdnsServiceInstance instance;
+		instance.instanceName = instanceName;
+		instance.host = srvRecord.target;
+		instance.port = srvRecord.port;
+		instance.txt = txtRecord.data;
+		instance.addresses = GetAddresses(srvRecord.target);
+		instance.ttl = std::min(srvRecord.ttl, txtRecord.ttl);
+		return instance;
+	}
+
+	std::vector<std::string> MdnsQuerier::GetAddresses(const std::string& host) const
+	{
+		std::vector<std::string> addresses;
+
+		for (const auto* cached : cache.Find(host, DnsType::A)) {
+			addresses.push_back(FormatIp4Address(cached->record.data.data()));
+		}
+
+		for (const auto* cached : cache.Find(host, DnsType::AAAA)) {
+			addresses.push_back(FormatIp6Address(cached->record.data.data()));
+		}
+
+		return addresses;
+	}
+
+	void MdnsQuerier::ReportBrowses()
+	{
+		// the cache is the source of truth: instances appear with their PTR record and disappear when it expires
+
+		std::vector<std::tuple<uint64_t, std::string, bool>> events;
+
+		for (auto& [id, browse] : browses) {
+
+			std::map<std::string, std::string> current;
+			for (const auto* cached : cache.Find(browse.serviceType, DnsType::PTR)) {
+				current.emplace(ToLowerDnsName(cached->record.target), cached->record.target);
+			}
+
+			for (const auto& [key, instanceName] : current) {
+				if (browse.instances.find(key) == browse.instances.end()) {
+					events.emplace_back(id, instanceName, true);
+				}
+			}
+
+			for (const auto& [key, instanceName] : browse.instances) {
+				if (current.find(key) == current.end()) {
+					events.emplace_back(id, instanceName, false);
+				}
+			}
+
+			browse.instances = std::move(current);
+		}
+
+		for (const auto& [id, instanceName, found] : events) {
+			if (browses.find(id) != browses.end()) { // the listener may have stopped the browse in the meantime
+				listener.OnBrowseResult(id, instanceName, found);
+			}
+		}
+	}
+
+	void MdnsQuerier::ReportResolves(const std::chrono::steady_clock::time_point now)
+	{
+		std::vector<std::pair<uint64_t, MdnsServiceInstance>> completed;
+
+		for (auto it = resolves.begin(); it != resolves.end();) {
+
+			auto& resolve = it->second;
+
+			auto instance = GetServiceInstance(resolve.instanceName);
+			if (!instance.has_value()) {
+				it++;
+				continue;
+			}
+
+			if (!resolve.answered.has_value()) {
+				resolve.answered = now;
+
+				if (instance->addresses.empty()) {
+					resolve.query.due = now; // ask for the addresses right away rather than after the backoff interval
+				}
+			}
+
+			// addresses usually come along in the additional section, otherwise they get a little time of their own
+			if (instance->addresses.empty() && now < resolve.answered.value() + kAddressGrace) {
+				it++;
+				continue;
+			}
+
+			completed.emplace_back(it->first, std::move(instance.value()));
+			it = resolves.erase(it);
+		}
+
+		for (const auto& [id, instance] : completed) {
+			listener.OnResolveResult(id, instance);
+		}
+	}
+}
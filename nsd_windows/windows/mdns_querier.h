@@ -0,0 +1,117 @@
+#pragma once
+
+#include "dns_message.h"
+#include "mdns_record_cache.h"
+#include "mdns_transport.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	struct MdnsServiceInstance {
+
+		std::string instanceName; // presentation format, e.g. "My\.Printer._ipp._tcp.local"
+		std::string host;
+		uint16_t port = 0;
+		std::vector<uint8_t> txt; // TXT rdata as received
+		std::vector<std::string> addresses; // of the host, as far as known
+		uint32_t ttl = 0; // seconds, the smaller one of SRV and TXT
+	};
+
+	// results are only reported from OnPacket() and Poll(), never from the calls that start the operations
+	class MdnsQuerierListener {
+	public:
+
+		virtual ~MdnsQuerierListener() = default;
+
+		virtual void OnBrowseResult(const uint64_t browseId, const std::string& instanceName, const bool found) = 0;
+		virtual void OnResolveResult(const uint64_t resolveId, const MdnsServiceInstance& instance) = 0;
+	};
+
+	// userspace mDNS querier (see https://datatracker.ietf.org/doc/html/rfc6762), alternative to DnsServiceBrowse / DnsServiceResolve;
+	// not thread safe, all calls must come from the same thread
+	//
+	// - continuous querying: browse queries are repeated with exponential backoff, cached answers are refreshed
+	//   before they expire (section 5.2)
+	// - known answer suppression: queries list the answers that are still fresh (section 7.1)
+	// - a single record cache serves all browses and resolves
+	class MdnsQuerier {
+	public:
+
+		using Clock = std::function<std::chrono::steady_clock::time_point()>;
+
+		MdnsQuerier(MdnsTransport& transport, MdnsQuerierListener& listener, Clock clock = std::chrono::steady_clock::now, const uint32_t seed = std::random_device()());
+
+		MdnsQuerier(const MdnsQuerier&) = delete; // disallow copy
+		MdnsQuerier& operator=(const MdnsQuerier&) = delete; // disallow assign
+
+		// service type in presentation format, e.g. "_http._tcp.local"
+		uint64_t Browse(const std::string& serviceType);
+		void StopBrowse(const uint64_t browseId);
+
+		// runs until the instance is resolved or it is cancelled; deadlines are up to the caller
+		uint64_t Resolve(const std::string& instanceName);
+		void CancelResolve(const uint64_t resolveId);
+
+		// feeds a received packet; queries from other hosts are ignored
+		void OnPacket(const uint8_t* data, const size_t size);
+
+		// sends due queries and reports cache changes; call at GetNextDue() at the latest
+		void Poll();
+		std::optional<std::chrono::steady_clock::time_point> GetNextDue() const;
+
+		const MdnsRecordCache& GetCache() const;
+
+	private:
+
+		static constexpr std::chrono::milliseconds kMinInitialDelay{ 20 }; // see section 5.2
+		static constexpr std::chrono::milliseconds kMaxInitialDelay{ 120 };
+		static constexpr std::chrono::seconds kFirstInterval{ 1 };
+		static constexpr std::chrono::minutes kMaxInterval{ 60 };
+		static constexpr std::chrono::seconds kAddressGrace{ 1 }; // resolves wait this long for addresses after SRV / TXT
+		static constexpr size_t kMaxQuerySize = 1400; // known answers beyond this are left out rather than fragmenting
+
+		struct ContinuousQuery {
+
+			std::chrono::steady_clock::time_point due;
+			std::chrono::steady_clock::duration interval{ 0 }; // zero until the first query has been sent
+		};
+
+		struct BrowseState {
+
+			std::string serviceType;
+			ContinuousQuery query;
+			std::map<std::string, std::string> instances; // lower case -> as received, reported as found
+		};
+
+		struct ResolveState {
+
+			std::string instanceName;
+			ContinuousQuery query;
+			std::optional<std::chrono::steady_clock::time_point> answered; // SRV and TXT are known since
+		};
+
+		MdnsTransport& transport;
+		MdnsQuerierListener& listener;
+		Clock clock;
+		std::minstd_rand random;
+		MdnsRecordCache cache;
+		std::map<uint64_t, BrowseState> browses;
+		std::map<uint64_t, ResolveState> resolves;
+		uint64_t nextId = 1;
+
+		void Advance(ContinuousQuery& query, const std::chrono::steady_clock::time_point now);
+		void AddQuestion(DnsMessage& query, const std::string& name, const DnsType type, const std::chrono::steady_clock::time_point now);
+		std::optional<MdnsServiceInstance> GetServiceInstance(const std::string& instanceName) const;
+		std::vector<std::string> GetAddresses(const std::string& host) const;
+		void ReportBrowses();
+		void ReportResolves(const std::chrono::steady_clock::time_point now);
+	};
+}
@@ -0,0 +1,146 @@
+#include "mdns_record_cache.h"
+#include "service_table.h"
+
+#include <algorithm>
+
+namespace nsd_windows {
+
+	uint32_t CachedRecord::GetRemainingTtl(const std::chrono::steady_clock::time_point now) const
+	{
+		if (now >= expires) {
+			return 0;
+		}
+		return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::seconds>(expires - now).count());
+	}
+
+	std::optional<std::chrono::steady_clock::time_point> CachedRecord::GetNextRefresh() const
+	{
+		if (refreshes >= 4 || record.ttl == 0) {
+			return std::nullopt;
+		}
+
+		const auto permille = 800 + 50 * refreshes + jitter;
+		return received + std::chrono::milliseconds(static_cast<int64_t>(record.ttl) * permille);
+	}
+
+	bool CachedRecord::IsKnownAnswer(const std::chrono::steady_clock::time_point now) const
+	{
+		return GetRemainingTtl(now) * 2 > record.ttl;
+	}
+
+	MdnsRecordCache::MdnsRecordCache(const uint32_t seed) : random(seed) {}
+
+	bool MdnsRecordCache::Add(const DnsRecord& record, const std::chrono::steady_clock::time_point now)
+	{
+		auto& set = records[{ ToLowerDnsName(record.name), record.type }];
+
+		auto existing = std::find_if(set.begin(), set.end(), [&record](const CachedRecord& cached) -> bool {
+			return cached.record.IsSameRecord(record);
+			});
+
+		if (record.ttl == 0) {
+			// goodbye: keep the record for another second, so a quick re-announcement doesn't look like a new service
+			if (existing != set.end()) {
+				existing->expires = std::min(existing->expires, now + kGoodbyeDelay);
+				existing->refreshes = 4;
+			}
+			return false;
+		}
+
+		if (record.cacheFlush) {
+			// other records of the set are outdated unless they arrived within the last second,
+			// see https://datatracker.ietf.org/doc/html/rfc6762#section-10.2
+			for (auto& cached : set) {
+				if (!cached.record.IsSameRecord(record) && cached.received + kGoodbyeDelay < now) {
+					cached.expires = std::min(cached.expires, now + kGoodbyeDelay);
+				}
+			}
+		}
+
+		if (existing != set.end()) {
+			existing->record.ttl = record.ttl;
+			existing->received = now;
+			existing->expires = now + std::chrono::seconds(record.ttl);
+			existing->refreshes = 0;
+			return false;
+		}
+
+		CachedRecord cached;
+		cached.record = record;
+		cached.received = now;
+		cached.expires = now + std::chrono::seconds(record.ttl);
+		cached.jitter = static_cast<int>(random() % 21); // up to 2%, so that queriers don't refresh in lockstep
+		set.push_back(std::move(cached));
+		size++;
+		return true;
+	}
+
+	std::vector<DnsRecord> MdnsRecordCache::Expire(const std::chrono::steady_clock::time_point now)
+	{
+		std::vector<DnsRecord> expired;
+
+		for (auto it = records.begin(); it != records.end();) {
+
+			auto& set = it->second;
+			auto end = std::stable_partition(set.begin(), set.end(), [now](const CachedRecord& cached) -> bool {
+				return cached.expires > now;
+				});
+
+			for (auto current = end; current != set.end(); current++) {
+				expired.push_back(std::move(current->record));
+			}
+
+			size -= std::distance(end, set.end());
+			set.erase(end, set.end());
+
+			it = set.empty() ? records.erase(it) : std::next(it);
+		}
+
+		return expired;
+	}
+
+	std::vector<const CachedRecord*> MdnsRecordCache::Find(const std::string_view name, const DnsType type) const
+	{
+		std::vector<const CachedRecord*> found;
+
+		auto it = records.find({ ToLowerDnsName(name), type });
+		if (it != records.end()) {
+			for (const auto& cached : it->second) {
+				found.push_back(&cached);
+			}
+		}
+		return found;
+	}
+
+	std::vector<CachedRecord*> MdnsRecordCache::Find(const std::string_view name, const DnsType type)
+	{
+		std::vector<CachedRecord*> found;
+
+		auto it = records.find({ ToLowerDnsName(name), type });
+		if (it != records.end()) {
+			for (auto& cached : it->second) {
+				found.push_back(&cached);
+			}
+		}
+		return found;
+	}
+
+	std::optional<std::chrono::steady_clock::time_point> MdnsRecordCache::GetNextExpiry() const
+	{
+		std::optional<std::chrono::steady_clock::time_point> next;
+
+		for (const auto& [key, set] : records) {
+			for (const auto& cached : set) {
+				if (!next.has_value() || cached.expires < next.value()) {
+					next = cached.expires;
+				}
+			}
+		}
+		return next;
+	}
+
+	size_t MdnsRecordCache::Size() const
+	{
+		return size;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "dns_message.h"
+
+#include <chrono>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	struct CachedRecord {
+
+		DnsRecord record; // TTL as received
+		std::chrono::steady_clock::time_point received;
+		std::chrono::steady_clock::time_point expires;
+		int refreshes = 0; // refresh queries sent since the record was received
+		int jitter = 0; // per mille of the TTL added to refresh times
+
+		uint32_t GetRemainingTtl(const std::chrono::steady_clock::time_point now) const; // seconds
+
+		// at 80%, 85%, 90% and 95% of the TTL, see https://datatracker.ietf.org/doc/html/rfc6762#section-5.2;
+		// nullopt once all refreshes have been sent
+		std::optional<std::chrono::steady_clock::time_point> GetNextRefresh() const;
+
+		// known answers are only listed while at least half of their TTL remains,
+		// see https://datatracker.ietf.org/doc/html/rfc6762#section-7.1
+		bool IsKnownAnswer(const std::chrono::steady_clock::time_point now) const;
+	};
+
+	// records received by the mDNS querier, shared by all browses and resolves
+	class MdnsRecordCache {
+	public:
+
+		explicit MdnsRecordCache(const uint32_t seed = std::random_device()());
+
+		MdnsRecordCache(const MdnsRecordCache&) = delete; // disallow copy
+		MdnsRecordCache& operator=(const MdnsRecordCache&) = delete; // disallow assign
+
+		// returns true if the record is new, false for refreshes and goodbyes
+		bool Add(const DnsRecord& record, const std::chrono::steady_clock::time_point now);
+
+		// removes expired records and returns them
+		std::vector<DnsRecord> Expire(const std::chrono::steady_clock::time_point now);
+
+		std::vector<const CachedRecord*> Find(const std::string_view name, const DnsType type) const;
+		std::vector<CachedRecord*> Find(const std::string_view name, const DnsType type);
+
+		std::optional<std::chrono::steady_clock::time_point> GetNextExpiry() const;
+
+		size_t Size() const;
+
+	private:
+
+		static constexpr std::chrono::seconds kGoodbyeDelay{ 1 }; // see https://datatracker.ietf.org/doc/html/rfc6762#section-10.1
+
+		std::map<std::pair<std::string, DnsType>, std::vector<CachedRecord>> records; // by lower case name and type
+		std::minstd_rand random;
+		size_t size = 0;
+	};
+}
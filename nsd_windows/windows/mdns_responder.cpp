@@ -0,0 +1,603 @@
+#include "mdns_responder.h"
+#include "dns_message_view.h"
+#include "nsd_error.h"
+#include "service_table.h"
+
+#include <algorithm>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr uint16_t kDnsFlagAuthoritative = 0x0400;
+		constexpr uint16_t kDnsFlagOpcode = 0x7800; // must be zero, see https://datatracker.ietf.org/doc/html/rfc6762#section-18.3
+		constexpr size_t kMaxLabelLength = 63;
+		const std::string kServiceTypeEnumerationName = "_services._dns-sd._udp.local"; // see https://datatracker.ietf.org/doc/html/rfc6763#section-9
+
+		// identifies a record for rate limiting
+		std::string GetRecordKey(const DnsRecord& record) {
+			auto key = ToLowerDnsName(record.name);
+			key += '/' + std::to_string(static_cast<uint16_t>(record.type)) + '/' + ToLowerDnsName(record.target) + '/';
+			key.append(record.data.begin(), record.data.end());
+			return key;
+		}
+
+		bool Contains(const std::vector<DnsRecord>& records, const DnsRecord& record) {
+			return std::any_of(records.begin(), records.end(), [&record](const DnsRecord& other) -> bool {
+				return other.IsSameRecord(record);
+				});
+		}
+
+		void AddUnique(std::vector<DnsRecord>& records, const DnsRecord& record) {
+			if (!Contains(records, record)) {
+				records.push_back(record);
+			}
+		}
+
+		void RemoveKnownAnswers(std::vector<DnsRecord>& answers, const DnsRecord& known) {
+			answers.erase(std::remove_if(answers.begin(), answers.end(), [&known](const DnsRecord& answer) -> bool {
+				return answer.IsSameRecord(known) && static_cast<uint64_t>(known.ttl) * 2 >= answer.ttl;
+				}), answers.end());
+		}
+
+		// a response packet of limited size; records are added in groups that stay together
+		struct ResponsePacket {
+
+			DnsMessage message;
+			size_t size = kDnsHeaderSize;
+
+			ResponsePacket() {
+				message.flags = kDnsFlagResponse | kDnsFlagAuthoritative;
+			}
+
+			bool IsEmpty() const {
+				return message.answers.empty();
+			}
+
+			// all or nothing; an empty packet takes any group, even if it ends up too large
+			bool Add(const std::vector<DnsRecord>& answers, const std::vector<DnsRecord>& additionals, const size_t maxSize) {
+
+				std::vector<DnsRecord> newAnswers;
+				std::vector<DnsRecord> newAdditionals;
+				size_t added = 0;
+
+				for (const auto& answer : answers) {
+					if (!Contains(message.answers, answer) && !Contains(newAnswers, answer)) {
+						newAnswers.push_back(answer);
+						added += EstimateDnsRecordSize(answer);
+					}
+				}
+
+				for (const auto& additional : additionals) {
+					if (!Contains(message.answers, additional) && !Contains(newAnswers, additional) &&
+						!Contains(message.additionals, additional) && !Contains(newAdditionals, additional)) {
+						newAdditionals.push_back(additional);
+						added += EstimateDnsRecordSize(additional);
+					}
+				}
+
+				if (!IsEmpty() && size + added > maxSize) {
+					return false;
+				}
+
+				// answers that are repeated as additionals in the packet don't need to be
+				message.additionals.erase(std::remove_if(message.additionals.begin(), message.additionals.end(), [&newAnswers](const DnsRecord& additional) -> bool {
+					return Contains(newAnswers, additional);
+					}), message.additionals.end());
+
+				message.answers.insert(message.answers.end(), newAnswers.begin(), newAnswers.end());
+				message.additionals.insert(message.additionals.end(), newAdditionals.begin(), newAdditionals.end());
+				size += added;
+				return true;
+			}
+		};
+	}
+
+	MdnsResponder::MdnsResponder(MdnsTransport& transport, Clock clock, const uint32_t seed)
+		: transport(transport), clock(std::move(clock)), random(seed) {}
+
+	void MdnsResponder::SetHost(const std::string& hostName, std::vector<std::vector<uint8_t>> addresses)
+	{
+		this->hostName = hostName;
+		this->addresses = std::move(addresses);
+	}
+
+	const std::string& MdnsResponder::GetHostName() const
+	{
+		return hostName;
+	}
+
+	uint64_t MdnsResponder::Register(const MdnsServiceRegistration& registration)
+	{
+		if (hostName.empty()) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, "mDNS responder: host not set");
+		}
+
+		const auto typeLabels = SplitDnsName(registration.type);
+		const auto validLabel = [](const std::string& label) -> bool {
+			return !label.empty() && label.size() <= kMaxLabelLength;
+		};
+
+		if (!validLabel(registration.name) || typeLabels.size() != 2 || !std::all_of(typeLabels.begin(), typeLabels.end(), validLabel)) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Invalid service name or type: " + registration.name + " " + registration.type);
+		}
+
+		Service service;
+		service.registration = registration;
+		service.instanceName = EscapeDnsLabel(registration.name) + "." + registration.type + ".local";
+		service.serviceType = registration.type + ".local";
+		service.nextAnnouncement = clock();
+
+		auto instanceKey = ToLowerDnsName(service.instanceName);
+		if (servicesByInstance.find(instanceKey) != servicesByInstance.end()) {
+			throw NsdError(ErrorCause::ALREADY_ACTIVE, "Service already registered: " + service.instanceName);
+		}
+
+		const auto id = nextId++;
+		servicesByInstance[instanceKey] = id;
+		servicesByType.emplace(ToLowerDnsName(service.serviceType), id);
+		services[id] = std::move(service);
+		return id;
+	}
+
+	void MdnsResponder::Unregister(const uint64_t id)
+	{
+		auto it = services.find(id);
+		if (it == services.end()) {
+			return;
+		}
+
+		const auto service = std::move(it->second);
+		services.erase(it);
+		servicesByInstance.erase(ToLowerDnsName(service.instanceName));
+
+		const auto typeKey = ToLowerDnsName(service.serviceType);
+		for (auto [current, end] = servicesByType.equal_range(typeKey); current != end; current++) {
+			if (current->second == id) {
+				servicesByType.erase(current);
+				break;
+			}
+		}
+
+		auto records = GetServiceRecords(service);
+		const auto lastOfType = servicesByType.find(typeKey) == servicesByType.end();
+		if (lastOfType) {
+			records.push_back(GetServiceTypeRecord(service.serviceType));
+		}
+
+		// nothing to answer for anymore
+		const auto answersFor = [&records](const DnsRecord& answer) -> bool {
+			return Contains(records, answer);
+		};
+		pendingAnswers.erase(std::remove_if(pendingAnswers.begin(), pendingAnswers.end(), answersFor), pendingAnswers.end());
+		for (auto& [destination, answers] : pendingUnicastAnswers) {
+			answers.erase(std::remove_if(answers.begin(), answers.end(), answersFor), answers.end());
+		}
+
+		// the host records stay, the operating system answers for the host name as well
+		for (auto& record : records) {
+			record.ttl = 0; // goodbye, see https://datatracker.ietf.org/doc/html/rfc6762#section-10.1
+		}
+		goodbyes.push_back(std::move(records));
+	}
+
+	void MdnsResponder::OnPacket(const uint8_t* data, const size_t size, const MdnsEndpoint& source)
+	{
+		if (services.empty()) {
+			return;
+		}
+
+		auto message = DnsMessageView::Parse(data, size);
+		if (!message.has_value() || message->IsResponse() || (message->GetFlags() & kDnsFlagOpcode) != 0) {
+			return;
+		}
+
+		std::vector<DnsRecord> answers;
+		std::vector<DnsRecord> unicastAnswers;
+
+		for (const auto& question : message->GetQuestions()) {
+			AddAnswers(question.name.ToString(), question.type, question.unicastResponse ? unicastAnswers : answers);
+		}
+
+		if (answers.empty() && unicastAnswers.empty()) {
+			return;
+		}
+
+		// known answer suppression, see https://datatracker.ietf.org/doc/html/rfc6762#section-7.1
+		for (const auto& known : message->GetAnswers()) {
+
+			if (known.rrclass != kDnsClassIn) {
+				continue;
+			}
+
+			const auto record = known.ToRecord();
+			RemoveKnownAnswers(answers, record);
+			RemoveKnownAnswers(unicastAnswers, record);
+		}
+
+		const auto now = clock();
+
+		// a unicast answer that hasn't been multicast within a quarter of its TTL is multicast instead, so that
+		// other caches get refreshed as well, see https://datatracker.ietf.org/doc/html/rfc6762#section-5.4
+		std::vector<DnsRecord> unicast;
+		for (const auto& answer : unicastAnswers) {
+			auto last = lastMulticast.find(GetRecordKey(answer));
+			if (last != lastMulticast.end() && last->second.time + std::chrono::seconds(answer.ttl) / 4 > now) {
+				AddUnique(unicast, answer);
+			}
+			else {
+				AddUnique(answers, answer);
+			}
+		}
+
+		if (!unicast.empty()) {
+			auto pending = std::find_if(pendingUnicastAnswers.begin(), pendingUnicastAnswers.end(), [&source](const auto& destination) -> bool {
+				return destination.first == source;
+				});
+			if (pendingUnicastAnswers.empty()) {
+				unicastResponseDue = now;
+			}
+			if (pending == pendingUnicastAnswers.end()) {
+				pending = pendingUnicastAnswers.insert(pendingUnicastAnswers.end(), { source, {} });
+			}
+			for (const auto& answer : unicast) {
+				AddUnique(pending->second, answer);
+			}
+		}
+
+		auto shared = false;
+		for (const auto& answer : answers) {
+			shared = shared || !answer.cacheFlush;
+			AddUnique(pendingAnswers, answer);
+		}
+
+		if (answers.empty()) {
+			return;
+		}
+
+		// shared answers are delayed so that responses of several hosts (and to several queries) can be aggregated (section 6)
+		auto due = now;
+		if (shared) {
+			std::uniform_int_distribution<int64_t> delay(kMinResponseDelay.count(), kMaxResponseDelay.count());
+			due += std::chrono::milliseconds(delay(random));
+		}
+
+		if (!responseDue.has_value() || due < responseDue.value()) {
+			responseDue = due;
+		}
+	}
+
+	void MdnsResponder::Poll()
+	{
+		const auto now = clock();
+
+		SendGoodbyes(now); // before announcements, so that a service registered again right away ends up announced
+		SendAnnouncements(now);
+		SendUnicastResponses();
+
+		if (responseDue.has_value() && responseDue.value() <= now) {
+			SendResponse(now);
+		}
+
+		for (auto it = lastMulticast.begin(); it != lastMulticast.end();) {
+			const auto& last = it->second;
+			it = (last.time + std::max<std::chrono::steady_clock::duration>(kMinMulticastInterval, last.interest) <= now) ? lastMulticast.erase(it) : std::next(it);
+		}
+	}
+
+	std::optional<std::chrono::steady_clock::time_point> MdnsResponder::GetNextDue() const
+	{
+		std::optional<std::chrono::steady_clock::time_point> next;
+
+		const auto consider = [&next](const std::chrono::steady_clock::time_point time) {
+			if (!next.has_value() || time < next.value()) {
+				next = time;
+			}
+		};
+
+		const auto packetAllowed = GetNextPacketAllowed();
+
+		if (!goodbyes.empty()) {
+			consider(packetAllowed);
+		}
+
+		for (const auto& [id, service] : services) {
+			if (service.announcements < kAnnouncements) {
+				consider(std::max(service.nextAnnouncement, packetAllowed));
+			}
+		}
+
+		if (responseDue.has_value()) {
+			consider(responseDue.value());
+		}
+
+		if (!pendingUnicastAnswers.empty()) {
+			consider(unicastResponseDue);
+		}
+
+		return next;
+	}
+
+	size_t MdnsResponder::GetServiceCount() const
+	{
+		return services.size();
+	}
+
+	std::vector<DnsRecord> MdnsResponder::GetServiceRecords(const Service& service) const
+	{
+		// see https://datatracker.ietf.org/doc/html/rfc6763#section-4.1
+
+		DnsRecord ptr;
+		ptr.name = service.serviceType;
+		ptr.type = DnsType::PTR;
+		ptr.ttl = kSharedTtl;
+		ptr.target = service.instanceName;
+
+		DnsRecord srv;
+		srv.name = service.instanceName;
+		srv.type = DnsType::SRV;
+		srv.cacheFlush = true;
+		srv.ttl = kUniqueTtl;
+		srv.port = service.registration.port;
+		srv.target = hostName;
+
+		DnsRecord txt;
+		txt.name = service.instanceName;
+		txt.type = DnsType::TXT;
+		txt.cacheFlush = true;
+		txt.ttl = kSharedTtl;
+		txt.data = service.registration.txt.empty() ? std::vector<uint8_t>{ 0 } : service.registration.txt; // a single empty string, see https://datatracker.ietf.org/doc/html/rfc6763#section-6.1
+
+		return { ptr, srv, txt };
+	}
+
+	DnsRecord MdnsResponder::GetServiceTypeRecord(const std::string& serviceType) const
+	{
+		DnsRecord ptr;
+		ptr.name = kServiceTypeEnumerationName;
+		ptr.type = DnsType::PTR;
+		ptr.ttl = kSharedTtl;
+		ptr.target = serviceType;
+		return ptr;
+	}
+
+	std::vector<DnsRecord> MdnsResponder::GetHostRecords(const DnsType type) const
+	{
+		std::vector<DnsRecord> records;
+
+		for (const auto& address : addresses) {
+
+			if (address.size() != (type == DnsType::A ? 4 : 16)) {
+				continue;
+			}
+
+			DnsRecord record;
+			record.name = hostName;
+			record.type = type;
+			record.cacheFlush = true;
+			record.ttl = kUniqueTtl;
+			record.data = address;
+			records.push_back(std::move(record));
+		}
+		return records;
+	}
+
+	std::vector<DnsRecord> MdnsResponder::GetAdditionalRecords(const std::vector<DnsRecord>& answers) const
+	{
+		// see https://datatracker.ietf.org/doc/html/rfc6763#section-12
+
+		std::vector<DnsRecord> additionals;
+		auto hostRecords = false;
+
+		for (const auto& answer : answers) {
+
+			if (answer.type == DnsType::PTR) {
+				auto it = servicesByInstance.find(ToLowerDnsName(answer.target));
+				if (it != servicesByInstance.end()) {
+					for (const auto& record : GetServiceRecords(services.at(it->second))) {
+						if (record.type != DnsType::PTR) {
+							AddUnique(additionals, record);
+						}
+					}
+					hostRecords = true;
+				}
+			}
+			else if (answer.type == DnsType::SRV) {
+				hostRecords = true;
+			}
+		}
+
+		if (hostRecords) {
+			for (const auto type : { DnsType::A, DnsType::AAAA }) {
+				for (const auto& record : GetHostRecords(type)) {
+					AddUnique(additionals, record);
+				}
+			}
+		}
+
+		return additionals;
+	}
+
+	void MdnsResponder::AddAnswers(const std::string& name, const DnsType type, std::vector<DnsRecord>& answers) const
+	{
+		const auto matches = [type](const DnsType recordType) -> bool {
+			return type == recordType || type == DnsType::ANY;
+		};
+
+		const auto key = ToLowerDnsName(name);
+
+		const auto addServiceRecords = [&](const uint64_t id) {
+			for (const auto& record : GetServiceRecords(services.at(id))) {
+				if (matches(record.type) && EqualsDnsName(record.name, name)) {
+					AddUnique(answers, record);
+				}
+			}
+		};
+
+		if (key == kServiceTypeEnumerationName && matches(DnsType::PTR)) {
+			for (auto it = servicesByType.begin(); it != servicesByType.end(); it = servicesByType.upper_bound(it->first)) {
+				AddUnique(answers, GetServiceTypeRecord(services.at(it->second).serviceType));
+			}
+		}
+
+		for (auto [it, end] = servicesByType.equal_range(key); it != end; it++) {
+			addServiceRecords(it->second);
+		}
+
+		auto instance = servicesByInstance.find(key);
+		if (instance != servicesByInstance.end()) {
+			addServiceRecords(instance->second);
+		}
+
+		if (EqualsDnsName(name, hostName)) {
+			for (const auto addressType : { DnsType::A, DnsType::AAAA }) {
+				if (matches(addressType)) {
+					for (const auto& record : GetHostRecords(addressType)) {
+						AddUnique(answers, record);
+					}
+				}
+			}
+		}
+	}
+
+	std::chrono::steady_clock::time_point MdnsResponder::GetNextPacketAllowed() const
+	{
+		// up to kMaxPacketBurst packets may be sent ahead of the schedule
+		return packetSchedule - kPacketInterval * (kMaxPacketBurst - 1);
+	}
+
+	void MdnsResponder::SendGoodbyes(const std::chrono::steady_clock::time_point now)
+	{
+		ResponsePacket packet;
+		size_t sent = 0; // groups
+
+		while (sent < goodbyes.size() && GetNextPacketAllowed() <= now) {
+
+			if (packet.Add(goodbyes[sent], {}, kMaxPacketSize)) {
+				sent++;
+				continue;
+			}
+
+			SendRateLimited(packet.message, now);
+			packet = ResponsePacket();
+		}
+
+		if (!packet.IsEmpty()) {
+			SendRateLimited(packet.message, now);
+		}
+
+		goodbyes.erase(goodbyes.begin(), goodbyes.begin() + sent);
+	}
+
+	void MdnsResponder::SendAnnouncements(const std::chrono::steady_clock::time_point now)
+	{
+		// see https://datatracker.ietf.org/doc/html/rfc6762#section-8.3
+
+		std::vector<DnsRecord> hostRecords = GetHostRecords(DnsType::A);
+		for (auto& record : GetHostRecords(DnsType::AAAA)) {
+			hostRecords.push_back(std::move(record));
+		}
+
+		ResponsePacket packet;
+
+		for (auto it = services.begin(); it != services.end() && GetNextPacketAllowed() <= now;) {
+
+			auto& service = it->second;
+
+			if (service.announcements >= kAnnouncements || service.nextAnnouncement > now) {
+				it++;
+				continue;
+			}
+
+			auto records = GetServiceRecords(service);
+			records.push_back(GetServiceTypeRecord(service.serviceType));
+			records.insert(records.end(), hostRecords.begin(), hostRecords.end());
+
+			if (!packet.Add(records, {}, kMaxPacketSize)) {
+				SendRateLimited(packet.message, now);
+				packet = ResponsePacket();
+				continue;
+			}
+
+			service.announcements++;
+			service.nextAnnouncement = now + kMinMulticastInterval * (1 << (service.announcements - 1)); // doubling
+			it++;
+		}
+
+		if (!packet.IsEmpty()) {
+			SendRateLimited(packet.message, now);
+		}
+	}
+
+	void MdnsResponder::SendResponse(const std::chrono::steady_clock::time_point now)
+	{
+		ResponsePacket packet;
+
+		for (const auto& answer : pendingAnswers) {
+
+			// a record isn't multicast again within a second, see https://datatracker.ietf.org/doc/html/rfc6762#section-6
+			auto last = lastMulticast.find(GetRecordKey(answer));
+			if (last != lastMulticast.end() && last->second.time + kMinMulticastInterval > now) {
+				continue;
+			}
+
+			const std::vector<DnsRecord> answers{ answer };
+			const auto additionals = GetAdditionalRecords(answers);
+
+			if (!packet.Add(answers, additionals, kMaxPacketSize)) {
+				Send(packet.message, now);
+				packet = ResponsePacket();
+				packet.Add(answers, additionals, kMaxPacketSize);
+			}
+		}
+
+		if (!packet.IsEmpty()) {
+			Send(packet.message, now);
+		}
+
+		pendingAnswers.clear();
+		responseDue.reset();
+	}
+
+	void MdnsResponder::SendUnicastResponses()
+	{
+		// not rate limited, nor delayed: only the querier gets them
+		for (const auto& [destination, answers] : pendingUnicastAnswers) {
+
+			ResponsePacket packet;
+
+			for (const auto& answer : answers) {
+
+				const std::vector<DnsRecord> group{ answer };
+				const auto additionals = GetAdditionalRecords(group);
+
+				if (!packet.Add(group, additionals, kMaxPacketSize)) {
+					transport.SendTo(SerializeDnsMessage(packet.message), destination);
+					packet = ResponsePacket();
+					packet.Add(group, additionals, kMaxPacketSize);
+				}
+			}
+
+			if (!packet.IsEmpty()) {
+				transport.SendTo(SerializeDnsMessage(packet.message), destination);
+			}
+		}
+
+		pendingUnicastAnswers.clear();
+	}
+
+	void MdnsResponder::SendRateLimited(const DnsMessage& message, const std::chrono::steady_clock::time_point now)
+	{
+		Send(message, now);
+		packetSchedule = std::max(packetSchedule, now) + kPacketInterval;
+	}
+
+	void MdnsResponder::Send(const DnsMessage& message, const std::chrono::steady_clock::time_point now)
+	{
+		transport.Send(SerializeDnsMessage(message));
+
+		for (const auto& answer : message.answers) {
+			lastMulticast[GetRecordKey(answer)] = { now, std::chrono::seconds(answer.ttl) / 4 };
+		}
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "dns_message.h"
+#include "mdns_transport.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	struct MdnsServiceRegistration {
+
+		std::string name; // instance label as is, e.g. "My.Printer"
+		std::string type; // e.g. "_ipp._tcp"
+		uint16_t port = 0;
+		std::vector<uint8_t> txt; // TXT rdata, empty for no entries
+	};
+
+	// userspace mDNS responder (see https://datatracker.ietf.org/doc/html/rfc6762), alternative to DnsServiceRegister
+	// for many services; not thread safe, all calls must come from the same thread
+	//
+	// - the host records are shared by all services
+	// - answers to concurrent queries are aggregated and packed into as few packets as possible
+	// - announcements and goodbyes are rate limited, so registering hundreds of services doesn't flood the network
+	// - questions asking for a unicast response (QU) are answered by unicast if the answer has been multicast recently
+	//
+	// services aren't probed (section 8.1): names are expected to be unique, conflicts aren't detected
+	class MdnsResponder {
+	public:
+
+		using Clock = std::function<std::chrono::steady_clock::time_point()>;
+
+		MdnsResponder(MdnsTransport& transport, Clock clock = std::chrono::steady_clock::now, const uint32_t seed = std::random_device()());
+
+		MdnsResponder(const MdnsResponder&) = delete; // disallow copy
+		MdnsResponder& operator=(const MdnsResponder&) = delete; // disallow assign
+
+		// host name in presentation format, e.g. "desktop.local", addresses in network order (4 or 16 bytes)
+		void SetHost(const std::string& hostName, std::vector<std::vector<uint8_t>> addresses);
+		const std::string& GetHostName() const;
+
+		// announced by the next Poll(); throws NsdError if the name is taken or invalid
+		uint64_t Register(const MdnsServiceRegistration& registration);
+
+		// goodbyes are sent by the next Poll()
+		void Unregister(const uint64_t id);
+
+		// feeds a received packet; responses from other hosts are ignored
+		void OnPacket(const uint8_t* data, const size_t size, const MdnsEndpoint& source);
+
+		// sends due announcements, goodbyes and responses; call at GetNextDue() at the latest
+		void Poll();
+		std::optional<std::chrono::steady_clock::time_point> GetNextDue() const;
+
+		size_t GetServiceCount() const;
+
+	private:
+
+		static constexpr uint32_t kSharedTtl = 4500; // PTR and TXT, see section 10
+		static constexpr uint32_t kUniqueTtl = 120; // SRV and host records
+		static constexpr std::chrono::milliseconds kMinResponseDelay{ 20 }; // shared answers, see section 6
+		static constexpr std::chrono::milliseconds kMaxResponseDelay{ 120 };
+		static constexpr std::chrono::seconds kMinMulticastInterval{ 1 }; // per record, see section 6
+		static constexpr int kAnnouncements = 2; // one second apart, see section 8.3
+		static constexpr std::chrono::milliseconds kPacketInterval{ 50 }; // announcements and goodbyes, 20 packets per second
+		static constexpr int kMaxPacketBurst = 10;
+		static constexpr size_t kMaxPacketSize = 1400; // stays below the Ethernet MTU, see section 17
+
+		struct Service {
+
+			MdnsServiceRegistration registration;
+			std::string instanceName; // presentation format, e.g. "My\.Printer._ipp._tcp.local"
+			std::string serviceType; // presentation format, e.g. "_ipp._tcp.local"
+			int announcements = 0; // sent so far
+			std::chrono::steady_clock::time_point nextAnnouncement;
+		};
+
+		MdnsTransport& transport;
+		Clock clock;
+		std::minstd_rand random;
+
+		std::string hostName;
+		std::vector<std::vector<uint8_t>> addresses;
+
+		std::map<uint64_t, Service> services;
+		std::map<std::string, uint64_t> servicesByInstance; // lower case instance name -> id
+		std::multimap<std::string, uint64_t> servicesByType; // lower case service type -> ids
+		uint64_t nextId = 1;
+
+		std::vector<std::vector<DnsRecord>> goodbyes; // per unregistered service, not sent yet
+		std::vector<DnsRecord> pendingAnswers; // to received queries, aggregated until the response is due
+		std::optional<std::chrono::steady_clock::time_point> responseDue;
+		std::vector<std::pair<MdnsEndpoint, std::vector<DnsRecord>>> pendingUnicastAnswers; // per querier, not delayed
+		std::chrono::steady_clock::time_point unicastResponseDue;
+
+		struct Multicast {
+			std::chrono::steady_clock::time_point time;
+			std::chrono::steady_clock::duration interest; // how long the time matters, at least a quarter of the TTL
+		};
+		std::map<std::string, Multicast> lastMulticast; // record key -> last multicast
+
+		std::chrono::steady_clock::time_point packetSchedule; // when the next rate limited packet is due if sent at the rate, may lie in the past
+
+		std::vector<DnsRecord> GetServiceRecords(const Service& service) const; // PTR, SRV, TXT
+		DnsRecord GetServiceTypeRecord(const std::string& serviceType) const; // for service type enumeration
+		std::vector<DnsRecord> GetHostRecords(const DnsType type) const;
+		std::vector<DnsRecord> GetAdditionalRecords(const std::vector<DnsRecord>& answers) const;
+		void AddAnswers(const std::string& name, const DnsType type, std::vector<DnsRecord>& answers) const;
+
+		std::chrono::steady_clock::time_point GetNextPacketAllowed() const;
+		void SendGoodbyes(const std::chrono::steady_clock::time_point now); // rate limited
+		void SendAnnouncements(const std::chrono::steady_clock::time_point now); // rate limited
+		void SendResponse(const std::chrono::steady_clock::time_point now);
+		void SendUnicastResponses();
+		void SendRateLimited(const DnsMessage& message, const std::chrono::steady_clock::time_point now);
+		void Send(const DnsMessage& message, const std::chrono::steady_clock::time_point now);
+	};
+}
@@ -0,0 +1,177 @@
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "mdns_transport.h"
+#include "nsd_error.h"
+
+#include <cerrno>
+#include <string>
+
+namespace nsd_windows {
+
+	namespace {
+
+#ifdef _WIN32
+		using NativeSocket = SOCKET;
+		const NativeSocket kInvalidSocket = INVALID_SOCKET;
+
+		void CloseSocket(const NativeSocket socket) {
+			closesocket(socket);
+		}
+
+		int GetSocketError() {
+			return WSAGetLastError();
+		}
+#else
+		using NativeSocket = int;
+		const NativeSocket kInvalidSocket = -1;
+
+		void CloseSocket(const NativeSocket socket) {
+			shutdown(socket, SHUT_RDWR); // wakes up a blocking recvfrom()
+			close(socket);
+		}
+
+		int GetSocketError() {
+			return errno;
+		}
+#endif
+
+		constexpr size_t kMaxPacketSize = 9000; // see https://datatracker.ietf.org/doc/html/rfc6762#section-17
+
+		[[noreturn]] void ThrowSocketError(const std::string& operation) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, "mDNS socket: " + operation + " failed: " + std::to_string(GetSocketError()));
+		}
+	}
+
+	UdpMdnsTransport::~UdpMdnsTransport()
+	{
+		Stop();
+	}
+
+	void UdpMdnsTransport::Start(Receiver receiver)
+	{
+#ifdef _WIN32
+		WSADATA wsaData;
+		if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, "mDNS socket: WSAStartup failed");
+		}
+#endif
+
+		auto native = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (native == kInvalidSocket) {
+			ThrowSocketError("socket");
+		}
+
+		// the OS responder (and other applications) use the port as well
+		int reuse = 1;
+		setsockopt(native, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+#ifdef SO_REUSEPORT
+		setsockopt(native, SOL_SOCKET, SO_REUSEPORT, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+#endif
+
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(kPort);
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+
+		if (bind(native, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+			CloseSocket(native);
+			ThrowSocketError("bind");
+		}
+
+		ip_mreq membership{};
+		inet_pton(AF_INET, kGroup, &membership.imr_multiaddr);
+		membership.imr_interface.s_addr = htonl(INADDR_ANY);
+
+		if (setsockopt(native, IPPROTO_IP, IP_ADD_MEMBERSHIP, reinterpret_cast<const char*>(&membership), sizeof(membership)) != 0) {
+			CloseSocket(native);
+			ThrowSocketError("join group");
+		}
+
+		int ttl = 255; // see https://datatracker.ietf.org/doc/html/rfc6762#section-11
+		setsockopt(native, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&ttl), sizeof(ttl));
+
+		socket = static_cast<intptr_t>(native);
+		stopping = false;
+		receiveThread = std::thread(&UdpMdnsTransport::Receive, this, std::move(receiver));
+	}
+
+	void UdpMdnsTransport::Stop()
+	{
+		if (socket == -1) {
+			return;
+		}
+
+		stopping = true;
+		CloseSocket(static_cast<NativeSocket>(socket));
+
+		if (receiveThread.joinable()) {
+			receiveThread.join();
+		}
+
+		socket = -1;
+
+#ifdef _WIN32
+		WSACleanup();
+#endif
+	}
+
+	void UdpMdnsTransport::Send(const std::vector<uint8_t>& packet)
+	{
+		in_addr group{};
+		inet_pton(AF_INET, kGroup, &group);
+		SendTo(packet, { ntohl(group.s_addr), kPort });
+	}
+
+	void UdpMdnsTransport::SendTo(const std::vector<uint8_t>& packet, const MdnsEndpoint& destination)
+	{
+		if (socket == -1) {
+			return;
+		}
+
+		sockaddr_in address{};
+		address.sin_family = AF_INET;
+		address.sin_port = htons(destination.port);
+		address.sin_addr.s_addr = htonl(destination.address);
+
+		// losing a packet is fine, the next query follows according to the query schedule
+		sendto(static_cast<NativeSocket>(socket), reinterpret_cast<const char*>(packet.data()), static_cast<int>(packet.size()), 0,
+			reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+	}
+
+	void UdpMdnsTransport::Receive(Receiver receiver)
+	{
+		std::vector<uint8_t> buffer(kMaxPacketSize);
+
+		while (!stopping) {
+
+			sockaddr_in source{};
+			socklen_t sourceLength = sizeof(source);
+
+			const auto received = recvfrom(static_cast<NativeSocket>(socket), reinterpret_cast<char*>(buffer.data()), static_cast<int>(buffer.size()), 0,
+				reinterpret_cast<sockaddr*>(&source), &sourceLength);
+
+			if (received < 0) {
+				if (stopping) {
+					break;
+				}
+				continue; // e.g. WSAECONNRESET after an ICMP error, the socket is still usable
+			}
+
+			// responses must come from port 5353, see https://datatracker.ietf.org/doc/html/rfc6762#section-6
+			if (ntohs(source.sin_port) != kPort) {
+				continue;
+			}
+
+			receiver(std::vector<uint8_t>(buffer.begin(), buffer.begin() + received), { ntohl(source.sin_addr.s_addr), ntohs(source.sin_port) });
+		}
+	}
+}
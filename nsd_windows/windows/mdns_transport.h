@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace nsd_windows {
+
+	// IPv4 address and port in host order, e.g. 0xC0A80117 for 192.168.1.23
+	struct MdnsEndpoint {
+
+		uint32_t address = 0;
+		uint16_t port = 0;
+
+		bool operator==(const MdnsEndpoint& other) const {
+			return address == other.address && port == other.port;
+		}
+	};
+
+	// carries mDNS packets for the built-in querier and responder; the engines doesn't care whether they go over a socket or
+	// stay in memory
+	class MdnsTransport {
+	public:
+
+		using Receiver = std::function<void(std::vector<uint8_t> packet, MdnsEndpoint source)>;
+
+		virtual ~MdnsTransport() = default;
+
+		// the receiver may be called on any thread until Stop() returns
+		virtual void Start(Receiver receiver) = 0;
+		virtual void Stop() = 0;
+
+		// sends to the mDNS multicast group
+		virtual void Send(const std::vector<uint8_t>& packet) = 0;
+
+		// sends to a single host, e.g. a unicast response, see https://datatracker.ietf.org/doc/html/rfc6762#section-5.4
+		virtual void SendTo(const std::vector<uint8_t>& packet, const MdnsEndpoint& destination) = 0;
+	};
+
+	// IPv4 multicast on UDP port 5353, see https://datatracker.ietf.org/doc/html/rfc6762#section-3
+	class UdpMdnsTransport : public MdnsTransport {
+	public:
+
+		UdpMdnsTransport() = default;
+		virtual ~UdpMdnsTransport();
+
+		UdpMdnsTransport(const UdpMdnsTransport&) = delete; // disallow copy
+		UdpMdnsTransport& operator=(const UdpMdnsTransport&) = delete; // disallow assign
+
+		void Start(Receiver receiver) override; // throws NsdError if the socket can't be set up
+		void Stop() override;
+		void Send(const std::vector<uint8_t>& packet) override;
+		void SendTo(const std::vector<uint8_t>& packet, const MdnsEndpoint& destination) override;
+
+	private:
+
+		static constexpr uint16_t kPort = 5353;
+		static constexpr const char* kGroup = "224.0.0.251";
+
+		intptr_t socket = -1; // native socket handle
+		std::thread receiveThread;
+		std::atomic<bool> stopping{ false };
+
+		void Receive(Receiver receiver);
+	};
+}
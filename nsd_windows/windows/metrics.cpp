@@ -0,0 +1,154 @@
+#include "metrics.h"
+
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace nsd_windows {
+
+	namespace {
+
+		// index of the highest bit set, value must not be 0
+		uint32_t GetHighestBit(const uint64_t value) noexcept
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse64(&index, value);
+			return static_cast<uint32_t>(index);
+#else
+			return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+		}
+	}
+
+	size_t LatencyHistogram::GetBucketIndex(const uint64_t value) noexcept
+	{
+		if (value < kSubBuckets) {
+			return static_cast<size_t>(value);
+		}
+
+		const auto exponent = GetHighestBit(value); // kSubBucketBits or more
+		const auto subBucket = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+		return (exponent - kSubBucketBits + 1) * kSubBuckets + static_cast<size_t>(subBucket);
+	}
+
+	uint64_t LatencyHistogram::GetBucketLimit(const size_t index) noexcept
+	{
+		if (index < kSubBuckets) {
+			return index;
+		}
+
+		const auto shift = static_cast<uint32_t>(index / kSubBuckets - 1);
+		const auto lowest = (kSubBuckets + index % kSubBuckets) << shift;
+		return lowest + (uint64_t{ 1 } << shift) - 1;
+	}
+
+	void LatencyHistogram::Record(uint64_t value) noexcept
+	{
+		value = std::min(value, kMaxValue);
+
+		buckets[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+		sum.fetch_add(value, std::memory_order_relaxed);
+
+		// rarely more than a load once a few values are in
+		auto current = min.load(std::memory_order_relaxed);
+		while (value < current && !min.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+
+		current = max.load(std::memory_order_relaxed);
+		while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+	}
+
+	LatencyHistogram::Summary LatencyHistogram::Summarize(const bool reset)
+	{
+		std::array<uint64_t, kBucketCount> counts;
+		Summary summary;
+
+		for (size_t i = 0; i < kBucketCount; i++) {
+			counts[i] = reset ? buckets[i].exchange(0, std::memory_order_relaxed) : buckets[i].load(std::memory_order_relaxed);
+			summary.count += counts[i];
+		}
+
+		const auto total = reset ? sum.exchange(0, std::memory_order_relaxed) : sum.load(std::memory_order_relaxed);
+		summary.min = reset ? min.exchange(UINT64_MAX, std::memory_order_relaxed) : min.load(std::memory_order_relaxed);
+		summary.max = reset ? max.exchange(0, std::memory_order_relaxed) : max.load(std::memory_order_relaxed);
+
+		if (summary.count == 0) {
+			return Summary();
+		}
+
+		summary.mean = total / summary.count;
+
+		const std::array<std::pair<uint64_t, uint64_t*>, 3> percentiles{ {
+			{ 50, &summary.p50 },
+			{ 90, &summary.p90 },
+			{ 99, &summary.p99 },
+		} };
+
+		size_t bucket = 0;
+		uint64_t seen = counts[0];
+
+		for (const auto& [percentile, result] : percentiles) {
+
+			const auto rank = std::max<uint64_t>((summary.count * percentile + 99) / 100, 1);
+			while (seen < rank) {
+				seen += counts[++bucket];
+			}
+			*result = std::min(GetBucketLimit(bucket), summary.max);
+		}
+
+		return summary;
+	}
+
+	void StatusCounter::Record(const uint32_t status) noexcept
+	{
+		const auto key = uint64_t{ status } + 1;
+
+		for (auto& slot : slots) {
+
+			auto current = slot.key.load(std::memory_order_relaxed);
+			if (current == 0 && slot.key.compare_exchange_strong(current, key, std::memory_order_relaxed)) {
+				current = key; // assigned it
+			}
+
+			if (current == key) {
+				slot.count.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+
+		other.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	StatusCounter::Summary StatusCounter::Summarize(const bool reset)
+	{
+		Summary summary;
+
+		for (auto& slot : slots) {
+
+			const auto key = slot.key.load(std::memory_order_relaxed);
+			if (key == 0) {
+				break; // slots are assigned in order
+			}
+
+			const auto count = reset ? slot.count.exchange(0, std::memory_order_relaxed) : slot.count.load(std::memory_order_relaxed);
+			if (count == 0) {
+				continue;
+			}
+
+			const auto status = static_cast<uint32_t>(key - 1);
+			summary.statuses.emplace_back(status, count);
+			summary.total += count;
+			if (status != 0) {
+				summary.failures += count;
+			}
+		}
+
+		summary.other = reset ? other.exchange(0, std::memory_order_relaxed) : other.load(std::memory_order_relaxed);
+		summary.total += summary.other;
+		summary.failures += summary.other;
+
+		return summary;
+	}
+}
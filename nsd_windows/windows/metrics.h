@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// latency histogram in microseconds, HDR style: values below kSubBuckets get a bucket each, above that every
+	// power of two is split into kSubBuckets linear buckets, so percentiles are off by less than 12.5%;
+	// values of kMaxValue and more are clamped
+	//
+	// Record() is lock-free and may be called from any thread, it only does relaxed atomic adds
+	class LatencyHistogram {
+	public:
+
+		static constexpr uint32_t kSubBucketBits = 3;
+		static constexpr size_t kSubBuckets = size_t{ 1 } << kSubBucketBits;
+		static constexpr uint32_t kMaxExponent = 40; // about 12 days
+		static constexpr uint64_t kMaxValue = (uint64_t{ 1 } << kMaxExponent) - 1;
+		static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+		struct Summary {
+			uint64_t count = 0;
+			uint64_t min = 0;
+			uint64_t max = 0;
+			uint64_t mean = 0;
+			uint64_t p50 = 0; // highest value of the bucket the percentile falls into, at most max
+			uint64_t p90 = 0;
+			uint64_t p99 = 0;
+		};
+
+		LatencyHistogram() = default;
+
+		LatencyHistogram(const LatencyHistogram&) = delete; // disallow copy
+		LatencyHistogram& operator=(const LatencyHistogram&) = delete; // disallow assign
+
+		void Record(const std::chrono::steady_clock::duration duration) noexcept {
+			const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+			Record(micros > 0 ? static_cast<uint64_t>(micros) : 0);
+		}
+
+		void Record(uint64_t value) noexcept;
+
+		// reset clears what has been summarized; values recorded concurrently end up in this summary or the next
+		Summary Summarize(const bool reset);
+
+		static size_t GetBucketIndex(const uint64_t value) noexcept;
+		static uint64_t GetBucketLimit(const size_t index) noexcept; // highest value of the bucket
+
+	private:
+
+		std::array<std::atomic<uint64_t>, kBucketCount> buckets{};
+		std::atomic<uint64_t> sum{ 0 };
+		std::atomic<uint64_t> min{ UINT64_MAX };
+		std::atomic<uint64_t> max{ 0 };
+	};
+
+	// counts by DWORD status; the first kSlots distinct statuses get a slot each, later ones are counted as other,
+	// which is plenty since callbacks report a handful of statuses at most
+	//
+	// Record() is lock-free and may be called from any thread
+	class StatusCounter {
+	public:
+
+		static constexpr size_t kSlots = 16;
+
+		struct Summary {
+			uint64_t total = 0;
+			uint64_t failures = 0; // statuses other than ERROR_SUCCESS, including other
+			uint64_t other = 0;
+			std::vector<std::pair<uint32_t, uint64_t>> statuses; // in the order they first occurred
+		};
+
+		StatusCounter() = default;
+
+		StatusCounter(const StatusCounter&) = delete; // disallow copy
+		StatusCounter& operator=(const StatusCounter&) = delete; // disallow assign
+
+		void Record(const uint32_t status) noexcept;
+
+		// slots stay assigned on reset, only their counts are cleared
+		Summary Summarize(const bool reset);
+
+	private:
+
+		struct Slot {
+			std::atomic<uint64_t> key{ 0 }; // status + 1, 0 while unassigned
+			std::atomic<uint64_t> count{ 0 };
+		};
+
+		std::array<Slot, kSlots> slots;
+		std::atomic<uint64_t> other{ 0 };
+	};
+
+	// an operation from start to completion, e.g. a resolve; completions are counted by status
+	struct OperationMetrics {
+
+		StatusCounter statuses;
+		LatencyHistogram latency;
+	};
+
+	// results of one kind of DNS API callback; only counted, timestamps would cost more than the counting
+	struct CallbackMetrics {
+
+		StatusCounter statuses;
+		std::atomic<uint64_t> dropped{ 0 }; // not passed on to the platform thread, e.g. failed browse callbacks
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace nsd_windows {
+
+	// lock-free unbounded multi-producer / single-consumer queue
+	// see https://www.1024cores.net/home/lock-free-algorithms/queues/intrusive-mpsc-node-based-queue
+	//
+	// Push() may be called from any thread, Pop() only from one thread at a time.
+	template<typename T>
+	class MpscQueue {
+	public:
+
+		MpscQueue() : head(&stub), tail(&stub) {}
+
+		virtual ~MpscQueue() {
+			while (Pop().has_value()) {}
+		}
+
+		MpscQueue(const MpscQueue&) = delete; // disallow copy
+		MpscQueue& operator=(const MpscQueue&) = delete; // disallow assign
+
+		void Push(T value) {
+			Enqueue(new Node(std::move(value)));
+		}
+
+		// returns nullopt if the queue is empty or if a producer is in the middle of a push; in the latter
+		// case the element becomes visible once that push completes
+		std::optional<T> Pop() {
+
+			auto current = tail;
+			auto next = current->next.load(std::memory_order_acquire);
+
+			if (current == &stub) {
+				if (next == nullptr) {
+					return std::nullopt;
+				}
+				tail = next;
+				current = next;
+				next = next->next.load(std::memory_order_acquire);
+			}
+
+			if (next == nullptr) {
+
+				if (current != head.load(std::memory_order_acquire)) {
+					return std::nullopt; // producer has swapped the head but not linked its node yet
+				}
+
+				Enqueue(&stub); // current is the last node: put the stub behind it so it can be unlinked
+				next = current->next.load(std::memory_order_acquire);
+
+				if (next == nullptr) {
+					return std::nullopt;
+				}
+			}
+
+			tail = next;
+
+			auto node = static_cast<Node*>(current);
+			std::optional<T> value(std::move(node->value));
+			delete node;
+			return value;
+		}
+
+	private:
+
+		struct NodeBase {
+			std::atomic<NodeBase*> next{ nullptr };
+		};
+
+		struct Node : NodeBase {
+			explicit Node(T&& value) : value(std::move(value)) {}
+			T value;
+		};
+
+		void Enqueue(NodeBase* node) {
+			node->next.store(nullptr, std::memory_order_relaxed);
+			auto previous = head.exchange(node, std::memory_order_acq_rel);
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		NodeBase stub;
+		std::atomic<NodeBase*> head; // written by producers
+		NodeBase* tail; // consumer only
+	};
+}
@@ -0,0 +1,58 @@
+#include "network_interfaces.h"
+
+#include <algorithm>
+
+namespace nsd_windows {
+
+	std::vector<uint32_t> SelectInterfaces(const InterfaceSelection& selection, const std::vector<NetworkInterface>& available)
+	{
+		if (selection.mode == InterfaceSelection::ANY) {
+			return { kAnyInterface };
+		}
+
+		std::vector<uint32_t> selected;
+
+		for (const auto& networkInterface : available) {
+
+			if (!networkInterface.up || networkInterface.index == kAnyInterface) {
+				continue;
+			}
+
+			if (selection.mode == InterfaceSelection::ALL) {
+				if (!networkInterface.loopback) {
+					selected.push_back(networkInterface.index);
+				}
+			}
+			else if (std::find(selection.indexes.begin(), selection.indexes.end(), networkInterface.index) != selection.indexes.end()) {
+				selected.push_back(networkInterface.index); // loopback is fine if asked for explicitly
+			}
+		}
+
+		std::sort(selected.begin(), selected.end());
+		selected.erase(std::unique(selected.begin(), selected.end()), selected.end());
+		return selected;
+	}
+
+	bool InterfaceSet::Add(const uint32_t index)
+	{
+		auto wasEmpty = indexes.empty();
+		if (std::find(indexes.begin(), indexes.end(), index) == indexes.end()) {
+			indexes.push_back(index);
+		}
+		return wasEmpty;
+	}
+
+	bool InterfaceSet::Remove(const uint32_t index)
+	{
+		auto it = std::find(indexes.begin(), indexes.end(), index);
+		if (it != indexes.end()) {
+			indexes.erase(it);
+		}
+		return indexes.empty();
+	}
+
+	bool InterfaceSet::Empty() const
+	{
+		return indexes.empty();
+	}
+}
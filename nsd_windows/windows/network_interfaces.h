@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	// index 0 lets the OS choose the interface(s), see DNS_SERVICE_BROWSE_REQUEST
+	constexpr uint32_t kAnyInterface = 0;
+
+	// network adapter independent of the IP helper API, so the selection below can be exercised with canned lists
+	struct NetworkInterface {
+
+		uint32_t index;
+		std::string name;
+		bool up = false;
+		bool loopback = false;
+	};
+
+	// requested interfaces of an operation
+	struct InterfaceSelection {
+
+		enum Mode {
+			ANY, // OS default, a single request with index 0
+			ALL, // every up, non-loopback interface, one request each
+			LIST, // the given indexes, one request each
+		};
+
+		Mode mode = ANY;
+		std::vector<uint32_t> indexes; // LIST only
+	};
+
+	// interface indexes to start requests on, sorted and without duplicates; empty if none of the
+	// requested interfaces is usable
+	std::vector<uint32_t> SelectInterfaces(const InterfaceSelection& selection, const std::vector<NetworkInterface>& available);
+
+	// interfaces a service has been seen on, so that it is reported found / lost once across interfaces
+	class InterfaceSet {
+	public:
+
+		// returns true if the set was empty before
+		bool Add(const uint32_t index);
+
+		// returns true if the set is empty afterwards
+		bool Remove(const uint32_t index);
+
+		bool Empty() const;
+
+	private:
+
+		std::vector<uint32_t> indexes; // usually one or two, a vector beats any set here
+	};
+}
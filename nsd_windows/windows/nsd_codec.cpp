@@ -0,0 +1,57 @@
+#include "nsd_codec.h"
+
+#include <any>
+
+namespace nsd_windows {
+
+	const flutter::EncodableValue* EventRecord::Get(const EventKey key) const
+	{
+		const auto index = static_cast<size_t>(key);
+		return (keys & (1u << index)) != 0 ? &values[index] : nullptr;
+	}
+
+	flutter::EncodableValue* EventRecord::Get(const EventKey key)
+	{
+		return const_cast<flutter::EncodableValue*>(static_cast<const EventRecord&>(*this).Get(key));
+	}
+
+	const NsdCodecSerializer& NsdCodecSerializer::GetInstance()
+	{
+		static NsdCodecSerializer instance;
+		return instance;
+	}
+
+	void NsdCodecSerializer::WriteValue(const flutter::EncodableValue& value, flutter::ByteStreamWriter* stream) const
+	{
+		auto custom = std::get_if<flutter::CustomEncodableValue>(&value);
+		auto record = custom != nullptr ? std::any_cast<EventRecord>(&static_cast<const std::any&>(*custom)) : nullptr;
+
+		if (record == nullptr) {
+			StandardCodecSerializer::WriteValue(value, stream);
+			return;
+		}
+
+		const auto keys = record->GetKeys();
+
+		stream->WriteByte(kEventRecordType);
+		stream->WriteByte(static_cast<uint8_t>(keys & 0xFF));
+		stream->WriteByte(static_cast<uint8_t>(keys >> 8));
+
+		for (size_t index = 0; index < static_cast<size_t>(EventKey::COUNT); index++) {
+			auto field = record->Get(static_cast<EventKey>(index));
+			if (field != nullptr) {
+				WriteValue(*field, stream); // records may contain lists of records
+			}
+		}
+	}
+
+	flutter::EncodableValue CreateEventValue(EventRecord record)
+	{
+		return flutter::EncodableValue(flutter::CustomEncodableValue(std::move(record)));
+	}
+
+	std::unique_ptr<flutter::EncodableValue> CreateEvent(EventRecord record)
+	{
+		return std::make_unique<flutter::EncodableValue>(CreateEventValue(std::move(record)));
+	}
+}
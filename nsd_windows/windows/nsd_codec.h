@@ -0,0 +1,81 @@
+#pragma once
+
+#include <flutter/encodable_value.h>
+#include <flutter/standard_method_codec.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace nsd_windows {
+
+	// keys of event records, as small integer tags; the dart side maps them back to the key strings
+	// in the same order (see codec.dart in nsd_platform_interface), so new keys go to the end
+	enum class EventKey : uint8_t {
+		HANDLE,
+		SERVICE_NAME,
+		SERVICE_TYPE,
+		SERVICE_HOST,
+		SERVICE_PORT,
+		SERVICE_TXT_RAW,
+		SERVICE_ADDRESSES,
+		SERVICE_INTERFACE_INDEX,
+		SERVICE_RESOLVED,
+		SERVICE_STATUS,
+		SERVICE_CHANGES,
+		SERVICE_TYPES,
+		ERROR_CAUSE,
+		ERROR_MESSAGE,
+		RESULTS,
+		EVENT, // method name of events on a discovery's event channel
+		COUNT
+	};
+
+	// arguments of a message to the dart side: one slot per key instead of a map with string keys
+	class EventRecord {
+	public:
+
+		template<typename T>
+		EventRecord& Set(const EventKey key, T&& value) & {
+			const auto index = static_cast<size_t>(key);
+			values[index] = flutter::EncodableValue(std::forward<T>(value));
+			keys |= 1u << index;
+			return *this;
+		}
+
+		template<typename T>
+		EventRecord&& Set(const EventKey key, T&& value) && {
+			return std::move(Set(key, std::forward<T>(value)));
+		}
+
+		// null if the key hasn't been set
+		const flutter::EncodableValue* Get(const EventKey key) const;
+		flutter::EncodableValue* Get(const EventKey key);
+
+		uint16_t GetKeys() const { return keys; } // bit per key
+
+	private:
+
+		static_assert(static_cast<size_t>(EventKey::COUNT) <= 16, "keys must fit into 16 bits");
+
+		uint16_t keys = 0;
+		std::array<flutter::EncodableValue, static_cast<size_t>(EventKey::COUNT)> values;
+	};
+
+	// standard codec plus event records, encoded as type byte, key bits (16 bit little endian)
+	// and the values of the present keys in key order; messages from the dart side are plain
+	// standard codec, so other platforms can keep using the standard codec on the same channel
+	class NsdCodecSerializer : public flutter::StandardCodecSerializer {
+	public:
+
+		static constexpr uint8_t kEventRecordType = 128; // first type not used by the standard codec
+
+		static const NsdCodecSerializer& GetInstance();
+
+		void WriteValue(const flutter::EncodableValue& value, flutter::ByteStreamWriter* stream) const override;
+	};
+
+	flutter::EncodableValue CreateEventValue(EventRecord record); // e.g. for lists of records
+	std::unique_ptr<flutter::EncodableValue> CreateEvent(EventRecord record); // method arguments
+}
@@ -17,6 +17,9 @@ namespace nsd_windows {
 		case OPERATION_NOT_SUPPORTED:
 			return "operationNotSupported";
 
+		case TIMEOUT:
+			return "timeout";
+
 		case INTERNAL_ERROR:
 		default:
 			return "internalError";
@@ -27,7 +30,7 @@ namespace nsd_windows {
 		return message.c_str(); 
 	}
 
-	NsdError::NsdError(const ErrorCause errorCause, const std::string& message) : errorCause(errorCause), message(message)
+	NsdError::NsdError(const ErrorCause errorCause, const std::string& message) : message(message), errorCause(errorCause)
 	{
 	}
 
@@ -12,6 +12,7 @@ namespace nsd_windows {
 		MAX_LIMIT,
 		OPERATION_NOT_SUPPORTED,
 		INTERNAL_ERROR,
+		TIMEOUT,
 	};
 
 	std::string ToErrorCode(const ErrorCause errorCause);
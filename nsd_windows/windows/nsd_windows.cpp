@@ -1,13 +1,18 @@
 #include "nsd_windows.h"
 
+#include "ip_address.h"
+#include "nsd_codec.h"
 #include "nsd_error.h"
+#include "service_instance_name.h"
 #include "utilities.h"
 
+#include <flutter/event_stream_handler_functions.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 
 #include <windows.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -15,20 +20,193 @@
 
 namespace nsd_windows {
 
-	NsdWindows::NsdWindows(std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel) {
+	NsdWindows::NsdWindows(flutter::PluginRegistrarWindows* registrar, std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel) {
+		this->registrar = registrar;
 		this->methodChannel = std::move(methodChannel);
 		this->methodChannel->SetMethodCallHandler(
 			[nsdWindows = this](const auto& call, auto result) { nsdWindows->HandleMethodCall(call, result);
 			});
 		this->systemRequirementsSatisfied = CheckSystemRequirementsSatisfied();
+		this->useBuiltInMdns = !this->systemRequirementsSatisfied; // older versions lack DnsServiceBrowse / DnsServiceResolve
+
+		// DNS API callbacks are handed over to the platform thread via a message to the top level window
+		this->window = GetAncestor(registrar->GetView()->GetNativeWindow(), GA_ROOT);
+		this->drainMessage = RegisterWindowMessage(L"com.haberey.nsd.drain");
+		this->windowProcDelegateId = registrar->RegisterTopLevelWindowProcDelegate(
+			[nsdWindows = this](HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) { return nsdWindows->HandleWindowProc(hwnd, message, wparam, lparam);
+			});
+
+		this->resolveDeadlineTimer = CreateThreadpoolTimer(&ResolveDeadlineTimerCallback, this, nullptr);
+	}
+
+	NsdWindows::~NsdWindows() {
+		registrar->UnregisterTopLevelWindowProcDelegate(windowProcDelegateId);
+
+		if (mdnsTransport) {
+			mdnsTransport->Stop(); // no more packets from the receive thread
+		}
+
+		if (mdnsTimer != nullptr) {
+			SetThreadpoolTimer(mdnsTimer, nullptr, 0, 0); // disarm
+			WaitForThreadpoolTimerCallbacks(mdnsTimer, TRUE);
+			CloseThreadpoolTimer(mdnsTimer);
+		}
+
+		if (resolveDeadlineTimer != nullptr) {
+			SetThreadpoolTimer(resolveDeadlineTimer, nullptr, 0, 0); // disarm
+			WaitForThreadpoolTimerCallbacks(resolveDeadlineTimer, TRUE);
+			CloseThreadpoolTimer(resolveDeadlineTimer);
+		}
+	}
+
+	bool ServiceInfo::IsResolved() const
+	{
+		return host.has_value() && port.has_value() && txt.has_value();
+	}
+
+	DiscoveryBatch::DiscoveryBatch(std::chrono::milliseconds interval, size_t maxSize) : interval(interval), maxSize(maxSize) {}
+
+	DiscoveryBatch::~DiscoveryBatch()
+	{
+		if (timer != nullptr) {
+			SetThreadpoolTimer(timer, nullptr, 0, 0); // disarm
+			WaitForThreadpoolTimerCallbacks(timer, TRUE); // discard queued callbacks, wait for running ones
+			CloseThreadpoolTimer(timer);
+		}
+	}
+
+	DiscoveryStream::DiscoveryStream(flutter::BinaryMessenger* messenger, const std::string& name) :
+		channel(std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+			messenger, name, &flutter::StandardMethodCodec::GetInstance(&NsdCodecSerializer::GetInstance()))) {}
+
+	DiscoveryStream::~DiscoveryStream()
+	{
+		channel->SetStreamHandler(nullptr); // destroying the channel alone leaves its handler registered
+	}
+
+	void NsdWindows::Post(DnsCallbackResult result)
+	{
+		metrics.callbacks[result.kind].statuses.Record(result.status);
+		callbackQueue.Push(std::move(result));
+		ScheduleDrain();
+	}
+
+	void NsdWindows::ScheduleDrain()
+	{
+		// a single pending message drains everything that was queued before it is handled
+		if (drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+			return;
+		}
+
+		tracer.Instant("dispatch", "ScheduleDrain");
+		drainPostedAt.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed); // once per message, not per result
+		PostMessage(window, drainMessage, 0, 0);
 	}
 
-	NsdWindows::~NsdWindows() {}
+	std::optional<LRESULT> NsdWindows::HandleWindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam)
+	{
+		if (message != drainMessage) {
+			return std::nullopt;
+		}
+
+		DrainCallbackQueue();
+		return 0;
+	}
+
+	void NsdWindows::DrainCallbackQueue()
+	{
+		// reset before draining so producers that push from now on post a new message
+		drainScheduled.exchange(false, std::memory_order_acq_rel);
+
+		const std::chrono::steady_clock::time_point posted(std::chrono::steady_clock::duration(drainPostedAt.load(std::memory_order_relaxed)));
+		metrics.drainDelay.Record(std::chrono::steady_clock::now() - posted);
+
+		TraceSpan span(tracer, "dispatch", "DrainCallbackQueue");
+
+		retiredStreams.clear(); // their handlers have returned by now
+
+		for (size_t i = 0; i < kMaxCallbackResultsPerDrain; i++) {
+
+			auto result = callbackQueue.Pop();
+			if (!result.has_value()) {
+				return;
+			}
+
+			Dispatch(result.value());
+		}
+
+		// results left: continue with the next message so other window messages are not starved
+		ScheduleDrain();
+	}
+
+	void NsdWindows::Dispatch(DnsCallbackResult& result)
+	{
+		TraceSpan span(tracer, "dispatch", kCallbackKindNames[result.kind]);
+
+		switch (result.kind) {
+		case DnsCallbackResult::SERVICE_DISCOVERED:
+			OnServiceDiscovered(result.id, result.serviceInfo.value());
+			break;
+
+		case DnsCallbackResult::BROWSE_CANCELLED:
+			OnBrowseCancelled(result.id, result.context);
+			break;
+
+		case DnsCallbackResult::SERVICE_TYPE_DISCOVERED:
+			OnServiceTypeDiscovered(result.id, result.serviceInfo.value());
+			break;
+
+		case DnsCallbackResult::SERVICE_RESOLVED:
+			OnServiceResolved(result.id, result.status, result.serviceInfo);
+			break;
+
+		case DnsCallbackResult::SERVICE_REGISTERED:
+			OnServiceRegistered(result.id, result.status, result.serviceInfo, result.pInstance);
+			break;
+
+		case DnsCallbackResult::SERVICE_UNREGISTERED:
+			OnServiceUnregistered(result.id, result.status);
+			break;
+
+		case DnsCallbackResult::DISCOVERY_BATCH_DUE:
+			OnDiscoveryBatchDue(result.id);
+			break;
+
+		case DnsCallbackResult::ADDRESSES_QUERIED:
+			OnAddressesQueried(result.id, result.status, result.serviceInfo, result.context);
+			break;
+
+		case DnsCallbackResult::RESOLVE_DEADLINE_DUE:
+			OnResolveDeadlineDue();
+			break;
+
+		case DnsCallbackResult::MDNS_PACKET_RECEIVED:
+			if (mdnsQuerier) {
+				mdnsQuerier->OnPacket(result.packet.data(), result.packet.size()); // responses
+			}
+			if (mdnsResponder) {
+				mdnsResponder->OnPacket(result.packet.data(), result.packet.size(), result.packetSource); // queries
+			}
+			ArmMdnsTimer();
+			break;
+
+		case DnsCallbackResult::MDNS_DUE:
+			if (mdnsQuerier) {
+				mdnsQuerier->Poll();
+			}
+			if (mdnsResponder) {
+				mdnsResponder->Poll();
+			}
+			ArmMdnsTimer();
+			break;
+		}
+	}
 
 	void NsdWindows::HandleMethodCall(const flutter::MethodCall<flutter::EncodableValue>& methodCall,
 		std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result) {
 
 		const auto& method_name = methodCall.method_name();
+		TraceSpan span(tracer, "method", "HandleMethodCall", method_name);
 
 		try {
 			const auto& arguments = std::get<flutter::EncodableMap>(*methodCall.arguments());
@@ -45,9 +223,36 @@ namespace nsd_windows {
 			else if (method_name == "resolve") {
 				Resolve(arguments, result);
 			}
+			else if (method_name == "cancelResolve") {
+				CancelResolve(arguments, result);
+			}
 			else if (method_name == "unregister") {
 				Unregister(arguments, result);
 			}
+			else if (method_name == "registerMany") {
+				RegisterMany(arguments, result);
+			}
+			else if (method_name == "unregisterMany") {
+				UnregisterMany(arguments, result);
+			}
+			else if (method_name == "setBackend") {
+				SetBackend(arguments, result);
+			}
+			else if (method_name == "setEventPort") {
+				SetEventPort(arguments, result);
+			}
+			else if (method_name == "getServiceChanges") {
+				GetServiceChanges(arguments, result);
+			}
+			else if (method_name == "getMetrics") {
+				GetMetrics(arguments, result);
+			}
+			else if (method_name == "setTracing") {
+				SetTracing(arguments, result);
+			}
+			else if (method_name == "dumpTrace") {
+				DumpTrace(arguments, result);
+			}
 			else {
 				result->NotImplemented();
 			}
@@ -62,34 +267,61 @@ namespace nsd_windows {
 
 	void NsdWindows::StartDiscovery(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
 	{
-		if (!this->systemRequirementsSatisfied) {
-			throw NsdError(ErrorCause::OPERATION_NOT_SUPPORTED, "Plugin requires at least Windows 10, build 18362");
+		auto handle = Deserialize<std::string>(arguments, "handle");
+		auto serviceTypes = DeserializeServiceTypes(arguments);
+		auto enumerateTypes = DeserializeOptional<bool>(arguments, "discovery.enumerateTypes").value_or(false);
+
+		if (enumerateTypes && (serviceTypes.size() != 1 || serviceTypes[0] != kServiceTypeEnumerationType)) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Type enumeration requires service type "s + kServiceTypeEnumerationType);
 		}
 
-		auto handle = Deserialize<std::string>(arguments, "handle");
-		auto serviceType = Deserialize<std::string>(arguments, "service.type");
+		if (discoveryHandles.find(handle) != discoveryHandles.end()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Handle in use");
+		}
 
-		auto context = std::make_unique<DiscoveryContext>();
+		auto [id, context] = discoveryContexts.Emplace();
 		context->nsdWindows = this;
+		context->id = id;
 		context->handle = handle;
+		context->enumerateTypes = enumerateTypes;
+		context->metrics = std::make_shared<DiscoveryMetrics>();
+		context->started = std::chrono::steady_clock::now();
+
+		if (DeserializeOptional<bool>(arguments, "discovery.stream").value_or(false)) {
+			context->stream = std::make_unique<DiscoveryStream>(registrar->messenger(), kDiscoveryChannelPrefix + handle);
+			context->stream->channel->SetStreamHandler(std::make_unique<flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+				[nsdWindows = this, id](const flutter::EncodableValue* arguments, std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&& sink)
+				-> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+					nsdWindows->OnDiscoveryListen(id, std::move(sink));
+					return nullptr;
+				},
+				[nsdWindows = this, id](const flutter::EncodableValue* arguments)
+				-> std::unique_ptr<flutter::StreamHandlerError<flutter::EncodableValue>> {
+					nsdWindows->OnDiscoveryCancel(id);
+					return nullptr;
+				}));
+		}
 
-		auto queryName = ToUtf16(serviceType + ".local");
-
-		DNS_SERVICE_BROWSE_REQUEST request{};
-		request.Version = DNS_QUERY_REQUEST_VERSION1;
-		request.InterfaceIndex = 0;
-		request.QueryName = queryName.c_str();
-		request.pBrowseCallback = &DnsServiceBrowseCallback;
-		request.pQueryContext = context.get();
+		// browses are asynchronous, so they all run in parallel
 
-		auto status = DnsServiceBrowse(&request, &context->canceller);
+		try {
+			context->batch = CreateDiscoveryBatch(arguments, *context);
+			context->autoResolve = DeserializeOptional<bool>(arguments, "discovery.autoResolve").value_or(false);
+			context->ipLookupType = DeserializeIpLookupType(arguments);
+			context->interfaces = DeserializeInterfaces(arguments);
 
-		if (status != DNS_REQUEST_PENDING) {
-			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+			for (const auto& serviceType : serviceTypes) {
+				StartBrowse(*context, serviceType, context->enumerateTypes);
+			}
+		}
+		catch (const std::exception&) {
+			CancelBrowses(*context); // the ones started so far
+			discoveryContexts.Erase(id);
+			throw;
 		}
 
-		discoveryContextMap[handle] = std::move(context);
-		methodChannel->InvokeMethod("onDiscoveryStartSuccessful", CreateMethodResult({ { "handle", handle } }));
+		discoveryHandles[handle] = id;
+		SendDiscoveryEvent(*context, "onDiscoveryStartSuccessful", EventRecord().Set(EventKey::HANDLE, handle));
 		result->Success();
 	}
 
@@ -97,347 +329,1997 @@ namespace nsd_windows {
 	{
 		auto handle = Deserialize<std::string>(arguments, "handle");
 
-		auto it = discoveryContextMap.find(handle);
-		if (it == discoveryContextMap.end()) {
+		auto it = discoveryHandles.find(handle);
+		if (it == discoveryHandles.end()) {
 			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown handle");
 		}
 
-		auto& context = *it->second.get();
-
-		const auto status = DnsServiceBrowseCancel(&context.canceller);
-		discoveryContextMap.erase(it);
+		const auto status = RemoveDiscoveryContext(*discoveryContexts.Get(it->second));
 
 		if (status != ERROR_SUCCESS) {
 			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
 		}
 
-		methodChannel->InvokeMethod("onDiscoveryStopSuccessful", CreateMethodResult({ { "handle", handle } }));
+		SendEvent("onDiscoveryStopSuccessful", EventRecord().Set(EventKey::HANDLE, handle));
 		result->Success();
 	}
 
-	void NsdWindows::Resolve(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	void NsdWindows::GetServiceChanges(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
 	{
+		// one page of the discovery's journal; since 0 means from scratch, so tombstones are left out then, and
+		// entries that change while the dart side pages through move to a later page
+
 		auto handle = Deserialize<std::string>(arguments, "handle");
-		auto serviceName = Deserialize<std::string>(arguments, "service.name");
-		auto serviceType = Deserialize<std::string>(arguments, "service.type");
+		auto since = static_cast<uint64_t>(DeserializeLong(arguments, "journal.since").value_or(0));
+		auto pageSize = DeserializeOptional<int>(arguments, "page.size").value_or(kDefaultJournalPageSize);
 
-		auto context = std::make_unique<ResolveContext>();
-		context->nsdWindows = this;
-		context->handle = handle;
+		if (pageSize <= 0) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Page size must be positive");
+		}
 
-		auto queryName = ToUtf16(serviceName + "." + serviceType + ".local");
+		auto it = discoveryHandles.find(handle);
+		if (it == discoveryHandles.end()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown handle");
+		}
 
-		DNS_SERVICE_RESOLVE_REQUEST request{};
-		request.Version = DNS_QUERY_REQUEST_VERSION1;
-		request.InterfaceIndex = 0;
-		request.QueryName = const_cast<PWSTR>(queryName.c_str());
-		request.pResolveCompletionCallback = &DnsServiceResolveCallback;
-		request.pQueryContext = context.get();
+		const auto& journal = discoveryContexts.Get(it->second)->journal;
+		const auto page = journal.GetChanges(since, static_cast<size_t>(pageSize), since > 0);
 
-		const auto status = DnsServiceResolve(&request, &context->canceller);
+		flutter::EncodableList changes;
+		changes.reserve(page.changes.size());
 
-		if (status != DNS_REQUEST_PENDING) {
-			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+		for (const auto& change : page.changes) {
+			auto serializedChange = SerializeServiceInfo(*change.value);
+			serializedChange.Set(EventKey::SERVICE_STATUS, change.present ? "found"s : "lost"s);
+			changes.push_back(CreateEventValue(std::move(serializedChange)));
 		}
 
-		resolveContextMap[handle] = std::move(context);
-		result->Success();
+		result->Success(flutter::EncodableValue(flutter::EncodableMap{
+			{ flutter::EncodableValue("service.changes"), flutter::EncodableValue(std::move(changes)) },
+			{ flutter::EncodableValue("journal.next"), flutter::EncodableValue(static_cast<int64_t>(page.next)) },
+			{ flutter::EncodableValue("journal.more"), flutter::EncodableValue(page.more) },
+			{ flutter::EncodableValue("journal.snapshotRequired"), flutter::EncodableValue(page.snapshotRequired) },
+			}));
 	}
 
-	void NsdWindows::Register(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	void NsdWindows::GetMetrics(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
 	{
-		if (!this->systemRequirementsSatisfied) {
-			throw NsdError(ErrorCause::OPERATION_NOT_SUPPORTED, "Plugin requires at least Windows 10, build 18362");
-		}
+		// plugin wide, or of a single discovery if a handle is given; latencies in microseconds, empty entries are left out
 
-		auto handle = Deserialize<std::string>(arguments, "handle");
-		auto serviceName = Deserialize<std::string>(arguments, "service.name");
-		auto serviceType = Deserialize<std::string>(arguments, "service.type");
-		auto servicePort = Deserialize<int>(arguments, "service.port");
-		auto serviceTxt = FlutterTxtToWindowsTxt(DeserializeOptional<flutter::EncodableMap>(arguments, "service.txt"));
+		static constexpr std::array<const char*, PluginMetrics::OPERATION_COUNT> operationNames{
+			"browseFirstResult", "resolve", "register", "unregister"
+		};
 
-		auto computerName = GetComputerName();
+		auto handle = DeserializeOptional<std::string>(arguments, "handle");
+		auto reset = DeserializeOptional<bool>(arguments, "metrics.reset").value_or(false);
 
-		// see https://docs.microsoft.com/en-us/windows/win32/api/windns/nf-windns-dnsserviceconstructinstance
+		flutter::EncodableMap operations;
+		flutter::EncodableMap callbacks;
+		flutter::EncodableMap serialized;
 
-		auto serviceNameW = ToUtf16(serviceName + "." + serviceType + ".local");
-		auto hostNameW = computerName + L".local";
+		auto add = [](flutter::EncodableMap& map, const char* name, std::optional<flutter::EncodableValue> value) {
+			if (value.has_value()) {
+				map[flutter::EncodableValue(name)] = std::move(value.value());
+			}
+		};
 
-		PDNS_SERVICE_INSTANCE pServiceInstance = DnsServiceConstructInstance(
-			serviceNameW.c_str(), // PCWSTR pServiceName
-			hostNameW.c_str(), // PCWSTR pHostName
-			nullptr, // PIP4_ADDRESS pIp4 (optional)
-			nullptr, // PIP6_ADDRESS pIp6 (optional)
-			static_cast<WORD>(servicePort), // WORD wPort
-			0, // WORD wPriority
-			0, // WORD wWeight
-			serviceTxt->size, // DWORD dwPropertiesCount
-			serviceTxt->pKeyPointers, // PCWSTR* keys
-			serviceTxt->pValuePointers // PCWSTR* values
-		);
+		if (handle.has_value()) {
 
-		auto context = std::make_unique<RegisterContext>();
-		context->nsdWindows = this;
-		context->handle = handle;
+			auto it = discoveryHandles.find(handle.value());
+			if (it == discoveryHandles.end()) {
+				throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown handle");
+			}
 
-		auto& request = context->request;
-		request.Version = DNS_QUERY_REQUEST_VERSION1;
-		request.InterfaceIndex = 0;
-		request.pServiceInstance = pServiceInstance;
-		request.pRegisterCompletionCallback = &DnsServiceRegisterCallback;
-		request.pQueryContext = context.get();
-		request.unicastEnabled = false;
+			auto& context = *discoveryContexts.Get(it->second);
+			auto& discoveryMetrics = *context.metrics;
+			const auto kind = context.enumerateTypes ? DnsCallbackResult::SERVICE_TYPE_DISCOVERED : DnsCallbackResult::SERVICE_DISCOVERED;
 
-		auto status = DnsServiceRegister(&request, &context->canceller);
+			add(operations, operationNames[PluginMetrics::BROWSE_FIRST_RESULT], SerializeOperationMetrics(discoveryMetrics.firstResult, reset));
+			add(callbacks, kCallbackKindNames[kind], SerializeCallbackMetrics(discoveryMetrics.browses, reset));
+		}
+		else {
 
-		DnsServiceFreeInstance(request.pServiceInstance);
-		request.pServiceInstance = nullptr; // will be replaced by OnServiceResolved()
-		request.pRegisterCompletionCallback = nullptr; // will be replaced by Unregister()
+			for (size_t i = 0; i < PluginMetrics::OPERATION_COUNT; i++) {
+				add(operations, operationNames[i], SerializeOperationMetrics(metrics.operations[i], reset));
+			}
 
-		if (status != DNS_REQUEST_PENDING) {
-			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+			for (size_t i = 0; i < DnsCallbackResult::KIND_COUNT; i++) {
+				add(callbacks, kCallbackKindNames[i], SerializeCallbackMetrics(metrics.callbacks[i], reset));
+			}
+
+			const auto drainDelay = metrics.drainDelay.Summarize(reset);
+			if (drainDelay.count > 0) {
+				serialized[flutter::EncodableValue("drainDelay")] = SerializeLatency(drainDelay);
+			}
+
+			const auto cache = resolveCache.GetStatistics(reset);
+			if (cache.hits + cache.staleHits + cache.misses > 0) {
+				serialized[flutter::EncodableValue("resolveCache")] = flutter::EncodableValue(flutter::EncodableMap{
+					{ flutter::EncodableValue("hits"), flutter::EncodableValue(static_cast<int64_t>(cache.hits)) },
+					{ flutter::EncodableValue("staleHits"), flutter::EncodableValue(static_cast<int64_t>(cache.staleHits)) },
+					{ flutter::EncodableValue("misses"), flutter::EncodableValue(static_cast<int64_t>(cache.misses)) },
+					});
+			}
 		}
 
-		registerContextMap[handle] = std::move(context);
-		result->Success();
+		serialized[flutter::EncodableValue("operations")] = flutter::EncodableValue(std::move(operations));
+		serialized[flutter::EncodableValue("callbacks")] = flutter::EncodableValue(std::move(callbacks));
+		result->Success(flutter::EncodableValue(std::move(serialized)));
 	}
 
-	void NsdWindows::Unregister(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	void NsdWindows::SetTracing(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
 	{
-		auto handle = Deserialize<std::string>(arguments, "handle");
+		auto enabled = Deserialize<bool>(arguments, "trace.enabled");
+		auto capacity = DeserializeOptional<int>(arguments, "trace.capacity").value_or(static_cast<int>(TraceRecorder::kDefaultCapacity));
 
-		auto it = registerContextMap.find(handle);
-		if (it == registerContextMap.end()) {
-			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown handle");
+		if (capacity <= 0) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Trace capacity must be positive");
 		}
 
-		auto& context = *it->second.get();
-		auto& request = context.request;
-
-		request.pRegisterCompletionCallback = &DnsServiceUnregisterCallback; // set callback for request reuse
-
-		auto status = DnsServiceDeRegister(&request, nullptr);
-
-		DnsServiceFreeInstance(request.pServiceInstance);
-		request.pServiceInstance = nullptr;
-
-		if (status != DNS_REQUEST_PENDING) {
-			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+		if (enabled) {
+			tracer.Enable(static_cast<size_t>(capacity)); // starts a new trace
+		}
+		else {
+			tracer.Disable();
 		}
 
 		result->Success();
 	}
 
-	void NsdWindows::OnServiceDiscovered(const std::string handle, const DWORD status, PDNS_RECORD records)
+	void NsdWindows::DumpTrace(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
 	{
-		//std::cout << GetTimeNow() << " " << "OnServiceDiscovered()" << std::endl;
+		auto clear = DeserializeOptional<bool>(arguments, "trace.clear").value_or(false);
+		result->Success(flutter::EncodableValue(tracer.Dump(clear)));
+	}
 
-		if (status != ERROR_SUCCESS) {
-			//std::cout << GetTimeNow() << " " << "OnServiceDiscovered(): ERROR: " << GetErrorMessage(status) << std::endl;
-			DnsRecordListFree(records, DnsFreeRecordList);
-			return;
-		}
+	void NsdWindows::RecordOperation(const PluginMetrics::Operation operation, const DWORD status, const std::chrono::steady_clock::time_point started)
+	{
+		auto& operationMetrics = metrics.operations[operation];
+		operationMetrics.statuses.Record(status);
+		operationMetrics.latency.Record(std::chrono::steady_clock::now() - started);
+	}
 
-		auto serviceInfoO = GetServiceInfoFromRecords(records);
-		if (!serviceInfoO.has_value()) {
-			// must be deleted as described here: https://docs.microsoft.com/en-us/windows/win32/api/windns/nc-windns-dns_service_browse_callback
-			DnsRecordListFree(records, DnsFreeRecordList);
+	void NsdWindows::RecordFirstResult(DiscoveryContext& context)
+	{
+		if (context.reported) {
 			return;
 		}
 
-		ServiceInfo& serviceInfo = serviceInfoO.value();
-		std::vector<ServiceInfo>& services = discoveryContextMap.at(handle)->services;
-
-		auto it = FindIf(services, [compare = serviceInfo](ServiceInfo& current) -> bool {
-			return
-				current.name == compare.name &&
-				current.type == compare.type;
-			});
-
-		if (serviceInfo.status == ServiceInfo::STATUS_FOUND) {
-
-			if (it == services.end()) {
-				services.push_back(serviceInfo);
-				methodChannel->InvokeMethod("onServiceDiscovered", CreateMethodResult({
-						{ "handle", handle },
-						{ "service.name", serviceInfo.name.value() },
-						{ "service.type", serviceInfo.type.value() },
-					}));
-			}
-		}
-		else {
+		context.reported = true;
 
-			if (it != services.end()) {
-				services.erase(it);
-				methodChannel->InvokeMethod("onServiceLost", CreateMethodResult({
-						{ "handle", handle },
-						{ "service.name", serviceInfo.name.value() },
-						{ "service.type", serviceInfo.type.value() },
-					}));
-			}
+		const auto latency = std::chrono::steady_clock::now() - context.started;
+		for (auto operationMetrics : { &metrics.operations[PluginMetrics::BROWSE_FIRST_RESULT], &context.metrics->firstResult }) {
+			operationMetrics->statuses.Record(ERROR_SUCCESS);
+			operationMetrics->latency.Record(latency);
 		}
-
-		DnsRecordListFree(records, DnsFreeRecordList);
 	}
 
-	void NsdWindows::OnServiceResolved(const std::string handle, const DWORD status, PDNS_SERVICE_INSTANCE pInstance)
+	void NsdWindows::OnDiscoveryListen(const SlabHandle id, std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> sink)
 	{
-		auto it = resolveContextMap.find(handle);
-		if (it == resolveContextMap.end()) {
-			//std::cout << "OnServiceResolved(): ERROR: Unknown handle: " << handle << std::endl;
-			DnsServiceFreeInstance(pInstance);
-			return;
-		}
-
-		if (status != ERROR_SUCCESS) {
-			methodChannel->InvokeMethod("onResolveFailed", CreateMethodResult({
-					{ "handle", handle },
-					{ "error.cause", ToErrorCode(ErrorCause::INTERNAL_ERROR) },
-					{ "error.message", GetErrorMessage(status) },
-				}));
-			DnsServiceFreeInstance(pInstance);
+		auto context = discoveryContexts.Get(id);
+		if (context == nullptr || !context->stream) {
 			return;
 		}
 
-		auto components = Split(ToUtf8(pInstance->pszInstanceName), '.'); // "HP Color LaserJet MFP M277dw (C162F4)._http._tcp.local"
-		auto serviceName = components.at(0);
-		auto serviceType = components.at(1) + "." + components.at(2);
-		auto servicePort = pInstance->wPort;
-		auto serviceHost = ToUtf8(pInstance->pszHostName);
-		auto serviceTxt = WindowsTxtToFlutterTxt(pInstance->dwPropertyCount, pInstance->keys, pInstance->values);
+		auto& stream = *context->stream;
+		stream.sink = std::move(sink);
 
-		DnsServiceFreeInstance(pInstance);
-		resolveContextMap.erase(it);
-
-		methodChannel->InvokeMethod("onResolveSuccessful", CreateMethodResult({
-				{ "handle", handle },
-				{ "service.type", serviceType },
-				{ "service.name", serviceName },
-				{ "service.port", servicePort },
-				{ "service.host", serviceHost },
-				{ "service.txt", serviceTxt },
-			}));
+		for (auto& event : stream.pending) {
+			stream.sink->Success(CreateEventValue(std::move(event)));
+		}
+		stream.pending.clear();
 	}
 
-	void NsdWindows::OnServiceRegistered(const std::string handle, const DWORD status, PDNS_SERVICE_INSTANCE pInstance)
+	void NsdWindows::OnDiscoveryCancel(const SlabHandle id)
 	{
-		auto it = registerContextMap.find(handle);
-		if (it == registerContextMap.end()) {
-			//std::cout << "OnServiceRegistered(): ERROR: Unknown handle: " << handle << std::endl;
-			DnsServiceFreeInstance(pInstance);
+		// the dart side cancelled its subscription to stop the discovery; it keeps its handlers until the stop
+		// is reported, so that and the pending changes go over the method channel
+
+		auto context = discoveryContexts.Get(id);
+		if (context == nullptr) {
 			return;
 		}
 
-		auto& context = *it->second.get();
-		auto& request = context.request;
+		const auto handle = context->handle;
+
+		// this runs in the channel's own handler, which must outlive the call
+		retiredStreams.push_back(std::move(context->stream));
+		ScheduleDrain();
+
+		const auto status = RemoveDiscoveryContext(*context);
 
 		if (status != ERROR_SUCCESS) {
-			DnsServiceFreeInstance(pInstance);
-			methodChannel->InvokeMethod("onRegistrationFailed", CreateMethodResult({
-					{ "handle", handle },
-					{ "error.cause", ToErrorCode(ErrorCause::INTERNAL_ERROR) },
-					{ "error.message", GetErrorMessage(status) },
-				}));
-			methodChannel->InvokeMethod("onRegistrationFailed", CreateMethodResult({ { "handle", handle } }));
+			SendEvent("onDiscoveryStopFailed", EventRecord()
+				.Set(EventKey::HANDLE, handle)
+				.Set(EventKey::ERROR_CAUSE, ToErrorCode(ErrorCause::INTERNAL_ERROR))
+				.Set(EventKey::ERROR_MESSAGE, GetErrorMessage(status)));
 			return;
 		}
 
-		auto components = Split(ToUtf8(pInstance->pszInstanceName), '.'); // "HP Color LaserJet MFP M277dw (C162F4)._http._tcp.local"
+		SendEvent("onDiscoveryStopSuccessful", EventRecord().Set(EventKey::HANDLE, handle));
+	}
+
+	DWORD NsdWindows::RemoveDiscoveryContext(DiscoveryContext& context)
+	{
+		// returns the first error from cancelling, the discovery is removed regardless
 
-		auto serviceName = components.at(0);
-		auto serviceType = components.at(1) + "." + components.at(2);
-		auto servicePort = pInstance->wPort;
-		auto serviceHost = ToUtf8(pInstance->pszHostName);
-		auto serviceTxt = WindowsTxtToFlutterTxt(pInstance->dwPropertyCount, pInstance->keys, pInstance->values);
+		const auto status = CancelBrowses(context);
 
-		// the existing request must be reused with the newly received instance for unregistering 
-		request.pServiceInstance = pInstance;
+		if (context.batch) {
+			FlushDiscoveryBatch(context); // deliver changes that are still waiting for the timer
+		}
 
-		methodChannel->InvokeMethod("onRegistrationSuccessful", CreateMethodResult({
-				{ "handle", handle },
-				{ "service.type", serviceType },
-				{ "service.name", serviceName },
-				{ "service.port", servicePort },
-				{ "service.host", serviceHost },
-				{ "service.txt", serviceTxt },
-			}));
+		discoveryHandles.erase(context.handle);
+		discoveryContexts.Erase(context.id); // results still queued for it are dropped, its handle is stale now
+
+		return status;
 	}
 
-	void NsdWindows::OnServiceUnregistered(const std::string handle, const DWORD status, PDNS_SERVICE_INSTANCE pInstance)
+	void NsdWindows::SendDiscoveryEvent(DiscoveryContext& context, const std::string& method, EventRecord arguments)
 	{
-		DnsServiceFreeInstance(pInstance); // not used
-
-		auto it = registerContextMap.find(handle);
-		if (it == registerContextMap.end()) {
-			//std::cout << "OnServiceUnregistered(): ERROR: Unknown handle: " << handle << std::endl;
+		if (!context.stream) {
+			SendEvent(method, std::move(arguments));
 			return;
 		}
 
-		registerContextMap.erase(it);
+		auto& stream = *context.stream;
+		arguments.Set(EventKey::EVENT, method);
 
-		if (status != ERROR_SUCCESS) {
-			methodChannel->InvokeMethod("onUnregistrationFailed", CreateMethodResult({
-					{ "handle", handle },
-					{ "error.cause", ToErrorCode(ErrorCause::INTERNAL_ERROR) },
-					{ "error.message", GetErrorMessage(status) },
-				}));
-			return;
+		if (stream.sink) {
+			TraceSpan span(tracer, "send", "SendDiscoveryEvent", method);
+			stream.sink->Success(CreateEventValue(std::move(arguments)));
+		}
+		else {
+			stream.pending.push_back(std::move(arguments)); // the dart side listens right after the start call returns
 		}
-
-		methodChannel->InvokeMethod("onUnregistrationSuccessful", CreateMethodResult({ { "handle", handle } }));
 	}
 
-	void NsdWindows::DnsServiceBrowseCallback(const DWORD status, LPVOID context, PDNS_RECORD records)
+	void NsdWindows::StartBrowse(DiscoveryContext& context, const std::string& serviceType, const bool enumeratesTypes)
 	{
-		DiscoveryContext& discoveryContext = *static_cast<DiscoveryContext*>(context);
-		discoveryContext.nsdWindows->OnServiceDiscovered(discoveryContext.handle, status, records);
-	}
+		if (useBuiltInMdns) {
+			StartMdnsBrowse(context, serviceType, enumeratesTypes);
+			return;
+		}
 
-	void NsdWindows::DnsServiceResolveCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance)
-	{
-		ResolveContext& resolveContext = *static_cast<ResolveContext*>(context);
-		resolveContext.nsdWindows->OnServiceResolved(resolveContext.handle, status, pInstance);
-	}
+		auto queryName = ToUtf16(serviceType + ".local");
 
-	void NsdWindows::DnsServiceRegisterCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance)
-	{
-		RegisterContext& registerContext = *static_cast<RegisterContext*>(context);
-		registerContext.nsdWindows->OnServiceRegistered(registerContext.handle, status, pInstance);
+		// one browse per interface, OnServiceDiscovered() merges their results
+
+		for (const auto interfaceIndex : context.interfaces) {
+
+			auto browse = std::make_unique<BrowseContext>();
+			browse->nsdWindows = this;
+			browse->discovery = context.id;
+			browse->serviceType = serviceType;
+			browse->interfaceIndex = interfaceIndex;
+			browse->autoResolve = context.autoResolve && !context.enumerateTypes;
+			browse->enumeratesTypes = enumeratesTypes;
+			browse->metrics = context.metrics;
+
+			DNS_SERVICE_BROWSE_REQUEST request{};
+			request.Version = DNS_QUERY_REQUEST_VERSION1;
+			request.InterfaceIndex = interfaceIndex;
+			request.QueryName = queryName.c_str();
+			request.pBrowseCallback = &DnsServiceBrowseCallback;
+			request.pQueryContext = browse.get();
+
+			TraceSpan span(tracer, "dns", "DnsServiceBrowse", serviceType);
+			auto status = DnsServiceBrowse(&request, &browse->canceller);
+			span.End();
+
+			if (status != DNS_REQUEST_PENDING) {
+				throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+			}
+
+			context.browses.push_back(std::move(browse));
+		}
 	}
 
-	void NsdWindows::DnsServiceUnregisterCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance)
+	DWORD NsdWindows::CancelBrowses(DiscoveryContext& context)
 	{
-		RegisterContext& registerContext = *static_cast<RegisterContext*>(context);
-		registerContext.nsdWindows->OnServiceUnregistered(registerContext.handle, status, pInstance);
-	}
+		// returns the first error, but cancels all browses regardless; the discovery has none left afterwards
 
-	std::optional<ServiceInfo> NsdWindows::GetServiceInfoFromRecords(const PDNS_RECORD& records) {
+		auto status = static_cast<DWORD>(ERROR_SUCCESS);
+		auto browses = std::move(context.browses);
+		context.browses.clear();
 
-		// record properties see https://docs.microsoft.com/en-us/windows/win32/api/windns/ns-windns-dns_recordw
-		// seen: DNS_TYPE_A (0x0001), DNS_TYPE_TEXT (0x0010), DNS_TYPE_AAAA (0x001c), DNS_TYPE_SRV (0x0021)
+		for (auto& browse : browses) {
 
-		for (auto record = records; record; record = record->pNext) {
-			if (record->wType == DNS_TYPE_PTR) { // 0x0012
-				return GetServiceInfoFromPtrRecord(record);
+			if (browse->querierBrowseId != 0) {
+				mdnsQuerier->StopBrowse(browse->querierBrowseId); // the querier doesn't call back after this
+				mdnsBrowses.erase(browse->querierBrowseId);
+				continue;
 			}
-		}
 
-		return std::nullopt;
+			TraceSpan span(tracer, "dns", "DnsServiceBrowseCancel", browse->serviceType);
+			const auto browseStatus = DnsServiceBrowseCancel(&browse->canceller);
+			span.End();
+
+			// freed by OnBrowseCancelled(); kept even if cancelling failed, a late callback would find it gone otherwise
+			auto key = browse.get();
+			retiredBrowseContextMap[key] = std::move(browse);
+			if (status == ERROR_SUCCESS) {
+				status = browseStatus;
+			}
+		}
+		return status;
 	}
 
-	std::optional<nsd_windows::ServiceInfo> NsdWindows::GetServiceInfoFromPtrRecord(const PDNS_RECORD& record)
+	void NsdWindows::OnBrowseCancelled(const SlabHandle id, const void* browse)
+	{
+		if (retiredBrowseContextMap.erase(static_cast<const BrowseContext*>(browse)) > 0) {
+			return; // cancelled by CancelBrowses()
+		}
+
+		// ended on its own, so there is nothing left to cancel when the discovery stops
+
+		auto context = discoveryContexts.Get(id);
+		if (context == nullptr) {
+			return;
+		}
+
+		auto& browses = context->browses;
+		browses.erase(std::remove_if(browses.begin(), browses.end(), [browse](const std::unique_ptr<BrowseContext>& current) -> bool {
+			return current.get() == browse;
+			}), browses.end());
+	}
+
+	void NsdWindows::Resolve(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		auto handle = Deserialize<std::string>(arguments, "handle");
+		auto serviceName = Deserialize<std::string>(arguments, "service.name");
+		auto serviceType = Deserialize<std::string>(arguments, "service.type");
+
+		auto ipLookupType = DeserializeIpLookupType(arguments);
+
+		// an entry without the requested address families needs a fresh resolve
+		auto cached = resolveCache.Get(GetInstanceName(serviceName, serviceType), [ipLookupType](const ServiceInfo& value) -> bool {
+			return GetMissingAddressFamilies(value.addresses.value_or(std::vector<std::string>()), ipLookupType).empty();
+			});
+		if (cached.has_value()) {
+
+			if (cached->stale) {
+				RefreshCachedResolve(serviceName, serviceType);
+			}
+
+			auto serviceInfo = cached->value;
+			SetAddresses(serviceInfo, FilterAddresses(serviceInfo.addresses.value_or(std::vector<std::string>()), ipLookupType));
+
+			auto arguments = SerializeServiceInfo(serviceInfo);
+			arguments.Set(EventKey::HANDLE, handle);
+			SendEvent("onResolveSuccessful", std::move(arguments));
+			result->Success();
+			return;
+		}
+
+		auto timeout = DeserializeOptional<int>(arguments, "resolve.timeout"); // milliseconds
+		if (timeout.has_value() && timeout.value() <= 0) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Resolve timeout must be positive");
+		}
+
+		ResolveWaiter waiter;
+		waiter.handle = handle;
+		waiter.ipLookupType = ipLookupType;
+		waiter.interfaceIndex = static_cast<uint32_t>(DeserializeOptional<int>(arguments, "service.interfaceIndex").value_or(kAnyInterface));
+
+		StartServiceResolve(serviceName, serviceType, waiter, ResolvePriority::NORMAL,
+			timeout.has_value() ? std::chrono::milliseconds(timeout.value()) : kDefaultResolveTimeout);
+		result->Success();
+	}
+
+	void NsdWindows::CancelResolve(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		auto handle = Deserialize<std::string>(arguments, "handle");
+
+		// the dart side has already failed the request, only the waiter needs to go
+
+		auto it = resolveHandles.find(handle);
+		if (it != resolveHandles.end()) {
+			CancelResolveWaiters(*resolveContexts.Get(it->second), [&handle](const ResolveWaiter& current) -> bool {
+				return current.handle == handle;
+				});
+		}
+
+		result->Success(); // unknown handles are fine, the resolve may have completed in the meantime
+	}
+
+	void NsdWindows::RefreshCachedResolve(const std::string& serviceName, const std::string& serviceType)
+	{
+		ResolveWaiter waiter; // no handle: the result only updates the cache
+		waiter.ipLookupType = IpLookupType::ANY;
+
+		StartServiceResolve(serviceName, serviceType, waiter, ResolvePriority::LOW, kDefaultResolveTimeout);
+	}
+
+	void NsdWindows::StartServiceResolve(const std::string& serviceName, const std::string& serviceType, ResolveWaiter waiter, const ResolvePriority priority, const std::chrono::milliseconds timeout)
+	{
+		auto instanceName = GetInstanceName(serviceName, serviceType);
+		auto key = ToLowerDnsName(instanceName);
+		const auto waiterId = nextResolveWaiterId++;
+		waiter.id = waiterId;
+
+		auto it = resolveKeys.find(key);
+		if (it != resolveKeys.end()) {
+
+			// already pending: share the result instead of sending the same query again
+			if (!waiter.handle.empty()) {
+				resolveHandles[waiter.handle] = it->second;
+			}
+			resolveContexts.Get(it->second)->waiters.Attach(std::move(waiter));
+		}
+		else {
+
+			auto [id, context] = resolveContexts.Emplace();
+			context->nsdWindows = this;
+			context->id = id;
+			context->key = key;
+			context->instanceName = instanceName;
+			context->escapedInstanceName = EscapeDnsLabel(serviceName) + "." + serviceType + ".local";
+			context->interfaceIndex = waiter.interfaceIndex;
+			context->started = std::chrono::steady_clock::now();
+			if (!waiter.handle.empty()) {
+				resolveHandles[waiter.handle] = id;
+			}
+			context->waiters.Attach(std::move(waiter));
+
+			resolveKeys[key] = id;
+		}
+
+		resolveScheduler.Submit(key, waiterId, priority, timeout); // calls ExecuteResolve() once a slot is free
+		ArmResolveDeadlineTimer();
+	}
+
+	void NsdWindows::ExecuteResolve(const std::string& key)
+	{
+		auto& context = *resolveContexts.Get(resolveKeys.at(key));
+
+		if (useBuiltInMdns) {
+			try {
+				context.querierResolveId = GetMdnsQuerier().Resolve(context.escapedInstanceName);
+				mdnsResolves[context.querierResolveId] = context.id;
+				ArmMdnsTimer();
+			}
+			catch (const std::exception&) {
+				Post({ DnsCallbackResult::SERVICE_RESOLVED, context.id, static_cast<DWORD>(ERROR_NETWORK_UNREACHABLE) });
+			}
+			return;
+		}
+
+		auto queryName = ToUtf16(context.instanceName);
+
+		DNS_SERVICE_RESOLVE_REQUEST request{};
+		request.Version = DNS_QUERY_REQUEST_VERSION1;
+		request.InterfaceIndex = context.interfaceIndex;
+		request.QueryName = const_cast<PWSTR>(queryName.c_str());
+		request.pResolveCompletionCallback = &DnsServiceResolveCallback;
+		request.pQueryContext = &context;
+
+		TraceSpan span(tracer, "dns", "DnsServiceResolve", context.instanceName);
+		const auto status = DnsServiceResolve(&request, &context.canceller);
+		span.End();
+
+		if (status != DNS_REQUEST_PENDING) {
+			// reported like a failed resolve, the scheduler must not be called back from here
+			Post({ DnsCallbackResult::SERVICE_RESOLVED, context.id, status });
+			return;
+		}
+
+		context.resolvePending = true;
+	}
+
+	void NsdWindows::AbortResolve(const std::string& key)
+	{
+		auto& context = *resolveContexts.Get(resolveKeys.at(key));
+
+		if (context.querierResolveId != 0) {
+			mdnsQuerier->CancelResolve(context.querierResolveId); // the querier doesn't call back after this
+			mdnsResolves.erase(context.querierResolveId);
+			context.querierResolveId = 0;
+		}
+
+		// callbacks still arrive after cancelling (with ERROR_CANCELLED), see RemoveResolveContext()
+
+		if (context.resolvePending) {
+			TraceSpan span(tracer, "dns", "DnsServiceResolveCancel", context.instanceName);
+			DnsServiceResolveCancel(&context.canceller);
+		}
+
+		for (auto& query : context.addressQueries) {
+			TraceSpan span(tracer, "dns", "DnsCancelQuery", query->hostName);
+			DnsCancelQuery(&query->canceller);
+		}
+	}
+
+	void NsdWindows::RemoveResolveContext(ResolveContext& context)
+	{
+		resolveKeys.erase(context.key);
+
+		if (!context.resolvePending && context.addressQueries.empty()) {
+			resolveContexts.Erase(context.id); // no callbacks outstanding, can go right away
+			return;
+		}
+
+		context.retired = true; // callbacks still arrive after cancelling (with ERROR_CANCELLED), the context is kept until then
+	}
+
+	void NsdWindows::ReleaseResolveWaiters(const std::vector<ResolveWaiter>& waiters)
+	{
+		for (const auto& waiter : waiters) {
+			if (!waiter.handle.empty()) {
+				resolveHandles.erase(waiter.handle);
+			}
+		}
+	}
+
+	void NsdWindows::OnRetiredResolveCallback(ResolveContext& context, const void* addressQuery)
+	{
+		if (addressQuery == nullptr) {
+			context.resolvePending = false;
+		}
+		else {
+			auto& queries = context.addressQueries;
+			queries.erase(std::remove_if(queries.begin(), queries.end(), [addressQuery](const std::unique_ptr<AddressQueryContext>& query) -> bool {
+				return query.get() == addressQuery;
+				}), queries.end());
+		}
+
+		if (!context.resolvePending && context.addressQueries.empty()) {
+			resolveContexts.Erase(context.id);
+		}
+	}
+
+	void NsdWindows::OnResolveDeadlineDue()
+	{
+		// only the expired waiters time out, the resolve keeps running for the others
+
+		for (const auto& [key, waiterId] : resolveScheduler.ExpireDeadlines()) {
+
+			auto it = resolveKeys.find(key);
+			if (it == resolveKeys.end()) {
+				continue;
+			}
+
+			auto& context = *resolveContexts.Get(it->second);
+			RecordOperation(PluginMetrics::RESOLVE, ERROR_TIMEOUT, context.started); // the expired waiter's share of the resolve
+
+			auto expired = context.waiters.Detach([waiterId = waiterId](const ResolveWaiter& current) -> bool {
+				return current.id == waiterId;
+				});
+			ReleaseResolveWaiters(expired);
+
+			if (context.waiters.Empty()) {
+				RemoveResolveContext(context); // the scheduler has cancelled the resolve along with its last waiter
+			}
+
+			for (const auto& waiter : expired) {
+				NotifyResolveWaiter(waiter, ERROR_TIMEOUT, std::nullopt);
+			}
+		}
+
+		ArmResolveDeadlineTimer();
+	}
+
+	void NsdWindows::ArmResolveDeadlineTimer()
+	{
+		if (resolveDeadlineTimer == nullptr) {
+			return;
+		}
+
+		auto deadline = resolveScheduler.GetNextDeadline();
+		if (!deadline.has_value()) {
+			SetThreadpoolTimer(resolveDeadlineTimer, nullptr, 0, 0); // disarm
+			return;
+		}
+
+		auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline.value() - std::chrono::steady_clock::now());
+		auto dueTime = ToRelativeFileTime(std::max(remaining, std::chrono::milliseconds(0)));
+		SetThreadpoolTimer(resolveDeadlineTimer, &dueTime, 0, 0);
+	}
+
+	void NsdWindows::SetBackend(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		// running browses and resolves stay on the backend they were started with
+
+		auto backend = Deserialize<std::string>(arguments, "backend");
+
+		if (backend == "system") {
+			if (!this->systemRequirementsSatisfied) {
+				throw NsdError(ErrorCause::OPERATION_NOT_SUPPORTED, "Plugin requires at least Windows 10, build 18362");
+			}
+			useBuiltInMdns = false;
+		}
+		else if (backend == "builtIn") {
+			useBuiltInMdns = true;
+		}
+		else {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown backend: "s + backend);
+		}
+
+		result->Success();
+	}
+
+	void NsdWindows::SetEventPort(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		auto port = DeserializeLong(arguments, "event.port").value_or(ILLEGAL_PORT);
+
+		if (port != ILLEGAL_PORT && !EventPort::IsDartApiInitialized()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Dart API not initialized, see NsdWindowsPluginCApiInitializeDartApi()");
+		}
+
+		eventPort.SetPort(port);
+		result->Success();
+	}
+
+	void NsdWindows::SendEvent(const std::string& method, EventRecord arguments)
+	{
+		TraceSpan span(tracer, "send", "SendEvent", method);
+
+		if (eventPort.IsEnabled() && eventPort.Post(method, arguments)) {
+			return;
+		}
+		methodChannel->InvokeMethod(method, CreateEvent(std::move(arguments)));
+	}
+
+	MdnsTransport& NsdWindows::GetMdnsTransport()
+	{
+		if (mdnsTransport) {
+			return *mdnsTransport;
+		}
+
+		if (mdnsTimer == nullptr) {
+			mdnsTimer = CreateThreadpoolTimer(&MdnsTimerCallback, this, nullptr);
+			if (mdnsTimer == nullptr) {
+				throw NsdError(ErrorCause::INTERNAL_ERROR, GetLastErrorMessage());
+			}
+		}
+
+		auto transport = std::make_unique<UdpMdnsTransport>();
+		transport->Start([nsdWindows = this](std::vector<uint8_t> packet, const MdnsEndpoint source) {
+			TraceSpan span(nsdWindows->tracer, "callback", "MdnsPacketReceived");
+			DnsCallbackResult result{ DnsCallbackResult::MDNS_PACKET_RECEIVED };
+			result.packet = std::move(packet);
+			result.packetSource = source;
+			nsdWindows->Post(std::move(result));
+			});
+
+		mdnsTransport = std::move(transport);
+		return *mdnsTransport;
+	}
+
+	MdnsQuerier& NsdWindows::GetMdnsQuerier()
+	{
+		if (!mdnsQuerier) {
+			mdnsQuerier = std::make_unique<MdnsQuerier>(GetMdnsTransport(), static_cast<MdnsQuerierListener&>(*this));
+		}
+		return *mdnsQuerier;
+	}
+
+	MdnsResponder& NsdWindows::GetMdnsResponder()
+	{
+		if (!mdnsResponder) {
+			auto responder = std::make_unique<MdnsResponder>(GetMdnsTransport());
+			responder->SetHost(ToUtf8(GetCachedComputerName()) + ".local", GetHostAddresses());
+			mdnsResponder = std::move(responder);
+		}
+		return *mdnsResponder;
+	}
+
+	void NsdWindows::StartMdnsBrowse(DiscoveryContext& context, const std::string& serviceType, const bool enumeratesTypes)
+	{
+		// the querier's socket covers all interfaces, so there is one browse regardless of the interface selection
+
+		auto& querier = GetMdnsQuerier();
+
+		auto browse = std::make_unique<BrowseContext>();
+		browse->nsdWindows = this;
+		browse->discovery = context.id;
+		browse->serviceType = serviceType;
+		browse->autoResolve = context.autoResolve && !context.enumerateTypes;
+		browse->enumeratesTypes = enumeratesTypes;
+		browse->metrics = context.metrics;
+		browse->querierBrowseId = querier.Browse(serviceType + ".local");
+
+		mdnsBrowses[browse->querierBrowseId] = browse.get();
+		context.browses.push_back(std::move(browse));
+		ArmMdnsTimer();
+	}
+
+	void NsdWindows::ArmMdnsTimer()
+	{
+		if (mdnsTimer == nullptr) {
+			return;
+		}
+
+		auto due = mdnsQuerier ? mdnsQuerier->GetNextDue() : std::nullopt;
+
+		if (mdnsResponder) {
+			auto responderDue = mdnsResponder->GetNextDue();
+			if (responderDue.has_value() && (!due.has_value() || responderDue.value() < due.value())) {
+				due = responderDue;
+			}
+		}
+
+		if (!due.has_value()) {
+			SetThreadpoolTimer(mdnsTimer, nullptr, 0, 0); // disarm
+			return;
+		}
+
+		auto remaining = std::chrono::ceil<std::chrono::milliseconds>(due.value() - std::chrono::steady_clock::now());
+		auto dueTime = ToRelativeFileTime(std::max(remaining, std::chrono::milliseconds(0)));
+		SetThreadpoolTimer(mdnsTimer, &dueTime, 0, 0);
+	}
+
+	void NsdWindows::OnBrowseResult(const uint64_t browseId, const std::string& instanceName, const bool found)
+	{
+		auto it = mdnsBrowses.find(browseId);
+		if (it == mdnsBrowses.end()) {
+			return;
+		}
+
+		const auto discovery = it->second->discovery;
+		const auto enumeratesTypes = it->second->enumeratesTypes;
+		const auto parsed = ParseServiceInstanceName(instanceName);
+		if (!parsed.has_value()) {
+			return;
+		}
+
+		ServiceInfo serviceInfo;
+		serviceInfo.status = found ? ServiceInfo::STATUS_FOUND : ServiceInfo::STATUS_LOST;
+		serviceInfo.type = std::string(parsed->GetType());
+
+		if (enumeratesTypes) {
+			OnServiceTypeDiscovered(discovery, serviceInfo); // "_http._tcp.local"
+			return;
+		}
+
+		auto name = UnescapeDnsLabel(parsed->instance);
+		if (!name.has_value() || name->empty()) {
+			return;
+		}
+
+		serviceInfo.name = std::move(name);
+		OnServiceDiscovered(discovery, serviceInfo);
+	}
+
+	void NsdWindows::OnResolveResult(const uint64_t resolveId, const MdnsServiceInstance& instance)
+	{
+		auto it = mdnsResolves.find(resolveId);
+		if (it == mdnsResolves.end()) {
+			return;
+		}
+
+		const auto id = it->second;
+		mdnsResolves.erase(it);
+
+		auto context = resolveContexts.Get(id);
+		if (context == nullptr) {
+			return;
+		}
+
+		context->querierResolveId = 0;
+
+		auto serviceInfo = GetServiceInfoFromMdnsInstance(instance);
+		OnServiceResolved(id, serviceInfo.has_value() ? ERROR_SUCCESS : ERROR_INVALID_DATA, serviceInfo);
+	}
+
+	void NsdWindows::Register(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		StartRegistration(arguments, "");
+		result->Success();
+	}
+
+	void NsdWindows::Unregister(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		StartUnregistration(Deserialize<std::string>(arguments, "handle"), "");
+		result->Success();
+	}
+
+	void NsdWindows::RegisterMany(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		auto handle = Deserialize<std::string>(arguments, "handle");
+		auto registrations = Deserialize<flutter::EncodableList>(arguments, "registrations");
+
+		if (registrationBatchMap.find(handle) != registrationBatchMap.end()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Handle in use");
+		}
+
+		auto context = std::make_unique<RegistrationBatchContext>(false, kMaxRunningRegistrations);
+
+		for (const auto& registration : registrations) {
+			auto registrationArguments = std::get<flutter::EncodableMap>(registration);
+			auto serviceHandle = Deserialize<std::string>(registrationArguments, "handle");
+			context->batch.Add(std::move(serviceHandle), std::move(registrationArguments)); // rejects duplicates before anything is started
+		}
+
+		registrationBatchMap[handle] = std::move(context);
+		result->Success();
+
+		ContinueRegistrationBatch(handle);
+	}
+
+	void NsdWindows::UnregisterMany(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result)
+	{
+		auto handle = Deserialize<std::string>(arguments, "handle");
+		auto handles = Deserialize<flutter::EncodableList>(arguments, "handles");
+
+		if (registrationBatchMap.find(handle) != registrationBatchMap.end()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Handle in use");
+		}
+
+		auto context = std::make_unique<RegistrationBatchContext>(true, kMaxRunningRegistrations);
+
+		for (const auto& value : handles) {
+			const auto& serviceHandle = std::get<std::string>(value);
+			context->batch.Add(serviceHandle, flutter::EncodableMap({ { "handle", serviceHandle } }));
+		}
+
+		registrationBatchMap[handle] = std::move(context);
+		result->Success();
+
+		ContinueRegistrationBatch(handle);
+	}
+
+	void NsdWindows::ContinueRegistrationBatch(const std::string& batchHandle)
+	{
+		auto it = registrationBatchMap.find(batchHandle);
+		if (it == registrationBatchMap.end()) {
+			return;
+		}
+
+		auto& context = *it->second;
+		auto& batch = context.batch;
+
+		// results arrive asynchronously on the platform thread, so none can come in while requests are started here
+		for (auto next = batch.StartNext(); next.has_value(); next = batch.StartNext()) {
+
+			const auto& [handle, arguments] = next.value();
+
+			try {
+				if (context.unregisters) {
+					StartUnregistration(handle, batchHandle);
+				}
+				else {
+					StartRegistration(arguments, batchHandle);
+				}
+			}
+			catch (const NsdError& e) {
+				batch.Complete(handle, EventRecord()
+					.Set(EventKey::HANDLE, handle)
+					.Set(EventKey::ERROR_CAUSE, ToErrorCode(e.errorCause))
+					.Set(EventKey::ERROR_MESSAGE, e.what()));
+			}
+			catch (const std::exception& e) {
+				batch.Complete(handle, EventRecord()
+					.Set(EventKey::HANDLE, handle)
+					.Set(EventKey::ERROR_CAUSE, ToErrorCode(ErrorCause::INTERNAL_ERROR))
+					.Set(EventKey::ERROR_MESSAGE, e.what()));
+			}
+		}
+
+		if (!batch.IsComplete()) {
+			return;
+		}
+
+		flutter::EncodableList results;
+		for (auto& result : batch.TakeResults()) {
+			results.push_back(CreateEventValue(std::move(result)));
+		}
+
+		auto method = context.unregisters ? "onUnregisterManyComplete" : "onRegisterManyComplete";
+		registrationBatchMap.erase(it);
+
+		SendEvent(method, EventRecord()
+			.Set(EventKey::HANDLE, batchHandle)
+			.Set(EventKey::RESULTS, std::move(results)));
+	}
+
+	const std::wstring& NsdWindows::GetCachedComputerName()
+	{
+		if (!computerName.has_value()) {
+			computerName = GetComputerName();
+		}
+		return computerName.value();
+	}
+
+	void NsdWindows::StartRegistration(const flutter::EncodableMap& arguments, const std::string& batchHandle)
+	{
+		if (useBuiltInMdns) {
+			StartRegistrationWithResponder(arguments, batchHandle);
+			return;
+		}
+
+		if (!this->systemRequirementsSatisfied) {
+			throw NsdError(ErrorCause::OPERATION_NOT_SUPPORTED, "Plugin requires at least Windows 10, build 18362");
+		}
+
+		auto handle = Deserialize<std::string>(arguments, "handle");
+		auto serviceName = Deserialize<std::string>(arguments, "service.name");
+		auto serviceType = Deserialize<std::string>(arguments, "service.type");
+		auto servicePort = Deserialize<int>(arguments, "service.port");
+		auto serviceTxt = TxtRecordToWindowsTxt(FlutterTxtToTxtRecord(DeserializeOptional<flutter::EncodableMap>(arguments, "service.txt")));
+		auto interfaceIndex = DeserializeOptional<int>(arguments, "service.interfaceIndex").value_or(kAnyInterface); // all interfaces by default
+
+		if (registerHandles.find(handle) != registerHandles.end()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Handle in use");
+		}
+
+		// see https://docs.microsoft.com/en-us/windows/win32/api/windns/nf-windns-dnsserviceconstructinstance
+
+		auto serviceNameW = ToUtf16(serviceName + "." + serviceType + ".local");
+		auto hostNameW = GetCachedComputerName() + L".local";
+
+		// freed on every path, including when emplacing the context throws
+		std::unique_ptr<DNS_SERVICE_INSTANCE, decltype(&DnsServiceFreeInstance)> serviceInstance(DnsServiceConstructInstance(
+			serviceNameW.c_str(), // PCWSTR pServiceName
+			hostNameW.c_str(), // PCWSTR pHostName
+			nullptr, // PIP4_ADDRESS pIp4 (optional)
+			nullptr, // PIP6_ADDRESS pIp6 (optional)
+			static_cast<WORD>(servicePort), // WORD wPort
+			0, // WORD wPriority
+			0, // WORD wWeight
+			serviceTxt->size, // DWORD dwPropertiesCount
+			serviceTxt->pKeyPointers, // PCWSTR* keys
+			serviceTxt->pValuePointers // PCWSTR* values
+		), &DnsServiceFreeInstance);
+
+		if (serviceInstance == nullptr) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, GetLastErrorMessage());
+		}
+
+		auto [id, context] = registerContexts.Emplace();
+		context->nsdWindows = this;
+		context->id = id;
+		context->handle = handle;
+		context->batchHandle = batchHandle;
+		context->started = std::chrono::steady_clock::now();
+
+		auto& request = context->request;
+		request.Version = DNS_QUERY_REQUEST_VERSION1;
+		request.InterfaceIndex = static_cast<ULONG>(interfaceIndex);
+		request.pServiceInstance = serviceInstance.get();
+		request.pRegisterCompletionCallback = &DnsServiceRegisterCallback;
+		request.pQueryContext = context;
+		request.unicastEnabled = false;
+
+		TraceSpan span(tracer, "dns", "DnsServiceRegister", handle);
+		auto status = DnsServiceRegister(&request, &context->canceller);
+		span.End();
+
+		serviceInstance.reset();
+		request.pServiceInstance = nullptr; // will be replaced by OnServiceResolved()
+		request.pRegisterCompletionCallback = nullptr; // will be replaced by Unregister()
+
+		if (status != DNS_REQUEST_PENDING) {
+			registerContexts.Erase(id);
+			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+		}
+
+		registerHandles[handle] = id;
+	}
+
+	void NsdWindows::StartRegistrationWithResponder(const flutter::EncodableMap& arguments, const std::string& batchHandle)
+	{
+		// the responder answers on all interfaces, service.interfaceIndex doesn't apply
+
+		auto handle = Deserialize<std::string>(arguments, "handle");
+		auto txt = FlutterTxtToTxtRecord(DeserializeOptional<flutter::EncodableMap>(arguments, "service.txt"));
+
+		MdnsServiceRegistration registration;
+		registration.name = Deserialize<std::string>(arguments, "service.name");
+		registration.type = Deserialize<std::string>(arguments, "service.type");
+		registration.port = static_cast<uint16_t>(Deserialize<int>(arguments, "service.port"));
+		registration.txt = txt.GetWire();
+
+		if (registerHandles.find(handle) != registerHandles.end()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Handle in use");
+		}
+
+		auto& responder = GetMdnsResponder();
+		auto responderId = responder.Register(registration); // names aren't probed, so they stay as requested
+
+		auto [id, context] = registerContexts.Emplace();
+		context->nsdWindows = this;
+		context->id = id;
+		context->handle = handle;
+		context->batchHandle = batchHandle;
+		context->started = std::chrono::steady_clock::now();
+		context->responderId = responderId;
+
+		registerHandles[handle] = id;
+		ArmMdnsTimer();
+
+		ServiceInfo serviceInfo;
+		serviceInfo.name = registration.name;
+		serviceInfo.type = registration.type;
+		serviceInfo.port = registration.port;
+		serviceInfo.host = responder.GetHostName();
+		serviceInfo.txt = std::move(txt);
+
+		DnsCallbackResult registered{ DnsCallbackResult::SERVICE_REGISTERED, id, ERROR_SUCCESS };
+		registered.serviceInfo = serviceInfo;
+		Post(std::move(registered));
+	}
+
+	void NsdWindows::StartUnregistration(const std::string& handle, const std::string& batchHandle)
+	{
+		auto it = registerHandles.find(handle);
+		if (it == registerHandles.end()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown handle");
+		}
+
+		auto& context = *registerContexts.Get(it->second);
+		context.batchHandle = batchHandle;
+		context.started = std::chrono::steady_clock::now();
+
+		if (context.responderId != 0) {
+			mdnsResponder->Unregister(context.responderId);
+			ArmMdnsTimer();
+			Post({ DnsCallbackResult::SERVICE_UNREGISTERED, context.id, ERROR_SUCCESS }); // goodbyes are sent asynchronously
+			return;
+		}
+
+		auto& request = context.request;
+
+		request.pRegisterCompletionCallback = &DnsServiceUnregisterCallback; // set callback for request reuse
+
+		TraceSpan span(tracer, "dns", "DnsServiceDeRegister", handle);
+		auto status = DnsServiceDeRegister(&request, nullptr);
+		span.End();
+
+		DnsServiceFreeInstance(request.pServiceInstance);
+		request.pServiceInstance = nullptr;
+
+		if (status != DNS_REQUEST_PENDING) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+		}
+	}
+
+	void NsdWindows::OnServiceDiscovered(const SlabHandle id, const ServiceInfo& serviceInfo)
+	{
+		auto pContext = discoveryContexts.Get(id);
+		if (pContext == nullptr) {
+			return; // discovery has been stopped in the meantime
+		}
+
+		DiscoveryContext& context = *pContext;
+		ServiceTable& services = context.services;
+
+		const auto interfaceIndex = serviceInfo.interfaceIndex.value_or(kAnyInterface);
+
+		if (serviceInfo.status == ServiceInfo::STATUS_FOUND) {
+
+			auto [entry, inserted] = services.Insert(serviceInfo.name.value(), serviceInfo.type.value());
+			entry->interfaces.Add(interfaceIndex);
+			if (!inserted) {
+				return; // known already, possibly from another interface
+			}
+
+			if (context.enumerateTypes) {
+				UpdateServiceTypeInstances(context, serviceInfo);
+				return;
+			}
+
+			if (context.autoResolve && !serviceInfo.IsResolved()) {
+				entry->resolving = true; // reported by OnDiscoveredServiceResolved()
+				AutoResolve(context, serviceInfo);
+				return;
+			}
+
+			if (serviceInfo.host.has_value()) {
+				entry->host = services.Intern(serviceInfo.host.value());
+			}
+
+			if (serviceInfo.IsResolved()) {
+				resolveCache.Put(GetInstanceName(serviceInfo.name.value(), serviceInfo.type.value()), serviceInfo, serviceInfo.ttl.value_or(kDefaultResolveTtl));
+			}
+
+			if (serviceInfo.addresses.has_value()) {
+				auto filtered = serviceInfo;
+				SetAddresses(filtered, FilterAddresses(serviceInfo.addresses.value(), context.ipLookupType));
+				NotifyServiceChanged(context, filtered);
+				return;
+			}
+
+			NotifyServiceChanged(context, serviceInfo);
+		}
+		else {
+
+			auto entry = services.Find(serviceInfo.name.value(), serviceInfo.type.value());
+			if (entry == nullptr || !entry->interfaces.Remove(interfaceIndex)) {
+				return; // unknown, or still present on another interface
+			}
+
+			const auto resolving = entry->resolving;
+
+			services.Erase(serviceInfo.name.value(), serviceInfo.type.value());
+			resolveCache.Erase(GetInstanceName(serviceInfo.name.value(), serviceInfo.type.value()));
+
+			if (resolving) {
+				CancelAutoResolve(context, serviceInfo); // never reported as found, so it isn't reported as lost either
+				return;
+			}
+
+			if (context.enumerateTypes) {
+				UpdateServiceTypeInstances(context, serviceInfo);
+				return;
+			}
+
+			NotifyServiceChanged(context, serviceInfo);
+		}
+	}
+
+	void NsdWindows::OnServiceTypeDiscovered(const SlabHandle id, const ServiceInfo& serviceInfo)
+	{
+		auto pContext = discoveryContexts.Get(id);
+		if (pContext == nullptr) {
+			return; // discovery has been stopped in the meantime
+		}
+
+		auto& context = *pContext;
+		auto serviceType = ToLowerDnsName(serviceInfo.type.value());
+		const auto interfaceIndex = serviceInfo.interfaceIndex.value_or(kAnyInterface);
+
+		if (serviceInfo.status == ServiceInfo::STATUS_FOUND) {
+
+			if (!context.serviceTypes.Announce(serviceType, interfaceIndex)) {
+				return; // known already, e.g. from another host or interface
+			}
+
+			// browse the type to count its instances
+			if (context.browsedTypes.insert(serviceType).second) {
+				try {
+					StartBrowse(context, serviceType, false);
+				}
+				catch (const std::exception&) {
+					// type is still reported, without instances
+				}
+			}
+
+			NotifyServiceTypeChanged(context, serviceType);
+			return;
+		}
+
+		// a goodbye only says that one host stopped announcing the type, it is kept while instances are left
+		if (context.serviceTypes.Withdraw(serviceType, interfaceIndex)) {
+			NotifyServiceTypeChanged(context, serviceType);
+		}
+	}
+
+	void NsdWindows::UpdateServiceTypeInstances(DiscoveryContext& context, const ServiceInfo& serviceInfo)
+	{
+		auto serviceType = ToLowerDnsName(serviceInfo.type.value());
+
+		const auto changed = (serviceInfo.status == ServiceInfo::STATUS_FOUND)
+			? context.serviceTypes.AddInstance(serviceType)
+			: context.serviceTypes.RemoveInstance(serviceType);
+
+		if (changed) {
+			NotifyServiceTypeChanged(context, serviceType);
+		}
+	}
+
+	void NsdWindows::NotifyServiceTypeChanged(DiscoveryContext& context, const std::string& serviceType)
+	{
+		// instance count, or null if the type is gone
+
+		RecordFirstResult(context);
+
+		auto count = context.serviceTypes.GetInstanceCount(serviceType);
+		auto instances = count.has_value() ? flutter::EncodableValue(static_cast<int>(count.value())) : flutter::EncodableValue();
+
+		SendDiscoveryEvent(context, "onServiceTypesChanged", EventRecord()
+			.Set(EventKey::HANDLE, context.handle)
+			.Set(EventKey::SERVICE_TYPES, flutter::EncodableMap({ { flutter::EncodableValue(serviceType), instances } })));
+	}
+
+	void NsdWindows::AutoResolve(DiscoveryContext& discoveryContext, const ServiceInfo& serviceInfo)
+	{
+		// the browse response didn't contain SRV / TXT records, fall back to a separate resolve
+
+		auto it = resolveKeys.find(ToLowerDnsName(GetInstanceName(serviceInfo.name.value(), serviceInfo.type.value())));
+		if (it != resolveKeys.end() && resolveContexts.Get(it->second)->waiters.Contains([&discoveryContext](const ResolveWaiter& waiter) -> bool {
+			return waiter.discovery == discoveryContext.id;
+			})) {
+			return; // still pending from an earlier sighting, its result will be reported
+		}
+
+		ResolveWaiter waiter;
+		waiter.ipLookupType = discoveryContext.ipLookupType;
+		waiter.interfaceIndex = serviceInfo.interfaceIndex.value_or(kAnyInterface);
+		waiter.discovery = discoveryContext.id;
+		waiter.discovered = serviceInfo;
+
+		StartServiceResolve(serviceInfo.name.value(), serviceInfo.type.value(), waiter, ResolvePriority::LOW, kDefaultResolveTimeout);
+	}
+
+	void NsdWindows::CancelAutoResolve(DiscoveryContext& discoveryContext, const ServiceInfo& serviceInfo)
+	{
+		// only the discovery's own waiter goes, others may still want the result
+
+		auto it = resolveKeys.find(ToLowerDnsName(GetInstanceName(serviceInfo.name.value(), serviceInfo.type.value())));
+		if (it == resolveKeys.end()) {
+			return;
+		}
+
+		CancelResolveWaiters(*resolveContexts.Get(it->second), [&discoveryContext](const ResolveWaiter& current) -> bool {
+			return current.discovery == discoveryContext.id;
+			});
+	}
+
+	void NsdWindows::CancelResolveWaiters(ResolveContext& context, const std::function<bool(const ResolveWaiter&)>& matches)
+	{
+		// the resolve keeps running for the other waiters, it is cancelled along with the last one
+
+		auto cancelled = context.waiters.Detach(matches);
+		ReleaseResolveWaiters(cancelled);
+
+		for (const auto& waiter : cancelled) {
+			resolveScheduler.Cancel(context.key, waiter.id); // calls AbortResolve() for the last one
+		}
+
+		if (context.waiters.Empty()) {
+			RemoveResolveContext(context);
+		}
+
+		ArmResolveDeadlineTimer();
+	}
+
+	void NsdWindows::NotifyServiceChanged(DiscoveryContext& context, const ServiceInfo& serviceInfo)
+	{
+		RecordFirstResult(context);
+
+		auto instanceName = GetInstanceName(serviceInfo.name.value(), serviceInfo.type.value());
+		if (serviceInfo.status == ServiceInfo::STATUS_FOUND) {
+			context.journal.Put(instanceName, serviceInfo);
+		}
+		else {
+			context.journal.Remove(instanceName, serviceInfo);
+		}
+
+		if (!context.batch) {
+			auto arguments = SerializeServiceInfo(serviceInfo);
+			arguments.Set(EventKey::HANDLE, context.handle);
+			SendDiscoveryEvent(context, serviceInfo.status == ServiceInfo::STATUS_FOUND ? "onServiceDiscovered" : "onServiceLost", std::move(arguments));
+			return;
+		}
+
+		auto& batch = *context.batch;
+
+		// latest pending change for the same service
+		auto it = std::find_if(batch.pending.rbegin(), batch.pending.rend(), [&serviceInfo](const ServiceInfo& current) -> bool {
+			return
+				EqualsDnsName(current.name.value(), serviceInfo.name.value()) &&
+				EqualsDnsName(current.type.value(), serviceInfo.type.value());
+			});
+
+		if (serviceInfo.status == ServiceInfo::STATUS_LOST && it != batch.pending.rend() && it->status == ServiceInfo::STATUS_FOUND) {
+			batch.pending.erase(std::next(it).base()); // found and lost within the same window, the dart side never needs to know
+			return;
+		}
+
+		batch.pending.push_back(serviceInfo);
+
+		if (batch.maxSize > 0 && batch.pending.size() >= batch.maxSize) {
+			FlushDiscoveryBatch(context);
+		}
+		else if (batch.pending.size() == 1) {
+			// first change of a new batch starts the window
+			auto dueTime = ToRelativeFileTime(batch.interval);
+			SetThreadpoolTimer(batch.timer, &dueTime, 0, 0);
+		}
+	}
+
+	void NsdWindows::FlushDiscoveryBatch(DiscoveryContext& context)
+	{
+		auto& batch = *context.batch;
+		std::vector<ServiceInfo> changes;
+
+		changes.swap(batch.pending);
+		SetThreadpoolTimer(batch.timer, nullptr, 0, 0); // batch is flushed, timer no longer needed
+
+		if (changes.empty()) {
+			return;
+		}
+
+		flutter::EncodableList serializedChanges;
+		serializedChanges.reserve(changes.size());
+
+		for (const auto& change : changes) {
+			auto serializedChange = SerializeServiceInfo(change);
+			serializedChange.Set(EventKey::SERVICE_STATUS, change.status == ServiceInfo::STATUS_FOUND ? "found"s : "lost"s);
+			serializedChanges.push_back(CreateEventValue(std::move(serializedChange)));
+		}
+
+		SendDiscoveryEvent(context, "onServicesChanged", EventRecord()
+			.Set(EventKey::HANDLE, context.handle)
+			.Set(EventKey::SERVICE_CHANGES, std::move(serializedChanges)));
+	}
+
+	void NsdWindows::OnDiscoveryBatchDue(const SlabHandle id)
+	{
+		auto context = discoveryContexts.Get(id);
+		if (context == nullptr) {
+			return; // discovery has been stopped in the meantime, pending changes were flushed then
+		}
+
+		FlushDiscoveryBatch(*context);
+	}
+
+	void NsdWindows::OnServiceResolved(const SlabHandle id, const DWORD status, const std::optional<ServiceInfo>& serviceInfo)
+	{
+		auto pContext = resolveContexts.Get(id);
+		if (pContext == nullptr) {
+			tracer.Instant("dispatch", "StaleResult", "OnServiceResolved");
+			return;
+		}
+
+		auto& resolveContext = *pContext;
+
+		if (resolveContext.retired) {
+			OnRetiredResolveCallback(resolveContext, nullptr); // timed out or cancelled
+			return;
+		}
+
+		resolveContext.resolvePending = false;
+
+		if (status == ERROR_SUCCESS) {
+
+			ServiceInfo resolved = serviceInfo.value();
+			SetAddresses(resolved, FilterAddresses(resolved.addresses.value_or(std::vector<std::string>()), resolveContext.waiters.GetIpLookupType()));
+			resolveContext.resolved = resolved;
+
+			StartAddressQueries(resolveContext);
+			if (!resolveContext.addressQueries.empty()) {
+				return; // completed by OnAddressesQueried()
+			}
+		}
+
+		CompleteResolve(resolveContext, status);
+	}
+
+	void NsdWindows::StartAddressQueries(ResolveContext& context)
+	{
+		auto& resolved = context.resolved.value();
+		auto addresses = resolved.addresses.value_or(std::vector<std::string>());
+
+		if (!resolved.host.has_value()) {
+			return;
+		}
+
+		for (const auto family : GetMissingAddressFamilies(addresses, context.waiters.GetIpLookupType())) {
+
+			auto query = std::make_unique<AddressQueryContext>();
+			query->nsdWindows = this;
+			query->resolve = context.id;
+			query->hostName = resolved.host.value();
+			query->queryName = ToUtf16(resolved.host.value());
+			query->result.Version = DNS_QUERY_RESULTS_VERSION1;
+
+			// see https://learn.microsoft.com/en-us/windows/win32/api/windns/nf-windns-dnsqueryex
+			DNS_QUERY_REQUEST request{};
+			request.Version = DNS_QUERY_REQUEST_VERSION1;
+			request.QueryName = query->queryName.c_str();
+			request.QueryType = (family == AddressFamily::V4) ? DNS_TYPE_A : DNS_TYPE_AAAA;
+			request.QueryOptions = DNS_QUERY_STANDARD;
+			request.pQueryCompletionCallback = &DnsQueryCompletionCallback;
+			request.pQueryContext = query.get();
+
+			TraceSpan span(tracer, "dns", "DnsQueryEx", query->hostName);
+			const auto status = DnsQueryEx(&request, &query->result, &query->canceller);
+			span.End();
+
+			if (status == DNS_REQUEST_PENDING) {
+				context.addressQueries.push_back(std::move(query));
+			}
+			else if (status == ERROR_SUCCESS) {
+				// answered from the cache, the callback won't be called
+				MergeAddresses(addresses, ExtractAddresses(GetAddressRecords(query->result.pQueryRecords), query->hostName, context.waiters.GetIpLookupType()));
+				DnsRecordListFree(query->result.pQueryRecords, DnsFreeRecordList);
+			}
+
+			// other errors: the service is reported without addresses, the dart side can still look them up
+		}
+
+		SetAddresses(resolved, addresses);
+	}
+
+	void NsdWindows::OnAddressesQueried(const SlabHandle id, const DWORD status, const std::optional<ServiceInfo>& serviceInfo, const void* addressQuery)
+	{
+		auto pContext = resolveContexts.Get(id);
+		if (pContext == nullptr) {
+			return;
+		}
+
+		auto& context = *pContext;
+
+		if (context.retired) {
+			OnRetiredResolveCallback(context, addressQuery); // timed out or cancelled
+			return;
+		}
+
+		auto& resolved = context.resolved.value();
+		auto& queries = context.addressQueries;
+
+		queries.erase(std::remove_if(queries.begin(), queries.end(), [addressQuery](const std::unique_ptr<AddressQueryContext>& query) -> bool {
+			return query.get() == addressQuery;
+			}), queries.end());
+
+		if (status == ERROR_SUCCESS && serviceInfo.has_value() && serviceInfo->addresses.has_value()) {
+			auto addresses = resolved.addresses.value_or(std::vector<std::string>());
+			MergeAddresses(addresses, FilterAddresses(serviceInfo->addresses.value(), context.waiters.GetIpLookupType()));
+			SetAddresses(resolved, addresses);
+		}
+
+		if (!queries.empty()) {
+			return;
+		}
+
+		CompleteResolve(context, ERROR_SUCCESS);
+	}
+
+	void NsdWindows::CompleteResolve(ResolveContext& context, const DWORD status)
+	{
+		resolveScheduler.Complete(context.key);
+		ArmResolveDeadlineTimer();
+		RecordOperation(PluginMetrics::RESOLVE, status, context.started);
+
+		std::optional<ServiceInfo> resolved;
+		if (status == ERROR_SUCCESS) {
+			resolved = context.resolved;
+			resolveCache.Put(GetInstanceName(resolved->name.value(), resolved->type.value()), resolved.value(), resolved->ttl.value_or(kDefaultResolveTtl));
+		}
+
+		auto waiters = context.waiters.DetachAll();
+		ReleaseResolveWaiters(waiters);
+		RemoveResolveContext(context); // nothing is outstanding, so the context is gone after this
+
+		for (const auto& waiter : waiters) {
+			NotifyResolveWaiter(waiter, status, resolved);
+		}
+	}
+
+	void NsdWindows::NotifyResolveWaiter(const ResolveWaiter& waiter, const DWORD status, const std::optional<ServiceInfo>& resolved)
+	{
+		if (waiter.discovery != kNoSlabHandle) {
+			OnDiscoveredServiceResolved(waiter.discovery, waiter.discovered.value(), resolved);
+			return;
+		}
+
+		if (waiter.handle.empty()) {
+			return; // cache refresh
+		}
+
+		if (status != ERROR_SUCCESS) {
+			SendEvent("onResolveFailed", EventRecord()
+				.Set(EventKey::HANDLE, waiter.handle)
+				.Set(EventKey::ERROR_CAUSE, ToErrorCode((status == ERROR_TIMEOUT) ? ErrorCause::TIMEOUT : ErrorCause::INTERNAL_ERROR))
+				.Set(EventKey::ERROR_MESSAGE, GetErrorMessage(status)));
+			return;
+		}
+
+		// the shared result may contain addresses other waiters asked for
+		auto serviceInfo = resolved.value();
+		SetAddresses(serviceInfo, FilterAddresses(serviceInfo.addresses.value_or(std::vector<std::string>()), waiter.ipLookupType));
+
+		auto arguments = SerializeServiceInfo(serviceInfo);
+		arguments.Set(EventKey::HANDLE, waiter.handle);
+		SendEvent("onResolveSuccessful", std::move(arguments));
+	}
+
+	void NsdWindows::OnDiscoveredServiceResolved(const SlabHandle discovery, const ServiceInfo& discovered, const std::optional<ServiceInfo>& resolved)
+	{
+		auto pContext = discoveryContexts.Get(discovery);
+		if (pContext == nullptr) {
+			return; // discovery has been stopped in the meantime
+		}
+
+		auto& context = *pContext;
+
+		auto entry = context.services.Find(discovered.name.value(), discovered.type.value());
+		if (entry == nullptr || !entry->resolving) {
+			return; // service has been lost in the meantime
+		}
+
+		entry->resolving = false;
+
+		if (!resolved.has_value()) {
+			NotifyServiceChanged(context, discovered); // report unresolved, the dart side resolves it
+			return;
+		}
+
+		ServiceInfo serviceInfo = resolved.value();
+		serviceInfo.status = ServiceInfo::STATUS_FOUND;
+		if (!serviceInfo.interfaceIndex.has_value()) {
+			serviceInfo.interfaceIndex = discovered.interfaceIndex;
+		}
+		entry->host = context.services.Intern(serviceInfo.host.value());
+
+		NotifyServiceChanged(context, serviceInfo);
+	}
+
+	void NsdWindows::OnServiceRegistered(const SlabHandle id, const DWORD status, const std::optional<ServiceInfo>& serviceInfo, PDNS_SERVICE_INSTANCE pInstance)
+	{
+		auto pContext = registerContexts.Get(id);
+		if (pContext == nullptr) {
+			tracer.Instant("dispatch", "StaleResult", "OnServiceRegistered");
+			DnsServiceFreeInstance(pInstance);
+			return;
+		}
+
+		auto& context = *pContext;
+		auto& request = context.request;
+		auto handle = context.handle;
+		auto batchHandle = context.batchHandle;
+
+		RecordOperation(PluginMetrics::REGISTER, status, context.started);
+
+		if (status != ERROR_SUCCESS) {
+			if (!batchHandle.empty()) {
+				RemoveRegisterContext(context); // the batch result is final, nothing is left to unregister
+			}
+			NotifyRegistrationChanged(batchHandle, "onRegistrationFailed", EventRecord()
+				.Set(EventKey::HANDLE, handle)
+				.Set(EventKey::ERROR_CAUSE, ToErrorCode(ErrorCause::INTERNAL_ERROR))
+				.Set(EventKey::ERROR_MESSAGE, GetErrorMessage(status)));
+			return;
+		}
+
+		// the existing request must be reused with the newly received instance for unregistering 
+		request.pServiceInstance = pInstance;
+
+		NotifyRegistrationChanged(batchHandle, "onRegistrationSuccessful", EventRecord()
+			.Set(EventKey::HANDLE, handle)
+			.Set(EventKey::SERVICE_TYPE, serviceInfo->type.value())
+			.Set(EventKey::SERVICE_NAME, serviceInfo->name.value())
+			.Set(EventKey::SERVICE_PORT, serviceInfo->port.value())
+			.Set(EventKey::SERVICE_HOST, serviceInfo->host.value())
+			.Set(EventKey::SERVICE_TXT_RAW, serviceInfo->txt->GetWire()));
+	}
+
+	void NsdWindows::OnServiceUnregistered(const SlabHandle id, const DWORD status)
+	{
+		auto context = registerContexts.Get(id);
+		if (context == nullptr) {
+			tracer.Instant("dispatch", "StaleResult", "OnServiceUnregistered");
+			return;
+		}
+
+		auto handle = context->handle;
+		auto batchHandle = context->batchHandle;
+		RecordOperation(PluginMetrics::UNREGISTER, status, context->started);
+		RemoveRegisterContext(*context);
+
+		if (status != ERROR_SUCCESS) {
+			NotifyRegistrationChanged(batchHandle, "onUnregistrationFailed", EventRecord()
+				.Set(EventKey::HANDLE, handle)
+				.Set(EventKey::ERROR_CAUSE, ToErrorCode(ErrorCause::INTERNAL_ERROR))
+				.Set(EventKey::ERROR_MESSAGE, GetErrorMessage(status)));
+			return;
+		}
+
+		NotifyRegistrationChanged(batchHandle, "onUnregistrationSuccessful", EventRecord().Set(EventKey::HANDLE, handle));
+	}
+
+	void NsdWindows::RemoveRegisterContext(RegisterContext& context)
+	{
+		registerHandles.erase(context.handle);
+		registerContexts.Erase(context.id);
+	}
+
+	void NsdWindows::NotifyRegistrationChanged(const std::string& batchHandle, const std::string& method, EventRecord arguments)
+	{
+		if (batchHandle.empty()) {
+			SendEvent(method, std::move(arguments));
+			return;
+		}
+
+		// part of a batch: the result is reported with the others once all are in, see ContinueRegistrationBatch()
+
+		auto it = registrationBatchMap.find(batchHandle);
+		if (it == registrationBatchMap.end()) {
+			return;
+		}
+
+		auto handle = std::get<std::string>(*arguments.Get(EventKey::HANDLE));
+		it->second->batch.Complete(handle, std::move(arguments));
+
+		ContinueRegistrationBatch(batchHandle);
+	}
+
+	// DNS API callbacks: these run on threadpool threads, they must not touch any plugin state
+
+	void NsdWindows::DnsServiceBrowseCallback(const DWORD status, LPVOID context, PDNS_RECORD records)
+	{
+		BrowseContext& browseContext = *static_cast<BrowseContext*>(context);
+		TraceSpan span(browseContext.nsdWindows->tracer, "callback", "DnsServiceBrowseCallback", browseContext.serviceType);
+
+		std::optional<ServiceInfo> serviceInfo;
+		if (status == ERROR_SUCCESS) {
+			serviceInfo = browseContext.enumeratesTypes ? GetServiceTypeFromRecords(records) : GetServiceInfoFromRecords(records, browseContext.autoResolve);
+		}
+
+		// must be deleted as described here: https://docs.microsoft.com/en-us/windows/win32/api/windns/nc-windns-dns_service_browse_callback
+		DnsRecordListFree(records, DnsFreeRecordList);
+
+		if (status == ERROR_CANCELLED) {
+			// final callback, the context may be freed as soon as this is posted
+			DnsCallbackResult result{ DnsCallbackResult::BROWSE_CANCELLED, browseContext.discovery, status };
+			result.context = &browseContext;
+			browseContext.nsdWindows->Post(std::move(result));
+			return;
+		}
+
+		auto kind = browseContext.enumeratesTypes ? DnsCallbackResult::SERVICE_TYPE_DISCOVERED : DnsCallbackResult::SERVICE_DISCOVERED;
+		browseContext.metrics->browses.statuses.Record(status);
+
+		if (!serviceInfo.has_value()) {
+			// failed, or the records didn't name a service; counted here since Post() never sees it
+			auto& callbackMetrics = browseContext.nsdWindows->metrics.callbacks[kind];
+			callbackMetrics.statuses.Record(status);
+			callbackMetrics.dropped.fetch_add(1, std::memory_order_relaxed);
+			browseContext.metrics->browses.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		if (browseContext.interfaceIndex != kAnyInterface) {
+			serviceInfo->interfaceIndex = browseContext.interfaceIndex; // browse records don't carry it
+		}
+
+		browseContext.nsdWindows->Post({ kind, browseContext.discovery, status, std::move(serviceInfo) });
+	}
+
+	void NsdWindows::DnsServiceResolveCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance)
+	{
+		ResolveContext& resolveContext = *static_cast<ResolveContext*>(context);
+		TraceSpan span(resolveContext.nsdWindows->tracer, "callback", "DnsServiceResolveCallback", resolveContext.instanceName);
+
+		DnsCallbackResult result{ DnsCallbackResult::SERVICE_RESOLVED, resolveContext.id, status };
+		if (status == ERROR_SUCCESS) {
+			result.serviceInfo = GetServiceInfoFromInstance(pInstance);
+		}
+
+		DnsServiceFreeInstance(pInstance);
+		resolveContext.nsdWindows->Post(std::move(result));
+	}
+
+	void NsdWindows::DnsServiceRegisterCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance)
+	{
+		RegisterContext& registerContext = *static_cast<RegisterContext*>(context);
+		TraceSpan span(registerContext.nsdWindows->tracer, "callback", "DnsServiceRegisterCallback", registerContext.handle);
+
+		DnsCallbackResult result{ DnsCallbackResult::SERVICE_REGISTERED, registerContext.id, status };
+		if (status == ERROR_SUCCESS) {
+			result.serviceInfo = GetServiceInfoFromInstance(pInstance);
+			result.pInstance = pInstance; // ownership is passed on to the platform thread
+		}
+		else {
+			DnsServiceFreeInstance(pInstance);
+		}
+
+		registerContext.nsdWindows->Post(std::move(result));
+	}
+
+	void NsdWindows::DnsServiceUnregisterCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance)
+	{
+		RegisterContext& registerContext = *static_cast<RegisterContext*>(context);
+		TraceSpan span(registerContext.nsdWindows->tracer, "callback", "DnsServiceUnregisterCallback", registerContext.handle);
+
+		DnsServiceFreeInstance(pInstance); // not used
+		registerContext.nsdWindows->Post({ DnsCallbackResult::SERVICE_UNREGISTERED, registerContext.id, status });
+	}
+
+	void NsdWindows::DnsQueryCompletionCallback(PVOID context, PDNS_QUERY_RESULT pQueryResults)
+	{
+		AddressQueryContext& queryContext = *static_cast<AddressQueryContext*>(context);
+		TraceSpan span(queryContext.nsdWindows->tracer, "callback", "DnsQueryCompletionCallback", queryContext.hostName);
+
+		const auto status = static_cast<DWORD>(pQueryResults->QueryStatus);
+
+		DnsCallbackResult result{ DnsCallbackResult::ADDRESSES_QUERIED, queryContext.resolve, status };
+		result.context = &queryContext;
+		if (status == ERROR_SUCCESS) {
+			ServiceInfo serviceInfo;
+			serviceInfo.addresses = ExtractAddresses(GetAddressRecords(pQueryResults->pQueryRecords), queryContext.hostName, IpLookupType::ANY);
+			result.serviceInfo = serviceInfo;
+		}
+
+		if (pQueryResults->pQueryRecords != nullptr) {
+			DnsRecordListFree(pQueryResults->pQueryRecords, DnsFreeRecordList);
+		}
+
+		queryContext.nsdWindows->Post(std::move(result));
+	}
+
+	void NsdWindows::ResolveDeadlineTimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer)
+	{
+		auto nsdWindows = static_cast<NsdWindows*>(context);
+		TraceSpan span(nsdWindows->tracer, "callback", "ResolveDeadlineTimerCallback");
+		nsdWindows->Post({ DnsCallbackResult::RESOLVE_DEADLINE_DUE });
+	}
+
+	void NsdWindows::MdnsTimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer)
+	{
+		auto nsdWindows = static_cast<NsdWindows*>(context);
+		TraceSpan span(nsdWindows->tracer, "callback", "MdnsTimerCallback");
+		nsdWindows->Post({ DnsCallbackResult::MDNS_DUE });
+	}
+
+	void NsdWindows::DiscoveryBatchTimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer)
+	{
+		DiscoveryContext& discoveryContext = *static_cast<DiscoveryContext*>(context);
+		TraceSpan span(discoveryContext.nsdWindows->tracer, "callback", "DiscoveryBatchTimerCallback", discoveryContext.handle);
+		discoveryContext.nsdWindows->Post({ DnsCallbackResult::DISCOVERY_BATCH_DUE, discoveryContext.id });
+	}
+
+	std::optional<ServiceInfo> NsdWindows::GetServiceInfoFromRecords(const PDNS_RECORD& records, const bool resolve) {
+
+		// record properties see https://docs.microsoft.com/en-us/windows/win32/api/windns/ns-windns-dns_recordw
+		// seen: DNS_TYPE_A (0x0001), DNS_TYPE_TEXT (0x0010), DNS_TYPE_AAAA (0x001c), DNS_TYPE_SRV (0x0021)
+
+		for (auto record = records; record; record = record->pNext) {
+			if (record->wType == DNS_TYPE_PTR) { // 0x0012
+				auto serviceInfo = GetServiceInfoFromPtrRecord(record);
+				if (resolve && serviceInfo.has_value() && serviceInfo->status == ServiceInfo::STATUS_FOUND) {
+					ResolveServiceInfoFromRecords(records, record->Data.PTR.pNameHost, serviceInfo.value());
+				}
+				return serviceInfo;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	std::optional<ServiceInfo> NsdWindows::GetServiceTypeFromRecords(const PDNS_RECORD& records)
+	{
+		for (auto record = records; record; record = record->pNext) {
+			if (record->wType == DNS_TYPE_PTR) {
+
+				auto nameHost = ToUtf8(record->Data.PTR.pNameHost); // "_http._tcp.local"
+				auto parsed = ParseServiceInstanceName(nameHost);
+				if (!parsed.has_value()) {
+					return std::nullopt;
+				}
+
+				ServiceInfo serviceInfo;
+				serviceInfo.type = std::string(parsed->GetType());
+				serviceInfo.status = (record->dwTtl > 0) ? ServiceInfo::STATUS_FOUND : ServiceInfo::STATUS_LOST;
+				return serviceInfo;
+			}
+		}
+
+		return std::nullopt;
+	}
+
+	void NsdWindows::ResolveServiceInfoFromRecords(const PDNS_RECORD& records, const std::wstring& instanceName, ServiceInfo& serviceInfo)
+	{
+		// responses usually carry the SRV, TXT and address records as additional records,
+		// see https://datatracker.ietf.org/doc/html/rfc6763#section-12.1
+
+		std::optional<std::wstring> hostName;
+
+		for (auto record = records; record; record = record->pNext) {
+
+			if (record->pName == nullptr || _wcsicmp(record->pName, instanceName.c_str()) != 0) {
+				continue;
+			}
+
+			auto ttl = std::chrono::seconds(record->dwTtl);
+
+			if (record->wType == DNS_TYPE_SRV) {
+				serviceInfo.ttl = std::min(ttl, serviceInfo.ttl.value_or(ttl));
+				hostName = record->Data.SRV.pNameTarget;
+				serviceInfo.host = ToUtf8(record->Data.SRV.pNameTarget);
+				serviceInfo.port = record->Data.SRV.wPort;
+			}
+			else if (record->wType == DNS_TYPE_TEXT) {
+				serviceInfo.ttl = std::min(ttl, serviceInfo.ttl.value_or(ttl));
+				serviceInfo.txt = DnsTxtToTxtRecord(record->Data.TXT.dwStringCount, record->Data.TXT.pStringArray);
+			}
+		}
+
+		if (!hostName.has_value()) {
+			return;
+		}
+
+		SetAddresses(serviceInfo, ExtractAddresses(GetAddressRecords(records), ToUtf8(hostName.value()), IpLookupType::ANY));
+	}
+
+	std::string NsdWindows::GetInstanceName(const std::string& serviceName, const std::string& serviceType)
+	{
+		return serviceName + "." + serviceType + ".local";
+	}
+
+	void NsdWindows::SetAddresses(ServiceInfo& serviceInfo, const std::vector<std::string>& addresses)
+	{
+		if (addresses.empty()) {
+			serviceInfo.addresses = std::nullopt; // "no addresses known" as far as the dart side is concerned
+		}
+		else {
+			serviceInfo.addresses = addresses;
+		}
+	}
+
+	EventRecord NsdWindows::SerializeServiceInfo(const ServiceInfo& serviceInfo)
+	{
+		EventRecord arguments;
+		arguments.Set(EventKey::SERVICE_NAME, serviceInfo.name.value());
+		arguments.Set(EventKey::SERVICE_TYPE, serviceInfo.type.value());
+
+		if (serviceInfo.host.has_value()) {
+			arguments.Set(EventKey::SERVICE_HOST, serviceInfo.host.value());
+		}
+
+		if (serviceInfo.port.has_value()) {
+			arguments.Set(EventKey::SERVICE_PORT, serviceInfo.port.value());
+		}
+
+		if (serviceInfo.txt.has_value()) {
+			arguments.Set(EventKey::SERVICE_TXT_RAW, serviceInfo.txt->GetWire()); // parsed lazily on the Dart side
+		}
+
+		if (serviceInfo.addresses.has_value()) {
+			arguments.Set(EventKey::SERVICE_ADDRESSES, flutter::EncodableList(serviceInfo.addresses->begin(), serviceInfo.addresses->end()));
+		}
+
+		if (serviceInfo.interfaceIndex.has_value()) {
+			arguments.Set(EventKey::SERVICE_INTERFACE_INDEX, static_cast<int>(serviceInfo.interfaceIndex.value()));
+		}
+
+		if (serviceInfo.IsResolved()) {
+			arguments.Set(EventKey::SERVICE_RESOLVED, true);
+		}
+
+		return arguments;
+	}
+
+	std::optional<flutter::EncodableValue> NsdWindows::SerializeOperationMetrics(OperationMetrics& metrics, const bool reset)
+	{
+		auto serialized = SerializeStatuses(metrics.statuses.Summarize(reset));
+		const auto latency = metrics.latency.Summarize(reset);
+
+		if (!serialized.has_value()) {
+			return std::nullopt;
+		}
+
+		serialized.value()[flutter::EncodableValue("latency")] = SerializeLatency(latency);
+		return flutter::EncodableValue(std::move(serialized.value()));
+	}
+
+	std::optional<flutter::EncodableValue> NsdWindows::SerializeCallbackMetrics(CallbackMetrics& metrics, const bool reset)
+	{
+		auto serialized = SerializeStatuses(metrics.statuses.Summarize(reset));
+		const auto dropped = reset ? metrics.dropped.exchange(0, std::memory_order_relaxed) : metrics.dropped.load(std::memory_order_relaxed);
+
+		if (!serialized.has_value()) {
+			return std::nullopt;
+		}
+
+		serialized.value()[flutter::EncodableValue("dropped")] = flutter::EncodableValue(static_cast<int64_t>(dropped));
+		return flutter::EncodableValue(std::move(serialized.value()));
+	}
+
+	std::optional<flutter::EncodableMap> NsdWindows::SerializeStatuses(const StatusCounter::Summary& summary)
+	{
+		if (summary.total == 0) {
+			return std::nullopt;
+		}
+
+		flutter::EncodableMap counts;
+		for (const auto& [status, count] : summary.statuses) {
+			counts[flutter::EncodableValue(static_cast<int64_t>(status))] = flutter::EncodableValue(static_cast<int64_t>(count));
+		}
+
+		return flutter::EncodableMap{
+			{ flutter::EncodableValue("count"), flutter::EncodableValue(static_cast<int64_t>(summary.total)) },
+			{ flutter::EncodableValue("failures"), flutter::EncodableValue(static_cast<int64_t>(summary.failures)) },
+			{ flutter::EncodableValue("statuses"), flutter::EncodableValue(std::move(counts)) },
+			{ flutter::EncodableValue("statuses.other"), flutter::EncodableValue(static_cast<int64_t>(summary.other)) },
+		};
+	}
+
+	flutter::EncodableValue NsdWindows::SerializeLatency(const LatencyHistogram::Summary& summary)
+	{
+		return flutter::EncodableValue(flutter::EncodableMap{
+			{ flutter::EncodableValue("count"), flutter::EncodableValue(static_cast<int64_t>(summary.count)) },
+			{ flutter::EncodableValue("min"), flutter::EncodableValue(static_cast<int64_t>(summary.min)) },
+			{ flutter::EncodableValue("max"), flutter::EncodableValue(static_cast<int64_t>(summary.max)) },
+			{ flutter::EncodableValue("mean"), flutter::EncodableValue(static_cast<int64_t>(summary.mean)) },
+			{ flutter::EncodableValue("p50"), flutter::EncodableValue(static_cast<int64_t>(summary.p50)) },
+			{ flutter::EncodableValue("p90"), flutter::EncodableValue(static_cast<int64_t>(summary.p90)) },
+			{ flutter::EncodableValue("p99"), flutter::EncodableValue(static_cast<int64_t>(summary.p99)) },
+			});
+	}
+
+	std::unique_ptr<DiscoveryBatch> NsdWindows::CreateDiscoveryBatch(const flutter::EncodableMap& arguments, DiscoveryContext& context)
+	{
+		auto intervalO = DeserializeOptional<int>(arguments, "discovery.batch.interval"); // milliseconds
+		auto maxSizeO = DeserializeOptional<int>(arguments, "discovery.batch.size");
+
+		if (!intervalO.has_value() && !maxSizeO.has_value()) {
+			return nullptr; // every change is delivered as a separate message
+		}
+
+		auto interval = intervalO.value_or(250); // if only the size is given, stragglers are flushed after this interval
+		auto maxSize = maxSizeO.value_or(0);
+
+		if (interval <= 0 || maxSize < 0) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Batch interval must be positive, batch size must not be negative");
+		}
+
+		auto batch = std::make_unique<DiscoveryBatch>(std::chrono::milliseconds(interval), static_cast<size_t>(maxSize));
+
+		batch->timer = CreateThreadpoolTimer(&DiscoveryBatchTimerCallback, &context, nullptr);
+		if (batch->timer == nullptr) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, GetLastErrorMessage());
+		}
+
+		return batch;
+	}
+
+	ServiceInfo NsdWindows::GetServiceInfoFromInstance(const PDNS_SERVICE_INSTANCE& pInstance)
+	{
+		auto instanceName = ToUtf8(pInstance->pszInstanceName); // "HP Color LaserJet MFP M277dw (C162F4)._http._tcp.local"
+		auto parsed = ParseServiceInstanceName(instanceName);
+
+		ServiceInfo serviceInfo;
+		if (parsed.has_value() && !parsed->instance.empty()) {
+			serviceInfo.name = std::string(parsed->instance); // not escaped by the DNS API
+			serviceInfo.type = std::string(parsed->GetType());
+		}
+		else {
+			serviceInfo.name = instanceName; // not expected from the DNS API, kept as is rather than failing on a threadpool thread
+			serviceInfo.type = "";
+		}
+		serviceInfo.port = pInstance->wPort;
+		serviceInfo.host = ToUtf8(pInstance->pszHostName);
+		serviceInfo.txt = WindowsTxtToTxtRecord(pInstance->dwPropertyCount, pInstance->keys, pInstance->values);
+		serviceInfo.status = ServiceInfo::STATUS_FOUND;
+		if (pInstance->dwInterfaceIndex != kAnyInterface) {
+			serviceInfo.interfaceIndex = pInstance->dwInterfaceIndex;
+		}
+		SetAddresses(serviceInfo, ExtractAddresses(GetAddressRecords(pInstance), serviceInfo.host.value(), IpLookupType::ANY));
+		return serviceInfo;
+	}
+
+	std::optional<ServiceInfo> NsdWindows::GetServiceInfoFromMdnsInstance(const MdnsServiceInstance& instance)
+	{
+		auto parsed = ParseServiceInstanceName(instance.instanceName); // "My\.Printer._ipp._tcp.local"
+		if (!parsed.has_value() || parsed->instance.empty()) {
+			return std::nullopt;
+		}
+
+		auto name = UnescapeDnsLabel(parsed->instance);
+		if (!name.has_value()) {
+			return std::nullopt;
+		}
+
+		ServiceInfo serviceInfo;
+		serviceInfo.name = std::move(name);
+		serviceInfo.type = std::string(parsed->GetType());
+		serviceInfo.port = instance.port;
+		serviceInfo.host = instance.host;
+		serviceInfo.txt = TxtRecord::FromWire(instance.txt.data(), instance.txt.size());
+		serviceInfo.ttl = std::chrono::seconds(instance.ttl);
+		serviceInfo.status = ServiceInfo::STATUS_FOUND;
+		SetAddresses(serviceInfo, instance.addresses);
+		return serviceInfo;
+	}
+
+	std::optional<nsd_windows::ServiceInfo> NsdWindows::GetServiceInfoFromPtrRecord(const PDNS_RECORD& record)
 	{
 		auto nameHost = ToUtf8(record->Data.PTR.pNameHost); // PTR rdata field DNAME, e.g. "HP Color LaserJet MFP M277dw (C162F4)._http._tcp.local"
 		auto ttl = record->dwTtl;
 
-		auto components = Split(nameHost, '.');
+		auto parsed = ParseServiceInstanceName(nameHost);
+		if (!parsed.has_value() || parsed->instance.empty()) {
+			return std::nullopt;
+		}
 
 		ServiceInfo serviceInfo;
-		serviceInfo.name = components[0];
-		serviceInfo.type = components[1] + "." + components[2];
+		serviceInfo.name = std::string(parsed->instance); // not escaped by the DNS API
+		serviceInfo.type = std::string(parsed->GetType());
 		serviceInfo.status = (ttl > 0) ? ServiceInfo::STATUS_FOUND : ServiceInfo::STATUS_LOST;
 
-		//std::cout << GetTimeNow() << " " << "Record: PTR: name: " << name << ", domain name: " << nameHost << ", ttl: " << ttl << std::endl;
 		return serviceInfo;
 	}
 
@@ -1,12 +1,40 @@
 #pragma once
 
+#include <flutter/event_channel.h>
+#include <flutter/event_sink.h>
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 
+#include "address_resolution.h"
+#include "event_port.h"
+#include "mdns_querier.h"
+#include "mdns_responder.h"
+#include "metrics.h"
+#include "mpsc_queue.h"
+#include "network_interfaces.h"
+#include "nsd_codec.h"
+#include "registration_batch.h"
+#include "resolve_cache.h"
+#include "resolve_waiters.h"
+#include "resolve_scheduler.h"
+#include "service_journal.h"
+#include "service_table.h"
+#include "service_type_counts.h"
+#include "slab.h"
+#include "trace_recorder.h"
+#include "txt_record.h"
+
 #include <windns.h>
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
 #include <memory>
+#include <set>
+#include <unordered_map>
 
 #pragma warning(disable : 4458) // declaration hides class member (used intentionally in method parameters vs local variables)
 #pragma comment(lib, "dnsapi.lib")
@@ -27,64 +55,285 @@ namespace nsd_windows {
 		std::optional<std::string> type;
 		std::optional<std::string> host;
 		std::optional<int> port;
+		std::optional<TxtRecord> txt;
+		std::optional<std::vector<std::string>> addresses;
+		std::optional<std::chrono::seconds> ttl; // of the records the info was taken from, if known
+		std::optional<uint32_t> interfaceIndex; // the info was received on, if known
 		Status status;
+
+		// true if host, port and txt are known, so no separate resolve is needed
+		bool IsResolved() const;
 	};
 
+	// result of a DNS API callback; callbacks run on threadpool threads, so they only parse the
+	// records into this structure and leave everything else to the platform thread
+	struct DnsCallbackResult {
+
+		enum Kind {
+			SERVICE_DISCOVERED,
+			BROWSE_CANCELLED,
+			SERVICE_TYPE_DISCOVERED,
+			SERVICE_RESOLVED,
+			SERVICE_REGISTERED,
+			SERVICE_UNREGISTERED,
+			DISCOVERY_BATCH_DUE,
+			ADDRESSES_QUERIED,
+			RESOLVE_DEADLINE_DUE,
+			MDNS_PACKET_RECEIVED,
+			MDNS_DUE,
+			KIND_COUNT
+		};
+
+		Kind kind;
+		SlabHandle id = kNoSlabHandle; // of the discovery, resolve or registration; stale once it has been stopped
+		DWORD status = ERROR_SUCCESS;
+		std::optional<ServiceInfo> serviceInfo;
+		PDNS_SERVICE_INSTANCE pInstance = nullptr; // registered instance, must be kept for unregistering
+		const void* context = nullptr; // browse or address query the result belongs to
+		std::vector<uint8_t> packet; // received by the built-in mDNS querier / responder
+		MdnsEndpoint packetSource; // replies to unicast questions go there
+	};
 
-	struct DiscoveryContext {
+
+	// instrumentation of the whole plugin, see GetMetrics()
+	struct PluginMetrics {
+
+		enum Operation {
+			BROWSE_FIRST_RESULT, // from the start of a discovery until its first service (or type) is reported
+			RESOLVE, // timeouts included, cancelled resolves and cache hits excluded
+			REGISTER,
+			UNREGISTER,
+			OPERATION_COUNT
+		};
+
+		std::array<OperationMetrics, OPERATION_COUNT> operations;
+		std::array<CallbackMetrics, DnsCallbackResult::KIND_COUNT> callbacks; // by kind
+		LatencyHistogram drainDelay; // from posting the drain message until the platform thread handles it
+	};
+
+	// instrumentation of a single discovery, resettable on its own
+	struct DiscoveryMetrics {
+
+		OperationMetrics firstResult; // see PluginMetrics::BROWSE_FIRST_RESULT
+		CallbackMetrics browses; // DnsServiceBrowse callbacks
+	};
+
+
+	// collects found / lost changes so they can be delivered to the dart side in one message
+	struct DiscoveryBatch {
+
+		DiscoveryBatch(std::chrono::milliseconds interval, size_t maxSize);
+		virtual ~DiscoveryBatch();
+		DiscoveryBatch(const DiscoveryBatch&) = delete; // disallow copy
+
+		const std::chrono::milliseconds interval;
+		const size_t maxSize; // 0 means no size limit, changes are only flushed by the timer
+
+		std::vector<ServiceInfo> pending;
+		PTP_TIMER timer = nullptr;
+	};
+
+	// event channel of a discovery that was started with discovery.stream, named kDiscoveryChannelPrefix + handle;
+	// events are held back until the dart side listens, cancelling the subscription stops the discovery
+	struct DiscoveryStream {
+
+		DiscoveryStream(flutter::BinaryMessenger* messenger, const std::string& name);
+		~DiscoveryStream(); // unregisters the channel, so never from within its own handler
+		DiscoveryStream(const DiscoveryStream&) = delete; // disallow copy
+
+		std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>> channel;
+		std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> sink; // set while the dart side listens
+		std::vector<EventRecord> pending;
+	};
+
+	// one browse per service type and interface of a discovery; holds copies of what the browse callback needs
+	struct BrowseContext {
 
 		NsdWindows* nsdWindows;
-		std::string handle;
+		SlabHandle discovery;
+		std::string serviceType;
+		uint32_t interfaceIndex = kAnyInterface;
+		bool autoResolve = false;
+		bool enumeratesTypes = false; // browses _services._dns-sd._udp, the records name service types
 		DNS_SERVICE_CANCEL canceller;
-		std::vector<ServiceInfo> services;
+		uint64_t querierBrowseId = 0; // set if the browse runs on the built-in mDNS querier instead
+		std::shared_ptr<DiscoveryMetrics> metrics; // of the discovery, shared since a cancelled browse may outlive it
+
 	};
 
+	struct DiscoveryContext {
+
+		NsdWindows* nsdWindows;
+		SlabHandle id;
+		std::string handle; // client handle, only used for messages to the dart side
+		std::vector<std::unique_ptr<BrowseContext>> browses;
+		std::vector<uint32_t> interfaces; // each service type is browsed on each of these
+		ServiceTable services; // services of all types
+		ServiceJournal<ServiceInfo> journal; // what has been reported, for getServiceChanges
+		std::unique_ptr<DiscoveryBatch> batch; // only set if batched delivery was requested
+		std::unique_ptr<DiscoveryStream> stream; // only set if events go to the discovery's own event channel
+		bool autoResolve = false; // resolve found services natively before reporting them
+		IpLookupType ipLookupType = IpLookupType::NONE;
+		bool enumerateTypes = false; // report service types with instance counts instead of services
+		ServiceTypeCounts serviceTypes;
+		std::set<std::string> browsedTypes; // browses keep running until the discovery stops
+		std::shared_ptr<DiscoveryMetrics> metrics; // shared with the browses
+		std::chrono::steady_clock::time_point started;
+		bool reported = false; // a first service (or type) has been reported
+	};
 
+
+	// A / AAAA query for the host of a resolved service, in case the resolve didn't deliver the addresses
+	struct AddressQueryContext {
+
+		NsdWindows* nsdWindows;
+		SlabHandle resolve; // that started the query
+		std::string hostName;
+		std::wstring queryName;
+		DNS_QUERY_RESULT result; // must stay valid until the query has completed
+		DNS_QUERY_CANCEL canceller;
+	};
+
+	// party waiting for the result of a resolve
+	struct ResolveWaiter {
+
+		ResolveScheduler::WaiterId id = 0; // tracks the waiter's deadline in the scheduler
+		std::string handle; // client handle, empty for internal resolves
+		IpLookupType ipLookupType = IpLookupType::NONE;
+		uint32_t interfaceIndex = kAnyInterface; // e.g. the one the service was discovered on
+		SlabHandle discovery = kNoSlabHandle; // set if the resolve was started by an auto resolving discovery
+		std::optional<ServiceInfo> discovered; // the service as discovered, set along with the discovery
+	};
+
+	// one pending DnsServiceResolve per instance, concurrent resolves for the same instance attach as waiters
 	struct ResolveContext {
 
 		NsdWindows* nsdWindows;
-		std::string handle;
+		SlabHandle id;
+		std::string key; // lower case instance name
+		std::string instanceName;
+		std::string escapedInstanceName; // presentation format, for the built-in mDNS querier
 		DNS_SERVICE_CANCEL canceller;
+		bool resolvePending = false; // DnsServiceResolve has been started and hasn't called back yet
+		uint64_t querierResolveId = 0; // set while the resolve runs on the built-in mDNS querier instead
+		uint32_t interfaceIndex = kAnyInterface; // of the waiter that started the resolve
+		ResolveWaiters<ResolveWaiter> waiters;
+		std::optional<ServiceInfo> resolved; // kept while address queries are pending
+		std::vector<std::unique_ptr<AddressQueryContext>> addressQueries; // pending ones only
+		bool retired = false; // timed out or cancelled, kept until the outstanding callbacks have arrived
+		std::chrono::steady_clock::time_point started; // including the time queued in the scheduler
 	};
 
 	struct RegisterContext {
 
 		NsdWindows* nsdWindows;
-		std::string handle;
+		SlabHandle id;
+		std::string handle; // client handle, only used for messages to the dart side
 		DNS_SERVICE_CANCEL canceller;
 		DNS_SERVICE_REGISTER_REQUEST request;
+		uint64_t responderId = 0; // set if the service is registered with the built-in mDNS responder instead
+		std::string batchHandle; // set if started by registerMany / unregisterMany
+		std::chrono::steady_clock::time_point started; // of the registration, then of the unregistration
+	};
+
+	// registerMany / unregisterMany: the items are registration arguments, or just the handle for unregistering
+	struct RegistrationBatchContext {
+
+		RegistrationBatchContext(const bool unregisters, const size_t maxRunning) : unregisters(unregisters), batch(maxRunning) {}
+
+		bool unregisters;
+		RegistrationBatch<flutter::EncodableMap, EventRecord> batch;
 	};
 
-	class NsdWindows {
+	class NsdWindows : private ResolveExecutor, private MdnsQuerierListener {
 	public:
 
 		static void DnsServiceBrowseCallback(const DWORD status, LPVOID context, PDNS_RECORD records);
 		static void DnsServiceRegisterCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance);
 		static void DnsServiceUnregisterCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance);
 		static void DnsServiceResolveCallback(const DWORD status, LPVOID context, PDNS_SERVICE_INSTANCE pInstance);
+		static void WINAPI DnsQueryCompletionCallback(PVOID context, PDNS_QUERY_RESULT pQueryResults);
+		static void CALLBACK DiscoveryBatchTimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer);
+		static void CALLBACK ResolveDeadlineTimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer);
+		static void CALLBACK MdnsTimerCallback(PTP_CALLBACK_INSTANCE instance, PVOID context, PTP_TIMER timer);
 
-		NsdWindows(std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel);
+		NsdWindows(flutter::PluginRegistrarWindows* registrar, std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel);
 		virtual ~NsdWindows();
 
 		NsdWindows(const NsdWindows&) = delete; // disallow copy
 		NsdWindows& operator=(const NsdWindows&) = delete; // disallow assign
 
-		void OnServiceDiscovered(const std::string handle, const DWORD status, PDNS_RECORD records);
-		void OnServiceResolved(const std::string handle, const DWORD status, PDNS_SERVICE_INSTANCE pInstance);
-		void OnServiceRegistered(const std::string handle, const DWORD status, PDNS_SERVICE_INSTANCE pInstance);
-		void OnServiceUnregistered(const std::string handle, const DWORD status, PDNS_SERVICE_INSTANCE pInstance);
+		// may be called from any thread, the result is processed on the platform thread
+		void Post(DnsCallbackResult result);
 
 	private:
 
-		static std::optional<ServiceInfo> GetServiceInfoFromRecords(const PDNS_RECORD& records);
+		static constexpr size_t kMaxCallbackResultsPerDrain = 64; // keeps the message loop responsive during bursts
+		static constexpr const char* kServiceTypeEnumerationType = "_services._dns-sd._udp";
+		static constexpr const char* kDiscoveryChannelPrefix = "com.haberey/nsd/discovery/";
+		static constexpr size_t kMaxRunningResolves = 8; // more are queued, so large discoveries don't flood the network
+		static constexpr size_t kMaxRunningRegistrations = 16; // per batch, see RegisterMany()
+		static constexpr int kDefaultJournalPageSize = 256; // see GetServiceChanges()
+		static constexpr std::chrono::milliseconds kDefaultResolveTimeout{ 10000 };
+		static constexpr std::chrono::seconds kDefaultResolveTtl{ 120 }; // instances carry no TTL, see https://datatracker.ietf.org/doc/html/rfc6762#section-10
+		static constexpr std::array<const char*, DnsCallbackResult::KIND_COUNT> kCallbackKindNames{
+			"serviceDiscovered", "browseCancelled", "serviceTypeDiscovered", "serviceResolved", "serviceRegistered", "serviceUnregistered",
+			"discoveryBatchDue", "addressesQueried", "resolveDeadlineDue", "mdnsPacketReceived", "mdnsDue"
+		};
+
+		static std::optional<ServiceInfo> GetServiceInfoFromRecords(const PDNS_RECORD& records, const bool resolve);
+		static std::optional<ServiceInfo> GetServiceTypeFromRecords(const PDNS_RECORD& records);
 		static std::optional<ServiceInfo> GetServiceInfoFromPtrRecord(const PDNS_RECORD& record);
+		static ServiceInfo GetServiceInfoFromInstance(const PDNS_SERVICE_INSTANCE& pInstance);
+		static std::optional<ServiceInfo> GetServiceInfoFromMdnsInstance(const MdnsServiceInstance& instance);
+		static void ResolveServiceInfoFromRecords(const PDNS_RECORD& records, const std::wstring& instanceName, ServiceInfo& serviceInfo);
+		static std::string GetInstanceName(const std::string& serviceName, const std::string& serviceType);
+		static void SetAddresses(ServiceInfo& serviceInfo, const std::vector<std::string>& addresses);
+		static EventRecord SerializeServiceInfo(const ServiceInfo& serviceInfo);
+		static std::unique_ptr<DiscoveryBatch> CreateDiscoveryBatch(const flutter::EncodableMap& arguments, DiscoveryContext& context);
+		static std::optional<flutter::EncodableValue> SerializeOperationMetrics(OperationMetrics& metrics, const bool reset); // nullopt if empty
+		static std::optional<flutter::EncodableValue> SerializeCallbackMetrics(CallbackMetrics& metrics, const bool reset);
+		static std::optional<flutter::EncodableMap> SerializeStatuses(const StatusCounter::Summary& summary); // nullopt if nothing was counted
+		static flutter::EncodableValue SerializeLatency(const LatencyHistogram::Summary& summary);
 
+		flutter::PluginRegistrarWindows* registrar;
 		std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel;
-		std::map<std::string, std::unique_ptr<DiscoveryContext>> discoveryContextMap;
-		std::map<std::string, std::unique_ptr<RegisterContext>> registerContextMap;
-		std::map<std::string, std::unique_ptr<ResolveContext>> resolveContextMap;
+		EventPort eventPort; // replaces the method channel for events if enabled, see SendEvent()
+
+		HWND window; // top level window, receives the drain message
+		UINT drainMessage;
+		int windowProcDelegateId;
+		MpscQueue<DnsCallbackResult> callbackQueue;
+		std::atomic<bool> drainScheduled{ false };
+		std::atomic<std::chrono::steady_clock::rep> drainPostedAt{ 0 }; // see PluginMetrics::drainDelay
+		PluginMetrics metrics; // recorded from any thread
+		TraceRecorder tracer; // recorded from any thread, see SetTracing()
+
+		// contexts are addressed by slab handle internally; client handles are mapped once, when a method call comes in
+		Slab<DiscoveryContext> discoveryContexts;
+		Slab<RegisterContext> registerContexts;
+		Slab<ResolveContext> resolveContexts; // including retired ones
+		std::unordered_map<std::string, SlabHandle> discoveryHandles;
+		std::vector<std::unique_ptr<DiscoveryStream>> retiredStreams; // of cancelled discoveries, released with the next drain
+		std::unordered_map<std::string, SlabHandle> registerHandles;
+		std::unordered_map<std::string, SlabHandle> resolveHandles; // waiter handle -> resolve
+		std::unordered_map<std::string, SlabHandle> resolveKeys; // lower case instance name -> resolve, retired ones excluded
+		std::map<std::string, std::unique_ptr<RegistrationBatchContext>> registrationBatchMap;
+		std::map<const BrowseContext*, std::unique_ptr<BrowseContext>> retiredBrowseContextMap; // cancelled, waiting for their final callback
+		ResolveCache<ServiceInfo> resolveCache;
+		ResolveScheduler::WaiterId nextResolveWaiterId = 1;
+		ResolveScheduler resolveScheduler{ *this, kMaxRunningResolves };
+		PTP_TIMER resolveDeadlineTimer = nullptr;
 
 		bool systemRequirementsSatisfied;
+		std::optional<std::wstring> computerName; // looked up once, see GetCachedComputerName()
+		bool useBuiltInMdns; // for browses, resolves and registrations started from now on, see SetBackend()
+		std::unique_ptr<MdnsTransport> mdnsTransport; // shared by querier and responder
+		std::unique_ptr<MdnsQuerier> mdnsQuerier; // created on first use
+		std::unique_ptr<MdnsResponder> mdnsResponder; // created on first use
+		std::map<uint64_t, BrowseContext*> mdnsBrowses; // by querier browse id
+		std::map<uint64_t, SlabHandle> mdnsResolves; // querier resolve id -> resolve
+		PTP_TIMER mdnsTimer = nullptr;
 
 		void HandleMethodCall(
 			const flutter::MethodCall<flutter::EncodableValue>& method_call,
@@ -92,10 +341,80 @@ namespace nsd_windows {
 
 		void StartDiscovery(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
 		void StopDiscovery(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void StartBrowse(DiscoveryContext& context, const std::string& serviceType, const bool enumeratesTypes);
+		DWORD CancelBrowses(DiscoveryContext& context);
 		void Resolve(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void CancelResolve(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
 		void Register(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
 		void Unregister(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void RegisterMany(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void UnregisterMany(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void SetBackend(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void SetEventPort(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void GetServiceChanges(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void GetMetrics(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void SetTracing(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+		void DumpTrace(const flutter::EncodableMap& arguments, std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>& result);
+
+		std::optional<LRESULT> HandleWindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+		void DrainCallbackQueue();
+		void ScheduleDrain(); // unless a drain is pending already
+		void Dispatch(DnsCallbackResult& result);
+
+		void OnServiceDiscovered(const SlabHandle id, const ServiceInfo& serviceInfo);
+		void OnBrowseCancelled(const SlabHandle id, const void* browse);
+		void OnServiceTypeDiscovered(const SlabHandle id, const ServiceInfo& serviceInfo);
+		void UpdateServiceTypeInstances(DiscoveryContext& context, const ServiceInfo& serviceInfo);
+		void NotifyServiceTypeChanged(DiscoveryContext& context, const std::string& serviceType);
+		void OnServiceResolved(const SlabHandle id, const DWORD status, const std::optional<ServiceInfo>& serviceInfo);
+		void OnDiscoveredServiceResolved(const SlabHandle discovery, const ServiceInfo& discovered, const std::optional<ServiceInfo>& resolved);
+		void OnServiceRegistered(const SlabHandle id, const DWORD status, const std::optional<ServiceInfo>& serviceInfo, PDNS_SERVICE_INSTANCE pInstance);
+		void OnServiceUnregistered(const SlabHandle id, const DWORD status);
+		void SendEvent(const std::string& method, EventRecord arguments); // port or method channel
+		void SendDiscoveryEvent(DiscoveryContext& context, const std::string& method, EventRecord arguments); // or its stream
+		void OnDiscoveryListen(const SlabHandle id, std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> sink);
+		void OnDiscoveryCancel(const SlabHandle id);
+		DWORD RemoveDiscoveryContext(DiscoveryContext& context); // stops the discovery, see StopDiscovery()
+		void NotifyRegistrationChanged(const std::string& batchHandle, const std::string& method, EventRecord arguments);
+		void OnDiscoveryBatchDue(const SlabHandle id);
+		void OnAddressesQueried(const SlabHandle id, const DWORD status, const std::optional<ServiceInfo>& serviceInfo, const void* addressQuery);
+		void OnResolveDeadlineDue();
+
+		void StartServiceResolve(const std::string& serviceName, const std::string& serviceType, ResolveWaiter waiter, const ResolvePriority priority, const std::chrono::milliseconds timeout);
+		void ExecuteResolve(const std::string& key) override;
+		void AbortResolve(const std::string& key) override;
+		void RemoveResolveContext(ResolveContext& context); // once it has no waiters left
+		void ReleaseResolveWaiters(const std::vector<ResolveWaiter>& waiters); // forgets their client handles
+		void OnRetiredResolveCallback(ResolveContext& context, const void* addressQuery);
+		void ArmResolveDeadlineTimer();
+		void AutoResolve(DiscoveryContext& context, const ServiceInfo& serviceInfo);
+		void CancelAutoResolve(DiscoveryContext& context, const ServiceInfo& serviceInfo);
+		void CancelResolveWaiters(ResolveContext& context, const std::function<bool(const ResolveWaiter&)>& matches);
+		void RefreshCachedResolve(const std::string& serviceName, const std::string& serviceType);
+		void StartAddressQueries(ResolveContext& context);
+		void CompleteResolve(ResolveContext& context, const DWORD status);
+		void NotifyResolveWaiter(const ResolveWaiter& waiter, const DWORD status, const std::optional<ServiceInfo>& resolved);
+
+		void StartRegistration(const flutter::EncodableMap& arguments, const std::string& batchHandle);
+		void StartRegistrationWithResponder(const flutter::EncodableMap& arguments, const std::string& batchHandle);
+		void StartUnregistration(const std::string& handle, const std::string& batchHandle);
+		void RemoveRegisterContext(RegisterContext& context);
+		void ContinueRegistrationBatch(const std::string& batchHandle);
+		const std::wstring& GetCachedComputerName();
+
+		MdnsTransport& GetMdnsTransport();
+		MdnsQuerier& GetMdnsQuerier();
+		MdnsResponder& GetMdnsResponder();
+		void StartMdnsBrowse(DiscoveryContext& context, const std::string& serviceType, const bool enumeratesTypes);
+		void ArmMdnsTimer();
+		void OnBrowseResult(const uint64_t browseId, const std::string& instanceName, const bool found) override;
+		void OnResolveResult(const uint64_t resolveId, const MdnsServiceInstance& instance) override;
+
+		void NotifyServiceChanged(DiscoveryContext& context, const ServiceInfo& serviceInfo);
+		void FlushDiscoveryBatch(DiscoveryContext& context);
 
+		void RecordOperation(const PluginMetrics::Operation operation, const DWORD status, const std::chrono::steady_clock::time_point started);
+		void RecordFirstResult(DiscoveryContext& context);
 	};
 
 }  // namespace nsd_windows
@@ -10,6 +10,8 @@
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 
+#include "nsd_codec.h"
+
 #include <memory>
 #include <sstream>
 
@@ -17,12 +19,12 @@ namespace nsd_windows {
 
 	void NsdWindowsPlugin::RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar) {
 		auto methodChannel = std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
-			registrar->messenger(), "com.haberey/nsd", &flutter::StandardMethodCodec::GetInstance());
-		auto nsdWindows = std::make_unique<NsdWindowsPlugin>(std::move(methodChannel));
+			registrar->messenger(), "com.haberey/nsd", &flutter::StandardMethodCodec::GetInstance(&NsdCodecSerializer::GetInstance()));
+		auto nsdWindows = std::make_unique<NsdWindowsPlugin>(registrar, std::move(methodChannel));
 		registrar->AddPlugin(std::move(nsdWindows));
 	}
 
-	NsdWindowsPlugin::NsdWindowsPlugin(std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel) : nsdWindows(std::move(methodChannel)) {}
+	NsdWindowsPlugin::NsdWindowsPlugin(flutter::PluginRegistrarWindows* registrar, std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel) : nsdWindows(registrar, std::move(methodChannel)) {}
 
 	NsdWindowsPlugin::~NsdWindowsPlugin() {};
 
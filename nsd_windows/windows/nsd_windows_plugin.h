@@ -14,7 +14,7 @@ namespace nsd_windows {
 	public:
 		static void RegisterWithRegistrar(flutter::PluginRegistrarWindows* registrar);
 
-		NsdWindowsPlugin(std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel);
+		NsdWindowsPlugin(flutter::PluginRegistrarWindows* registrar, std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> methodChannel);
 		virtual ~NsdWindowsPlugin();
 
 		// Disallow copy and assign.
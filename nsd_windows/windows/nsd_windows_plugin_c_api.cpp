@@ -2,6 +2,7 @@
 
 #include <flutter/plugin_registrar_windows.h>
 
+#include "event_port.h"
 #include "nsd_windows_plugin.h"
 
 void NsdWindowsPluginCApiRegisterWithRegistrar(
@@ -10,3 +11,7 @@ void NsdWindowsPluginCApiRegisterWithRegistrar(
       flutter::PluginRegistrarManager::GetInstance()
           ->GetRegistrar<flutter::PluginRegistrarWindows>(registrar));
 }
+
+intptr_t NsdWindowsPluginCApiInitializeDartApi(void* data) {
+  return nsd_windows::EventPort::InitializeDartApi(data) ? 0 : -1;
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "nsd_error.h"
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// registerMany / unregisterMany bookkeeping: a few items run at a time, the others wait in request order; the
+	// results are handed out together once all items are complete
+	//
+	// items are identified by their service handle, so a handle may only appear once per batch
+	template<typename Item, typename Result>
+	class RegistrationBatch {
+	public:
+
+		explicit RegistrationBatch(const size_t maxRunning) : maxRunning(maxRunning) {}
+
+		// throws NsdError if the handle is already part of the batch, results are kept by handle
+		void Add(std::string handle, Item item) {
+			if (!indices.emplace(handle, entries.size()).second) {
+				throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Duplicate handle: " + handle);
+			}
+			entries.push_back({ std::move(handle), std::move(item), std::nullopt });
+		}
+
+		// the next queued item if fewer than maxRunning are running; it is running until completed, even if it
+		// fails to start
+		std::optional<std::pair<std::string, Item>> StartNext() {
+			if (running >= maxRunning || started >= entries.size()) {
+				return std::nullopt;
+			}
+
+			auto& entry = entries[started++];
+			running++;
+			return std::make_pair(entry.handle, std::move(entry.item));
+		}
+
+		// false if the item isn't running, e.g. unknown or completed already
+		bool Complete(const std::string& handle, Result result) {
+			auto it = indices.find(handle);
+			if (it == indices.end() || it->second >= started) {
+				return false;
+			}
+
+			auto& entry = entries[it->second];
+			if (entry.result.has_value()) {
+				return false;
+			}
+
+			entry.result = std::move(result);
+			running--;
+			completed++;
+			return true;
+		}
+
+		bool IsComplete() const {
+			return completed == entries.size();
+		}
+
+		// in request order; only valid once the batch is complete
+		std::vector<Result> TakeResults() {
+			std::vector<Result> results;
+			results.reserve(entries.size());
+			for (auto& entry : entries) {
+				results.push_back(std::move(entry.result.value()));
+			}
+			return results;
+		}
+
+		size_t GetRunningCount() const {
+			return running;
+		}
+
+		size_t GetQueuedCount() const {
+			return entries.size() - started;
+		}
+
+	private:
+
+		struct Entry {
+			std::string handle;
+			Item item; // moved out once started
+			std::optional<Result> result;
+		};
+
+		size_t maxRunning;
+		std::vector<Entry> entries; // in request order
+		std::unordered_map<std::string, size_t> indices; // handle -> index into entries
+		size_t started = 0; // entries before this index have been started
+		size_t running = 0;
+		size_t completed = 0;
+	};
+}
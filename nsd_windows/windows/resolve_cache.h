@@ -0,0 +1,122 @@
+#pragma once
+
+#include "service_table.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+namespace nsd_windows {
+
+	struct ResolveCacheStatistics {
+
+		uint64_t hits = 0; // answered from a fresh entry
+		uint64_t staleHits = 0; // answered from an expired entry that is being refreshed
+		uint64_t misses = 0;
+	};
+
+	// resolve results keyed by full instance name (compared case-insensitively), valid for the record TTL;
+	// expired entries are still served for maxStale so the caller can refresh them in the background
+	template<typename V>
+	class ResolveCache {
+	public:
+
+		using TimePoint = std::chrono::steady_clock::time_point;
+		using Clock = std::function<TimePoint()>;
+
+		struct Result {
+			V value;
+			bool stale; // caller should refresh the entry
+		};
+
+		explicit ResolveCache(const std::chrono::seconds maxStale = std::chrono::seconds(60), Clock clock = &std::chrono::steady_clock::now)
+			: maxStale(maxStale), clock(std::move(clock)) {}
+
+		// entries the caller can't use (see usable) are kept, but count as misses
+		std::optional<Result> Get(const std::string_view key, const std::function<bool(const V&)>& usable = nullptr) {
+
+			auto it = items.find(ToLowerDnsName(key));
+			if (it == items.end() || (usable && !usable(it->second.value))) {
+				statistics.misses++;
+				return std::nullopt;
+			}
+
+			const auto now = clock();
+
+			if (now < it->second.expiry) {
+				statistics.hits++;
+				return Result{ it->second.value, false };
+			}
+
+			if (now < it->second.expiry + maxStale) {
+				statistics.staleHits++;
+				return Result{ it->second.value, true };
+			}
+
+			items.erase(it);
+			statistics.misses++;
+			return std::nullopt;
+		}
+
+		// a TTL of zero announces that the record is gone (see https://datatracker.ietf.org/doc/html/rfc6762#section-10.1)
+		void Put(const std::string_view key, V value, const std::chrono::seconds ttl) {
+
+			if (ttl.count() <= 0) {
+				Erase(key);
+				return;
+			}
+
+			items.insert_or_assign(ToLowerDnsName(key), Item{ std::move(value), clock() + ttl });
+
+			// sweep once insertions outnumber half the entries, keeps insertion amortized O(1) and also
+			// triggers while the table only grows
+			if (++insertionsSinceSweep > items.size() / 2) {
+				Sweep();
+			}
+		}
+
+		bool Erase(const std::string_view key) {
+			return items.erase(ToLowerDnsName(key)) > 0;
+		}
+
+		size_t Size() const {
+			return items.size();
+		}
+
+		ResolveCacheStatistics GetStatistics(const bool reset = false) {
+			auto current = statistics;
+			if (reset) {
+				statistics = ResolveCacheStatistics();
+			}
+			return current;
+		}
+
+	private:
+
+		struct Item {
+			V value;
+			TimePoint expiry;
+		};
+
+		void Sweep() {
+			insertionsSinceSweep = 0;
+
+			const auto now = clock();
+			for (auto it = items.begin(); it != items.end();) {
+				it = (now < it->second.expiry + maxStale) ? std::next(it) : items.erase(it);
+			}
+		}
+
+		const std::chrono::seconds maxStale;
+		const Clock clock;
+
+		std::unordered_map<std::string, Item> items;
+		size_t insertionsSinceSweep = 0;
+		ResolveCacheStatistics statistics;
+	};
+}
@@ -0,0 +1,150 @@
+#include "resolve_scheduler.h"
+
+#include <utility>
+
+namespace nsd_windows {
+
+	ResolveScheduler::ResolveScheduler(ResolveExecutor& executor, const size_t maxRunning, Clock clock)
+		: executor(executor), maxRunning(maxRunning), clock(std::move(clock)) {}
+
+	void ResolveScheduler::Submit(const std::string& key, const WaiterId waiter, const ResolvePriority priority, const std::chrono::milliseconds timeout)
+	{
+		const auto deadline = clock() + timeout;
+		const QueueKey queueKey{ -static_cast<int>(priority), sequence++ };
+
+		deadlines.emplace(deadline, key, waiter);
+
+		auto it = entries.find(key);
+		if (it == entries.end()) {
+			entries[key] = { queueKey, { { waiter, deadline } } };
+			queue[queueKey] = key;
+			StartQueued();
+			return;
+		}
+
+		auto& entry = it->second;
+		entry.waiters[waiter] = deadline;
+
+		if (!entry.running && std::get<0>(queueKey) < std::get<0>(entry.queueKey)) {
+			queue.erase(entry.queueKey);
+			entry.queueKey = queueKey;
+			queue[queueKey] = key;
+		}
+	}
+
+	void ResolveScheduler::Complete(const std::string& key)
+	{
+		Remove(key);
+		StartQueued();
+	}
+
+	bool ResolveScheduler::Cancel(const std::string& key, const WaiterId waiter)
+	{
+		const auto removed = RemoveWaiter(key, waiter);
+		StartQueued();
+		return removed;
+	}
+
+	std::vector<std::pair<std::string, ResolveScheduler::WaiterId>> ResolveScheduler::ExpireDeadlines()
+	{
+		std::vector<std::pair<std::string, WaiterId>> expired;
+		const auto now = clock();
+
+		while (!deadlines.empty() && std::get<0>(*deadlines.begin()) <= now) {
+
+			auto [deadline, key, waiter] = *deadlines.begin();
+
+			RemoveWaiter(key, waiter);
+			expired.emplace_back(std::move(key), waiter);
+		}
+
+		StartQueued();
+		return expired;
+	}
+
+	std::optional<ResolveScheduler::TimePoint> ResolveScheduler::GetNextDeadline() const
+	{
+		if (deadlines.empty()) {
+			return std::nullopt;
+		}
+		return std::get<0>(*deadlines.begin());
+	}
+
+	bool ResolveScheduler::IsRunning(const std::string& key) const
+	{
+		auto it = entries.find(key);
+		return it != entries.end() && it->second.running;
+	}
+
+	size_t ResolveScheduler::GetRunningCount() const
+	{
+		return running;
+	}
+
+	size_t ResolveScheduler::GetQueuedCount() const
+	{
+		return queue.size();
+	}
+
+	void ResolveScheduler::Remove(const std::string& key)
+	{
+		auto it = entries.find(key);
+		if (it == entries.end()) {
+			return;
+		}
+
+		auto& entry = it->second;
+
+		if (entry.running) {
+			running--;
+		}
+		else {
+			queue.erase(entry.queueKey);
+		}
+
+		for (const auto& [waiter, deadline] : entry.waiters) {
+			deadlines.erase({ deadline, key, waiter });
+		}
+		entries.erase(it);
+	}
+
+	bool ResolveScheduler::RemoveWaiter(const std::string& key, const WaiterId waiter)
+	{
+		auto it = entries.find(key);
+		if (it == entries.end()) {
+			return true;
+		}
+
+		auto& waiters = it->second.waiters;
+		auto waiterIt = waiters.find(waiter);
+		if (waiterIt != waiters.end()) {
+			deadlines.erase({ waiterIt->second, key, waiter });
+			waiters.erase(waiterIt);
+		}
+
+		if (!waiters.empty()) {
+			return false;
+		}
+
+		if (it->second.running) {
+			executor.AbortResolve(key);
+		}
+
+		Remove(key);
+		return true;
+	}
+
+	void ResolveScheduler::StartQueued()
+	{
+		while (running < maxRunning && !queue.empty()) {
+
+			auto key = queue.begin()->second;
+			queue.erase(queue.begin());
+
+			entries[key].running = true;
+			running++;
+
+			executor.ExecuteResolve(key);
+		}
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// starts and cancels the actual resolves on behalf of the scheduler
+	class ResolveExecutor {
+	public:
+
+		virtual ~ResolveExecutor() = default;
+
+		// must not call back into the scheduler; failures are reported later via ResolveScheduler::Complete()
+		virtual void ExecuteResolve(const std::string& key) = 0;
+		virtual void AbortResolve(const std::string& key) = 0;
+	};
+
+	enum class ResolvePriority {
+		LOW, // background work, e.g. auto resolve and cache refresh
+		NORMAL, // requested by the client
+	};
+
+	// limits the number of resolves running at once, queues the rest by priority (FIFO within a priority)
+	// and enforces deadlines; independent of the DNS API, so it can run against a fake executor
+	//
+	// several waiters may share the resolve of a key, each with its own deadline; the resolve is cancelled
+	// once the last of them is gone
+	class ResolveScheduler {
+	public:
+
+		using TimePoint = std::chrono::steady_clock::time_point;
+		using Clock = std::function<TimePoint()>;
+		using WaiterId = uint64_t; // unique per key, chosen by the caller
+
+		ResolveScheduler(ResolveExecutor& executor, const size_t maxRunning, Clock clock = &std::chrono::steady_clock::now);
+
+		ResolveScheduler(const ResolveScheduler&) = delete; // disallow copy
+		ResolveScheduler& operator=(const ResolveScheduler&) = delete; // disallow assign
+
+		// adds a waiter to the key, scheduling it if it isn't known yet; a queued key takes the higher priority
+		void Submit(const std::string& key, const WaiterId waiter, const ResolvePriority priority, const std::chrono::milliseconds timeout);
+
+		// the resolve has finished (successfully or not), frees its slot along with all waiters
+		void Complete(const std::string& key);
+
+		// removes the waiter; along with the last one, a queued key is removed and a running one cancelled
+		// returns true if the key is gone
+		bool Cancel(const std::string& key, const WaiterId waiter);
+
+		// removes the waiters past their deadline like Cancel() and returns them, the earliest first
+		std::vector<std::pair<std::string, WaiterId>> ExpireDeadlines();
+
+		std::optional<TimePoint> GetNextDeadline() const;
+
+		bool IsRunning(const std::string& key) const;
+		size_t GetRunningCount() const;
+		size_t GetQueuedCount() const;
+
+	private:
+
+		// ordered by priority (descending), then submission order
+		using QueueKey = std::tuple<int, uint64_t>;
+
+		struct Entry {
+			QueueKey queueKey;
+			std::map<WaiterId, TimePoint> waiters; // and their deadlines
+			bool running = false;
+		};
+
+		void Remove(const std::string& key);
+		bool RemoveWaiter(const std::string& key, const WaiterId waiter); // returns true if the key is gone
+		void StartQueued();
+
+		ResolveExecutor& executor;
+		const size_t maxRunning;
+		const Clock clock;
+
+		std::map<std::string, Entry> entries;
+		std::map<QueueKey, std::string> queue;
+		std::set<std::tuple<TimePoint, std::string, WaiterId>> deadlines;
+		size_t running = 0;
+		uint64_t sequence = 0;
+	};
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "address_resolution.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// parties waiting for the result of one pending resolve: concurrent resolves of the same instance attach to
+	// the resolve that is already running instead of sending the same query again; W needs an ipLookupType member
+	template<typename W>
+	class ResolveWaiters {
+	public:
+
+		// returns true for the first waiter, the resolve has to be started then
+		bool Attach(W waiter) {
+			ipLookupType = CombineIpLookupTypes(ipLookupType, waiter.ipLookupType);
+			waiters.push_back(std::move(waiter));
+			return waiters.size() == 1;
+		}
+
+		// all waiters in the order they attached, to hand them the result
+		std::vector<W> DetachAll() {
+			ipLookupType = IpLookupType::NONE;
+			return std::exchange(waiters, std::vector<W>());
+		}
+
+		// the matching waiters, e.g. cancelled or timed out ones; the others keep waiting
+		template<typename P>
+		std::vector<W> Detach(const P& matches) {
+			std::vector<W> detached;
+			std::vector<W> remaining;
+			for (auto& waiter : waiters) {
+				(matches(waiter) ? detached : remaining).push_back(std::move(waiter));
+			}
+			waiters = std::move(remaining);
+
+			ipLookupType = IpLookupType::NONE;
+			for (const auto& waiter : waiters) {
+				ipLookupType = CombineIpLookupTypes(ipLookupType, waiter.ipLookupType);
+			}
+			return detached;
+		}
+
+		template<typename P>
+		bool Contains(const P& matches) const {
+			return std::any_of(waiters.begin(), waiters.end(), matches);
+		}
+
+		// covers the lookup types of all waiters, each one only gets the addresses it asked for (see FilterAddresses())
+		IpLookupType GetIpLookupType() const {
+			return ipLookupType;
+		}
+
+		bool Empty() const {
+			return waiters.empty();
+		}
+
+		size_t Size() const {
+			return waiters.size();
+		}
+
+	private:
+
+		std::vector<W> waiters;
+		IpLookupType ipLookupType = IpLookupType::NONE;
+	};
+}
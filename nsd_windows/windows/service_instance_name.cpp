@@ -0,0 +1,100 @@
+#include "service_instance_name.h"
+
+#include <array>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr size_t kMaxLabels = 128; // a name has at most 255 bytes on the wire, see https://datatracker.ietf.org/doc/html/rfc1035#section-2.3.4
+
+		bool EqualsIgnoreCase(const std::string_view label, const std::string_view lowerCase) {
+			if (label.size() != lowerCase.size()) {
+				return false;
+			}
+			for (size_t i = 0; i < label.size(); i++) {
+				const auto c = label[i];
+				if (((c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c) != lowerCase[i]) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool IsProtocolLabel(const std::string_view label) {
+			return EqualsIgnoreCase(label, "_tcp") || EqualsIgnoreCase(label, "_udp");
+		}
+
+		// from the start of the first to the end of the last label
+		std::string_view GetSpan(const std::string_view first, const std::string_view last) {
+			return std::string_view(first.data(), last.data() + last.size() - first.data());
+		}
+	}
+
+	std::string_view ServiceInstanceName::GetType() const
+	{
+		return GetSpan(service, protocol);
+	}
+
+	std::optional<ServiceInstanceName> ParseServiceInstanceName(const std::string_view name)
+	{
+		std::array<std::string_view, kMaxLabels> labels;
+		size_t count = 0;
+		size_t start = 0;
+
+		for (size_t i = 0; i <= name.size(); i++) {
+
+			if (i < name.size() && name[i] == '\\' && i + 1 < name.size()) {
+				i++; // escaped character; the digits of "\DDD" need no special treatment, they can't be dots
+				continue;
+			}
+
+			if (i < name.size() && name[i] != '.') {
+				continue;
+			}
+
+			const auto label = name.substr(start, i - start);
+			start = i + 1;
+
+			if (label.empty()) {
+				if (i == name.size() && count > 0) {
+					break; // a trailing dot denotes the root
+				}
+				return std::nullopt;
+			}
+
+			if (count == kMaxLabels) {
+				return std::nullopt;
+			}
+			labels[count++] = label;
+		}
+
+		// searched from the right: the instance label may contain anything, the domain doesn't contain a protocol label
+		for (size_t p = count; p-- > 1;) {
+
+			if (!IsProtocolLabel(labels[p]) || labels[p - 1].size() < 2 || labels[p - 1][0] != '_') {
+				continue;
+			}
+
+			ServiceInstanceName result;
+			result.service = labels[p - 1];
+			result.protocol = labels[p];
+
+			if (p + 1 < count) {
+				result.domain = GetSpan(labels[p + 1], labels[count - 1]);
+			}
+
+			const auto prefix = p - 1; // labels in front of the service
+
+			if (prefix == 2 && EqualsIgnoreCase(labels[1], "_sub")) {
+				result.subtype = labels[0];
+			}
+			else if (prefix > 0) {
+				result.instance = GetSpan(labels[0], labels[prefix - 1]);
+			}
+			return result;
+		}
+
+		return std::nullopt;
+	}
+}
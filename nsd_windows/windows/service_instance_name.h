@@ -0,0 +1,28 @@
+#pragma once
+
+#include <optional>
+#include <string_view>
+
+namespace nsd_windows {
+
+	// a DNS-SD name split into its parts, see https://datatracker.ietf.org/doc/html/rfc6763#section-4.1:
+	// an instance ("My\.Printer._ipp._tcp.local"), a service type ("_ipp._tcp.local") or a subtype
+	// ("_color._sub._ipp._tcp.local", see section 7.1); the parts are views into the parsed name,
+	// in presentation format, so they may still contain escapes (see UnescapeDnsLabel())
+	struct ServiceInstanceName {
+
+		std::string_view instance; // empty for service types and subtypes
+		std::string_view subtype; // e.g. "_color", empty if none
+		std::string_view service; // e.g. "_ipp"
+		std::string_view protocol; // "_tcp" or "_udp"
+		std::string_view domain; // e.g. "local", without a trailing dot; may be empty
+
+		// e.g. "_ipp._tcp"
+		std::string_view GetType() const;
+	};
+
+	// returns nullopt if there is no "_<service>._tcp" or "_<service>._udp" pair of labels or if a label is empty;
+	// several labels in front of the service are taken as one instance, as the Windows DNS API doesn't
+	// escape dots in instance names
+	std::optional<ServiceInstanceName> ParseServiceInstanceName(const std::string_view name);
+}
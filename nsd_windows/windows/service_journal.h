@@ -0,0 +1,146 @@
+#pragma once
+
+#include "service_table.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// the services a discovery has reported, keyed by full instance name (compared case-insensitively), so the
+	// dart side can resync without restarting browses; every change gets the next version, lost services are
+	// kept as tombstones for deltas until there are more than maxTombstones, then the oldest one is dropped
+	// and deltas since versions before it are no longer complete, a snapshot from version 0 is required then
+	template<typename V>
+	class ServiceJournal {
+	public:
+
+		struct Change {
+			const V* value;
+			bool present; // false for tombstones
+		};
+
+		struct Page {
+			std::vector<Change> changes; // in version order
+			uint64_t next; // version of the last change looked at, to continue from
+			bool more;
+			bool snapshotRequired; // the version is before the horizon, no changes then
+		};
+
+		explicit ServiceJournal(const size_t maxTombstones = 1024) : maxTombstones(maxTombstones) {}
+
+		ServiceJournal(const ServiceJournal&) = delete; // the version index points into the entries
+		ServiceJournal& operator=(const ServiceJournal&) = delete;
+
+		void Put(const std::string_view key, V value) {
+			Record(key, std::move(value), true);
+		}
+
+		void Remove(const std::string_view key, V value) {
+
+			auto it = entries.find(ToLowerDnsName(key));
+			if (it == entries.end() || !it->second.present) {
+				return; // never reported
+			}
+
+			Record(key, std::move(value), false);
+
+			while (tombstones.size() > maxTombstones) {
+				const auto oldest = *tombstones.begin();
+				auto node = versions.at(oldest);
+
+				horizon = oldest;
+				tombstones.erase(tombstones.begin());
+				versions.erase(oldest);
+				entries.erase(node->first);
+			}
+		}
+
+		uint64_t GetVersion() const {
+			return version;
+		}
+
+		// changes since this version or later are complete
+		uint64_t GetHorizon() const {
+			return horizon;
+		}
+
+		// changes after the given version in version order, at most limit; tombstones only if includeRemoved
+		Page GetChanges(const uint64_t since, const size_t limit, const bool includeRemoved) const {
+
+			Page page{ {}, since, false, false };
+
+			if (since > 0 && since < horizon) {
+				page.snapshotRequired = true; // tombstones after since may have been dropped
+				return page;
+			}
+
+			for (auto it = versions.upper_bound(since); it != versions.end(); it++) {
+
+				if (page.changes.size() >= limit) {
+					page.more = true;
+					break;
+				}
+
+				const auto& entry = it->second->second;
+				if (entry.present || includeRemoved) {
+					page.changes.push_back(Change{ &entry.value, entry.present });
+				}
+				page.next = it->first;
+			}
+
+			return page;
+		}
+
+		size_t Size() const {
+			return entries.size() - tombstones.size();
+		}
+
+	private:
+
+		struct Entry {
+			V value;
+			uint64_t version = 0;
+			bool present = false;
+		};
+
+		using Entries = std::unordered_map<std::string, Entry>;
+
+		void Record(const std::string_view key, V value, const bool present) {
+
+			auto [it, inserted] = entries.try_emplace(ToLowerDnsName(key));
+			auto& entry = it->second;
+
+			if (!inserted) {
+				versions.erase(entry.version);
+				if (!entry.present) {
+					tombstones.erase(entry.version);
+				}
+			}
+
+			entry.value = std::move(value);
+			entry.version = ++version;
+			entry.present = present;
+
+			versions.emplace(entry.version, &*it); // nodes of unordered maps stay put on rehash
+			if (!present) {
+				tombstones.insert(entry.version);
+			}
+		}
+
+		const size_t maxTombstones;
+
+		Entries entries;
+		std::map<uint64_t, typename Entries::value_type*> versions; // latest change of each entry
+		std::set<uint64_t> tombstones; // versions
+		uint64_t version = 0;
+		uint64_t horizon = 0;
+	};
+}
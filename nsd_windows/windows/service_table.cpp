@@ -0,0 +1,167 @@
+#include "service_table.h"
+
+namespace nsd_windows {
+
+	namespace {
+
+		inline char ToLowerAscii(const char c) {
+			return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+		}
+	}
+
+	const std::string* StringPool::Intern(const std::string_view value)
+	{
+		// unordered_set nodes are never relocated, so the address of an element is stable
+		return &*strings.emplace(value).first;
+	}
+
+	size_t StringPool::Size() const
+	{
+		return strings.size();
+	}
+
+	uint64_t HashDnsName(const std::string_view name, uint64_t seed)
+	{
+		// FNV-1a over the lower case representation
+
+		auto hash = seed;
+		for (const char c : name) {
+			hash ^= static_cast<unsigned char>(ToLowerAscii(c));
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	bool EqualsDnsName(const std::string_view a, const std::string_view b)
+	{
+		if (a.size() != b.size()) {
+			return false;
+		}
+
+		for (size_t i = 0; i < a.size(); i++) {
+			if (ToLowerAscii(a[i]) != ToLowerAscii(b[i])) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string ToLowerDnsName(const std::string_view name)
+	{
+		std::string lower(name);
+		for (auto& c : lower) {
+			c = ToLowerAscii(c);
+		}
+		return lower;
+	}
+
+	ServiceTable::ServiceTable() : slots(kMinCapacity) {}
+
+	ServiceEntry* ServiceTable::Find(const std::string_view name, const std::string_view type)
+	{
+		auto& slot = slots[Locate(Hash(name, type), name, type)];
+		return (slot.hash != kEmpty) ? &slot.entry : nullptr;
+	}
+
+	std::pair<ServiceEntry*, bool> ServiceTable::Insert(const std::string_view name, const std::string_view type)
+	{
+		auto hash = Hash(name, type);
+		auto index = Locate(hash, name, type);
+
+		if (slots[index].hash != kEmpty) {
+			return { &slots[index].entry, false };
+		}
+
+		if ((size + 1) * 2 > slots.size()) { // keep load factor at or below 0.5
+			Grow();
+			index = Locate(hash, name, type);
+		}
+
+		auto& slot = slots[index];
+		slot.hash = hash;
+		slot.entry.name = std::string(name);
+		slot.entry.type = strings.Intern(type);
+		slot.entry.host = nullptr;
+		size++;
+
+		return { &slot.entry, true };
+	}
+
+	bool ServiceTable::Erase(const std::string_view name, const std::string_view type)
+	{
+		const auto mask = slots.size() - 1;
+		auto hole = Locate(Hash(name, type), name, type);
+
+		if (slots[hole].hash == kEmpty) {
+			return false;
+		}
+
+		// backward shift deletion: move following entries of the same probe sequence into the hole,
+		// so that lookups never need tombstones
+
+		for (auto current = (hole + 1) & mask; slots[current].hash != kEmpty; current = (current + 1) & mask) {
+			auto home = slots[current].hash & mask;
+			if (((current - home) & mask) >= ((current - hole) & mask)) {
+				slots[hole] = std::move(slots[current]);
+				hole = current;
+			}
+		}
+
+		slots[hole].hash = kEmpty;
+		slots[hole].entry = ServiceEntry();
+		size--;
+
+		return true;
+	}
+
+	const std::string* ServiceTable::Intern(const std::string_view value)
+	{
+		return strings.Intern(value);
+	}
+
+	size_t ServiceTable::Size() const
+	{
+		return size;
+	}
+
+	uint64_t ServiceTable::Hash(const std::string_view name, const std::string_view type)
+	{
+		auto hash = HashDnsName(type, HashDnsName(name) ^ 0x9e3779b97f4a7c15ULL);
+		return (hash == kEmpty) ? 1 : hash; // zero marks empty slots
+	}
+
+	size_t ServiceTable::Locate(const uint64_t hash, const std::string_view name, const std::string_view type) const
+	{
+		const auto mask = slots.size() - 1;
+
+		for (auto index = hash & mask;; index = (index + 1) & mask) {
+			const auto& slot = slots[index];
+			if (slot.hash == kEmpty) {
+				return index;
+			}
+			if (slot.hash == hash && EqualsDnsName(slot.entry.name, name) && EqualsDnsName(*slot.entry.type, type)) {
+				return index;
+			}
+		}
+	}
+
+	void ServiceTable::Grow()
+	{
+		std::vector<Slot> previous(slots.size() * 2);
+		previous.swap(slots);
+
+		const auto mask = slots.size() - 1;
+
+		for (auto& slot : previous) {
+			if (slot.hash == kEmpty) {
+				continue;
+			}
+
+			auto index = slot.hash & mask;
+			while (slots[index].hash != kEmpty) {
+				index = (index + 1) & mask;
+			}
+			slots[index] = std::move(slot);
+		}
+	}
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "network_interfaces.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// stores each distinct string once; returned pointers stay valid for the lifetime of the pool
+	class StringPool {
+	public:
+
+		const std::string* Intern(const std::string_view value);
+		size_t Size() const;
+
+	private:
+
+		std::unordered_set<std::string> strings;
+	};
+
+	// DNS names are compared case-insensitively for ASCII characters only (see https://datatracker.ietf.org/doc/html/rfc4343)
+	uint64_t HashDnsName(const std::string_view name, uint64_t seed = 14695981039346656037ULL);
+	bool EqualsDnsName(const std::string_view a, const std::string_view b);
+	std::string ToLowerDnsName(const std::string_view name);
+
+	struct ServiceEntry {
+
+		std::string name;
+		const std::string* type = nullptr; // interned
+		const std::string* host = nullptr; // interned, null until known
+		bool resolving = false; // auto resolve pending, not reported to the dart side yet
+		InterfaceSet interfaces; // the service has been found on
+	};
+
+	// flat open addressing hash table (linear probing, backward shift deletion) keyed by service name + type
+	class ServiceTable {
+	public:
+
+		ServiceTable();
+
+		ServiceTable(const ServiceTable&) = delete; // entries point into the string pool
+		ServiceTable& operator=(const ServiceTable&) = delete;
+
+		ServiceEntry* Find(const std::string_view name, const std::string_view type);
+
+		// returns the entry and true if it was inserted, false if it existed already
+		std::pair<ServiceEntry*, bool> Insert(const std::string_view name, const std::string_view type);
+
+		// returns true if the entry existed
+		bool Erase(const std::string_view name, const std::string_view type);
+
+		const std::string* Intern(const std::string_view value);
+
+		size_t Size() const;
+
+		template<typename F>
+		void ForEach(const F&& consumer) const {
+			for (const auto& slot : slots) {
+				if (slot.hash != kEmpty) {
+					consumer(slot.entry);
+				}
+			}
+		}
+
+	private:
+
+		static constexpr uint64_t kEmpty = 0;
+		static constexpr size_t kMinCapacity = 16;
+
+		struct Slot {
+			uint64_t hash = kEmpty;
+			ServiceEntry entry;
+		};
+
+		std::vector<Slot> slots;
+		size_t size = 0;
+		StringPool strings; // service types and host names, interned once per table
+
+		static uint64_t Hash(const std::string_view name, const std::string_view type);
+
+		size_t Locate(const uint64_t hash, const std::string_view name, const std::string_view type) const;
+		void Grow();
+	};
+}
@@ -0,0 +1,66 @@
+#include "service_type_counts.h"
+
+#include "service_table.h"
+
+namespace nsd_windows {
+
+	bool ServiceTypeCounts::Announce(const std::string& serviceType, const uint32_t interfaceIndex)
+	{
+		auto [it, inserted] = types.try_emplace(ToLowerDnsName(serviceType));
+		it->second.announced.Add(interfaceIndex); // known already if not inserted, e.g. from another host or interface
+		return inserted;
+	}
+
+	bool ServiceTypeCounts::Withdraw(const std::string& serviceType, const uint32_t interfaceIndex)
+	{
+		auto it = types.find(ToLowerDnsName(serviceType));
+		if (it == types.end()) {
+			return false;
+		}
+
+		if (!it->second.announced.Remove(interfaceIndex) || it->second.instances > 0) {
+			return false; // still announced on another interface, or instances are left
+		}
+
+		types.erase(it);
+		return true;
+	}
+
+	bool ServiceTypeCounts::AddInstance(const std::string& serviceType)
+	{
+		types[ToLowerDnsName(serviceType)].instances++;
+		return true;
+	}
+
+	bool ServiceTypeCounts::RemoveInstance(const std::string& serviceType)
+	{
+		auto it = types.find(ToLowerDnsName(serviceType));
+		if (it == types.end()) {
+			return false;
+		}
+
+		auto& state = it->second;
+		if (state.instances > 0) {
+			state.instances--;
+		}
+
+		if (state.instances == 0 && state.announced.Empty()) {
+			types.erase(it);
+		}
+		return true;
+	}
+
+	std::optional<size_t> ServiceTypeCounts::GetInstanceCount(const std::string& serviceType) const
+	{
+		auto it = types.find(ToLowerDnsName(serviceType));
+		if (it == types.end()) {
+			return std::nullopt;
+		}
+		return it->second.instances;
+	}
+
+	size_t ServiceTypeCounts::Size() const
+	{
+		return types.size();
+	}
+}
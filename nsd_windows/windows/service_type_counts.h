@@ -0,0 +1,45 @@
+#pragma once
+
+#include "network_interfaces.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+namespace nsd_windows {
+
+	// service types found by a type enumeration (see https://datatracker.ietf.org/doc/html/rfc6763#section-9) along
+	// with the number of instances found by the browse for each type; a type is listed as long as it is announced
+	// on some interface or instances are left, since a goodbye only says that one host stopped announcing it
+	//
+	// types are compared case-insensitively; the methods return true if the listing of the type has changed, so
+	// it needs to be reported
+	class ServiceTypeCounts {
+	public:
+
+		// the enumeration record is alive; true if the type is new, it has to be browsed then to count its instances
+		bool Announce(const std::string& serviceType, const uint32_t interfaceIndex = kAnyInterface);
+
+		// the enumeration record has gone away on the interface; true if the type is gone along with it
+		bool Withdraw(const std::string& serviceType, const uint32_t interfaceIndex = kAnyInterface);
+
+		bool AddInstance(const std::string& serviceType);
+		bool RemoveInstance(const std::string& serviceType);
+
+		// empty if the type isn't listed
+		std::optional<size_t> GetInstanceCount(const std::string& serviceType) const;
+
+		size_t Size() const;
+
+	private:
+
+		struct State {
+			InterfaceSet announced; // interfaces on which the PTR record under _services._dns-sd._udp is alive
+			size_t instances = 0;
+		};
+
+		std::map<std::string, State> types; // by lower case type, listed ones only
+	};
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "nsd_error.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// generational handle: slot index in the low 16 bits, slot generation in the high 16 bits;
+	// generations start at 1, so 0 is never issued
+	using SlabHandle = uint32_t;
+
+	constexpr SlabHandle kNoSlabHandle = 0;
+
+	// objects in fixed size chunks that are never moved or freed before the slab itself, so pointers
+	// to them can be handed to the DNS API; erased slots go to a free list and are reused without
+	// allocating, and their generation is bumped so handles to the previous occupant no longer match
+	template<typename T, size_t ChunkSize = 32>
+	class Slab {
+	public:
+
+		static constexpr size_t kMaxSize = 0x10000;
+
+		Slab() = default;
+
+		virtual ~Slab() {
+			Clear();
+		}
+
+		Slab(const Slab&) = delete; // disallow copy
+		Slab& operator=(const Slab&) = delete; // disallow assign
+
+		// throws NsdError if all slots are taken
+		template<typename... Args>
+		std::pair<SlabHandle, T*> Emplace(Args&&... args) {
+
+			if (freeSlots.empty()) {
+				Grow();
+			}
+
+			const auto index = freeSlots.back();
+			auto& slot = GetSlot(index);
+
+			auto object = new (slot.storage) T(std::forward<Args>(args)...); // on throw the slot simply stays free
+			freeSlots.pop_back();
+			slot.occupied = true;
+			size++;
+
+			return { (static_cast<SlabHandle>(slot.generation) << 16) | index, object };
+		}
+
+		// null if the handle is stale (its object has been erased) or was never issued
+		T* Get(const SlabHandle handle) const {
+
+			const auto index = handle & 0xFFFF;
+			if (index >= chunks.size() * ChunkSize) {
+				return nullptr;
+			}
+
+			auto& slot = GetSlot(index);
+			if (!slot.occupied || slot.generation != (handle >> 16)) {
+				return nullptr;
+			}
+			return std::launder(reinterpret_cast<T*>(slot.storage));
+		}
+
+		bool Erase(const SlabHandle handle) {
+
+			auto object = Get(handle);
+			if (object == nullptr) {
+				return false;
+			}
+
+			const auto index = handle & 0xFFFF;
+			auto& slot = GetSlot(index);
+
+			object->~T();
+			slot.occupied = false;
+			slot.generation = (slot.generation == 0xFFFF) ? 1 : slot.generation + 1;
+			freeSlots.push_back(index);
+			size--;
+			return true;
+		}
+
+		// f(handle, object); f must not emplace or erase
+		template<typename F>
+		void ForEach(F f) {
+			for (size_t index = 0; index < chunks.size() * ChunkSize; index++) {
+				auto& slot = GetSlot(index);
+				if (slot.occupied) {
+					f((static_cast<SlabHandle>(slot.generation) << 16) | static_cast<SlabHandle>(index), *std::launder(reinterpret_cast<T*>(slot.storage)));
+				}
+			}
+		}
+
+		void Clear() {
+			for (size_t index = 0; index < chunks.size() * ChunkSize; index++) {
+				auto& slot = GetSlot(index);
+				if (slot.occupied) {
+					Erase((static_cast<SlabHandle>(slot.generation) << 16) | static_cast<SlabHandle>(index));
+				}
+			}
+		}
+
+		size_t Size() const {
+			return size;
+		}
+
+		size_t Capacity() const {
+			return chunks.size() * ChunkSize;
+		}
+
+	private:
+
+		static_assert(kMaxSize % ChunkSize == 0, "chunk size must divide the maximum size");
+
+		struct Slot {
+
+			alignas(T) unsigned char storage[sizeof(T)];
+			uint16_t generation = 1;
+			bool occupied = false;
+		};
+
+		struct Chunk {
+
+			Slot slots[ChunkSize];
+		};
+
+		Slot& GetSlot(const size_t index) const {
+			return chunks[index / ChunkSize]->slots[index % ChunkSize];
+		}
+
+		void Grow() {
+
+			if (chunks.size() * ChunkSize >= kMaxSize) {
+				throw NsdError(ErrorCause::MAX_LIMIT, "Too many operations");
+			}
+
+			const auto first = static_cast<uint32_t>(chunks.size() * ChunkSize);
+			chunks.push_back(std::make_unique<Chunk>());
+
+			// lowest index on top, so slots are handed out in order
+			freeSlots.reserve(freeSlots.size() + ChunkSize);
+			for (auto index = first + ChunkSize; index > first; index--) {
+				freeSlots.push_back(index - 1);
+			}
+		}
+
+		std::vector<std::unique_ptr<Chunk>> chunks;
+		std::vector<uint32_t> freeSlots; // indexes, most recently freed last
+		size_t size = 0;
+	};
+}
@@ -0,0 +1,76 @@
+#include "address_resolution.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using Addresses = std::vector<std::string>;
+		using Families = std::vector<AddressFamily>;
+
+		// canned records as a resolve or an A / AAAA query returns them
+		const std::vector<AddressRecord> kRecords = {
+			{ "printer.local", AddressFamily::V6, "fe80::1" },
+			{ "other.local", AddressFamily::V4, "10.0.0.9" },
+			{ "Printer.Local", AddressFamily::V4, "192.168.1.23" },
+			{ "printer.local", AddressFamily::V4, "192.168.1.23" }, // duplicate
+			{ "printer.local", AddressFamily::V4, "10.0.0.23" },
+		};
+	}
+
+	TEST(AddressResolutionTest, ParsesDartLookupTypes)
+	{
+		EXPECT_EQ(ParseIpLookupType("none"), IpLookupType::NONE);
+		EXPECT_EQ(ParseIpLookupType("v4"), IpLookupType::V4);
+		EXPECT_EQ(ParseIpLookupType("v6"), IpLookupType::V6);
+		EXPECT_EQ(ParseIpLookupType("any"), IpLookupType::ANY);
+		EXPECT_FALSE(ParseIpLookupType("V4").has_value());
+		EXPECT_FALSE(ParseIpLookupType("").has_value());
+	}
+
+	TEST(AddressResolutionTest, CombinesLookupTypes)
+	{
+		EXPECT_EQ(CombineIpLookupTypes(IpLookupType::NONE, IpLookupType::NONE), IpLookupType::NONE);
+		EXPECT_EQ(CombineIpLookupTypes(IpLookupType::NONE, IpLookupType::V6), IpLookupType::V6);
+		EXPECT_EQ(CombineIpLookupTypes(IpLookupType::V4, IpLookupType::NONE), IpLookupType::V4);
+		EXPECT_EQ(CombineIpLookupTypes(IpLookupType::V4, IpLookupType::V4), IpLookupType::V4);
+		EXPECT_EQ(CombineIpLookupTypes(IpLookupType::V4, IpLookupType::V6), IpLookupType::ANY);
+		EXPECT_EQ(CombineIpLookupTypes(IpLookupType::V6, IpLookupType::ANY), IpLookupType::ANY);
+	}
+
+	TEST(AddressResolutionTest, ExtractsAddressesOfTheHost)
+	{
+		EXPECT_EQ(ExtractAddresses(kRecords, "PRINTER.local", IpLookupType::ANY), (Addresses{ "fe80::1", "192.168.1.23", "10.0.0.23" }));
+		EXPECT_EQ(ExtractAddresses(kRecords, "printer.local", IpLookupType::NONE), (Addresses{ "fe80::1", "192.168.1.23", "10.0.0.23" }));
+		EXPECT_EQ(ExtractAddresses(kRecords, "printer.local", IpLookupType::V4), (Addresses{ "192.168.1.23", "10.0.0.23" }));
+		EXPECT_EQ(ExtractAddresses(kRecords, "printer.local", IpLookupType::V6), (Addresses{ "fe80::1" }));
+		EXPECT_TRUE(ExtractAddresses(kRecords, "unknown.local", IpLookupType::ANY).empty());
+	}
+
+	TEST(AddressResolutionTest, FiltersAndMergesAddresses)
+	{
+		const Addresses addresses = { "192.168.1.23", "fe80::1", "::ffff:10.0.0.1" };
+
+		EXPECT_EQ(FilterAddresses(addresses, IpLookupType::V4), (Addresses{ "192.168.1.23" }));
+		EXPECT_EQ(FilterAddresses(addresses, IpLookupType::V6), (Addresses{ "fe80::1", "::ffff:10.0.0.1" }));
+		EXPECT_EQ(FilterAddresses(addresses, IpLookupType::ANY), addresses);
+
+		Addresses target = { "192.168.1.23" };
+		MergeAddresses(target, { "fe80::1", "192.168.1.23", "fe80::1" });
+		EXPECT_EQ(target, (Addresses{ "192.168.1.23", "fe80::1" }));
+	}
+
+	TEST(AddressResolutionTest, ReportsFamiliesToQuery)
+	{
+		EXPECT_EQ(GetMissingAddressFamilies({}, IpLookupType::NONE), Families{});
+		EXPECT_EQ(GetMissingAddressFamilies({}, IpLookupType::ANY), (Families{ AddressFamily::V4, AddressFamily::V6 }));
+		EXPECT_EQ(GetMissingAddressFamilies({ "fe80::1" }, IpLookupType::ANY), Families{}); // either family will do
+		EXPECT_EQ(GetMissingAddressFamilies({ "fe80::1" }, IpLookupType::V4), Families{ AddressFamily::V4 });
+		EXPECT_EQ(GetMissingAddressFamilies({ "fe80::1" }, IpLookupType::V6), Families{});
+		EXPECT_EQ(GetMissingAddressFamilies({ "10.0.0.1" }, IpLookupType::V6), Families{ AddressFamily::V6 });
+	}
+}
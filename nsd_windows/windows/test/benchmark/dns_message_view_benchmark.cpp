@@ -0,0 +1,51 @@
+#include "dns_message_view.h"
+#include "test_messages.h"
+
+#include <benchmark/benchmark.h>
+
+namespace nsd_windows {
+
+	namespace {
+
+		// what the querier does with a response: match the records against a name without copying them
+		void BM_DnsMessageViewParse(benchmark::State& state)
+		{
+			const auto packet = SerializeServiceResponse();
+
+			for (auto _ : state) {
+				const auto message = DnsMessageView::Parse(packet.data(), packet.size());
+				auto matches = 0;
+				for (const auto& record : message->GetAdditionals()) {
+					matches += record.name.Equals("My\\.Printer._ipp._tcp.local") ? 1 : 0;
+				}
+				benchmark::DoNotOptimize(matches);
+			}
+			state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * packet.size()));
+		}
+		BENCHMARK(BM_DnsMessageViewParse);
+
+		// the copying parser, for comparison
+		void BM_ParseDnsMessage(benchmark::State& state)
+		{
+			const auto packet = SerializeServiceResponse();
+
+			for (auto _ : state) {
+				auto message = ParseDnsMessage(packet.data(), packet.size());
+				benchmark::DoNotOptimize(message);
+			}
+			state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * packet.size()));
+		}
+		BENCHMARK(BM_ParseDnsMessage);
+
+		void BM_SerializeDnsMessage(benchmark::State& state)
+		{
+			const auto message = CreateServiceResponse("My\\.Printer", "_ipp._tcp.local", "printer-1.local");
+
+			for (auto _ : state) {
+				auto packet = SerializeDnsMessage(message);
+				benchmark::DoNotOptimize(packet);
+			}
+		}
+		BENCHMARK(BM_SerializeDnsMessage);
+	}
+}
@@ -0,0 +1,44 @@
+#include "fake_mdns_transport.h"
+#include "mdns_responder.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace nsd_windows {
+
+	namespace {
+
+		// registerMany with the built-in responder: registering the services and sending all their
+		// announcements, against a fake transport and clock
+		void BM_MdnsResponderRegisterMany(benchmark::State& state)
+		{
+			const auto count = static_cast<int>(state.range(0));
+
+			for (auto _ : state) {
+
+				FakeMdnsTransport transport;
+				std::chrono::steady_clock::time_point now;
+				MdnsResponder responder(transport, [&now]() { return now; }, 42);
+				responder.SetHost("desktop.local", { { 192, 168, 1, 10 } });
+
+				for (int i = 0; i < count; i++) {
+					MdnsServiceRegistration registration;
+					registration.name = "Service " + std::to_string(i);
+					registration.type = "_http._tcp";
+					registration.port = 8080;
+					responder.Register(registration);
+				}
+
+				for (auto due = responder.GetNextDue(); due.has_value(); due = responder.GetNextDue()) {
+					now = std::max(now, due.value());
+					responder.Poll();
+				}
+
+				benchmark::DoNotOptimize(transport.sent.size());
+			}
+			state.SetItemsProcessed(state.iterations() * count);
+		}
+		BENCHMARK(BM_MdnsResponderRegisterMany)->Arg(1)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+	}
+}
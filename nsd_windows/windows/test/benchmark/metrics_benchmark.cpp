@@ -0,0 +1,83 @@
+#include "metrics.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+
+namespace nsd_windows {
+
+	namespace {
+
+		OperationMetrics sharedMetrics; // contended by the threaded runs
+
+		void BM_LatencyHistogramRecord(benchmark::State& state)
+		{
+			uint64_t value = 0;
+			for (auto _ : state) {
+				sharedMetrics.latency.Record(value);
+				value = (value + 97) & 0xFFFFF;
+			}
+		}
+		BENCHMARK(BM_LatencyHistogramRecord)->ThreadRange(1, 4);
+
+		void BM_StatusCounterRecord(benchmark::State& state)
+		{
+			uint32_t status = 0;
+			for (auto _ : state) {
+				sharedMetrics.statuses.Record(status);
+				status = (status + 1) & 3;
+			}
+		}
+		BENCHMARK(BM_StatusCounterRecord)->ThreadRange(1, 4);
+
+		// an event as the plugin records it: its latency and its status; reported against the 50 ns budget
+		// rather than asserted, timing depends too much on the machine for a test
+		void BM_RecordEvent(benchmark::State& state)
+		{
+			int64_t micros = 0;
+			for (auto _ : state) {
+				sharedMetrics.latency.Record(std::chrono::microseconds(micros));
+				sharedMetrics.statuses.Record(0);
+				micros = (micros + 97) & 0xFFFFF;
+			}
+
+			// an inverted rate of iterations / 1e9 is the cpu time per iteration in ns, per thread like the time columns
+			state.counters["ns_per_event"] = benchmark::Counter(static_cast<double>(state.iterations()) * 1e-9,
+				benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+			state.counters["budget_ns"] = benchmark::Counter(50, benchmark::Counter::kAvgThreads);
+		}
+		BENCHMARK(BM_RecordEvent)->ThreadRange(1, 4);
+
+		// the clock read ending a span, for comparison; its cost depends on the clock source, e.g. a few ns
+		// with the TSC and far more on VMs falling back to a paravirtual clock
+		void BM_SteadyClockNow(benchmark::State& state)
+		{
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(std::chrono::steady_clock::now());
+			}
+		}
+		BENCHMARK(BM_SteadyClockNow);
+
+		void BM_RecordEventWithClock(benchmark::State& state)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			for (auto _ : state) {
+				sharedMetrics.latency.Record(std::chrono::steady_clock::now() - start);
+				sharedMetrics.statuses.Record(0);
+			}
+		}
+		BENCHMARK(BM_RecordEventWithClock);
+
+		void BM_LatencyHistogramSummarize(benchmark::State& state)
+		{
+			LatencyHistogram histogram;
+			for (uint64_t value = 0; value < 10000; value++) {
+				histogram.Record(value * 13);
+			}
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(histogram.Summarize(false));
+			}
+		}
+		BENCHMARK(BM_LatencyHistogramSummarize);
+	}
+}
@@ -0,0 +1,72 @@
+#include "nsd_codec.h"
+
+#include <flutter/standard_message_codec.h>
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		const std::vector<uint8_t> kTxt = { 9, 't', 'x', 't', 'v', 'e', 'r', 's', '=', '1' };
+
+		// a discovery event with a resolved service, as sent for every found service
+		flutter::EncodableValue CreateRecordEvent()
+		{
+			return CreateEventValue(EventRecord()
+				.Set(EventKey::HANDLE, "3f2504e0-4f89-11d3-9a0c-0305e82c3301")
+				.Set(EventKey::SERVICE_NAME, "Living Room Speaker")
+				.Set(EventKey::SERVICE_TYPE, "_googlecast._tcp")
+				.Set(EventKey::SERVICE_HOST, "speaker-1.local")
+				.Set(EventKey::SERVICE_PORT, 8009)
+				.Set(EventKey::SERVICE_TXT_RAW, kTxt)
+				.Set(EventKey::SERVICE_ADDRESSES, flutter::EncodableList{ flutter::EncodableValue("192.168.1.23") }));
+		}
+
+		// the same event as a map with string keys, as before the records
+		flutter::EncodableValue CreateMapEvent()
+		{
+			return flutter::EncodableValue(flutter::EncodableMap{
+				{ flutter::EncodableValue("handle"), flutter::EncodableValue("3f2504e0-4f89-11d3-9a0c-0305e82c3301") },
+				{ flutter::EncodableValue("service.name"), flutter::EncodableValue("Living Room Speaker") },
+				{ flutter::EncodableValue("service.type"), flutter::EncodableValue("_googlecast._tcp") },
+				{ flutter::EncodableValue("service.host"), flutter::EncodableValue("speaker-1.local") },
+				{ flutter::EncodableValue("service.port"), flutter::EncodableValue(8009) },
+				{ flutter::EncodableValue("service.txt.raw"), flutter::EncodableValue(kTxt) },
+				{ flutter::EncodableValue("service.addresses"), flutter::EncodableValue(flutter::EncodableList{ flutter::EncodableValue("192.168.1.23") }) },
+			});
+		}
+
+		// building and encoding an event; bytes per event are reported as a counter
+		void BM_EncodeRecordEvent(benchmark::State& state)
+		{
+			const auto& codec = flutter::StandardMessageCodec::GetInstance(&NsdCodecSerializer::GetInstance());
+			size_t bytes = 0;
+
+			for (auto _ : state) {
+				auto encoded = codec.EncodeMessage(CreateRecordEvent());
+				bytes = encoded->size();
+				benchmark::DoNotOptimize(encoded);
+			}
+			state.counters["bytes_per_event"] = static_cast<double>(bytes);
+		}
+		BENCHMARK(BM_EncodeRecordEvent);
+
+		void BM_EncodeMapEvent(benchmark::State& state)
+		{
+			const auto& codec = flutter::StandardMessageCodec::GetInstance();
+			size_t bytes = 0;
+
+			for (auto _ : state) {
+				auto encoded = codec.EncodeMessage(CreateMapEvent());
+				bytes = encoded->size();
+				benchmark::DoNotOptimize(encoded);
+			}
+			state.counters["bytes_per_event"] = static_cast<double>(bytes);
+		}
+		BENCHMARK(BM_EncodeMapEvent);
+	}
+}
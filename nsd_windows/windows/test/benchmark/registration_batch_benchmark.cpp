@@ -0,0 +1,86 @@
+#include "registration_batch.h"
+
+#include <benchmark/benchmark.h>
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr size_t kMaxRunning = 16; // as in the plugin
+
+		using Arguments = std::map<std::string, std::string>; // stands in for the method call arguments
+		using Batch = RegistrationBatch<Arguments, Arguments>;
+
+		// completes the started registrations one callback at a time, in the order they were started, like the
+		// results posted to the platform thread
+		class FakeRegistrationBackend {
+		public:
+
+			void Start(const std::string& handle, const Arguments& arguments) {
+				pending.push_back({ { "handle", handle }, { "service.name", arguments.at("service.name") } });
+			}
+
+			bool Deliver(Batch& batch) {
+				if (pending.empty()) {
+					return false;
+				}
+				auto result = std::move(pending.front());
+				pending.pop_front();
+				const auto handle = result.at("handle");
+				batch.Complete(handle, std::move(result));
+				return true;
+			}
+
+		private:
+
+			std::deque<Arguments> pending;
+		};
+
+		void Continue(Batch& batch, FakeRegistrationBackend& backend)
+		{
+			for (auto next = batch.StartNext(); next.has_value(); next = batch.StartNext()) {
+				backend.Start(next->first, next->second);
+			}
+		}
+
+		// registerMany from the method call to the collected results, against a backend that completes right away
+		void BM_RegisterMany(benchmark::State& state)
+		{
+			const auto count = static_cast<size_t>(state.range(0));
+
+			std::vector<Arguments> registrations;
+			for (size_t i = 0; i < count; i++) {
+				registrations.push_back({
+					{ "handle", "handle-" + std::to_string(i) },
+					{ "service.name", "Service " + std::to_string(i) },
+					{ "service.type", "_http._tcp" },
+					});
+			}
+
+			for (auto _ : state) {
+
+				Batch batch(kMaxRunning);
+				FakeRegistrationBackend backend;
+
+				for (const auto& registration : registrations) {
+					batch.Add(registration.at("handle"), registration);
+				}
+
+				Continue(batch, backend);
+				while (backend.Deliver(batch)) {
+					Continue(batch, backend);
+				}
+
+				auto results = batch.TakeResults();
+				benchmark::DoNotOptimize(results.data());
+			}
+			state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+		}
+		BENCHMARK(BM_RegisterMany)->Arg(1)->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+	}
+}
@@ -0,0 +1,40 @@
+#include "service_instance_name.h"
+
+#include <benchmark/benchmark.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		const std::string kName = "Living Room Speaker._googlecast._tcp.local";
+
+		void BM_ParseServiceInstanceName(benchmark::State& state)
+		{
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(ParseServiceInstanceName(kName));
+			}
+		}
+		BENCHMARK(BM_ParseServiceInstanceName);
+
+		// the previous approach: split on every dot into a vector of strings
+		void BM_SplitServiceInstanceName(benchmark::State& state)
+		{
+			for (auto _ : state) {
+				std::vector<std::string> components;
+				std::istringstream stream(kName);
+				std::string component;
+				while (std::getline(stream, component, '.')) {
+					components.push_back(component);
+				}
+				auto type = components[1] + "." + components[2];
+				benchmark::DoNotOptimize(components[0]);
+				benchmark::DoNotOptimize(type);
+			}
+		}
+		BENCHMARK(BM_SplitServiceInstanceName);
+	}
+}
@@ -0,0 +1,109 @@
+#include "service_table.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr auto kType = "_http._tcp";
+
+		std::vector<std::string> CreateNames(const size_t count)
+		{
+			std::vector<std::string> names;
+			names.reserve(count);
+			for (size_t i = 0; i < count; i++) {
+				names.push_back("Instance " + std::to_string(i));
+			}
+			return names;
+		}
+
+		void Fill(ServiceTable& table, const std::vector<std::string>& names)
+		{
+			for (const auto& name : names) {
+				table.Insert(name, kType);
+			}
+		}
+
+		// a browse callback for a known instance, with the name spelled differently
+		void BM_ServiceTableFind(benchmark::State& state)
+		{
+			const auto names = CreateNames(static_cast<size_t>(state.range(0)));
+			ServiceTable table;
+			Fill(table, names);
+
+			std::vector<std::string> queries;
+			for (auto query : names) {
+				std::transform(query.begin(), query.end(), query.begin(), [](const unsigned char c) -> char {
+					return static_cast<char>(std::tolower(c));
+					});
+				queries.push_back(std::move(query));
+			}
+
+			size_t i = 0;
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(table.Find(queries[i], kType));
+				i = (i + 1) % queries.size();
+			}
+		}
+		BENCHMARK(BM_ServiceTableFind)->Arg(10)->Arg(1000)->Arg(50000);
+
+		// the linear search the table replaced, for comparison
+		void BM_LinearFind(benchmark::State& state)
+		{
+			const auto names = CreateNames(static_cast<size_t>(state.range(0)));
+
+			std::vector<std::pair<std::string, std::string>> services;
+			for (const auto& name : names) {
+				services.emplace_back(name, kType);
+			}
+
+			size_t i = 0;
+			for (auto _ : state) {
+				const auto& name = names[i];
+				auto it = services.begin();
+				while (it != services.end() && !(EqualsDnsName(it->first, name) && EqualsDnsName(it->second, kType))) {
+					++it;
+				}
+				benchmark::DoNotOptimize(it);
+				i = (i + 1) % names.size();
+			}
+		}
+		BENCHMARK(BM_LinearFind)->Arg(10)->Arg(1000)->Arg(50000);
+
+		// a full browse: every instance is found, then lost; per instance
+		void BM_ServiceTableInsertErase(benchmark::State& state)
+		{
+			const auto names = CreateNames(static_cast<size_t>(state.range(0)));
+
+			for (auto _ : state) {
+				ServiceTable table;
+				Fill(table, names);
+				for (const auto& name : names) {
+					table.Erase(name, kType);
+				}
+				benchmark::DoNotOptimize(table.Size());
+			}
+			state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * names.size()));
+		}
+		BENCHMARK(BM_ServiceTableInsertErase)->Arg(10)->Arg(1000)->Arg(50000);
+
+		// one instance appears and disappears in a table of the given size
+		void BM_ServiceTableInsertEraseOne(benchmark::State& state)
+		{
+			ServiceTable table;
+			Fill(table, CreateNames(static_cast<size_t>(state.range(0))));
+
+			for (auto _ : state) {
+				table.Insert("New Instance", kType);
+				table.Erase("New Instance", kType);
+			}
+		}
+		BENCHMARK(BM_ServiceTableInsertEraseOne)->Arg(10)->Arg(1000)->Arg(50000);
+	}
+}
@@ -0,0 +1,74 @@
+#include "slab.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr int kOperations = 10000;
+
+		// roughly the size of an operation context
+		struct Context {
+			std::string handle;
+			uint64_t state[16] = {};
+		};
+
+		std::vector<std::string> CreateHandles()
+		{
+			std::vector<std::string> handles;
+			for (int i = 0; i < kOperations; i++) {
+				handles.push_back("3f2504e0-4f89-11d3-9a0c-" + std::to_string(100000000000 + i)); // uuid sized
+			}
+			return handles;
+		}
+
+		// 10k operations started, each looked up by a callback, then stopped
+		void BM_SlabChurn(benchmark::State& state)
+		{
+			const auto handles = CreateHandles();
+			Slab<Context> slab;
+			std::vector<SlabHandle> ids(kOperations);
+
+			for (auto _ : state) {
+				for (int i = 0; i < kOperations; i++) {
+					ids[i] = slab.Emplace(Context{ handles[i] }).first;
+				}
+				for (int i = 0; i < kOperations; i++) {
+					benchmark::DoNotOptimize(slab.Get(ids[i]));
+				}
+				for (int i = 0; i < kOperations; i++) {
+					slab.Erase(ids[i]);
+				}
+			}
+			state.SetItemsProcessed(state.iterations() * kOperations);
+		}
+		BENCHMARK(BM_SlabChurn)->Unit(benchmark::kMicrosecond);
+
+		// the contexts by string handle it replaced
+		void BM_MapChurn(benchmark::State& state)
+		{
+			const auto handles = CreateHandles();
+			std::map<std::string, std::unique_ptr<Context>> contexts;
+
+			for (auto _ : state) {
+				for (int i = 0; i < kOperations; i++) {
+					contexts[handles[i]] = std::make_unique<Context>(Context{ handles[i] });
+				}
+				for (int i = 0; i < kOperations; i++) {
+					benchmark::DoNotOptimize(contexts.find(handles[i])->second.get());
+				}
+				for (int i = 0; i < kOperations; i++) {
+					contexts.erase(handles[i]);
+				}
+			}
+			state.SetItemsProcessed(state.iterations() * kOperations);
+		}
+		BENCHMARK(BM_MapChurn)->Unit(benchmark::kMicrosecond);
+	}
+}
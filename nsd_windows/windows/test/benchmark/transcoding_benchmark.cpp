@@ -0,0 +1,90 @@
+#include "transcoding.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace nsd_windows {
+
+	namespace {
+
+		const std::string kAsciiName = "Living Room Speaker._googlecast._tcp.local";
+		const std::string kMixedName = "Imprimante du salon \xC3\xA0 c\xC3\xB4t\xC3\xA9 de la fen\xC3\xAAtre._ipp._tcp.local";
+
+		// the previous approach, like MultiByteToWideChar called twice: one pass to size the output, one to convert
+		// into a newly allocated string; valid input only
+		std::u16string ConvertTwoPass(const std::string& value)
+		{
+			const auto bytes = reinterpret_cast<const uint8_t*>(value.data());
+
+			size_t size = 0;
+			for (size_t i = 0; i < value.size(); size++) {
+				const auto lead = bytes[i];
+				const size_t length = lead < 0x80 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+				size += length == 4 ? 1 : 0;
+				i += length;
+			}
+
+			std::u16string result(size, u'\0');
+			size_t written = 0;
+			for (size_t i = 0; i < value.size();) {
+				const auto lead = bytes[i];
+				if (lead < 0x80) {
+					result[written++] = lead;
+					i++;
+				}
+				else if (lead < 0xE0) {
+					result[written++] = static_cast<char16_t>(((lead & 0x1F) << 6) | (bytes[i + 1] & 0x3F));
+					i += 2;
+				}
+				else if (lead < 0xF0) {
+					result[written++] = static_cast<char16_t>(((lead & 0x0F) << 12) | ((bytes[i + 1] & 0x3F) << 6) | (bytes[i + 2] & 0x3F));
+					i += 3;
+				}
+				else {
+					const uint32_t codePoint = (((lead & 0x07) << 18) | ((bytes[i + 1] & 0x3F) << 12) | ((bytes[i + 2] & 0x3F) << 6) | (bytes[i + 3] & 0x3F)) - 0x10000;
+					result[written++] = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+					result[written++] = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+					i += 4;
+				}
+			}
+			return result;
+		}
+
+		void BM_Utf8ToUtf16(benchmark::State& state, const std::string& value)
+		{
+			std::u16string out(GetMaxUtf16Size(value.size()), u'\0');
+
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(Utf8ToUtf16(value.data(), value.size(), out.data()));
+			}
+			state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * value.size()));
+		}
+		BENCHMARK_CAPTURE(BM_Utf8ToUtf16, Ascii, kAsciiName);
+		BENCHMARK_CAPTURE(BM_Utf8ToUtf16, Mixed, kMixedName);
+
+		void BM_Utf8ToUtf16TwoPass(benchmark::State& state, const std::string& value)
+		{
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(ConvertTwoPass(value));
+			}
+			state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * value.size()));
+		}
+		BENCHMARK_CAPTURE(BM_Utf8ToUtf16TwoPass, Ascii, kAsciiName);
+		BENCHMARK_CAPTURE(BM_Utf8ToUtf16TwoPass, Mixed, kMixedName);
+
+		void BM_Utf16ToUtf8(benchmark::State& state, const std::string& value)
+		{
+			std::u16string utf16(GetMaxUtf16Size(value.size()), u'\0');
+			utf16.resize(Utf8ToUtf16(value.data(), value.size(), utf16.data()).size);
+			std::string out(GetMaxUtf8Size(utf16.size()), '\0');
+
+			for (auto _ : state) {
+				benchmark::DoNotOptimize(Utf16ToUtf8(utf16.data(), utf16.size(), out.data()));
+			}
+			state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * value.size()));
+		}
+		BENCHMARK_CAPTURE(BM_Utf16ToUtf8, Ascii, kAsciiName);
+		BENCHMARK_CAPTURE(BM_Utf16ToUtf8, Mixed, kMixedName);
+	}
+}
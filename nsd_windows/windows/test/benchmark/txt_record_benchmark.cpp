@@ -0,0 +1,74 @@
+#include "txt_record.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		std::vector<uint8_t> CreateWire(const int entries)
+		{
+			std::vector<uint8_t> wire;
+			for (int i = 0; i < entries; i++) {
+				const auto entry = "key" + std::to_string(i) + "=value " + std::to_string(i);
+				wire.push_back(static_cast<uint8_t>(entry.size()));
+				wire.insert(wire.end(), entry.begin(), entry.end());
+			}
+			return wire;
+		}
+
+		// received TXT rdata to the form sent to dart
+		void BM_TxtRecordFromWire(benchmark::State& state)
+		{
+			const auto wire = CreateWire(static_cast<int>(state.range(0)));
+
+			for (auto _ : state) {
+				auto txt = TxtRecord::FromWire(wire.data(), wire.size());
+				benchmark::DoNotOptimize(txt.GetWire().data());
+			}
+		}
+		BENCHMARK(BM_TxtRecordFromWire)->Arg(1)->Arg(8)->Arg(32);
+
+		// a string key, string value and byte vector per entry, as before the arena
+		void BM_TxtMapFromWire(benchmark::State& state)
+		{
+			const auto wire = CreateWire(static_cast<int>(state.range(0)));
+
+			for (auto _ : state) {
+				std::map<std::string, std::vector<uint8_t>> txt;
+				for (size_t offset = 0; offset < wire.size(); offset += 1 + wire[offset]) {
+					const std::string entry(reinterpret_cast<const char*>(&wire[offset + 1]), wire[offset]);
+					const auto separator = entry.find('=');
+					const auto value = entry.substr(separator + 1);
+					txt.emplace(entry.substr(0, separator), std::vector<uint8_t>(value.begin(), value.end()));
+				}
+				benchmark::DoNotOptimize(txt);
+			}
+		}
+		BENCHMARK(BM_TxtMapFromWire)->Arg(1)->Arg(8)->Arg(32);
+
+		// a registration's TXT entries to rdata
+		void BM_TxtRecordAdd(benchmark::State& state)
+		{
+			const auto count = static_cast<int>(state.range(0));
+
+			std::vector<std::pair<std::string, std::string>> entries;
+			for (int i = 0; i < count; i++) {
+				entries.emplace_back("key" + std::to_string(i), "value " + std::to_string(i));
+			}
+
+			for (auto _ : state) {
+				TxtRecord txt;
+				for (const auto& [key, value] : entries) {
+					txt.Add(key, reinterpret_cast<const uint8_t*>(value.data()), value.size());
+				}
+				benchmark::DoNotOptimize(txt.GetWire().data());
+			}
+		}
+		BENCHMARK(BM_TxtRecordAdd)->Arg(1)->Arg(8)->Arg(32);
+	}
+}
@@ -0,0 +1,149 @@
+#include "dns_message_view.h"
+#include "test_messages.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		std::vector<std::string> GetStrings(const DnsStringsView strings)
+		{
+			return std::vector<std::string>(strings.begin(), strings.end());
+		}
+	}
+
+	TEST(DnsMessageViewTest, ParsesServiceResponse)
+	{
+		const auto packet = SerializeServiceResponse();
+		const auto message = DnsMessageView::Parse(packet.data(), packet.size());
+
+		ASSERT_TRUE(message.has_value());
+		EXPECT_TRUE(message->IsResponse());
+		EXPECT_EQ(message->GetQuestions().Size(), 0u);
+		ASSERT_EQ(message->GetAnswers().Size(), 1u);
+		EXPECT_EQ(message->GetAuthorities().Size(), 0u);
+		ASSERT_EQ(message->GetAdditionals().Size(), 5u);
+
+		const auto ptr = *message->GetAnswers().begin();
+		EXPECT_EQ(ptr.type, DnsType::PTR);
+		EXPECT_EQ(ptr.ttl, 4500u);
+		EXPECT_FALSE(ptr.cacheFlush);
+		EXPECT_EQ(ptr.name.ToString(), "_ipp._tcp.local");
+		EXPECT_EQ(ptr.GetPtrTarget().ToString(), "My\\.Printer._ipp._tcp.local");
+
+		std::vector<DnsRecordView> records(message->GetAdditionals().begin(), message->GetAdditionals().end());
+
+		EXPECT_EQ(records[0].type, DnsType::SRV);
+		EXPECT_TRUE(records[0].cacheFlush);
+		EXPECT_EQ(records[0].GetSrv().port, 8080);
+		EXPECT_EQ(records[0].GetSrv().target.ToString(), "printer-1.local");
+
+		EXPECT_EQ(records[1].type, DnsType::TXT);
+		EXPECT_EQ(GetStrings(records[1].GetTxt()), (std::vector<std::string>{ "txtvers=1", "path=/printer", "note=Hallway" }));
+
+		EXPECT_EQ(records[2].type, DnsType::A);
+		EXPECT_EQ(std::vector<uint8_t>(records[2].GetAddress(), records[2].GetAddress() + 4), (std::vector<uint8_t>{ 192, 168, 1, 23 }));
+
+		EXPECT_EQ(records[3].type, DnsType::AAAA);
+		EXPECT_EQ(records[3].rdataSize, 16);
+
+		EXPECT_EQ(records[4].type, DnsType::NSEC);
+		const auto nsec = records[4].GetNsec();
+		EXPECT_EQ(nsec.nextName.ToString(), "printer-1.local");
+		EXPECT_TRUE(nsec.HasType(DnsType::A));
+		EXPECT_TRUE(nsec.HasType(DnsType::AAAA));
+		EXPECT_FALSE(nsec.HasType(DnsType::SRV));
+		EXPECT_FALSE(nsec.HasType(DnsType::ANY));
+	}
+
+	TEST(DnsMessageViewTest, MatchesParseDnsMessage)
+	{
+		const auto expected = CreateServiceResponse("My\\.Printer", "_ipp._tcp.local", "printer-1.local");
+		const auto packet = SerializeDnsMessage(expected);
+
+		const auto message = ParseDnsMessage(packet.data(), packet.size());
+
+		ASSERT_TRUE(message.has_value());
+		ASSERT_EQ(message->answers.size(), expected.answers.size());
+		ASSERT_EQ(message->additionals.size(), expected.additionals.size());
+		for (size_t i = 0; i < expected.additionals.size(); i++) {
+			EXPECT_TRUE(message->additionals[i].IsSameRecord(expected.additionals[i])) << i;
+			EXPECT_EQ(message->additionals[i].ttl, expected.additionals[i].ttl) << i;
+			EXPECT_EQ(message->additionals[i].cacheFlush, expected.additionals[i].cacheFlush) << i;
+		}
+	}
+
+	TEST(DnsMessageViewTest, NameEqualsIsCaseInsensitiveAndUnescapes)
+	{
+		const auto packet = SerializeServiceResponse();
+		const auto message = DnsMessageView::Parse(packet.data(), packet.size());
+		ASSERT_TRUE(message.has_value());
+
+		const auto name = message->GetAnswers().begin()->GetPtrTarget(); // compressed
+
+		EXPECT_TRUE(name.Equals("My\\.Printer._ipp._tcp.local"));
+		EXPECT_TRUE(name.Equals("my\\.printer._IPP._TCP.LOCAL"));
+		EXPECT_TRUE(name.Equals("My\\046Printer._ipp._tcp.local"));
+		EXPECT_FALSE(name.Equals("My.Printer._ipp._tcp.local"));
+		EXPECT_FALSE(name.Equals("My\\.Printer._ipp._tcp"));
+		EXPECT_FALSE(name.Equals("My\\.Printer._ipp._tcp.local.x"));
+		EXPECT_FALSE(name.Equals(""));
+	}
+
+	TEST(DnsMessageViewTest, RejectsTruncatedMessages)
+	{
+		const auto packet = SerializeServiceResponse();
+
+		for (size_t size = 0; size < packet.size(); size++) {
+			EXPECT_FALSE(DnsMessageView::Parse(packet.data(), size).has_value()) << size;
+		}
+	}
+
+	TEST(DnsMessageViewTest, RejectsForwardAndLoopingPointers)
+	{
+		// one question whose name is a pointer
+		std::vector<uint8_t> packet = { 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0xC0, 0, 0, 1, 0, 1 };
+
+		for (const uint8_t target : { 12, 14, 0 }) { // itself, forward, into the header
+			packet[13] = target;
+			EXPECT_FALSE(DnsMessageView::Parse(packet.data(), packet.size()).has_value()) << static_cast<int>(target);
+		}
+	}
+
+	TEST(DnsMessageViewTest, RejectsMalformedRdata)
+	{
+		DnsMessage message;
+		message.flags = kDnsFlagResponse;
+		message.answers.push_back(CreateRecord("host.local", DnsType::A));
+		message.answers.back().data = { 10, 0, 0 }; // too short
+
+		auto packet = SerializeDnsMessage(message);
+		EXPECT_FALSE(DnsMessageView::Parse(packet.data(), packet.size()).has_value());
+
+		message.answers.back() = CreateRecord("_http._tcp.local", DnsType::TXT);
+		message.answers.back().data = { 5, 'a', '=', 'b' }; // string runs past the rdata
+
+		packet = SerializeDnsMessage(message);
+		EXPECT_FALSE(DnsMessageView::Parse(packet.data(), packet.size()).has_value());
+	}
+
+	TEST(DnsMessageViewTest, KeepsUnknownTypesRaw)
+	{
+		DnsMessage message;
+		message.flags = kDnsFlagResponse;
+		message.answers.push_back(CreateRecord("host.local", static_cast<DnsType>(99)));
+		message.answers.back().data = { 1, 2, 3 };
+
+		const auto packet = SerializeDnsMessage(message);
+		const auto view = DnsMessageView::Parse(packet.data(), packet.size());
+
+		ASSERT_TRUE(view.has_value());
+		const auto record = view->GetAnswers().begin()->ToRecord();
+		EXPECT_EQ(record.type, static_cast<DnsType>(99));
+		EXPECT_EQ(record.data, (std::vector<uint8_t>{ 1, 2, 3 }));
+	}
+}
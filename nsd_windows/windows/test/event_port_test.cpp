@@ -0,0 +1,170 @@
+#include "event_port.h"
+
+#include <dart_version.h>
+#include <internal/dart_api_dl_impl.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		// what the fake Dart_PostCObject() received, rendered as text; empty if nothing was posted
+		std::string posted;
+		bool postSucceeds = true;
+
+		std::string Render(const Dart_CObject& object)
+		{
+			switch (object.type) {
+			case Dart_CObject_kNull:
+				return "null";
+			case Dart_CObject_kBool:
+				return object.value.as_bool ? "true" : "false";
+			case Dart_CObject_kInt32:
+				return std::to_string(object.value.as_int32);
+			case Dart_CObject_kInt64:
+				return std::to_string(object.value.as_int64);
+			case Dart_CObject_kString:
+				return "'" + std::string(object.value.as_string) + "'";
+			case Dart_CObject_kTypedData:
+				return "bytes(" + std::to_string(object.value.as_typed_data.length) + ")";
+			case Dart_CObject_kExternalTypedData:
+				return "external(" + std::to_string(object.value.as_external_typed_data.length) + ")";
+			case Dart_CObject_kArray: {
+				std::string text = "[";
+				for (intptr_t i = 0; i < object.value.as_array.length; i++) {
+					text += (i > 0 ? ", " : "") + Render(*object.value.as_array.values[i]);
+				}
+				return text + "]";
+			}
+			default:
+				return "?";
+			}
+		}
+
+		// external typed data belongs to dart once posted, so it is finalized right away
+		void Finalize(const Dart_CObject& object)
+		{
+			if (object.type == Dart_CObject_kExternalTypedData) {
+				object.value.as_external_typed_data.callback(nullptr, object.value.as_external_typed_data.peer);
+			}
+			if (object.type == Dart_CObject_kArray) {
+				for (intptr_t i = 0; i < object.value.as_array.length; i++) {
+					Finalize(*object.value.as_array.values[i]);
+				}
+			}
+		}
+
+		bool FakePostCObject(Dart_Port port, Dart_CObject* message)
+		{
+			if (!postSucceeds) {
+				return false;
+			}
+			posted = Render(*message);
+			Finalize(*message);
+			return true;
+		}
+
+		const DartApiEntry kFunctions[] = {
+			{ "Dart_PostInteger", nullptr },
+			{ "Dart_PostCObject", reinterpret_cast<void (*)(void)>(&FakePostCObject) },
+			{ nullptr, nullptr },
+		};
+		const DartApi kApi = { DART_API_DL_MAJOR_VERSION, DART_API_DL_MINOR_VERSION, kFunctions };
+
+		class EventPortTest : public testing::Test {
+		protected:
+
+			void SetUp() override {
+				ASSERT_TRUE(EventPort::InitializeDartApi(const_cast<DartApi*>(&kApi)));
+				port.SetPort(42);
+				posted.clear();
+				postSucceeds = true;
+			}
+
+			EventPort port;
+		};
+	}
+
+	TEST_F(EventPortTest, PostsRecordsAsTaggedArrays)
+	{
+		auto arguments = EventRecord()
+			.Set(EventKey::HANDLE, "h1")
+			.Set(EventKey::SERVICE_PORT, 631)
+			.Set(EventKey::SERVICE_ADDRESSES, flutter::EncodableList{ flutter::EncodableValue("192.168.1.23") })
+			.Set(EventKey::SERVICE_RESOLVED, true);
+
+		ASSERT_TRUE(port.Post("onServiceDiscovered", arguments));
+
+		// record tag, key bits (0, 4, 6 and 8), values in key order; lists start with their tag
+		EXPECT_EQ(posted, "['onServiceDiscovered', [2, 337, 'h1', 631, [0, '192.168.1.23'], true]]");
+	}
+
+	TEST_F(EventPortTest, PostsNestedRecordsAndMaps)
+	{
+		auto arguments = EventRecord()
+			.Set(EventKey::SERVICE_CHANGES, flutter::EncodableList{
+				CreateEventValue(EventRecord().Set(EventKey::SERVICE_NAME, "Printer")),
+				})
+			.Set(EventKey::SERVICE_TYPES, flutter::EncodableMap{
+				{ flutter::EncodableValue("_ipp._tcp"), flutter::EncodableValue() },
+				});
+
+		ASSERT_TRUE(port.Post("onServicesChanged", arguments));
+		EXPECT_EQ(posted, "['onServicesChanged', [2, 3072, [0, [2, 2, 'Printer']], [1, '_ipp._tcp', null]]]");
+	}
+
+	TEST_F(EventPortTest, HandsOverLargeByteArraysAsExternalTypedData)
+	{
+		auto arguments = EventRecord()
+			.Set(EventKey::SERVICE_TXT_RAW, std::vector<uint8_t>(EventPort::kMinExternalSize))
+			.Set(EventKey::RESULTS, flutter::EncodableList{
+				CreateEventValue(EventRecord().Set(EventKey::SERVICE_TXT_RAW, std::vector<uint8_t>(5))),
+				});
+
+		ASSERT_TRUE(port.Post("onRegistrationsChanged", arguments));
+		EXPECT_EQ(posted, "['onRegistrationsChanged', [2, 16416, external(256), [0, [2, 32, bytes(5)]]]]");
+
+		// moved out of the event
+		EXPECT_TRUE(std::get<std::vector<uint8_t>>(*arguments.Get(EventKey::SERVICE_TXT_RAW)).empty());
+	}
+
+	TEST_F(EventPortTest, DisablesThePortIfPostingFails)
+	{
+		postSucceeds = false; // e.g. the isolate closed the port
+		auto arguments = EventRecord().Set(EventKey::SERVICE_TXT_RAW, std::vector<uint8_t>(300, 'x'));
+
+		EXPECT_FALSE(port.Post("onServiceDiscovered", arguments));
+		EXPECT_FALSE(port.IsEnabled());
+
+		// restored for the method channel
+		EXPECT_EQ(std::get<std::vector<uint8_t>>(*arguments.Get(EventKey::SERVICE_TXT_RAW)), std::vector<uint8_t>(300, 'x'));
+
+		postSucceeds = true;
+		EXPECT_FALSE(port.Post("onServiceDiscovered", arguments));
+		EXPECT_TRUE(posted.empty());
+	}
+
+	TEST_F(EventPortTest, DoesNotPostWithoutPort)
+	{
+		port.SetPort(ILLEGAL_PORT);
+		auto arguments = EventRecord().Set(EventKey::HANDLE, "h1");
+
+		EXPECT_FALSE(port.IsEnabled());
+		EXPECT_FALSE(port.Post("onDiscoveryStopSuccessful", arguments));
+		EXPECT_TRUE(posted.empty());
+	}
+
+	TEST_F(EventPortTest, RejectsIncompatibleDartApi)
+	{
+		const DartApi api = { DART_API_DL_MAJOR_VERSION + 1, 0, kFunctions };
+		EXPECT_FALSE(EventPort::InitializeDartApi(const_cast<DartApi*>(&api)));
+
+		const DartApiEntry functions[] = { { nullptr, nullptr } };
+		const DartApi withoutPost = { DART_API_DL_MAJOR_VERSION, 0, functions };
+		EXPECT_FALSE(EventPort::InitializeDartApi(const_cast<DartApi*>(&withoutPost)));
+	}
+}
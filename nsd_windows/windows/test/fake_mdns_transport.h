@@ -0,0 +1,35 @@
+#pragma once
+
+#include "mdns_transport.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	// keeps sent packets in memory, received packets are injected by calling the receiver
+	class FakeMdnsTransport : public MdnsTransport {
+	public:
+
+		std::vector<std::vector<uint8_t>> sent; // multicast
+		std::vector<std::pair<MdnsEndpoint, std::vector<uint8_t>>> sentTo; // unicast
+		Receiver receiver;
+
+		void Start(Receiver receiver) override {
+			this->receiver = std::move(receiver);
+		}
+
+		void Stop() override {
+			receiver = nullptr;
+		}
+
+		void Send(const std::vector<uint8_t>& packet) override {
+			sent.push_back(packet);
+		}
+
+		void SendTo(const std::vector<uint8_t>& packet, const MdnsEndpoint& destination) override {
+			sentTo.emplace_back(destination, packet);
+		}
+	};
+}
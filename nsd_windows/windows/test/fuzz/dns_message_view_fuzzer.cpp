@@ -0,0 +1,137 @@
+#include "dns_message.h"
+#include "dns_message_view.h"
+#include "fuzz_target.h"
+#include "service_table.h"
+#include "test_messages.h"
+
+// parses arbitrary packets with DnsMessageView, uses every accessor the parser validated for, and checks that
+// what ParseDnsMessage() copies serializes into a packet that parses back to the same message
+
+namespace {
+
+	using namespace nsd_windows;
+
+	volatile size_t sink; // keeps the accessors from being optimized out
+
+	size_t Touch(const DnsRecordView& record)
+	{
+		size_t result = record.name.ToString().size();
+
+		switch (record.type) {
+		case DnsType::PTR:
+			result += record.GetPtrTarget().ToString().size();
+			break;
+		case DnsType::SRV:
+			result += record.GetSrv().target.ToString().size();
+			break;
+		case DnsType::TXT:
+			for (const auto entry : record.GetTxt()) {
+				result += entry.size();
+			}
+			break;
+		case DnsType::NSEC: {
+			const auto nsec = record.GetNsec();
+			result += nsec.nextName.ToString().size() + (nsec.HasType(DnsType::A) ? 1 : 0) + (nsec.HasType(DnsType::SRV) ? 1 : 0);
+			break;
+		}
+		default:
+			break;
+		}
+		return result;
+	}
+
+	// raw rdata is copied as is, a compression pointer in it would point elsewhere once serialized again
+	bool HasCompressedRdata(const DnsRecordView& record)
+	{
+		if (record.type != DnsType::NSEC) {
+			return false;
+		}
+
+		const auto rdata = record.GetRdata();
+		size_t position = 0;
+		while (rdata[position] != 0 && (rdata[position] & 0xC0) != 0xC0) {
+			position += 1 + rdata[position];
+		}
+		return rdata[position] != 0;
+	}
+
+	bool IsSameSection(const std::vector<DnsRecord>& a, const std::vector<DnsRecord>& b)
+	{
+		if (a.size() != b.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); i++) {
+			// names compare case-insensitively, compression may point to a suffix spelled differently
+			if (!a[i].IsSameRecord(b[i]) || a[i].ttl != b[i].ttl || a[i].cacheFlush != b[i].cacheFlush) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+std::vector<std::vector<uint8_t>> GetFuzzSeeds()
+{
+	auto query = CreateServiceResponse("Kitchen", "_airplay._tcp.local", "kitchen.local");
+	query.flags = 0;
+	query.questions.push_back({ "_airplay._tcp.local", DnsType::PTR, true });
+	query.questions.push_back({ "Kitchen._airplay._tcp.local", DnsType::ANY });
+	query.additionals.clear(); // known answer
+
+	return {
+		SerializeServiceResponse(),
+		SerializeDnsMessage(CreateServiceResponse("a", "_b._udp.local", "c.local")),
+		SerializeDnsMessage(query),
+	};
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	const auto view = DnsMessageView::Parse(data, size);
+	if (!view.has_value()) {
+		return 0;
+	}
+
+	size_t total = 0;
+	auto roundTrips = true;
+
+	for (const auto& question : view->GetQuestions()) {
+		const auto name = question.name.ToString();
+		FUZZ_CHECK(question.name.Equals(name));
+		total += name.size();
+	}
+
+	for (const auto section : { view->GetAnswers(), view->GetAuthorities(), view->GetAdditionals() }) {
+		for (const auto& record : section) {
+			FUZZ_CHECK(record.name.Equals(record.name.ToString()));
+			total += Touch(record);
+			roundTrips = roundTrips && !HasCompressedRdata(record);
+		}
+	}
+
+	const auto message = ParseDnsMessage(data, size);
+	FUZZ_CHECK(message.has_value());
+	FUZZ_CHECK(message->questions.size() + message->answers.size() + message->authorities.size() + message->additionals.size() == view->GetQuestions().Size() + view->GetAnswers().Size() + view->GetAuthorities().Size() + view->GetAdditionals().Size());
+
+	if (!roundTrips) {
+		return 0;
+	}
+
+	const auto packet = SerializeDnsMessage(*message);
+	const auto reparsed = ParseDnsMessage(packet.data(), packet.size());
+
+	FUZZ_CHECK(reparsed.has_value());
+	FUZZ_CHECK(reparsed->id == message->id && reparsed->flags == message->flags);
+	FUZZ_CHECK(reparsed->questions.size() == message->questions.size());
+	for (size_t i = 0; i < message->questions.size(); i++) {
+		FUZZ_CHECK(EqualsDnsName(reparsed->questions[i].name, message->questions[i].name));
+		FUZZ_CHECK(reparsed->questions[i].type == message->questions[i].type);
+		FUZZ_CHECK(reparsed->questions[i].unicastResponse == message->questions[i].unicastResponse);
+	}
+	FUZZ_CHECK(IsSameSection(reparsed->answers, message->answers));
+	FUZZ_CHECK(IsSameSection(reparsed->authorities, message->authorities));
+	FUZZ_CHECK(IsSameSection(reparsed->additionals, message->additionals));
+
+	sink = total;
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include "fuzz_target.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+// stand-in for libFuzzer's main where it isn't available: runs the files given on the command line, or
+// the seeds and a fixed number of mutations of them, so the targets also run as regular tests
+
+namespace {
+
+	constexpr int kIterations = 100000;
+	constexpr size_t kMaxSize = 4096;
+
+	void Mutate(std::vector<uint8_t>& input, std::mt19937& random)
+	{
+		const auto mutations = 1 + random() % 4;
+
+		for (uint32_t i = 0; i < mutations; i++) {
+
+			const auto position = input.empty() ? 0 : random() % input.size();
+
+			switch (random() % 6) {
+			case 0: // flip a bit
+				if (!input.empty()) {
+					input[position] ^= static_cast<uint8_t>(1u << (random() % 8));
+				}
+				break;
+			case 1: // random byte
+				if (!input.empty()) {
+					input[position] = static_cast<uint8_t>(random());
+				}
+				break;
+			case 2: // interesting byte, e.g. lengths and compression pointers
+				if (!input.empty()) {
+					static constexpr uint8_t interesting[] = { 0x00, 0x01, 0x3F, 0x40, 0x7F, 0x80, 0xC0, 0xFF, '\\', '.', '=' };
+					input[position] = interesting[random() % sizeof(interesting)];
+				}
+				break;
+			case 3: // insert a byte
+				if (input.size() < kMaxSize) {
+					input.insert(input.begin() + position, static_cast<uint8_t>(random()));
+				}
+				break;
+			case 4: // erase a byte
+				if (!input.empty()) {
+					input.erase(input.begin() + position);
+				}
+				break;
+			default: // truncate
+				input.resize(position);
+				break;
+			}
+		}
+	}
+
+	bool RunFile(const char* path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			std::fprintf(stderr, "Cannot read %s\n", path);
+			return false;
+		}
+
+		const std::vector<uint8_t> input((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++) {
+			if (!RunFile(argv[i])) {
+				return 1;
+			}
+		}
+		return 0;
+	}
+
+	auto seeds = GetFuzzSeeds();
+	seeds.emplace_back(); // the empty input
+
+	for (const auto& seed : seeds) {
+		LLVMFuzzerTestOneInput(seed.data(), seed.size());
+	}
+
+	std::mt19937 random(42); // fixed, failures must be reproducible
+
+	for (int i = 0; i < kIterations; i++) {
+
+		auto input = seeds[random() % seeds.size()];
+		Mutate(input, random);
+		LLVMFuzzerTestOneInput(input.data(), input.size());
+	}
+
+	std::printf("%d inputs passed\n", kIterations + static_cast<int>(seeds.size()));
+	return 0;
+}
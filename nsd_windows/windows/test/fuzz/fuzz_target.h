@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// defined by each fuzz target: well-formed inputs the driver mutates, see fuzz_driver.cpp
+std::vector<std::vector<uint8_t>> GetFuzzSeeds();
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// invariant of the code under test; aborts so both libFuzzer and the driver report the input
+#define FUZZ_CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::fprintf(stderr, "%s:%d: FUZZ_CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			std::abort(); \
+		} \
+	} while (false)
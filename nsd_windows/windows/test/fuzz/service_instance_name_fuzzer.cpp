@@ -0,0 +1,76 @@
+#include "dns_message.h"
+#include "fuzz_target.h"
+#include "service_instance_name.h"
+
+#include <string>
+#include <string_view>
+
+// parses arbitrary names and checks that the parts are in order within the name; also takes the input as an
+// instance label, which must come back unchanged after escaping, parsing and unescaping
+
+namespace {
+
+	using namespace nsd_windows;
+
+	bool IsWithin(const std::string_view part, const std::string_view name)
+	{
+		return part.data() >= name.data() && part.data() + part.size() <= name.data() + name.size();
+	}
+
+	bool IsBefore(const std::string_view first, const std::string_view second)
+	{
+		return first.empty() || second.empty() || first.data() + first.size() < second.data();
+	}
+}
+
+std::vector<std::vector<uint8_t>> GetFuzzSeeds()
+{
+	std::vector<std::vector<uint8_t>> seeds;
+	for (const std::string name : { "My\\.Printer._ipp._tcp.local", "Printer v1.2._http._tcp.example.com.", "_color._sub._ipp._udp.local", "A\\066\\\\._x._tcp" }) {
+		seeds.emplace_back(name.begin(), name.end());
+	}
+	return seeds;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	const std::string_view input(reinterpret_cast<const char*>(data), size);
+
+	const auto name = ParseServiceInstanceName(input);
+	if (name.has_value()) {
+
+		FUZZ_CHECK(name->service.size() >= 2 && name->service[0] == '_');
+		FUZZ_CHECK(name->protocol.size() == 4);
+		FUZZ_CHECK(name->instance.empty() || name->subtype.empty());
+
+		for (const auto part : { name->instance, name->subtype, name->service, name->protocol, name->domain, name->GetType() }) {
+			FUZZ_CHECK(part.empty() || IsWithin(part, input));
+		}
+
+		FUZZ_CHECK(IsBefore(name->instance, name->service));
+		FUZZ_CHECK(IsBefore(name->subtype, name->service));
+		FUZZ_CHECK(IsBefore(name->protocol, name->domain));
+
+		if (!name->instance.empty()) {
+			UnescapeDnsLabel(name->instance);
+		}
+	}
+
+	// the input as a label, e.g. as registered by the built-in responder
+	if (!input.empty()) {
+
+		const auto escaped = EscapeDnsLabel(input);
+		const auto fullName = escaped + "._http._tcp.local"; // parsed in place
+		const auto instanceName = ParseServiceInstanceName(fullName);
+
+		FUZZ_CHECK(instanceName.has_value());
+		FUZZ_CHECK(instanceName->instance == escaped);
+		FUZZ_CHECK(instanceName->GetType() == "_http._tcp");
+		FUZZ_CHECK(UnescapeDnsLabel(instanceName->instance) == std::string(input));
+
+		const auto labels = SplitDnsName(escaped + ".local");
+		FUZZ_CHECK(labels.size() == 2 && labels[0] == input);
+	}
+
+	return 0;
+}
@@ -0,0 +1,29 @@
+#include "ip_address.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace nsd_windows {
+
+	TEST(IpAddressTest, FormatsIp4Addresses)
+	{
+		const uint8_t bytes[] = { 192, 168, 1, 255 };
+		EXPECT_EQ(FormatIp4Address(bytes), "192.168.1.255");
+	}
+
+	TEST(IpAddressTest, FormatsIp6AddressesAsRecommended)
+	{
+		auto format = [](std::vector<uint8_t> bytes) {
+			return FormatIp6Address(bytes.data());
+		};
+
+		EXPECT_EQ(format({ 0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x11, 0x22, 0xFF, 0xFE, 0x33, 0x44, 0x55 }), "fe80::211:22ff:fe33:4455");
+		EXPECT_EQ(format(std::vector<uint8_t>(16, 0)), "::");
+		EXPECT_EQ(format({ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }), "::1");
+		EXPECT_EQ(format({ 0x20, 0x01, 0x0D, 0xB8, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 1 }), "2001:db8::1:0:0:1"); // first of equal runs
+		EXPECT_EQ(format({ 0x20, 0x01, 0x0D, 0xB8, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1 }), "2001:db8:0:1:1:1:1:1"); // single zero group stays
+		EXPECT_EQ(format({ 0x20, 0x01, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0 }), "2001:0:0:1::"); // longest run wins
+	}
+}
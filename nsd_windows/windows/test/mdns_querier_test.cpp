@@ -0,0 +1,321 @@
+#include "mdns_querier.h"
+
+#include "fake_mdns_transport.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using namespace std::chrono_literals;
+		using TimePoint = std::chrono::steady_clock::time_point;
+
+		constexpr const char* kServiceType = "_ipp._tcp.local";
+		constexpr const char* kInstanceName = "Printer._ipp._tcp.local";
+
+		class RecordingListener : public MdnsQuerierListener {
+		public:
+
+			std::vector<std::tuple<uint64_t, std::string, bool>> browseResults;
+			std::vector<std::pair<uint64_t, MdnsServiceInstance>> resolveResults;
+
+			void OnBrowseResult(const uint64_t browseId, const std::string& instanceName, const bool found) override {
+				browseResults.emplace_back(browseId, instanceName, found);
+			}
+
+			void OnResolveResult(const uint64_t resolveId, const MdnsServiceInstance& instance) override {
+				resolveResults.emplace_back(resolveId, instance);
+			}
+		};
+
+		DnsRecord CreateRecord(const std::string& name, const DnsType type, const uint32_t ttl)
+		{
+			DnsRecord record;
+			record.name = name;
+			record.type = type;
+			record.ttl = ttl;
+			return record;
+		}
+
+		DnsRecord CreatePtrRecord(const uint32_t ttl)
+		{
+			auto record = CreateRecord(kServiceType, DnsType::PTR, ttl);
+			record.target = kInstanceName;
+			return record;
+		}
+
+		DnsRecord CreateSrvRecord(const uint32_t ttl)
+		{
+			auto record = CreateRecord(kInstanceName, DnsType::SRV, ttl);
+			record.target = "printer.local";
+			record.port = 631;
+			return record;
+		}
+
+		DnsRecord CreateTxtRecord(const uint32_t ttl)
+		{
+			auto record = CreateRecord(kInstanceName, DnsType::TXT, ttl);
+			record.data = { 5, 'r', 'p', '=', 'i', 'p' };
+			return record;
+		}
+
+		DnsRecord CreateAddressRecord(const DnsType type, std::vector<uint8_t> address)
+		{
+			auto record = CreateRecord("printer.local", type, 120);
+			record.cacheFlush = true;
+			record.data = std::move(address);
+			return record;
+		}
+
+		class MdnsQuerierTest : public testing::Test {
+		protected:
+
+			FakeMdnsTransport transport;
+			RecordingListener listener;
+			TimePoint now;
+			MdnsQuerier querier{ transport, listener, [this]() { return now; }, 1 };
+
+			std::vector<TimePoint> sendTimes; // of transport.sent
+
+			void Receive(std::vector<DnsRecord> answers, std::vector<DnsRecord> additionals = {})
+			{
+				DnsMessage response;
+				response.flags = kDnsFlagResponse;
+				response.answers = std::move(answers);
+				response.additionals = std::move(additionals);
+
+				auto packet = SerializeDnsMessage(response);
+				querier.OnPacket(packet.data(), packet.size());
+			}
+
+			// polls whenever the querier asks for it, like the plugin's timer does
+			void RunUntil(const TimePoint end)
+			{
+				for (auto due = querier.GetNextDue(); due.has_value() && due.value() <= end; due = querier.GetNextDue()) {
+					now = std::max(now, due.value());
+					const auto sent = transport.sent.size();
+					querier.Poll();
+					sendTimes.insert(sendTimes.end(), transport.sent.size() - sent, now);
+				}
+				now = end;
+			}
+
+			DnsMessage GetLastQuery()
+			{
+				EXPECT_FALSE(transport.sent.empty());
+				auto& packet = transport.sent.back();
+				return ParseDnsMessage(packet.data(), packet.size()).value();
+			}
+
+			static bool Asks(const DnsMessage& query, const std::string& name, const DnsType type)
+			{
+				return std::any_of(query.questions.begin(), query.questions.end(), [&](const DnsQuestion& question) -> bool {
+					return question.name == name && question.type == type;
+					});
+			}
+		};
+	}
+
+	TEST_F(MdnsQuerierTest, BacksOffBrowseQueries)
+	{
+		querier.Browse(kServiceType);
+
+		// a random delay of 20-120 ms first, then intervals starting at one second and doubling
+		RunUntil(now + 4h);
+
+		ASSERT_GE(sendTimes.size(), 15u); // the last ones an hour apart
+		EXPECT_GE(sendTimes[0], TimePoint() + 20ms);
+		EXPECT_LE(sendTimes[0], TimePoint() + 120ms);
+
+		auto interval = 1s;
+		for (size_t i = 1; i < sendTimes.size(); i++) {
+			EXPECT_EQ(sendTimes[i] - sendTimes[i - 1], std::chrono::steady_clock::duration(interval)) << i;
+			interval = std::min<std::chrono::seconds>(interval * 2, 1h);
+		}
+
+		auto query = GetLastQuery();
+		EXPECT_FALSE(query.IsResponse());
+		EXPECT_TRUE(Asks(query, kServiceType, DnsType::PTR));
+	}
+
+	TEST_F(MdnsQuerierTest, ReportsFoundAndLostInstances)
+	{
+		const auto browseId = querier.Browse(kServiceType);
+		RunUntil(now + 1s);
+
+		Receive({ CreatePtrRecord(120) });
+		Receive({ CreatePtrRecord(120) }); // repeated answer
+
+		ASSERT_EQ(listener.browseResults.size(), 1u);
+		EXPECT_EQ(listener.browseResults[0], std::make_tuple(browseId, std::string(kInstanceName), true));
+
+		// no refresh answers: gone once the TTL has run out
+		RunUntil(now + 121s);
+
+		ASSERT_EQ(listener.browseResults.size(), 2u);
+		EXPECT_EQ(listener.browseResults[1], std::make_tuple(browseId, std::string(kInstanceName), false));
+		EXPECT_EQ(querier.GetCache().Size(), 0u);
+	}
+
+	TEST_F(MdnsQuerierTest, ReportsGoodbyesAfterOneSecond)
+	{
+		querier.Browse(kServiceType);
+		RunUntil(now + 1s);
+
+		Receive({ CreatePtrRecord(4500) });
+		Receive({ CreatePtrRecord(0) });
+		EXPECT_EQ(listener.browseResults.size(), 1u); // kept for a second, in case it is announced again right away
+
+		RunUntil(now + 999ms);
+		EXPECT_EQ(listener.browseResults.size(), 1u);
+
+		RunUntil(now + 1ms);
+		ASSERT_EQ(listener.browseResults.size(), 2u);
+		EXPECT_FALSE(std::get<2>(listener.browseResults[1]));
+	}
+
+	TEST_F(MdnsQuerierTest, RefreshesAnswersBeforeTheyExpire)
+	{
+		querier.Browse(kServiceType);
+		RunUntil(now + 1s);
+
+		const auto received = now;
+		Receive({ CreatePtrRecord(10) });
+
+		sendTimes.clear();
+		RunUntil(received + 10s);
+
+		// the backoff has queries due at 3 s and 7 s, the refreshes come at 80, 85, 90 and 95% of the TTL
+		std::vector<TimePoint> refreshes;
+		std::copy_if(sendTimes.begin(), sendTimes.end(), std::back_inserter(refreshes), [received](const TimePoint time) -> bool {
+			return time >= received + 8s;
+			});
+
+		ASSERT_EQ(refreshes.size(), 4u);
+		for (size_t i = 0; i < refreshes.size(); i++) {
+			const auto percent = 80 + 5 * static_cast<int>(i);
+			EXPECT_GE(refreshes[i], received + std::chrono::milliseconds(percent * 100)) << percent;
+			EXPECT_LE(refreshes[i], received + std::chrono::milliseconds((percent + 2) * 100)) << percent; // up to 2% jitter
+		}
+
+		EXPECT_EQ(listener.browseResults.size(), 2u); // found, then lost at 10 s
+	}
+
+	TEST_F(MdnsQuerierTest, ListsKnownAnswersInQueries)
+	{
+		querier.Browse(kServiceType);
+		RunUntil(now + 1s);
+
+		Receive({ CreatePtrRecord(4500) });
+
+		RunUntil(now + 2s); // next backoff query
+
+		auto query = GetLastQuery();
+		ASSERT_TRUE(Asks(query, kServiceType, DnsType::PTR));
+		ASSERT_EQ(query.answers.size(), 1u);
+		EXPECT_EQ(query.answers[0].target, kInstanceName);
+		EXPECT_LT(query.answers[0].ttl, 4500u); // the remaining TTL
+		EXPECT_GT(query.answers[0].ttl, 4490u);
+		EXPECT_FALSE(query.answers[0].cacheFlush);
+	}
+
+	TEST_F(MdnsQuerierTest, LeavesOutAnswersPastHalfTheirTtl)
+	{
+		querier.Browse(kServiceType);
+		RunUntil(now + 1s);
+
+		const auto received = now;
+		Receive({ CreatePtrRecord(8) });
+
+		const auto sent = transport.sent.size();
+		RunUntil(received + 7s); // the refreshes from 80% of the TTL on are past half of it
+
+		ASSERT_GT(transport.sent.size(), sent);
+		auto query = GetLastQuery();
+		EXPECT_TRUE(Asks(query, kServiceType, DnsType::PTR));
+		EXPECT_TRUE(query.answers.empty());
+	}
+
+	TEST_F(MdnsQuerierTest, ResolvesWithTheAddressRecords)
+	{
+		const auto resolveId = querier.Resolve(kInstanceName);
+		querier.Poll();
+
+		auto query = GetLastQuery();
+		EXPECT_TRUE(Asks(query, kInstanceName, DnsType::SRV));
+		EXPECT_TRUE(Asks(query, kInstanceName, DnsType::TXT));
+
+		Receive({ CreateSrvRecord(120), CreateTxtRecord(4500) }, {
+			CreateAddressRecord(DnsType::A, { 192, 168, 1, 23 }),
+			CreateAddressRecord(DnsType::AAAA, { 0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 }),
+			});
+
+		ASSERT_EQ(listener.resolveResults.size(), 1u);
+
+		const auto& [id, instance] = listener.resolveResults[0];
+		EXPECT_EQ(id, resolveId);
+		EXPECT_EQ(instance.instanceName, kInstanceName);
+		EXPECT_EQ(instance.host, "printer.local");
+		EXPECT_EQ(instance.port, 631);
+		EXPECT_EQ(instance.txt, CreateTxtRecord(0).data);
+		EXPECT_EQ(instance.addresses, (std::vector<std::string>{ "192.168.1.23", "fe80::1" }));
+		EXPECT_EQ(instance.ttl, 120u);
+
+		// done, no more queries
+		EXPECT_FALSE(querier.GetNextDue().has_value() && querier.GetNextDue().value() < now + 100s);
+	}
+
+	TEST_F(MdnsQuerierTest, AsksForMissingAddressesBeforeResolving)
+	{
+		querier.Resolve(kInstanceName);
+		querier.Poll();
+
+		Receive({ CreateSrvRecord(120), CreateTxtRecord(120) });
+		EXPECT_TRUE(listener.resolveResults.empty()); // addresses get a second of their own
+
+		RunUntil(now + 1s - 1ms);
+		auto query = GetLastQuery();
+		EXPECT_TRUE(Asks(query, "printer.local", DnsType::A));
+		EXPECT_TRUE(Asks(query, "printer.local", DnsType::AAAA));
+		EXPECT_TRUE(listener.resolveResults.empty());
+
+		Receive({ CreateAddressRecord(DnsType::A, { 192, 168, 1, 23 }) });
+
+		ASSERT_EQ(listener.resolveResults.size(), 1u);
+		EXPECT_EQ(listener.resolveResults[0].second.addresses, std::vector<std::string>{ "192.168.1.23" });
+	}
+
+	TEST_F(MdnsQuerierTest, ResolvesWithoutAddressesAfterTheGracePeriod)
+	{
+		querier.Resolve(kInstanceName);
+		querier.Poll();
+
+		Receive({ CreateSrvRecord(120), CreateTxtRecord(120) });
+		RunUntil(now + 1s);
+
+		ASSERT_EQ(listener.resolveResults.size(), 1u);
+		EXPECT_TRUE(listener.resolveResults[0].second.addresses.empty());
+	}
+
+	TEST_F(MdnsQuerierTest, IgnoresQueriesOfOtherHosts)
+	{
+		querier.Browse(kServiceType);
+
+		DnsMessage query;
+		query.questions.push_back({ kServiceType, DnsType::PTR });
+		query.answers.push_back(CreatePtrRecord(120)); // a known answer of another querier
+
+		auto packet = SerializeDnsMessage(query);
+		querier.OnPacket(packet.data(), packet.size());
+
+		EXPECT_EQ(querier.GetCache().Size(), 0u);
+		EXPECT_TRUE(listener.browseResults.empty());
+	}
+}
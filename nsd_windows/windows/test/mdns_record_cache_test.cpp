@@ -0,0 +1,157 @@
+#include "mdns_record_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using namespace std::chrono_literals;
+
+		DnsRecord CreatePtrRecord(const std::string& target, const uint32_t ttl)
+		{
+			DnsRecord record;
+			record.name = "_http._tcp.local";
+			record.type = DnsType::PTR;
+			record.ttl = ttl;
+			record.target = target;
+			return record;
+		}
+
+		DnsRecord CreateARecord(const uint8_t lastByte, const uint32_t ttl, const bool cacheFlush = false)
+		{
+			DnsRecord record;
+			record.name = "printer.local";
+			record.type = DnsType::A;
+			record.ttl = ttl;
+			record.cacheFlush = cacheFlush;
+			record.data = { 192, 168, 1, lastByte };
+			return record;
+		}
+
+		class MdnsRecordCacheTest : public testing::Test {
+		protected:
+
+			MdnsRecordCache cache{ 1 };
+			std::chrono::steady_clock::time_point start;
+
+			const CachedRecord& FindOnly(const std::string& name, const DnsType type)
+			{
+				auto found = cache.Find(name, type);
+				EXPECT_EQ(found.size(), 1u);
+				return *found.front();
+			}
+		};
+	}
+
+	TEST_F(MdnsRecordCacheTest, TellsNewRecordsFromRefreshes)
+	{
+		EXPECT_TRUE(cache.Add(CreatePtrRecord("A._http._tcp.local", 120), start));
+		EXPECT_FALSE(cache.Add(CreatePtrRecord("a._HTTP._tcp.local", 120), start + 10s)); // names compare case-insensitively
+		EXPECT_TRUE(cache.Add(CreatePtrRecord("B._http._tcp.local", 120), start));
+
+		EXPECT_EQ(cache.Size(), 2u);
+		EXPECT_EQ(cache.Find("_HTTP._tcp.local", DnsType::PTR).size(), 2u);
+		EXPECT_TRUE(cache.Find("_http._tcp.local", DnsType::SRV).empty());
+
+		// the refresh restarts the TTL
+		EXPECT_EQ(cache.Expire(start + 120s).size(), 1u);
+		EXPECT_EQ(FindOnly("_http._tcp.local", DnsType::PTR).record.target, "A._http._tcp.local");
+	}
+
+	TEST_F(MdnsRecordCacheTest, RefreshesAt80To95PercentOfTheTtl)
+	{
+		cache.Add(CreatePtrRecord("A._http._tcp.local", 100), start);
+
+		auto& cached = *cache.Find("_http._tcp.local", DnsType::PTR).front();
+
+		for (auto percent : { 80, 85, 90, 95 }) {
+			auto refresh = cached.GetNextRefresh();
+			ASSERT_TRUE(refresh.has_value());
+
+			// plus up to 2% of jitter, so that queriers don't refresh in lockstep
+			EXPECT_GE(refresh.value(), start + std::chrono::seconds(percent));
+			EXPECT_LE(refresh.value(), start + std::chrono::seconds(percent + 2));
+
+			cached.refreshes++;
+		}
+
+		EXPECT_FALSE(cached.GetNextRefresh().has_value());
+
+		// an answer restarts the refreshes
+		cache.Add(CreatePtrRecord("A._http._tcp.local", 100), start + 96s);
+		EXPECT_GE(cached.GetNextRefresh().value(), start + 96s + 80s);
+	}
+
+	TEST_F(MdnsRecordCacheTest, ExpiresRecordsAfterTheirTtl)
+	{
+		cache.Add(CreatePtrRecord("A._http._tcp.local", 100), start);
+		cache.Add(CreatePtrRecord("B._http._tcp.local", 200), start);
+
+		EXPECT_EQ(cache.GetNextExpiry(), start + 100s);
+		EXPECT_TRUE(cache.Expire(start + 99s).empty());
+
+		auto expired = cache.Expire(start + 100s);
+		ASSERT_EQ(expired.size(), 1u);
+		EXPECT_EQ(expired[0].target, "A._http._tcp.local");
+
+		EXPECT_EQ(cache.Size(), 1u);
+		EXPECT_EQ(cache.GetNextExpiry(), start + 200s);
+		EXPECT_EQ(FindOnly("_http._tcp.local", DnsType::PTR).GetRemainingTtl(start + 150s), 50u);
+	}
+
+	TEST_F(MdnsRecordCacheTest, KeepsGoodbyesForAnotherSecond)
+	{
+		cache.Add(CreatePtrRecord("A._http._tcp.local", 4500), start);
+
+		EXPECT_FALSE(cache.Add(CreatePtrRecord("A._http._tcp.local", 0), start + 10s));
+
+		// still there, so a quick re-announcement doesn't look like a new service, but no longer refreshed
+		EXPECT_EQ(cache.Size(), 1u);
+		EXPECT_FALSE(FindOnly("_http._tcp.local", DnsType::PTR).GetNextRefresh().has_value());
+		EXPECT_EQ(cache.GetNextExpiry(), start + 11s);
+
+		EXPECT_TRUE(cache.Expire(start + 10500ms).empty());
+		EXPECT_EQ(cache.Expire(start + 11s).size(), 1u);
+		EXPECT_EQ(cache.Size(), 0u);
+	}
+
+	TEST_F(MdnsRecordCacheTest, IgnoresGoodbyesOfUnknownRecords)
+	{
+		EXPECT_FALSE(cache.Add(CreatePtrRecord("A._http._tcp.local", 0), start));
+		EXPECT_EQ(cache.Size(), 0u);
+		EXPECT_FALSE(cache.GetNextExpiry().has_value());
+	}
+
+	TEST_F(MdnsRecordCacheTest, CacheFlushOutdatesTheRestOfTheSet)
+	{
+		cache.Add(CreateARecord(23, 120), start);
+		cache.Add(CreateARecord(24, 120), start);
+
+		// records received within the last second belong to the same announcement and stay
+		cache.Add(CreateARecord(25, 120, true), start + 500ms);
+		EXPECT_EQ(cache.GetNextExpiry(), start + 120s);
+
+		cache.Add(CreateARecord(26, 120, true), start + 5s);
+		EXPECT_EQ(cache.GetNextExpiry(), start + 6s);
+
+		auto expired = cache.Expire(start + 6s);
+		EXPECT_EQ(expired.size(), 3u);
+
+		auto& remaining = FindOnly("printer.local", DnsType::A);
+		EXPECT_EQ(remaining.record.data, (std::vector<uint8_t>{ 192, 168, 1, 26 }));
+	}
+
+	TEST_F(MdnsRecordCacheTest, ListsKnownAnswersWhileHalfTheTtlRemains)
+	{
+		cache.Add(CreatePtrRecord("A._http._tcp.local", 100), start);
+		auto& cached = FindOnly("_http._tcp.local", DnsType::PTR);
+
+		EXPECT_TRUE(cached.IsKnownAnswer(start));
+		EXPECT_TRUE(cached.IsKnownAnswer(start + 49s));
+		EXPECT_FALSE(cached.IsKnownAnswer(start + 50s));
+	}
+}
@@ -0,0 +1,461 @@
+#include "dns_message.h"
+#include "fake_mdns_transport.h"
+#include "mdns_querier.h"
+#include "mdns_responder.h"
+#include "nsd_error.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using namespace std::chrono_literals;
+		using TimePoint = std::chrono::steady_clock::time_point;
+
+		constexpr MdnsEndpoint kQuerier{ 0xC0A80117, 5353 }; // 192.168.1.23
+
+		DnsMessage Parse(const std::vector<uint8_t>& packet)
+		{
+			auto message = ParseDnsMessage(packet.data(), packet.size());
+			EXPECT_TRUE(message.has_value());
+			return message.value_or(DnsMessage());
+		}
+
+		const DnsRecord* Find(const std::vector<DnsRecord>& records, const std::string& name, const DnsType type)
+		{
+			auto it = std::find_if(records.begin(), records.end(), [&](const DnsRecord& record) -> bool {
+				return record.name == name && record.type == type;
+				});
+			return it == records.end() ? nullptr : &*it;
+		}
+
+		class MdnsResponderTest : public testing::Test {
+		protected:
+
+			FakeMdnsTransport transport;
+			TimePoint now;
+			MdnsResponder responder{ transport, [this]() { return now; }, 42 };
+
+			void SetUp() override {
+				responder.SetHost("desktop.local", { { 192, 168, 1, 10 } });
+			}
+
+			uint64_t Register(const std::string& name, const std::string& type = "_http._tcp") {
+				MdnsServiceRegistration registration;
+				registration.name = name;
+				registration.type = type;
+				registration.port = 8080;
+				registration.txt = { 4, 'p', '=', '/', 'x' };
+				return responder.Register(registration);
+			}
+
+			// announces the registered services, then lets the announcements age past the one second limit
+			void RegisterAndAnnounce(const std::vector<std::string>& names) {
+				for (const auto& name : names) {
+					Register(name);
+				}
+				RunUntilIdle();
+				now += 2s;
+				transport.sent.clear();
+			}
+
+			void Query(const std::vector<DnsQuestion>& questions, const std::vector<DnsRecord>& knownAnswers = {}) {
+				DnsMessage query;
+				query.questions = questions;
+				query.answers = knownAnswers;
+
+				auto packet = SerializeDnsMessage(query);
+				responder.OnPacket(packet.data(), packet.size(), kQuerier);
+			}
+
+			// polls at every due time until nothing is left to send
+			void RunUntilIdle() {
+				for (auto due = responder.GetNextDue(); due.has_value(); due = responder.GetNextDue()) {
+					now = std::max(now, due.value());
+					responder.Poll();
+				}
+			}
+
+			std::vector<DnsMessage> GetSentMessages() const {
+				std::vector<DnsMessage> messages;
+				for (const auto& packet : transport.sent) {
+					messages.push_back(Parse(packet));
+				}
+				return messages;
+			}
+		};
+	}
+
+	TEST_F(MdnsResponderTest, RejectsInvalidAndDuplicateRegistrations)
+	{
+		Register("My Printer");
+
+		try {
+			Register("my printer");
+			FAIL();
+		}
+		catch (const NsdError& error) {
+			EXPECT_EQ(error.errorCause, ErrorCause::ALREADY_ACTIVE);
+		}
+
+		for (const auto& [name, type] : std::map<std::string, std::string>{ { "", "_http._tcp" }, { "a", "_http" }, { std::string(64, 'a'), "_http._tcp" } }) {
+			try {
+				Register(name, type);
+				FAIL() << name << " " << type;
+			}
+			catch (const NsdError& error) {
+				EXPECT_EQ(error.errorCause, ErrorCause::ILLEGAL_ARGUMENT);
+			}
+		}
+
+		EXPECT_EQ(responder.GetServiceCount(), 1u);
+	}
+
+	// registering many services at once must neither flood the network nor send oversized packets
+	TEST_F(MdnsResponderTest, AnnouncesManyServicesRateLimited)
+	{
+		constexpr int kServices = 1000;
+
+		for (int i = 0; i < kServices; i++) {
+			Register("Service " + std::to_string(i));
+		}
+
+		const auto start = now;
+		RunUntilIdle();
+
+		std::map<std::string, int> announcements; // instance name -> count
+		for (const auto& message : GetSentMessages()) {
+			for (const auto& record : message.answers) {
+				if (record.type == DnsType::SRV) {
+					announcements[record.name]++;
+				}
+			}
+		}
+
+		ASSERT_EQ(announcements.size(), static_cast<size_t>(kServices));
+		for (const auto& [name, count] : announcements) {
+			EXPECT_EQ(count, 2) << name;
+		}
+
+		for (const auto& packet : transport.sent) {
+			EXPECT_LE(packet.size(), 1400u);
+		}
+
+		// 20 packets per second after a burst of 10
+		const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(now - start).count();
+		EXPECT_LE(transport.sent.size(), 10 + 20 * seconds + 1);
+	}
+
+	TEST_F(MdnsResponderTest, SendsGoodbyesForUnregisteredServices)
+	{
+		const auto first = Register("First");
+		const auto second = Register("Second");
+		RunUntilIdle();
+		transport.sent.clear();
+
+		responder.Unregister(first);
+		responder.Unregister(second);
+		responder.Unregister(second); // unknown by now
+		RunUntilIdle();
+
+		const auto messages = GetSentMessages();
+		ASSERT_EQ(messages.size(), 1u); // aggregated
+
+		auto serviceTypeGoodbye = false;
+		for (const auto& record : messages[0].answers) {
+			EXPECT_EQ(record.ttl, 0u);
+			serviceTypeGoodbye = serviceTypeGoodbye || record.name == "_services._dns-sd._udp.local";
+		}
+		EXPECT_EQ(messages[0].answers.size(), 7u); // PTR, SRV, TXT each and the last of the type
+		EXPECT_TRUE(serviceTypeGoodbye);
+		EXPECT_EQ(responder.GetServiceCount(), 0u);
+	}
+
+	TEST_F(MdnsResponderTest, AnswersBrowsesWithTheServiceAndHostRecordsInOnePacket)
+	{
+		RegisterAndAnnounce({ "Printer" });
+		const auto received = now;
+
+		Query({ { "_http._tcp.local", DnsType::PTR } });
+		RunUntilIdle();
+
+		// shared answers are delayed by 20-120 ms
+		EXPECT_GE(now, received + 20ms);
+		EXPECT_LE(now, received + 120ms);
+
+		const auto messages = GetSentMessages();
+		ASSERT_EQ(messages.size(), 1u);
+		const auto& response = messages[0];
+		EXPECT_TRUE(response.IsResponse());
+
+		ASSERT_EQ(response.answers.size(), 1u);
+		EXPECT_EQ(response.answers[0].type, DnsType::PTR);
+		EXPECT_EQ(response.answers[0].target, "Printer._http._tcp.local");
+		EXPECT_FALSE(response.answers[0].cacheFlush);
+
+		const auto srv = Find(response.additionals, "Printer._http._tcp.local", DnsType::SRV);
+		ASSERT_NE(srv, nullptr);
+		EXPECT_EQ(srv->target, "desktop.local");
+		EXPECT_EQ(srv->port, 8080);
+		EXPECT_TRUE(srv->cacheFlush);
+
+		const auto txt = Find(response.additionals, "Printer._http._tcp.local", DnsType::TXT);
+		ASSERT_NE(txt, nullptr);
+		EXPECT_EQ(txt->data, (std::vector<uint8_t>{ 4, 'p', '=', '/', 'x' }));
+
+		const auto a = Find(response.additionals, "desktop.local", DnsType::A);
+		ASSERT_NE(a, nullptr);
+		EXPECT_EQ(a->data, (std::vector<uint8_t>{ 192, 168, 1, 10 }));
+
+		EXPECT_EQ(response.additionals.size(), 3u);
+	}
+
+	TEST_F(MdnsResponderTest, AnswersUniqueRecordsRightAway)
+	{
+		RegisterAndAnnounce({ "Printer" });
+		const auto received = now;
+
+		Query({
+			{ "Printer._http._tcp.local", DnsType::SRV },
+			{ "Printer._http._tcp.local", DnsType::TXT },
+			{ "desktop.local", DnsType::A },
+			});
+
+		EXPECT_EQ(responder.GetNextDue(), received);
+		responder.Poll();
+
+		const auto messages = GetSentMessages();
+		ASSERT_EQ(messages.size(), 1u);
+
+		const auto& answers = messages[0].answers;
+		EXPECT_EQ(answers.size(), 3u);
+		EXPECT_NE(Find(answers, "Printer._http._tcp.local", DnsType::SRV), nullptr);
+		EXPECT_NE(Find(answers, "Printer._http._tcp.local", DnsType::TXT), nullptr);
+		EXPECT_NE(Find(answers, "desktop.local", DnsType::A), nullptr);
+
+		// the host record answers the query already, it isn't repeated as an additional
+		EXPECT_EQ(Find(messages[0].additionals, "desktop.local", DnsType::A), nullptr);
+	}
+
+	TEST_F(MdnsResponderTest, AggregatesAnswersToSeveralQueries)
+	{
+		RegisterAndAnnounce({ "First", "Second" });
+
+		Query({ { "First._http._tcp.local", DnsType::TXT }, { "_http._tcp.local", DnsType::PTR } });
+		now += 10ms;
+		Query({ { "_http._tcp.local", DnsType::PTR } }); // e.g. from another querier
+		RunUntilIdle();
+
+		const auto messages = GetSentMessages();
+		ASSERT_EQ(messages.size(), 1u);
+
+		std::set<std::string> instances;
+		for (const auto& answer : messages[0].answers) {
+			if (answer.type == DnsType::PTR) {
+				instances.insert(answer.target);
+			}
+		}
+		EXPECT_EQ(instances, (std::set<std::string>{ "First._http._tcp.local", "Second._http._tcp.local" }));
+		EXPECT_NE(Find(messages[0].answers, "First._http._tcp.local", DnsType::TXT), nullptr);
+		EXPECT_EQ(Find(messages[0].additionals, "First._http._tcp.local", DnsType::TXT), nullptr);
+		EXPECT_NE(Find(messages[0].additionals, "Second._http._tcp.local", DnsType::SRV), nullptr);
+	}
+
+	TEST_F(MdnsResponderTest, SuppressesKnownAnswers)
+	{
+		RegisterAndAnnounce({ "First", "Second" });
+
+		const auto knownAnswer = [](const std::string& instance, const uint32_t ttl) -> DnsRecord {
+			DnsRecord record;
+			record.name = "_http._tcp.local";
+			record.type = DnsType::PTR;
+			record.ttl = ttl;
+			record.target = instance + "._http._tcp.local";
+			return record;
+		};
+
+		// the querier knows both, but its TTL of the second is below half of the real one
+		Query({ { "_http._tcp.local", DnsType::PTR } }, { knownAnswer("First", 4500), knownAnswer("Second", 2000) });
+		RunUntilIdle();
+
+		auto messages = GetSentMessages();
+		ASSERT_EQ(messages.size(), 1u);
+		ASSERT_EQ(messages[0].answers.size(), 1u);
+		EXPECT_EQ(messages[0].answers[0].target, "Second._http._tcp.local");
+
+		// nothing left to answer
+		now += 2s;
+		transport.sent.clear();
+		Query({ { "_http._tcp.local", DnsType::PTR } }, { knownAnswer("First", 4000), knownAnswer("Second", 4000) });
+		EXPECT_FALSE(responder.GetNextDue().has_value());
+		EXPECT_TRUE(transport.sent.empty());
+	}
+
+	TEST_F(MdnsResponderTest, RepliesByUnicastToQuQuestions)
+	{
+		RegisterAndAnnounce({ "Printer" });
+
+		Query({ { "_http._tcp.local", DnsType::PTR, true } });
+
+		// not delayed, only the querier gets the reply
+		EXPECT_EQ(responder.GetNextDue(), now);
+		responder.Poll();
+
+		EXPECT_TRUE(transport.sent.empty());
+		ASSERT_EQ(transport.sentTo.size(), 1u);
+		EXPECT_EQ(transport.sentTo[0].first, kQuerier);
+
+		const auto response = Parse(transport.sentTo[0].second);
+		ASSERT_EQ(response.answers.size(), 1u);
+		EXPECT_EQ(response.answers[0].target, "Printer._http._tcp.local");
+		EXPECT_NE(Find(response.additionals, "Printer._http._tcp.local", DnsType::SRV), nullptr);
+		EXPECT_NE(Find(response.additionals, "desktop.local", DnsType::A), nullptr);
+	}
+
+	TEST_F(MdnsResponderTest, MulticastsQuAnswersNotMulticastWithinAQuarterOfTheirTtl)
+	{
+		RegisterAndAnnounce({ "Printer" });
+		now += 4500s / 4; // of the PTR record
+
+		Query({ { "_http._tcp.local", DnsType::PTR, true } });
+		RunUntilIdle();
+
+		EXPECT_TRUE(transport.sentTo.empty());
+		const auto messages = GetSentMessages();
+		ASSERT_EQ(messages.size(), 1u);
+		ASSERT_EQ(messages[0].answers.size(), 1u);
+		EXPECT_EQ(messages[0].answers[0].target, "Printer._http._tcp.local");
+
+		// multicast just now, the next one is answered by unicast again
+		now += 2s;
+		Query({ { "_http._tcp.local", DnsType::PTR, true } });
+		RunUntilIdle();
+		EXPECT_EQ(transport.sentTo.size(), 1u);
+		EXPECT_EQ(transport.sent.size(), 1u);
+	}
+
+	TEST_F(MdnsResponderTest, IgnoresResponsesAndOtherNames)
+	{
+		RegisterAndAnnounce({ "Printer" });
+
+		Query({ { "_ipp._tcp.local", DnsType::PTR }, { "laptop.local", DnsType::A }, { "Printer._http._tcp.local", DnsType::AAAA } });
+
+		DnsMessage response;
+		response.flags = kDnsFlagResponse;
+		response.questions.push_back({ "_http._tcp.local", DnsType::PTR });
+		auto packet = SerializeDnsMessage(response);
+		responder.OnPacket(packet.data(), packet.size(), kQuerier);
+
+		EXPECT_FALSE(responder.GetNextDue().has_value());
+	}
+
+	namespace {
+
+		class BrowseRecorder : public MdnsQuerierListener {
+		public:
+
+			std::set<std::string> found;
+			std::set<std::string> lost;
+
+			void OnBrowseResult(const uint64_t, const std::string& instanceName, const bool isFound) override {
+				(isFound ? found : lost).insert(instanceName);
+			}
+
+			void OnResolveResult(const uint64_t, const MdnsServiceInstance&) override {}
+		};
+
+		// a querier and a responder on the same in-memory link
+		class MdnsResponderLoadTest : public testing::Test {
+		protected:
+
+			static constexpr MdnsEndpoint kResponder{ 0xC0A8010A, 5353 }; // 192.168.1.10
+
+			FakeMdnsTransport querierTransport;
+			FakeMdnsTransport responderTransport;
+			BrowseRecorder listener;
+			TimePoint now;
+			MdnsQuerier querier{ querierTransport, listener, [this]() { return now; }, 1 };
+			MdnsResponder responder{ responderTransport, [this]() { return now; }, 42 };
+
+			// hands over the sent packets until both sides are quiet
+			void Deliver() {
+				while (!querierTransport.sent.empty() || !responderTransport.sent.empty() || !responderTransport.sentTo.empty()) {
+
+					auto queries = std::move(querierTransport.sent);
+					querierTransport.sent.clear();
+					for (const auto& packet : queries) {
+						responder.OnPacket(packet.data(), packet.size(), kQuerier);
+					}
+
+					auto responses = std::move(responderTransport.sent);
+					responderTransport.sent.clear();
+					for (auto& [destination, packet] : responderTransport.sentTo) {
+						responses.push_back(std::move(packet));
+					}
+					responderTransport.sentTo.clear();
+					for (const auto& packet : responses) {
+						querier.OnPacket(packet.data(), packet.size());
+					}
+				}
+			}
+
+			void RunUntil(const TimePoint end) {
+				for (;;) {
+					Deliver();
+
+					auto due = querier.GetNextDue();
+					const auto responderDue = responder.GetNextDue();
+					if (!due.has_value() || (responderDue.has_value() && responderDue.value() < due.value())) {
+						due = responderDue;
+					}
+
+					if (!due.has_value() || due.value() > end) {
+						break;
+					}
+
+					now = std::max(now, due.value());
+					querier.Poll();
+					responder.Poll();
+				}
+				now = end;
+			}
+		};
+	}
+
+	TEST_F(MdnsResponderLoadTest, QuerierFindsAndLosesThreeHundredServices)
+	{
+		constexpr int kServices = 300;
+
+		responder.SetHost("desktop.local", { { 192, 168, 1, 10 } });
+		querier.Browse("_http._tcp.local");
+
+		std::vector<uint64_t> ids;
+		for (int i = 0; i < kServices; i++) {
+			MdnsServiceRegistration registration;
+			registration.name = "Service " + std::to_string(i);
+			registration.type = "_http._tcp";
+			registration.port = static_cast<uint16_t>(8000 + i);
+			ids.push_back(responder.Register(registration));
+		}
+
+		RunUntil(now + 30s);
+		EXPECT_EQ(listener.found.size(), static_cast<size_t>(kServices));
+		EXPECT_TRUE(listener.lost.empty());
+
+		for (const auto id : ids) {
+			responder.Unregister(id);
+		}
+
+		RunUntil(now + 30s);
+		EXPECT_EQ(listener.lost.size(), static_cast<size_t>(kServices));
+		EXPECT_EQ(listener.lost, listener.found);
+		EXPECT_EQ(responder.GetServiceCount(), 0u);
+	}
+}
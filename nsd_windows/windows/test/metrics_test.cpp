@@ -0,0 +1,137 @@
+#include "metrics.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace nsd_windows {
+
+	TEST(LatencyHistogramTest, BucketsStayWithinPrecision)
+	{
+		size_t previousIndex = 0;
+
+		for (uint64_t value = 0; value < (uint64_t{ 1 } << 20); value += 1 + value / 64) {
+
+			const auto index = LatencyHistogram::GetBucketIndex(value);
+			const auto limit = LatencyHistogram::GetBucketLimit(index);
+
+			ASSERT_LT(index, LatencyHistogram::kBucketCount);
+			ASSERT_GE(index, previousIndex) << value;
+			ASSERT_GE(limit, value);
+			ASSERT_LE(limit - value, value / 8) << value; // off by less than 12.5%
+			ASSERT_TRUE(index == 0 || LatencyHistogram::GetBucketLimit(index - 1) < value) << value;
+			previousIndex = index;
+		}
+
+		EXPECT_EQ(LatencyHistogram::GetBucketIndex(LatencyHistogram::kMaxValue), LatencyHistogram::kBucketCount - 1);
+		EXPECT_EQ(LatencyHistogram::GetBucketLimit(LatencyHistogram::kBucketCount - 1), LatencyHistogram::kMaxValue);
+	}
+
+	TEST(LatencyHistogramTest, SummarizesPercentiles)
+	{
+		LatencyHistogram histogram;
+		EXPECT_EQ(histogram.Summarize(false).count, 0u);
+
+		for (uint64_t value = 1; value <= 100; value++) {
+			histogram.Record(value * 1000);
+		}
+
+		const auto summary = histogram.Summarize(false);
+		EXPECT_EQ(summary.count, 100u);
+		EXPECT_EQ(summary.min, 1000u);
+		EXPECT_EQ(summary.max, 100000u);
+		EXPECT_EQ(summary.mean, 50500u);
+		EXPECT_GE(summary.p50, 50000u);
+		EXPECT_LE(summary.p50, 50000u * 9 / 8);
+		EXPECT_GE(summary.p90, 90000u);
+		EXPECT_LE(summary.p90, 90000u * 9 / 8);
+		EXPECT_GE(summary.p99, 99000u);
+		EXPECT_LE(summary.p99, 100000u); // at most max
+	}
+
+	TEST(LatencyHistogramTest, ResetsAndClamps)
+	{
+		LatencyHistogram histogram;
+		histogram.Record(std::chrono::milliseconds(3));
+		histogram.Record(std::chrono::steady_clock::duration(-1)); // clock went backwards
+
+		auto summary = histogram.Summarize(true);
+		EXPECT_EQ(summary.count, 2u);
+		EXPECT_EQ(summary.min, 0u);
+		EXPECT_EQ(summary.max, 3000u);
+		EXPECT_EQ(histogram.Summarize(false).count, 0u);
+
+		histogram.Record(UINT64_MAX);
+		summary = histogram.Summarize(false);
+		EXPECT_EQ(summary.max, LatencyHistogram::kMaxValue);
+		EXPECT_EQ(summary.p99, LatencyHistogram::kMaxValue);
+	}
+
+	TEST(StatusCounterTest, CountsByStatus)
+	{
+		StatusCounter counter;
+
+		counter.Record(0);
+		counter.Record(1460); // ERROR_TIMEOUT
+		counter.Record(0);
+
+		auto summary = counter.Summarize(true);
+		EXPECT_EQ(summary.total, 3u);
+		EXPECT_EQ(summary.failures, 1u);
+		EXPECT_EQ(summary.other, 0u);
+		EXPECT_EQ(summary.statuses, (std::vector<std::pair<uint32_t, uint64_t>>{ { 0, 2 }, { 1460, 1 } }));
+
+		// slots stay assigned, statuses without counts are left out
+		counter.Record(1460);
+		summary = counter.Summarize(false);
+		EXPECT_EQ(summary.statuses, (std::vector<std::pair<uint32_t, uint64_t>>{ { 1460, 1 } }));
+	}
+
+	TEST(StatusCounterTest, CountsStatusesBeyondTheSlotsAsOther)
+	{
+		StatusCounter counter;
+
+		for (uint32_t status = 0; status < StatusCounter::kSlots + 2; status++) {
+			counter.Record(status);
+		}
+
+		const auto summary = counter.Summarize(false);
+		EXPECT_EQ(summary.statuses.size(), StatusCounter::kSlots);
+		EXPECT_EQ(summary.other, 2u);
+		EXPECT_EQ(summary.total, StatusCounter::kSlots + 2);
+		EXPECT_EQ(summary.failures, StatusCounter::kSlots + 1);
+	}
+
+	TEST(MetricsTest, RecordsFromSeveralThreads)
+	{
+		constexpr int kThreads = 4;
+		constexpr int kRecords = 100000;
+
+		OperationMetrics metrics;
+
+		std::vector<std::thread> threads;
+		for (int thread = 0; thread < kThreads; thread++) {
+			threads.emplace_back([&metrics, thread]() {
+				for (int i = 0; i < kRecords; i++) {
+					metrics.statuses.Record(static_cast<uint32_t>((i + thread) % 3));
+					metrics.latency.Record(static_cast<uint64_t>(i));
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		const auto statuses = metrics.statuses.Summarize(false);
+		EXPECT_EQ(statuses.total, static_cast<uint64_t>(kThreads * kRecords));
+		EXPECT_EQ(statuses.statuses.size(), 3u);
+		EXPECT_EQ(statuses.other, 0u);
+
+		const auto latency = metrics.latency.Summarize(false);
+		EXPECT_EQ(latency.count, static_cast<uint64_t>(kThreads * kRecords));
+		EXPECT_EQ(latency.min, 0u);
+		EXPECT_EQ(latency.max, static_cast<uint64_t>(kRecords - 1));
+	}
+}
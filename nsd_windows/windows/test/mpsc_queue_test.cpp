@@ -0,0 +1,93 @@
+#include "mpsc_queue.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	TEST(MpscQueueTest, PopsInPushOrder)
+	{
+		MpscQueue<int> queue;
+		EXPECT_FALSE(queue.Pop().has_value());
+
+		for (int i = 0; i < 3; i++) {
+			queue.Push(i);
+		}
+
+		for (int i = 0; i < 3; i++) {
+			EXPECT_EQ(queue.Pop(), i);
+		}
+		EXPECT_FALSE(queue.Pop().has_value());
+
+		// the stub is reused once the queue has been drained
+		queue.Push(3);
+		EXPECT_EQ(queue.Pop(), 3);
+		EXPECT_FALSE(queue.Pop().has_value());
+	}
+
+	TEST(MpscQueueTest, DestroysRemainingElements)
+	{
+		auto value = std::make_shared<int>(0);
+		{
+			MpscQueue<std::shared_ptr<int>> queue;
+			queue.Push(value);
+			queue.Push(value);
+			EXPECT_EQ(value.use_count(), 3);
+		}
+		EXPECT_EQ(value.use_count(), 1);
+	}
+
+	// producers push concurrently while the consumer pops; every element must arrive exactly once and each
+	// producer's elements in the order they were pushed
+	TEST(MpscQueueTest, MultipleProducersStress)
+	{
+		constexpr int kProducers = 4;
+		constexpr int kPushesPerProducer = 200000;
+
+		MpscQueue<std::pair<int, int>> queue; // producer, sequence number
+
+		std::vector<std::thread> producers;
+		for (int producer = 0; producer < kProducers; producer++) {
+			producers.emplace_back([&queue, producer]() {
+				for (int i = 0; i < kPushesPerProducer; i++) {
+					queue.Push({ producer, i });
+					if (i % 1024 == 0) {
+						std::this_thread::yield(); // interleave on machines with few cores
+					}
+				}
+			});
+		}
+
+		std::vector<int> expected(kProducers, 0);
+		int received = 0;
+
+		while (received < kProducers * kPushesPerProducer) {
+
+			const auto element = queue.Pop();
+			if (!element.has_value()) {
+				std::this_thread::yield(); // empty, or a producer is in the middle of a push
+				continue;
+			}
+
+			const auto [producer, sequence] = *element;
+			ASSERT_GE(producer, 0);
+			ASSERT_LT(producer, kProducers);
+			ASSERT_EQ(sequence, expected[producer]) << "producer " << producer;
+			expected[producer]++;
+			received++;
+		}
+
+		for (auto& producer : producers) {
+			producer.join();
+		}
+
+		EXPECT_FALSE(queue.Pop().has_value());
+		for (const auto count : expected) {
+			EXPECT_EQ(count, kPushesPerProducer);
+		}
+	}
+}
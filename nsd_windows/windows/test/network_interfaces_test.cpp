@@ -0,0 +1,71 @@
+#include "network_interfaces.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using Indexes = std::vector<uint32_t>;
+
+		// canned adapter list as GetAdaptersAddresses reports it
+		const std::vector<NetworkInterface> kAvailable = {
+			{ 7, "Wi-Fi", true, false },
+			{ 1, "Loopback Pseudo-Interface 1", true, true },
+			{ 3, "Ethernet", true, false },
+			{ 12, "Bluetooth Network Connection", false, false },
+			{ 3, "Ethernet", true, false }, // reported twice, e.g. once per address family
+		};
+
+		InterfaceSelection CreateList(Indexes indexes)
+		{
+			InterfaceSelection selection;
+			selection.mode = InterfaceSelection::LIST;
+			selection.indexes = std::move(indexes);
+			return selection;
+		}
+	}
+
+	TEST(NetworkInterfacesTest, AnyLetsTheOsChoose)
+	{
+		EXPECT_EQ(SelectInterfaces(InterfaceSelection(), kAvailable), Indexes{ kAnyInterface });
+		EXPECT_EQ(SelectInterfaces(InterfaceSelection(), {}), Indexes{ kAnyInterface });
+	}
+
+	TEST(NetworkInterfacesTest, AllSelectsUpNonLoopbackInterfaces)
+	{
+		InterfaceSelection selection;
+		selection.mode = InterfaceSelection::ALL;
+
+		EXPECT_EQ(SelectInterfaces(selection, kAvailable), (Indexes{ 3, 7 }));
+		EXPECT_TRUE(SelectInterfaces(selection, {}).empty());
+	}
+
+	TEST(NetworkInterfacesTest, ListSelectsUsableRequestedInterfaces)
+	{
+		EXPECT_EQ(SelectInterfaces(CreateList({ 7, 1, 7 }), kAvailable), (Indexes{ 1, 7 })); // loopback if asked for
+		EXPECT_TRUE(SelectInterfaces(CreateList({ 12 }), kAvailable).empty()); // down
+		EXPECT_TRUE(SelectInterfaces(CreateList({ 42 }), kAvailable).empty()); // unknown
+		EXPECT_TRUE(SelectInterfaces(CreateList({ kAnyInterface }), kAvailable).empty());
+		EXPECT_TRUE(SelectInterfaces(CreateList({}), kAvailable).empty());
+	}
+
+	TEST(InterfaceSetTest, ReportsFirstAndLastInterface)
+	{
+		InterfaceSet set;
+		EXPECT_TRUE(set.Empty());
+
+		EXPECT_TRUE(set.Add(3)); // found
+		EXPECT_FALSE(set.Add(7));
+		EXPECT_FALSE(set.Add(3));
+
+		EXPECT_FALSE(set.Remove(3));
+		EXPECT_FALSE(set.Remove(42));
+		EXPECT_TRUE(set.Remove(7)); // lost
+		EXPECT_TRUE(set.Empty());
+
+		EXPECT_TRUE(set.Add(7)); // found again
+	}
+}
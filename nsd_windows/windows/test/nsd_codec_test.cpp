@@ -0,0 +1,196 @@
+#include "nsd_codec.h"
+
+#include <flutter/standard_message_codec.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using Bytes = std::vector<uint8_t>;
+
+		// standard codec type bytes, see standard_codec.cc in the client wrapper
+		constexpr uint8_t kInt32 = 3;
+		constexpr uint8_t kString = 7;
+		constexpr uint8_t kList = 12;
+		constexpr uint8_t kMap = 13;
+
+		const flutter::StandardMessageCodec& GetCodec()
+		{
+			return flutter::StandardMessageCodec::GetInstance(&NsdCodecSerializer::GetInstance());
+		}
+
+		Bytes Encode(const flutter::EncodableValue& value)
+		{
+			return *GetCodec().EncodeMessage(value);
+		}
+
+		// name -> bytes, from the file shared with the dart test (see NSD_WINDOWS_GOLDEN_EVENT_RECORDS)
+		std::map<std::string, Bytes> ReadGoldenRecords()
+		{
+			std::map<std::string, Bytes> records;
+			std::ifstream file(NSD_WINDOWS_GOLDEN_EVENT_RECORDS);
+
+			std::string line;
+			while (std::getline(file, line)) {
+				const auto colon = line.find(':');
+				if (line.empty() || line[0] == '#' || colon == std::string::npos) {
+					continue;
+				}
+
+				auto& bytes = records[line.substr(0, colon)];
+				std::istringstream hex(line.substr(colon + 1));
+				for (unsigned int byte; hex >> std::hex >> byte;) {
+					bytes.push_back(static_cast<uint8_t>(byte));
+				}
+			}
+			return records;
+		}
+
+		// the records behind the golden bytes; the dart test checks what they decode to
+		std::map<std::string, flutter::EncodableValue> CreateGoldenRecords()
+		{
+			const Bytes txt = { 5, 'r', 'p', '=', 'i', 'p' };
+
+			auto change = [](const char* name, const char* status) -> flutter::EncodableValue {
+				return CreateEventValue(EventRecord()
+					.Set(EventKey::SERVICE_NAME, name)
+					.Set(EventKey::SERVICE_TYPE, "_ipp._tcp")
+					.Set(EventKey::SERVICE_STATUS, status));
+			};
+
+			return {
+				{ "discovered", CreateEventValue(EventRecord()
+					.Set(EventKey::HANDLE, "h1")
+					.Set(EventKey::SERVICE_NAME, "Printer")
+					.Set(EventKey::SERVICE_TYPE, "_ipp._tcp")
+					.Set(EventKey::SERVICE_HOST, "printer.local")
+					.Set(EventKey::SERVICE_PORT, 631)
+					.Set(EventKey::SERVICE_TXT_RAW, txt)
+					.Set(EventKey::SERVICE_ADDRESSES, flutter::EncodableList{ flutter::EncodableValue("192.168.1.23"), flutter::EncodableValue("fe80::1") })
+					.Set(EventKey::SERVICE_INTERFACE_INDEX, 3)
+					.Set(EventKey::SERVICE_RESOLVED, true)) },
+				{ "failed", CreateEventValue(EventRecord()
+					.Set(EventKey::HANDLE, "h2")
+					.Set(EventKey::ERROR_CAUSE, "timeout")
+					.Set(EventKey::ERROR_MESSAGE, "Timed out")) },
+				{ "changes", CreateEventValue(EventRecord()
+					.Set(EventKey::HANDLE, "h3")
+					.Set(EventKey::SERVICE_CHANGES, flutter::EncodableList{ change("Printer", "found"), change("Scanner", "lost") })) },
+				{ "types", CreateEventValue(EventRecord()
+					.Set(EventKey::HANDLE, "h4")
+					.Set(EventKey::SERVICE_TYPES, flutter::EncodableMap{
+						{ flutter::EncodableValue("_http._tcp"), flutter::EncodableValue(2) },
+						{ flutter::EncodableValue("_ipp._tcp"), flutter::EncodableValue() },
+						})) },
+				{ "results", CreateEventValue(EventRecord()
+					.Set(EventKey::HANDLE, "h5")
+					.Set(EventKey::RESULTS, flutter::EncodableList{
+						CreateEventValue(EventRecord()
+							.Set(EventKey::HANDLE, "a")
+							.Set(EventKey::SERVICE_NAME, "Printer")
+							.Set(EventKey::SERVICE_TYPE, "_ipp._tcp")
+							.Set(EventKey::SERVICE_HOST, "printer.local")
+							.Set(EventKey::SERVICE_PORT, 631)
+							.Set(EventKey::SERVICE_TXT_RAW, Bytes())),
+						CreateEventValue(EventRecord()
+							.Set(EventKey::HANDLE, "b")
+							.Set(EventKey::ERROR_CAUSE, "illegalArgument")
+							.Set(EventKey::ERROR_MESSAGE, "Unknown handle")),
+						})) },
+				{ "streamed", CreateEventValue(EventRecord()
+					.Set(EventKey::HANDLE, "h6")
+					.Set(EventKey::SERVICE_NAME, "Printer")
+					.Set(EventKey::SERVICE_TYPE, "_ipp._tcp")
+					.Set(EventKey::EVENT, "onServiceLost")) },
+			};
+		}
+	}
+
+	TEST(NsdCodecTest, EncodesGoldenRecords)
+	{
+		const auto golden = ReadGoldenRecords();
+		const auto records = CreateGoldenRecords();
+		ASSERT_EQ(golden.size(), records.size()) << NSD_WINDOWS_GOLDEN_EVENT_RECORDS;
+
+		for (const auto& [name, record] : records) {
+			auto it = golden.find(name);
+			ASSERT_NE(it, golden.end()) << name;
+			EXPECT_EQ(Encode(record), it->second) << name;
+		}
+	}
+
+	TEST(NsdCodecTest, EncodesPresentKeysInKeyOrder)
+	{
+		const auto value = CreateEventValue(EventRecord()
+			.Set(EventKey::SERVICE_PORT, 80) // set out of order
+			.Set(EventKey::HANDLE, "h"));
+
+		const Bytes expected = {
+			NsdCodecSerializer::kEventRecordType, 0x11, 0x00, // HANDLE (0) and SERVICE_PORT (4)
+			kString, 1, 'h',
+			kInt32, 80, 0, 0, 0,
+		};
+		EXPECT_EQ(Encode(value), expected);
+	}
+
+	TEST(NsdCodecTest, EncodesKeysAboveTheFirstByte)
+	{
+		const auto value = CreateEventValue(EventRecord().Set(EventKey::ERROR_MESSAGE, "Timed out"));
+
+		const auto bytes = Encode(value);
+		ASSERT_GE(bytes.size(), 3u);
+		EXPECT_EQ(bytes[1], 0x00);
+		EXPECT_EQ(bytes[2], 1u << (static_cast<size_t>(EventKey::ERROR_MESSAGE) - 8));
+	}
+
+	TEST(NsdCodecTest, EncodesNestedRecords)
+	{
+		const auto value = CreateEventValue(EventRecord()
+			.Set(EventKey::RESULTS, flutter::EncodableList{
+				CreateEventValue(EventRecord().Set(EventKey::HANDLE, "a")),
+				CreateEventValue(EventRecord()),
+				}));
+
+		const auto resultsBit = 1u << static_cast<size_t>(EventKey::RESULTS);
+		const Bytes expected = {
+			NsdCodecSerializer::kEventRecordType, static_cast<uint8_t>(resultsBit), static_cast<uint8_t>(resultsBit >> 8),
+			kList, 2,
+			NsdCodecSerializer::kEventRecordType, 0x01, 0x00, kString, 1, 'a',
+			NsdCodecSerializer::kEventRecordType, 0x00, 0x00,
+		};
+		EXPECT_EQ(Encode(value), expected);
+	}
+
+	TEST(NsdCodecTest, PassesStandardValuesThrough)
+	{
+		const flutter::EncodableValue value(flutter::EncodableMap{
+			{ flutter::EncodableValue("handle"), flutter::EncodableValue("h") },
+			});
+
+		EXPECT_EQ(Encode(value), (Bytes{ kMap, 1, kString, 6, 'h', 'a', 'n', 'd', 'l', 'e', kString, 1, 'h' }));
+
+		// messages from the dart side are plain standard codec
+		const auto decoded = GetCodec().DecodeMessage(Encode(value));
+		ASSERT_NE(decoded, nullptr);
+		EXPECT_EQ(*decoded, value);
+	}
+
+	TEST(NsdCodecTest, GetsSetValues)
+	{
+		EventRecord record;
+		record.Set(EventKey::SERVICE_NAME, "Printer");
+
+		ASSERT_NE(record.Get(EventKey::SERVICE_NAME), nullptr);
+		EXPECT_EQ(std::get<std::string>(*record.Get(EventKey::SERVICE_NAME)), "Printer");
+		EXPECT_EQ(record.Get(EventKey::SERVICE_TYPE), nullptr);
+		EXPECT_EQ(record.GetKeys(), 1u << static_cast<size_t>(EventKey::SERVICE_NAME));
+	}
+}
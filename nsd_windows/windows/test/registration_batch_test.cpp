@@ -0,0 +1,126 @@
+#include "registration_batch.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		// items are service names, results are the error message, empty on success
+		using TestBatch = RegistrationBatch<std::string, std::string>;
+
+		std::vector<std::string> StartAll(TestBatch& batch)
+		{
+			std::vector<std::string> started;
+			for (auto next = batch.StartNext(); next.has_value(); next = batch.StartNext()) {
+				started.push_back(next->first);
+			}
+			return started;
+		}
+	}
+
+	TEST(RegistrationBatchTest, RunsAtMostMaxRunningItems)
+	{
+		TestBatch batch(2);
+		for (const auto handle : { "a", "b", "c", "d", "e" }) {
+			batch.Add(handle, std::string("Service ") + handle);
+		}
+
+		auto next = batch.StartNext();
+		ASSERT_TRUE(next.has_value());
+		EXPECT_EQ(next->first, "a");
+		EXPECT_EQ(next->second, "Service a");
+
+		EXPECT_EQ(StartAll(batch), std::vector<std::string>{ "b" });
+		EXPECT_EQ(batch.GetRunningCount(), 2u);
+		EXPECT_EQ(batch.GetQueuedCount(), 3u);
+
+		// a completed item frees its slot for the next queued one, in request order
+		EXPECT_TRUE(batch.Complete("b", ""));
+		EXPECT_EQ(StartAll(batch), std::vector<std::string>{ "c" });
+		EXPECT_TRUE(batch.Complete("a", ""));
+		EXPECT_TRUE(batch.Complete("c", ""));
+		EXPECT_EQ(StartAll(batch), (std::vector<std::string>{ "d", "e" }));
+		EXPECT_EQ(batch.GetQueuedCount(), 0u);
+		EXPECT_FALSE(batch.IsComplete());
+	}
+
+	TEST(RegistrationBatchTest, CompletesRunningItemsOnce)
+	{
+		TestBatch batch(1);
+		batch.Add("a", "Service a");
+		batch.Add("b", "Service b");
+		StartAll(batch);
+
+		EXPECT_FALSE(batch.Complete("x", "")); // unknown
+		EXPECT_FALSE(batch.Complete("b", "")); // still queued
+		EXPECT_TRUE(batch.Complete("a", "Failed"));
+		EXPECT_FALSE(batch.Complete("a", "")); // e.g. a late callback
+		EXPECT_EQ(batch.GetRunningCount(), 0u);
+
+		StartAll(batch);
+		EXPECT_TRUE(batch.Complete("b", ""));
+		EXPECT_TRUE(batch.IsComplete());
+		EXPECT_EQ(batch.TakeResults(), (std::vector<std::string>{ "Failed", "" }));
+	}
+
+	TEST(RegistrationBatchTest, ReportsResultsInRequestOrder)
+	{
+		TestBatch batch(16);
+		for (const auto handle : { "a", "b", "c" }) {
+			batch.Add(handle, handle);
+		}
+		StartAll(batch);
+
+		batch.Complete("c", "c done");
+		batch.Complete("a", "a done");
+		EXPECT_FALSE(batch.IsComplete());
+		batch.Complete("b", "b done");
+
+		ASSERT_TRUE(batch.IsComplete());
+		EXPECT_EQ(batch.TakeResults(), (std::vector<std::string>{ "a done", "b done", "c done" }));
+	}
+
+	TEST(RegistrationBatchTest, RejectsDuplicateHandles)
+	{
+		TestBatch batch(16);
+		batch.Add("a", "Service a");
+
+		try {
+			batch.Add("a", "Service a again");
+			FAIL();
+		}
+		catch (const NsdError& error) {
+			EXPECT_EQ(error.errorCause, ErrorCause::ILLEGAL_ARGUMENT);
+		}
+
+		EXPECT_EQ(StartAll(batch), std::vector<std::string>{ "a" });
+		EXPECT_EQ(batch.GetQueuedCount(), 0u);
+	}
+
+	TEST(RegistrationBatchTest, ItemsThatFailToStartFreeTheirSlot)
+	{
+		TestBatch batch(1);
+		batch.Add("a", "Service a");
+		batch.Add("b", "Service b");
+
+		auto next = batch.StartNext();
+		EXPECT_TRUE(batch.Complete(next->first, "Invalid name"));
+
+		next = batch.StartNext();
+		ASSERT_TRUE(next.has_value());
+		EXPECT_EQ(next->first, "b");
+	}
+
+	TEST(RegistrationBatchTest, EmptyBatchIsComplete)
+	{
+		TestBatch batch(16);
+
+		EXPECT_FALSE(batch.StartNext().has_value());
+		EXPECT_TRUE(batch.IsComplete());
+		EXPECT_TRUE(batch.TakeResults().empty());
+	}
+}
@@ -0,0 +1,90 @@
+#include "resolve_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using namespace std::chrono_literals;
+
+		class ResolveCacheTest : public testing::Test {
+		protected:
+
+			ResolveCache<std::string>::TimePoint now;
+			ResolveCache<std::string> cache{ 60s, [this]() { return now; } };
+		};
+	}
+
+	TEST_F(ResolveCacheTest, ServesFreshThenStaleEntries)
+	{
+		cache.Put("My Printer._ipp._tcp.local", "printer.local", 120s);
+
+		auto result = cache.Get("my printer._IPP._tcp.local");
+		ASSERT_TRUE(result.has_value());
+		EXPECT_EQ(result->value, "printer.local");
+		EXPECT_FALSE(result->stale);
+
+		now += 120s;
+		result = cache.Get("My Printer._ipp._tcp.local");
+		ASSERT_TRUE(result.has_value());
+		EXPECT_TRUE(result->stale);
+
+		now += 60s;
+		EXPECT_FALSE(cache.Get("My Printer._ipp._tcp.local").has_value());
+		EXPECT_EQ(cache.Size(), 0u); // dropped on access
+
+		const auto statistics = cache.GetStatistics();
+		EXPECT_EQ(statistics.hits, 1u);
+		EXPECT_EQ(statistics.staleHits, 1u);
+		EXPECT_EQ(statistics.misses, 1u);
+	}
+
+	TEST_F(ResolveCacheTest, ZeroTtlErasesTheEntry)
+	{
+		cache.Put("a._http._tcp.local", "a.local", 120s);
+		cache.Put("A._http._tcp.local", "a.local", 0s); // goodbye packet
+
+		EXPECT_FALSE(cache.Get("a._http._tcp.local").has_value());
+		EXPECT_EQ(cache.Size(), 0u);
+	}
+
+	TEST_F(ResolveCacheTest, UnusableEntriesCountAsMisses)
+	{
+		cache.Put("a._http._tcp.local", "", 120s); // e.g. without the addresses the caller needs
+
+		auto usable = [](const std::string& value) { return !value.empty(); };
+
+		EXPECT_FALSE(cache.Get("a._http._tcp.local", usable).has_value());
+		EXPECT_EQ(cache.Size(), 1u); // kept for other callers
+		EXPECT_TRUE(cache.Get("a._http._tcp.local").has_value());
+
+		auto statistics = cache.GetStatistics(true);
+		EXPECT_EQ(statistics.hits, 1u);
+		EXPECT_EQ(statistics.misses, 1u);
+
+		statistics = cache.GetStatistics();
+		EXPECT_EQ(statistics.hits, 0u);
+		EXPECT_EQ(statistics.misses, 0u);
+	}
+
+	TEST_F(ResolveCacheTest, SweepsEntriesPastMaxStaleOnInsertion)
+	{
+		for (int i = 0; i < 10; i++) {
+			cache.Put("old " + std::to_string(i), "host", 1s);
+		}
+
+		now += 61s + 1s;
+
+		// only new keys, the table grows until a sweep runs
+		for (int i = 0; i < 11; i++) {
+			cache.Put("new " + std::to_string(i), "host", 120s);
+		}
+
+		EXPECT_EQ(cache.Size(), 11u);
+		EXPECT_FALSE(cache.Get("old 0").has_value());
+		EXPECT_TRUE(cache.Get("new 9").has_value());
+	}
+}
@@ -0,0 +1,151 @@
+#include "resolve_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using namespace std::chrono_literals;
+		using Keys = std::vector<std::string>;
+		using Expired = std::vector<std::pair<std::string, ResolveScheduler::WaiterId>>;
+
+		class FakeExecutor : public ResolveExecutor {
+		public:
+
+			Keys started;
+			Keys aborted;
+
+			void ExecuteResolve(const std::string& key) override {
+				started.push_back(key);
+			}
+
+			void AbortResolve(const std::string& key) override {
+				aborted.push_back(key);
+			}
+		};
+
+		class ResolveSchedulerTest : public testing::Test {
+		protected:
+
+			FakeExecutor executor;
+			ResolveScheduler::TimePoint now;
+			ResolveScheduler scheduler{ executor, 2, [this]() { return now; } };
+		};
+	}
+
+	TEST_F(ResolveSchedulerTest, LimitsRunningResolves)
+	{
+		scheduler.Submit("a", 1, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("b", 2, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("c", 3, ResolvePriority::NORMAL, 5s);
+
+		EXPECT_EQ(executor.started, (Keys{ "a", "b" }));
+		EXPECT_EQ(scheduler.GetRunningCount(), 2u);
+		EXPECT_EQ(scheduler.GetQueuedCount(), 1u);
+		EXPECT_FALSE(scheduler.IsRunning("c"));
+
+		scheduler.Complete("a");
+
+		EXPECT_EQ(executor.started, (Keys{ "a", "b", "c" }));
+		EXPECT_TRUE(scheduler.IsRunning("c"));
+		EXPECT_FALSE(scheduler.IsRunning("a"));
+		EXPECT_EQ(scheduler.GetQueuedCount(), 0u);
+	}
+
+	TEST_F(ResolveSchedulerTest, StartsHigherPriorityFirst)
+	{
+		scheduler.Submit("running 1", 1, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("running 2", 2, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("low", 3, ResolvePriority::LOW, 5s);
+		scheduler.Submit("upgraded", 4, ResolvePriority::LOW, 5s);
+		scheduler.Submit("normal", 5, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("upgraded", 6, ResolvePriority::NORMAL, 5s); // a client asks for an auto resolve
+
+		scheduler.Complete("running 1");
+		scheduler.Complete("running 2");
+		scheduler.Complete("normal");
+
+		EXPECT_EQ(executor.started, (Keys{ "running 1", "running 2", "normal", "upgraded", "low" }));
+	}
+
+	TEST_F(ResolveSchedulerTest, SharesResolvesBetweenWaiters)
+	{
+		scheduler.Submit("a", 1, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("a", 2, ResolvePriority::NORMAL, 5s);
+
+		EXPECT_EQ(executor.started, Keys{ "a" });
+		EXPECT_EQ(scheduler.GetRunningCount(), 1u);
+
+		EXPECT_FALSE(scheduler.Cancel("a", 1)); // the other waiter keeps it running
+		EXPECT_TRUE(executor.aborted.empty());
+
+		EXPECT_TRUE(scheduler.Cancel("a", 2));
+		EXPECT_EQ(executor.aborted, Keys{ "a" });
+		EXPECT_EQ(scheduler.GetRunningCount(), 0u);
+		EXPECT_FALSE(scheduler.GetNextDeadline().has_value());
+	}
+
+	TEST_F(ResolveSchedulerTest, CancellingAQueuedKeyDoesNotAbort)
+	{
+		scheduler.Submit("a", 1, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("b", 2, ResolvePriority::NORMAL, 5s);
+		scheduler.Submit("c", 3, ResolvePriority::NORMAL, 5s);
+
+		EXPECT_TRUE(scheduler.Cancel("c", 3));
+		EXPECT_TRUE(executor.aborted.empty());
+		EXPECT_EQ(scheduler.GetQueuedCount(), 0u);
+
+		EXPECT_TRUE(scheduler.Cancel("unknown", 4));
+	}
+
+	TEST_F(ResolveSchedulerTest, ExpiresWaitersIndividually)
+	{
+		scheduler.Submit("a", 1, ResolvePriority::NORMAL, 1s);
+		scheduler.Submit("a", 2, ResolvePriority::NORMAL, 3s);
+		scheduler.Submit("b", 3, ResolvePriority::NORMAL, 2s);
+
+		EXPECT_EQ(scheduler.GetNextDeadline(), now + 1s);
+		EXPECT_TRUE(scheduler.ExpireDeadlines().empty());
+
+		now += 2s;
+		EXPECT_EQ(scheduler.ExpireDeadlines(), (Expired{ { "a", 1 }, { "b", 3 } }));
+		EXPECT_TRUE(scheduler.IsRunning("a")); // waiter 2 still waits
+		EXPECT_EQ(executor.aborted, Keys{ "b" });
+		EXPECT_EQ(scheduler.GetNextDeadline(), now + 1s);
+
+		now += 1s;
+		EXPECT_EQ(scheduler.ExpireDeadlines(), (Expired{ { "a", 2 } }));
+		EXPECT_EQ(executor.aborted, (Keys{ "b", "a" }));
+		EXPECT_EQ(scheduler.GetRunningCount(), 0u);
+		EXPECT_FALSE(scheduler.GetNextDeadline().has_value());
+	}
+
+	TEST_F(ResolveSchedulerTest, ExpiringFreesSlotsForQueuedKeys)
+	{
+		scheduler.Submit("a", 1, ResolvePriority::NORMAL, 1s);
+		scheduler.Submit("b", 2, ResolvePriority::NORMAL, 10s);
+		scheduler.Submit("c", 3, ResolvePriority::NORMAL, 10s);
+
+		now += 1s;
+		scheduler.ExpireDeadlines();
+
+		EXPECT_EQ(executor.started, (Keys{ "a", "b", "c" }));
+	}
+
+	TEST_F(ResolveSchedulerTest, CompleteDropsAllWaiters)
+	{
+		scheduler.Submit("a", 1, ResolvePriority::NORMAL, 1s);
+		scheduler.Submit("a", 2, ResolvePriority::NORMAL, 2s);
+
+		scheduler.Complete("a");
+
+		EXPECT_FALSE(scheduler.GetNextDeadline().has_value());
+		now += 5s;
+		EXPECT_TRUE(scheduler.ExpireDeadlines().empty());
+		EXPECT_TRUE(executor.aborted.empty());
+	}
+}
@@ -0,0 +1,132 @@
+#include "resolve_waiters.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		struct Waiter {
+
+			std::string handle;
+			IpLookupType ipLookupType = IpLookupType::NONE;
+		};
+
+		std::vector<std::string> GetHandles(const std::vector<Waiter>& waiters)
+		{
+			std::vector<std::string> handles;
+			for (const auto& waiter : waiters) {
+				handles.push_back(waiter.handle);
+			}
+			return handles;
+		}
+	}
+
+	TEST(ResolveWaitersTest, OnlyTheFirstWaiterStartsTheResolve)
+	{
+		ResolveWaiters<Waiter> waiters;
+		EXPECT_TRUE(waiters.Empty());
+
+		EXPECT_TRUE(waiters.Attach({ "a", IpLookupType::V4 }));
+		EXPECT_FALSE(waiters.Attach({ "b", IpLookupType::V4 }));
+		EXPECT_FALSE(waiters.Attach({ "c", IpLookupType::NONE }));
+		EXPECT_EQ(waiters.Size(), 3u);
+	}
+
+	TEST(ResolveWaitersTest, CoversTheLookupTypesOfAllWaiters)
+	{
+		ResolveWaiters<Waiter> waiters;
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::NONE);
+
+		waiters.Attach({ "a", IpLookupType::NONE });
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::NONE);
+
+		waiters.Attach({ "b", IpLookupType::V6 });
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::V6);
+
+		waiters.Attach({ "c", IpLookupType::V4 });
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::ANY);
+	}
+
+	TEST(ResolveWaitersTest, DetachesAllWaitersInAttachOrder)
+	{
+		ResolveWaiters<Waiter> waiters;
+		waiters.Attach({ "a", IpLookupType::V4 });
+		waiters.Attach({ "b", IpLookupType::V6 });
+		waiters.Attach({ "", IpLookupType::ANY }); // e.g. a cache refresh
+
+		EXPECT_EQ(GetHandles(waiters.DetachAll()), (std::vector<std::string>{ "a", "b", "" }));
+		EXPECT_TRUE(waiters.Empty());
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::NONE);
+
+		EXPECT_TRUE(waiters.Attach({ "c", IpLookupType::V4 })); // starts over
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::V4);
+	}
+
+	TEST(ResolveWaitersTest, DetachesMatchingWaitersOnly)
+	{
+		ResolveWaiters<Waiter> waiters;
+		waiters.Attach({ "a", IpLookupType::V4 });
+		waiters.Attach({ "b", IpLookupType::V6 });
+		waiters.Attach({ "c", IpLookupType::V4 });
+
+		auto detached = waiters.Detach([](const Waiter& waiter) -> bool {
+			return waiter.handle == "b";
+			});
+
+		EXPECT_EQ(GetHandles(detached), std::vector<std::string>{ "b" });
+		EXPECT_EQ(waiters.Size(), 2u);
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::V4); // no longer covers the detached waiter
+		EXPECT_EQ(GetHandles(waiters.DetachAll()), (std::vector<std::string>{ "a", "c" }));
+	}
+
+	TEST(ResolveWaitersTest, DetachingTheLastWaiterLeavesItEmpty)
+	{
+		ResolveWaiters<Waiter> waiters;
+		waiters.Attach({ "a", IpLookupType::V4 });
+
+		EXPECT_TRUE(waiters.Detach([](const Waiter& waiter) -> bool { return waiter.handle == "x"; }).empty());
+		EXPECT_FALSE(waiters.Empty());
+
+		EXPECT_EQ(waiters.Detach([](const Waiter& waiter) -> bool { return waiter.handle == "a"; }).size(), 1u);
+		EXPECT_TRUE(waiters.Empty());
+		EXPECT_EQ(waiters.GetIpLookupType(), IpLookupType::NONE);
+	}
+
+	TEST(ResolveWaitersTest, FindsWaiters)
+	{
+		ResolveWaiters<Waiter> waiters;
+		waiters.Attach({ "a", IpLookupType::V4 });
+		waiters.Attach({ "b", IpLookupType::V6 });
+
+		auto hasHandle = [](const std::string& handle) {
+			return [handle](const Waiter& waiter) -> bool {
+				return waiter.handle == handle;
+			};
+		};
+
+		EXPECT_TRUE(waiters.Contains(hasHandle("b")));
+		EXPECT_FALSE(waiters.Contains(hasHandle("c")));
+	}
+
+	TEST(ResolveWaitersTest, EachWaiterGetsTheFamiliesItAskedFor)
+	{
+		ResolveWaiters<Waiter> waiters;
+		waiters.Attach({ "a", IpLookupType::V4 });
+		waiters.Attach({ "b", IpLookupType::V6 });
+		waiters.Attach({ "c", IpLookupType::ANY });
+
+		// the shared result covers both families
+		EXPECT_TRUE(GetMissingAddressFamilies({ "192.168.1.23", "fe80::1" }, waiters.GetIpLookupType()).empty());
+
+		std::vector<std::vector<std::string>> delivered;
+		for (const auto& waiter : waiters.DetachAll()) {
+			delivered.push_back(FilterAddresses({ "192.168.1.23", "fe80::1" }, waiter.ipLookupType));
+		}
+
+		EXPECT_EQ(delivered, (std::vector<std::vector<std::string>>{ { "192.168.1.23" }, { "fe80::1" }, { "192.168.1.23", "fe80::1" } }));
+	}
+}
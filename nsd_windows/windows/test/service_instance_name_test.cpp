@@ -0,0 +1,93 @@
+#include "dns_message.h"
+#include "service_instance_name.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace nsd_windows {
+
+	TEST(ServiceInstanceNameTest, ParsesInstanceNames)
+	{
+		const auto name = ParseServiceInstanceName("My Printer._ipp._tcp.local");
+
+		ASSERT_TRUE(name.has_value());
+		EXPECT_EQ(name->instance, "My Printer");
+		EXPECT_EQ(name->subtype, "");
+		EXPECT_EQ(name->service, "_ipp");
+		EXPECT_EQ(name->protocol, "_tcp");
+		EXPECT_EQ(name->domain, "local");
+		EXPECT_EQ(name->GetType(), "_ipp._tcp");
+	}
+
+	TEST(ServiceInstanceNameTest, KeepsEscapesInInstances)
+	{
+		auto name = ParseServiceInstanceName("My\\.Printer\\\\2._ipp._tcp.local.");
+		ASSERT_TRUE(name.has_value());
+		EXPECT_EQ(name->instance, "My\\.Printer\\\\2");
+		EXPECT_EQ(name->domain, "local"); // without the root
+		EXPECT_EQ(UnescapeDnsLabel(name->instance), "My.Printer\\2");
+
+		name = ParseServiceInstanceName("My\\046Printer._ipp._tcp.local");
+		ASSERT_TRUE(name.has_value());
+		EXPECT_EQ(UnescapeDnsLabel(name->instance), "My.Printer");
+	}
+
+	TEST(ServiceInstanceNameTest, TakesUnescapedDotsAsPartOfTheInstance)
+	{
+		// the Windows DNS API doesn't escape instance names
+		const auto name = ParseServiceInstanceName("Printer v1.2._http._tcp.example.com");
+
+		ASSERT_TRUE(name.has_value());
+		EXPECT_EQ(name->instance, "Printer v1.2");
+		EXPECT_EQ(name->GetType(), "_http._tcp");
+		EXPECT_EQ(name->domain, "example.com");
+	}
+
+	TEST(ServiceInstanceNameTest, ParsesTypesAndSubtypes)
+	{
+		auto name = ParseServiceInstanceName("_airplay._TCP");
+		ASSERT_TRUE(name.has_value());
+		EXPECT_EQ(name->instance, "");
+		EXPECT_EQ(name->GetType(), "_airplay._TCP");
+		EXPECT_EQ(name->domain, "");
+
+		name = ParseServiceInstanceName("_color._sub._ipp._udp.local");
+		ASSERT_TRUE(name.has_value());
+		EXPECT_EQ(name->instance, "");
+		EXPECT_EQ(name->subtype, "_color");
+		EXPECT_EQ(name->GetType(), "_ipp._udp");
+
+		// the rightmost service and protocol count, the instance may look like a type
+		name = ParseServiceInstanceName("_x._tcp._ipp._tcp.local");
+		ASSERT_TRUE(name.has_value());
+		EXPECT_EQ(name->instance, "_x._tcp");
+		EXPECT_EQ(name->service, "_ipp");
+	}
+
+	TEST(ServiceInstanceNameTest, RejectsInvalidNames)
+	{
+		for (const auto name : { "", ".", "Printer.local", "Printer.ipp._tcp.local", "Printer.__tcp", "Printer._._tcp", "Printer.._ipp._tcp", ".Printer._ipp._tcp", "Printer._ipp._tcp..", "Printer._ipp._sctp.local" }) {
+			EXPECT_FALSE(ParseServiceInstanceName(name).has_value()) << name;
+		}
+	}
+
+	TEST(ServiceInstanceNameTest, UnescapesDnsLabels)
+	{
+		EXPECT_EQ(UnescapeDnsLabel("plain"), "plain");
+		EXPECT_EQ(UnescapeDnsLabel("a\\.b\\\\c"), "a.b\\c");
+		EXPECT_EQ(UnescapeDnsLabel("\\065\\000z"), std::string("A\0z", 3));
+		EXPECT_EQ(UnescapeDnsLabel("\\06"), "06"); // not three digits
+		EXPECT_EQ(UnescapeDnsLabel("trailing\\"), "trailing\\");
+		EXPECT_FALSE(UnescapeDnsLabel("\\256").has_value());
+		EXPECT_FALSE(UnescapeDnsLabel("a\\999").has_value());
+	}
+
+	TEST(ServiceInstanceNameTest, SplitsEscapedDnsNames)
+	{
+		EXPECT_EQ(SplitDnsName("My\\.Printer._ipp._tcp.local."), (std::vector<std::string>{ "My.Printer", "_ipp", "_tcp", "local" }));
+		EXPECT_EQ(SplitDnsName("a\\098c.d"), (std::vector<std::string>{ "abc", "d" }));
+		EXPECT_EQ(SplitDnsName("a\\256"), (std::vector<std::string>{ "a256" })); // beyond 255: an escaped digit
+		EXPECT_EQ(EscapeDnsLabel("My.Printer\\2"), "My\\.Printer\\\\2");
+	}
+}
@@ -0,0 +1,214 @@
+#include "service_journal.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		// values are the service names, keys the full instance names
+		using TestJournal = ServiceJournal<std::string>;
+
+		std::string GetKey(const std::string& name)
+		{
+			return name + "._ipp._tcp.local";
+		}
+
+		void Put(TestJournal& journal, const std::string& name)
+		{
+			journal.Put(GetKey(name), name);
+		}
+
+		void Remove(TestJournal& journal, const std::string& name)
+		{
+			journal.Remove(GetKey(name), name);
+		}
+
+		// name, or "-name" for tombstones
+		std::vector<std::string> Describe(const TestJournal::Page& page)
+		{
+			std::vector<std::string> changes;
+			for (const auto& change : page.changes) {
+				changes.push_back((change.present ? "" : "-") + *change.value);
+			}
+			return changes;
+		}
+
+		// all pages from the given version on, like the dart side does
+		std::pair<std::vector<std::string>, uint64_t> GetAllChanges(const TestJournal& journal, uint64_t since, const size_t limit)
+		{
+			std::vector<std::string> changes;
+			const auto includeRemoved = since > 0;
+
+			while (true) {
+				const auto page = journal.GetChanges(since, limit, includeRemoved);
+				EXPECT_FALSE(page.snapshotRequired);
+				EXPECT_LE(page.changes.size(), limit);
+
+				const auto described = Describe(page);
+				changes.insert(changes.end(), described.begin(), described.end());
+
+				since = page.next;
+				if (!page.more) {
+					return { changes, since };
+				}
+			}
+		}
+	}
+
+	TEST(ServiceJournalTest, PagesThroughASnapshot)
+	{
+		TestJournal journal;
+		for (const auto name : { "A", "B", "C", "D", "E" }) {
+			Put(journal, name);
+		}
+		Remove(journal, "C");
+
+		auto page = journal.GetChanges(0, 2, false);
+		EXPECT_EQ(Describe(page), (std::vector<std::string>{ "A", "B" }));
+		EXPECT_EQ(page.next, 2u);
+		EXPECT_TRUE(page.more);
+
+		// from scratch, so without tombstones
+		page = journal.GetChanges(page.next, 2, false);
+		EXPECT_EQ(Describe(page), (std::vector<std::string>{ "D", "E" }));
+		EXPECT_EQ(page.next, 5u);
+		EXPECT_TRUE(page.more); // C's tombstone follows
+
+		page = journal.GetChanges(page.next, 2, false);
+		EXPECT_TRUE(page.changes.empty());
+		EXPECT_EQ(page.next, journal.GetVersion());
+		EXPECT_FALSE(page.more);
+
+		EXPECT_EQ(journal.Size(), 4u);
+	}
+
+	TEST(ServiceJournalTest, MovesEntriesChangedWhilePagingToLaterPages)
+	{
+		TestJournal journal;
+		for (const auto name : { "A", "B", "C" }) {
+			Put(journal, name);
+		}
+
+		const auto first = journal.GetChanges(0, 2, false);
+		EXPECT_EQ(Describe(first), (std::vector<std::string>{ "A", "B" }));
+
+		// A is updated and B is lost before the next page is requested
+		Put(journal, "A");
+		Remove(journal, "B");
+
+		auto [changes, version] = GetAllChanges(journal, first.next, 2);
+		EXPECT_EQ(changes, (std::vector<std::string>{ "C", "A", "-B" }));
+		EXPECT_EQ(version, journal.GetVersion());
+	}
+
+	TEST(ServiceJournalTest, ReturnsDeltasSinceAVersion)
+	{
+		TestJournal journal;
+		Put(journal, "A");
+		Put(journal, "B");
+		Put(journal, "C");
+		const auto since = journal.GetVersion();
+
+		Remove(journal, "B");
+		Put(journal, "D");
+		Put(journal, "a"); // same instance, keys are case-insensitive
+
+		auto [changes, version] = GetAllChanges(journal, since, 10);
+		EXPECT_EQ(changes, (std::vector<std::string>{ "-B", "D", "a" }));
+		EXPECT_EQ(version, since + 3);
+
+		// nothing since the latest version
+		const auto page = journal.GetChanges(journal.GetVersion(), 10, true);
+		EXPECT_TRUE(page.changes.empty());
+		EXPECT_FALSE(page.more);
+		EXPECT_FALSE(page.snapshotRequired);
+
+		// tombstones can be left out
+		EXPECT_EQ(Describe(journal.GetChanges(since, 10, false)), (std::vector<std::string>{ "D", "a" }));
+	}
+
+	TEST(ServiceJournalTest, FoundAgainReplacesTheTombstone)
+	{
+		TestJournal journal;
+		Put(journal, "A");
+		Remove(journal, "A");
+		Put(journal, "A");
+
+		EXPECT_EQ(Describe(journal.GetChanges(0, 10, true)), std::vector<std::string>{ "A" });
+		EXPECT_EQ(journal.Size(), 1u);
+		EXPECT_EQ(journal.GetVersion(), 3u);
+	}
+
+	TEST(ServiceJournalTest, IgnoresRemovalsOfUnreportedServices)
+	{
+		TestJournal journal;
+		Put(journal, "A");
+		Remove(journal, "B");
+		Remove(journal, "A");
+		Remove(journal, "A"); // lost already
+
+		EXPECT_EQ(journal.GetVersion(), 2u);
+		EXPECT_EQ(Describe(journal.GetChanges(0, 10, true)), std::vector<std::string>{ "-A" });
+	}
+
+	TEST(ServiceJournalTest, CapsTombstones)
+	{
+		TestJournal journal(2);
+		for (const auto name : { "A", "B", "C", "D" }) {
+			Put(journal, name);
+		}
+
+		Remove(journal, "A"); // version 5
+		Remove(journal, "B"); // 6
+		EXPECT_EQ(journal.GetHorizon(), 0u);
+
+		Remove(journal, "C"); // 7, drops A's tombstone
+		EXPECT_EQ(journal.GetHorizon(), 5u);
+		EXPECT_EQ(Describe(journal.GetChanges(0, 10, true)), (std::vector<std::string>{ "D", "-B", "-C" }));
+
+		Remove(journal, "D"); // 8, drops B's
+		EXPECT_EQ(journal.GetHorizon(), 6u);
+		EXPECT_EQ(Describe(journal.GetChanges(0, 10, true)), (std::vector<std::string>{ "-C", "-D" }));
+		EXPECT_EQ(journal.Size(), 0u);
+
+		// a service found again is no tombstone, so it doesn't count towards the cap
+		Put(journal, "C");
+		Remove(journal, "A"); // forgotten
+		EXPECT_EQ(journal.GetHorizon(), 6u);
+	}
+
+	TEST(ServiceJournalTest, RequiresSnapshotBeforeTheHorizon)
+	{
+		TestJournal journal(1);
+		Put(journal, "A"); // 1
+		Put(journal, "B"); // 2
+		Remove(journal, "A"); // 3
+		Remove(journal, "B"); // 4, drops A's tombstone
+
+		ASSERT_EQ(journal.GetHorizon(), 3u);
+
+		// A's loss after version 2 would be missing
+		for (const uint64_t since : { 1u, 2u }) {
+			const auto page = journal.GetChanges(since, 10, true);
+			EXPECT_TRUE(page.snapshotRequired) << since;
+			EXPECT_TRUE(page.changes.empty());
+			EXPECT_FALSE(page.more);
+			EXPECT_EQ(page.next, since);
+		}
+
+		auto page = journal.GetChanges(3, 10, true);
+		EXPECT_FALSE(page.snapshotRequired);
+		EXPECT_EQ(Describe(page), std::vector<std::string>{ "-B" });
+
+		// from scratch, the snapshot itself
+		page = journal.GetChanges(0, 10, false);
+		EXPECT_FALSE(page.snapshotRequired);
+		EXPECT_TRUE(page.changes.empty());
+		EXPECT_EQ(page.next, 4u);
+	}
+}
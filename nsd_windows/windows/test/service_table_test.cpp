@@ -0,0 +1,116 @@
+#include "service_table.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+namespace nsd_windows {
+
+	namespace {
+
+		std::string GetName(const int i)
+		{
+			return "Instance " + std::to_string(i);
+		}
+	}
+
+	TEST(ServiceTableTest, FindsInsertedEntriesCaseInsensitively)
+	{
+		ServiceTable table;
+
+		const auto [entry, inserted] = table.Insert("My Printer", "_ipp._tcp");
+		ASSERT_TRUE(inserted);
+		EXPECT_EQ(entry->name, "My Printer");
+		EXPECT_EQ(*entry->type, "_ipp._tcp");
+		EXPECT_EQ(entry->host, nullptr);
+
+		EXPECT_EQ(table.Find("my printer", "_IPP._tcp"), table.Find("My Printer", "_ipp._tcp"));
+		EXPECT_NE(table.Find("MY PRINTER", "_ipp._tcp"), nullptr);
+		EXPECT_EQ(table.Find("My Printer", "_http._tcp"), nullptr);
+		EXPECT_EQ(table.Find("My Printer 2", "_ipp._tcp"), nullptr);
+		EXPECT_EQ(table.Size(), 1u);
+	}
+
+	TEST(ServiceTableTest, InsertReturnsExistingEntry)
+	{
+		ServiceTable table;
+
+		table.Insert("My Printer", "_ipp._tcp").first->host = table.Intern("printer.local");
+
+		const auto [entry, inserted] = table.Insert("MY PRINTER", "_ipp._tcp");
+		EXPECT_FALSE(inserted);
+		EXPECT_EQ(entry->name, "My Printer"); // spelling of the first insert
+		ASSERT_NE(entry->host, nullptr);
+		EXPECT_EQ(*entry->host, "printer.local");
+		EXPECT_EQ(table.Size(), 1u);
+	}
+
+	TEST(ServiceTableTest, InternsTypesAndHosts)
+	{
+		ServiceTable table;
+
+		const auto* first = table.Insert("a", "_ipp._tcp").first->type;
+		const auto* second = table.Insert("b", "_ipp._tcp").first->type;
+
+		EXPECT_EQ(first, second);
+		EXPECT_EQ(table.Intern("host.local"), table.Intern("host.local"));
+		EXPECT_NE(table.Intern("host.local"), table.Intern("other.local"));
+	}
+
+	TEST(ServiceTableTest, KeepsEntriesAcrossGrowthAndErasure)
+	{
+		constexpr int kCount = 5000;
+		ServiceTable table;
+
+		for (int i = 0; i < kCount; i++) {
+			ASSERT_TRUE(table.Insert(GetName(i), "_http._tcp").second);
+		}
+		EXPECT_EQ(table.Size(), static_cast<size_t>(kCount));
+
+		// erasing shifts later entries of the same probe sequence back, they must stay reachable
+		for (int i = 0; i < kCount; i += 2) {
+			ASSERT_TRUE(table.Erase(GetName(i), "_HTTP._tcp"));
+		}
+		EXPECT_FALSE(table.Erase(GetName(0), "_http._tcp"));
+		EXPECT_EQ(table.Size(), static_cast<size_t>(kCount / 2));
+
+		for (int i = 0; i < kCount; i++) {
+			const auto* entry = table.Find(GetName(i), "_http._tcp");
+			if (i % 2 == 0) {
+				EXPECT_EQ(entry, nullptr) << i;
+			}
+			else {
+				ASSERT_NE(entry, nullptr) << i;
+				EXPECT_EQ(entry->name, GetName(i));
+			}
+		}
+	}
+
+	TEST(ServiceTableTest, ForEachVisitsEveryEntryOnce)
+	{
+		ServiceTable table;
+		for (int i = 0; i < 100; i++) {
+			table.Insert(GetName(i), i % 2 == 0 ? "_http._tcp" : "_ipp._tcp");
+		}
+		table.Erase(GetName(42), "_http._tcp");
+
+		std::set<std::string> names;
+		table.ForEach([&names](const ServiceEntry& entry) {
+			EXPECT_TRUE(names.insert(entry.name).second);
+		});
+
+		EXPECT_EQ(names.size(), 99u);
+		EXPECT_EQ(names.count(GetName(42)), 0u);
+	}
+
+	TEST(ServiceTableTest, ComparesDnsNamesAsciiCaseInsensitively)
+	{
+		EXPECT_TRUE(EqualsDnsName("Printer.Local", "printer.local"));
+		EXPECT_FALSE(EqualsDnsName("printer.local", "printer.local."));
+		EXPECT_FALSE(EqualsDnsName("\xC3\x84", "\xC3\xA4")); // non-ascii letters aren't folded
+		EXPECT_EQ(HashDnsName("Printer.Local"), HashDnsName("printer.local"));
+		EXPECT_NE(HashDnsName("printer.local"), HashDnsName("printer.locak"));
+		EXPECT_EQ(ToLowerDnsName("My \xC3\x84 Printer"), "my \xC3\x84 printer");
+	}
+}
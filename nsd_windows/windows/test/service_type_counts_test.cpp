@@ -0,0 +1,94 @@
+#include "service_type_counts.h"
+
+#include <gtest/gtest.h>
+
+namespace nsd_windows {
+
+	TEST(ServiceTypeCountsTest, ListsAnnouncedTypesOnce)
+	{
+		ServiceTypeCounts types;
+
+		EXPECT_TRUE(types.Announce("_http._tcp")); // new, has to be browsed
+		EXPECT_FALSE(types.Announce("_HTTP._tcp")); // e.g. announced by another host
+		EXPECT_TRUE(types.Announce("_ipp._tcp"));
+
+		EXPECT_EQ(types.Size(), 2u);
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), 0u);
+		EXPECT_EQ(types.GetInstanceCount("_printer._tcp"), std::nullopt);
+	}
+
+	TEST(ServiceTypeCountsTest, CountsInstances)
+	{
+		ServiceTypeCounts types;
+		types.Announce("_http._tcp");
+
+		EXPECT_TRUE(types.AddInstance("_http._tcp"));
+		EXPECT_TRUE(types.AddInstance("_Http._Tcp"));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), 2u);
+
+		EXPECT_TRUE(types.RemoveInstance("_http._tcp"));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), 1u);
+	}
+
+	TEST(ServiceTypeCountsTest, WithdrawnTypeIsGoneWithoutInstances)
+	{
+		ServiceTypeCounts types;
+		types.Announce("_http._tcp");
+
+		EXPECT_TRUE(types.Withdraw("_http._tcp"));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), std::nullopt);
+
+		EXPECT_FALSE(types.Withdraw("_http._tcp")); // unknown by now
+		EXPECT_TRUE(types.Announce("_http._tcp")); // and new again
+	}
+
+	TEST(ServiceTypeCountsTest, WithdrawnTypeStaysListedWhileInstancesAreLeft)
+	{
+		ServiceTypeCounts types;
+		types.Announce("_http._tcp");
+		types.AddInstance("_http._tcp");
+		types.AddInstance("_http._tcp");
+
+		EXPECT_FALSE(types.Withdraw("_http._tcp"));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), 2u);
+
+		EXPECT_TRUE(types.RemoveInstance("_http._tcp"));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), 1u);
+
+		EXPECT_TRUE(types.RemoveInstance("_http._tcp")); // reported as gone
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), std::nullopt);
+		EXPECT_EQ(types.Size(), 0u);
+	}
+
+	TEST(ServiceTypeCountsTest, TypeStaysListedWhileAnnouncedOnAnotherInterface)
+	{
+		ServiceTypeCounts types;
+
+		EXPECT_TRUE(types.Announce("_http._tcp", 3));
+		EXPECT_FALSE(types.Announce("_http._tcp", 7));
+
+		EXPECT_FALSE(types.Withdraw("_http._tcp", 3));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), 0u);
+
+		EXPECT_TRUE(types.Withdraw("_http._tcp", 7));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), std::nullopt);
+	}
+
+	TEST(ServiceTypeCountsTest, AnnouncedTypeStaysListedWithoutInstances)
+	{
+		ServiceTypeCounts types;
+		types.Announce("_http._tcp");
+		types.AddInstance("_http._tcp");
+
+		EXPECT_TRUE(types.RemoveInstance("_http._tcp"));
+		EXPECT_EQ(types.GetInstanceCount("_http._tcp"), 0u);
+	}
+
+	TEST(ServiceTypeCountsTest, IgnoresInstancesOfUnknownTypes)
+	{
+		ServiceTypeCounts types;
+
+		EXPECT_FALSE(types.RemoveInstance("_http._tcp"));
+		EXPECT_EQ(types.Size(), 0u);
+	}
+}
@@ -0,0 +1,134 @@
+#include "slab.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	TEST(SlabTest, GetsEmplacedObjects)
+	{
+		Slab<std::string> slab;
+
+		const auto [first, firstObject] = slab.Emplace("first");
+		const auto [second, secondObject] = slab.Emplace(3, 'x');
+
+		EXPECT_NE(first, kNoSlabHandle);
+		EXPECT_NE(first, second);
+		EXPECT_EQ(slab.Get(first), firstObject);
+		EXPECT_EQ(*slab.Get(second), "xxx");
+		EXPECT_EQ(slab.Size(), 2u);
+		EXPECT_EQ(slab.Get(kNoSlabHandle), nullptr);
+		EXPECT_EQ(slab.Get(0xFFFF), nullptr); // beyond the capacity
+	}
+
+	TEST(SlabTest, DetectsStaleHandles)
+	{
+		Slab<std::string> slab;
+
+		const auto stale = slab.Emplace("first").first;
+		EXPECT_TRUE(slab.Erase(stale));
+		EXPECT_FALSE(slab.Erase(stale));
+		EXPECT_EQ(slab.Get(stale), nullptr);
+
+		const auto reused = slab.Emplace("second").first; // same slot, next generation
+		EXPECT_EQ(reused & 0xFFFF, stale & 0xFFFF);
+		EXPECT_NE(reused, stale);
+		EXPECT_EQ(slab.Get(stale), nullptr);
+		EXPECT_FALSE(slab.Erase(stale));
+		EXPECT_EQ(*slab.Get(reused), "second");
+	}
+
+	TEST(SlabTest, GenerationsWrapAroundWithoutIssuingZero)
+	{
+		Slab<int> slab;
+		std::set<SlabHandle> handles;
+
+		for (int i = 0; i < 0x10000; i++) {
+			const auto handle = slab.Emplace(i).first;
+			EXPECT_NE(handle >> 16, 0u);
+			handles.insert(handle);
+			slab.Erase(handle);
+		}
+
+		EXPECT_EQ(handles.size(), 0xFFFFu); // every generation of the slot once, then the first again
+	}
+
+	TEST(SlabTest, KeepsObjectsInPlaceWhileGrowing)
+	{
+		Slab<std::string, 4> slab;
+		std::vector<std::pair<SlabHandle, std::string*>> objects;
+
+		for (int i = 0; i < 100; i++) {
+			objects.push_back(slab.Emplace(std::to_string(i)));
+		}
+
+		EXPECT_EQ(slab.Capacity(), 100u);
+		for (size_t i = 0; i < objects.size(); i++) {
+			EXPECT_EQ(slab.Get(objects[i].first), objects[i].second);
+			EXPECT_EQ(*objects[i].second, std::to_string(i));
+		}
+	}
+
+	TEST(SlabTest, ThrowsWhenFull)
+	{
+		Slab<int> slab;
+		for (size_t i = 0; i < Slab<int>::kMaxSize; i++) {
+			slab.Emplace(0);
+		}
+
+		try {
+			slab.Emplace(0);
+			FAIL();
+		}
+		catch (const NsdError& error) {
+			EXPECT_EQ(error.errorCause, ErrorCause::MAX_LIMIT);
+		}
+	}
+
+	TEST(SlabTest, LeavesTheSlotFreeIfTheConstructorThrows)
+	{
+		struct Throwing {
+			explicit Throwing(const bool fail) {
+				if (fail) {
+					throw std::runtime_error("fail");
+				}
+			}
+		};
+
+		Slab<Throwing> slab;
+		EXPECT_THROW(slab.Emplace(true), std::runtime_error);
+		EXPECT_EQ(slab.Size(), 0u);
+
+		const auto handle = slab.Emplace(false).first;
+		EXPECT_EQ(handle & 0xFFFF, 0u); // the slot was reused
+	}
+
+	TEST(SlabTest, ForEachAndClearVisitOccupiedSlots)
+	{
+		auto value = std::make_shared<int>(0);
+		Slab<std::shared_ptr<int>> slab;
+
+		std::vector<SlabHandle> handles;
+		for (int i = 0; i < 10; i++) {
+			handles.push_back(slab.Emplace(value).first);
+		}
+		slab.Erase(handles[3]);
+
+		std::set<SlabHandle> visited;
+		slab.ForEach([&visited](const SlabHandle handle, std::shared_ptr<int>&) {
+			visited.insert(handle);
+		});
+		EXPECT_EQ(visited.size(), 9u);
+		EXPECT_EQ(visited.count(handles[3]), 0u);
+
+		slab.Clear();
+		EXPECT_EQ(slab.Size(), 0u);
+		EXPECT_EQ(value.use_count(), 1); // destroyed
+		EXPECT_EQ(slab.Get(handles[0]), nullptr);
+	}
+}
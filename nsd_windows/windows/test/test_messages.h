@@ -0,0 +1,79 @@
+#pragma once
+
+#include "dns_message.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	inline DnsRecord CreateRecord(const std::string& name, const DnsType type)
+	{
+		DnsRecord record;
+		record.name = name;
+		record.type = type;
+		return record;
+	}
+
+	// mDNS response announcing a service instance, as sent by a responder: PTR answer, SRV, TXT, A, AAAA and NSEC
+	// records in the additional section, names share suffixes so they get compressed
+	inline DnsMessage CreateServiceResponse(const std::string& instanceName, const std::string& serviceType, const std::string& hostName)
+	{
+		const auto fullName = instanceName + '.' + serviceType;
+
+		DnsMessage message;
+		message.flags = kDnsFlagResponse;
+
+		auto ptr = CreateRecord(serviceType, DnsType::PTR);
+		ptr.ttl = 4500;
+		ptr.target = fullName;
+		message.answers.push_back(ptr);
+
+		auto srv = CreateRecord(fullName, DnsType::SRV);
+		srv.cacheFlush = true;
+		srv.ttl = 120;
+		srv.port = 8080;
+		srv.target = hostName;
+		message.additionals.push_back(srv);
+
+		auto txt = CreateRecord(fullName, DnsType::TXT);
+		txt.cacheFlush = true;
+		txt.ttl = 4500;
+		for (const std::string entry : { "txtvers=1", "path=/printer", "note=Hallway" }) {
+			txt.data.push_back(static_cast<uint8_t>(entry.size()));
+			txt.data.insert(txt.data.end(), entry.begin(), entry.end());
+		}
+		message.additionals.push_back(txt);
+
+		auto a = CreateRecord(hostName, DnsType::A);
+		a.cacheFlush = true;
+		a.ttl = 120;
+		a.data = { 192, 168, 1, 23 };
+		message.additionals.push_back(a);
+
+		auto aaaa = CreateRecord(hostName, DnsType::AAAA);
+		aaaa.cacheFlush = true;
+		aaaa.ttl = 120;
+		aaaa.data = { 0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x11, 0x22, 0xFF, 0xFE, 0x33, 0x44, 0x55 };
+		message.additionals.push_back(aaaa);
+
+		// next name uncompressed, window 0 with A (1) and AAAA (28), see https://datatracker.ietf.org/doc/html/rfc6762#section-6.1
+		auto nsec = CreateRecord(hostName, DnsType::NSEC);
+		nsec.cacheFlush = true;
+		nsec.ttl = 120;
+		for (const auto& label : SplitDnsName(hostName)) {
+			nsec.data.push_back(static_cast<uint8_t>(label.size()));
+			nsec.data.insert(nsec.data.end(), label.begin(), label.end());
+		}
+		nsec.data.insert(nsec.data.end(), { 0, 0, 4, 0x40, 0, 0, 0x08 });
+		message.additionals.push_back(nsec);
+
+		return message;
+	}
+
+	inline std::vector<uint8_t> SerializeServiceResponse()
+	{
+		return SerializeDnsMessage(CreateServiceResponse("My\\.Printer", "_ipp._tcp.local", "printer-1.local"));
+	}
+}
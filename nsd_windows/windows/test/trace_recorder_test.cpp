@@ -0,0 +1,133 @@
+#include "trace_recorder.h"
+
+#include <gtest/gtest.h>
+
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		// the trace events of a dump without the thread name metadata, one JSON object each
+		std::vector<std::string> GetEvents(const std::string& json)
+		{
+			std::vector<std::string> events;
+			const std::regex event("\\{\"name\":\"[^\"]*\",\"cat\":[^{}]*(\\{[^{}]*\\})?\\}"); // metadata has no category
+			for (auto it = std::sregex_iterator(json.begin(), json.end(), event); it != std::sregex_iterator(); ++it) {
+				events.push_back(it->str());
+			}
+			return events;
+		}
+
+		std::string GetField(const std::string& event, const std::string& name)
+		{
+			std::smatch match;
+			const std::regex field("\"" + name + "\":(\"[^\"]*\"|[0-9]+)");
+			return std::regex_search(event, match, field) ? match[1].str() : "";
+		}
+	}
+
+	TEST(TraceRecorderTest, RecordsNothingWhileDisabled)
+	{
+		TraceRecorder recorder;
+		recorder.Instant("dispatch", "ScheduleDrain");
+		{
+			TraceSpan span(recorder, "dns", "DnsServiceBrowse");
+		}
+
+		EXPECT_FALSE(recorder.IsEnabled());
+		EXPECT_EQ(recorder.Dump(false), "{\"traceEvents\":[],\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten\":\"0\"}}");
+	}
+
+	TEST(TraceRecorderTest, WritesPhasesTimestampsAndThreads)
+	{
+		TraceRecorder recorder;
+		recorder.Enable(16);
+
+		const auto before = TraceRecorder::Now();
+		recorder.Instant("dispatch", "ScheduleDrain");
+		{
+			TraceSpan span(recorder, "dns", "DnsServiceBrowse", "_ipp._tcp");
+		}
+		std::thread([&recorder]() {
+			recorder.Instant("callback", "DnsServiceBrowseCallback");
+			}).join();
+		const auto after = TraceRecorder::Now();
+
+		const auto json = recorder.Dump(false);
+		const auto events = GetEvents(json);
+		ASSERT_EQ(events.size(), 3u) << json;
+
+		EXPECT_EQ(GetField(events[0], "name"), "\"ScheduleDrain\"");
+		EXPECT_EQ(GetField(events[0], "cat"), "\"dispatch\"");
+		EXPECT_EQ(GetField(events[0], "ph"), "\"i\"");
+		EXPECT_EQ(GetField(events[0], "s"), "\"t\""); // scoped to the thread
+		EXPECT_EQ(GetField(events[0], "dur"), "");
+
+		EXPECT_EQ(GetField(events[1], "ph"), "\"X\"");
+		EXPECT_NE(GetField(events[1], "dur"), "");
+		EXPECT_EQ(GetField(events[1], "detail"), "\"_ipp._tcp\"");
+
+		for (const auto& event : events) {
+			const auto timestamp = std::stoull(GetField(event, "ts"));
+			EXPECT_GE(timestamp, before);
+			EXPECT_LE(timestamp, after);
+			EXPECT_EQ(GetField(event, "pid"), GetField(events[0], "pid"));
+		}
+
+		// the thread enabling the recorder is named platform
+		const auto platformThread = GetField(events[0], "tid");
+		EXPECT_NE(json.find("\"tid\":" + platformThread + ",\"args\":{\"name\":\"platform\"}"), std::string::npos) << json;
+		EXPECT_EQ(GetField(events[1], "tid"), platformThread);
+		EXPECT_NE(GetField(events[2], "tid"), platformThread);
+	}
+
+	TEST(TraceRecorderTest, EscapesStrings)
+	{
+		TraceRecorder recorder;
+		recorder.Enable(16);
+		recorder.Instant("dns", "DnsServiceResolve", "say \"hi\"\\\n\x01.local");
+
+		const auto json = recorder.Dump(false);
+		EXPECT_NE(json.find("\"args\":{\"detail\":\"say \\\"hi\\\"\\\\\\u000a\\u0001.local\"}"), std::string::npos) << json;
+	}
+
+	TEST(TraceRecorderTest, OverwritesTheOldestEventsOnceFull)
+	{
+		TraceRecorder recorder;
+		recorder.Enable(3);
+		for (const auto detail : { "1", "2", "3", "4", "5" }) {
+			recorder.Instant("dispatch", "Drain", detail);
+		}
+
+		const auto json = recorder.Dump(true);
+		std::vector<std::string> details;
+		for (const auto& event : GetEvents(json)) {
+			details.push_back(GetField(event, "detail"));
+		}
+
+		EXPECT_EQ(details, (std::vector<std::string>{ "\"3\"", "\"4\"", "\"5\"" }));
+		EXPECT_NE(json.find("\"overwritten\":\"2\""), std::string::npos) << json;
+
+		// cleared by the dump
+		EXPECT_TRUE(GetEvents(recorder.Dump(false)).empty());
+	}
+
+	TEST(TraceRecorderTest, KeepsEventsWhenDisabled)
+	{
+		TraceRecorder recorder;
+		recorder.Enable(16);
+		recorder.Instant("dispatch", "Drain");
+		recorder.Disable();
+		recorder.Instant("dispatch", "Drain");
+
+		EXPECT_EQ(GetEvents(recorder.Dump(false)).size(), 1u);
+
+		// enabling again starts over
+		recorder.Enable(16);
+		EXPECT_TRUE(GetEvents(recorder.Dump(false)).empty());
+	}
+}
@@ -0,0 +1,151 @@
+#include "transcoding.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+namespace nsd_windows {
+
+	namespace {
+
+		struct Utf16 {
+			std::u16string value;
+			bool valid;
+		};
+
+		struct Utf8 {
+			std::string value;
+			bool valid;
+		};
+
+		Utf16 ToUtf16(const std::string& value)
+		{
+			std::u16string out(GetMaxUtf16Size(value.size()), u'\0');
+			const auto result = Utf8ToUtf16(value.data(), value.size(), out.data());
+			out.resize(result.size);
+			return { out, result.valid };
+		}
+
+		Utf8 ToUtf8(const std::u16string& value)
+		{
+			std::string out(GetMaxUtf8Size(value.size()), '\0');
+			const auto result = Utf16ToUtf8(value.data(), value.size(), out.data());
+			out.resize(result.size);
+			return { out, result.valid };
+		}
+	}
+
+	TEST(TranscodingTest, ConvertsAsciiOfAnyLength)
+	{
+		// lengths around the 16 byte blocks of the vectorized path, with a non-ascii character at every position
+		for (size_t length = 0; length <= 40; length++) {
+
+			std::string utf8(length, 'a');
+			std::u16string utf16(length, u'a');
+			for (size_t i = 0; i < length; i++) {
+				utf8[i] = utf16[i] = static_cast<char>('!' + i);
+			}
+
+			EXPECT_EQ(ToUtf16(utf8).value, utf16) << length;
+			EXPECT_EQ(ToUtf8(utf16).value, utf8) << length;
+
+			for (size_t i = 0; i < length; i++) {
+				auto mixed8 = utf8;
+				auto mixed16 = utf16;
+				mixed8.replace(i, 1, "\xC3\xA4");
+				mixed16[i] = u'ä';
+
+				EXPECT_EQ(ToUtf16(mixed8).value, mixed16) << length << " " << i;
+				EXPECT_EQ(ToUtf8(mixed16).value, mixed8) << length << " " << i;
+			}
+		}
+	}
+
+	TEST(TranscodingTest, ConvertsAllSequenceLengths)
+	{
+		const std::string utf8 = "A\xC3\xA4\xE2\x82\xAC\xF0\x9F\x96\xA8 Drucker"; // A, U+00E4, U+20AC, U+1F5A8
+		const std::u16string utf16 = u"Aä€\U0001F5A8 Drucker";
+
+		const auto wide = ToUtf16(utf8);
+		EXPECT_EQ(wide.value, utf16);
+		EXPECT_TRUE(wide.valid);
+
+		const auto narrow = ToUtf8(utf16);
+		EXPECT_EQ(narrow.value, utf8);
+		EXPECT_TRUE(narrow.valid);
+	}
+
+	TEST(TranscodingTest, ReplacesMalformedUtf8PerMaximalSubpart)
+	{
+		const std::pair<std::string, std::u16string> cases[] = {
+			{ "\x80", u"�" }, // lone continuation
+			{ "\xC0\xAF", u"��" }, // overlong
+			{ "\xE0\x80\xAF", u"���" }, // overlong
+			{ "\xED\xA0\x80", u"���" }, // surrogate
+			{ "\xF4\x90\x80\x80", u"����" }, // above U+10FFFF
+			{ "\xF5", u"�" },
+			{ "a\xE2\x82", u"a�" }, // truncated
+			{ "\xE2\x82" "a", u"�a" },
+			{ "\xF0\x9F\x96" "\xC3\xA4", u"�ä" },
+		};
+
+		for (const auto& [utf8, expected] : cases) {
+			const auto result = ToUtf16(utf8);
+			EXPECT_EQ(result.value, expected) << testing::PrintToString(utf8);
+			EXPECT_FALSE(result.valid) << testing::PrintToString(utf8);
+		}
+	}
+
+	TEST(TranscodingTest, ReplacesUnpairedSurrogates)
+	{
+		const std::pair<std::u16string, std::string> cases[] = {
+			{ u"\xD83D", "\xEF\xBF\xBD" },
+			{ std::u16string(u"a") + char16_t(0xDE00) + u"b", "a\xEF\xBF\xBD" "b" },
+			{ std::u16string(1, char16_t(0xD83D)) + char16_t(0xD83D) + char16_t(0xDDA8), "\xEF\xBF\xBD\xF0\x9F\x96\xA8" },
+		};
+
+		for (const auto& [utf16, expected] : cases) {
+			const auto result = ToUtf8(utf16);
+			EXPECT_EQ(result.value, expected);
+			EXPECT_FALSE(result.valid);
+		}
+	}
+
+	TEST(TranscodingTest, RoundTripsRandomCodePoints)
+	{
+		std::mt19937 random(42);
+		std::uniform_int_distribution<uint32_t> planes(0, 3);
+
+		for (int run = 0; run < 1000; run++) {
+
+			std::u16string utf16;
+			const auto length = random() % 64;
+
+			for (uint32_t i = 0; i < length; i++) {
+				switch (planes(random)) {
+				case 0:
+					utf16 += static_cast<char16_t>(random() % 0x80);
+					break;
+				case 1:
+					utf16 += static_cast<char16_t>(0x80 + random() % (0xD800 - 0x80));
+					break;
+				case 2:
+					utf16 += static_cast<char16_t>(0xE000 + random() % 0x2000);
+					break;
+				default: {
+					const auto codePoint = random() % 0x100000; // above U+FFFF, minus 0x10000
+					utf16 += static_cast<char16_t>(0xD800 + (codePoint >> 10));
+					utf16 += static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+				}
+				}
+			}
+
+			const auto utf8 = ToUtf8(utf16);
+			ASSERT_TRUE(utf8.valid);
+			const auto back = ToUtf16(utf8.value);
+			ASSERT_TRUE(back.valid);
+			ASSERT_EQ(back.value, utf16);
+		}
+	}
+}
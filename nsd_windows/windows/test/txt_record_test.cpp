@@ -0,0 +1,105 @@
+#include "nsd_error.h"
+#include "txt_record.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace nsd_windows {
+
+	namespace {
+
+		using Bytes = std::vector<uint8_t>;
+
+		Bytes ToBytes(const std::string& value)
+		{
+			return Bytes(value.begin(), value.end());
+		}
+
+		Bytes GetValue(const TxtEntry& entry)
+		{
+			return Bytes(entry.value, entry.value + entry.valueSize);
+		}
+	}
+
+	TEST(TxtRecordTest, ParsesWireEntries)
+	{
+		const char data[] = "\x09txtvers=1\x04" "flag\x06" "empty=";
+		const Bytes wire(data, data + sizeof(data) - 1);
+		const auto txt = TxtRecord::FromWire(wire.data(), wire.size());
+
+		ASSERT_EQ(txt.GetCount(), 3u);
+
+		auto entry = txt.Get(0);
+		EXPECT_EQ(entry.key, "txtvers");
+		EXPECT_TRUE(entry.hasValue);
+		EXPECT_EQ(GetValue(entry), ToBytes("1"));
+
+		entry = txt.Get(1);
+		EXPECT_EQ(entry.key, "flag");
+		EXPECT_FALSE(entry.hasValue); // boolean attribute
+
+		entry = txt.Get(2);
+		EXPECT_EQ(entry.key, "empty");
+		EXPECT_TRUE(entry.hasValue);
+		EXPECT_EQ(entry.valueSize, 0u);
+
+		EXPECT_EQ(txt.GetWire(), wire);
+	}
+
+	TEST(TxtRecordTest, ParsesLeniently)
+	{
+		// empty string, entry without key, duplicate key (case insensitive), truncated last string
+		const char data[] = "\x00\x02=x\x03" "a=1\x03" "A=2\x09" "b=2";
+		const Bytes wire(data, data + sizeof(data) - 1);
+		const auto txt = TxtRecord::FromWire(wire.data(), wire.size());
+
+		ASSERT_EQ(txt.GetCount(), 2u);
+		EXPECT_EQ(txt.Get(0).key, "a");
+		EXPECT_EQ(GetValue(txt.Get(0)), ToBytes("1"));
+		EXPECT_EQ(txt.Get(1).key, "b");
+		EXPECT_EQ(GetValue(txt.Get(1)), ToBytes("2"));
+
+		EXPECT_TRUE(TxtRecord::FromWire(nullptr, 0).IsEmpty());
+		const uint8_t single[] = { 0 };
+		EXPECT_TRUE(TxtRecord::FromWire(single, 1).IsEmpty()); // no entries on the wire
+	}
+
+	TEST(TxtRecordTest, RoundTripsBinaryValues)
+	{
+		Bytes binary;
+		for (int i = 0; i < 250; i++) {
+			binary.push_back(static_cast<uint8_t>(255 - i)); // includes '=', zero and invalid utf-8
+		}
+
+		TxtRecord txt;
+		EXPECT_TRUE(txt.Add("data", binary.data(), binary.size() - 5));
+		EXPECT_TRUE(txt.Add("Flag"));
+		EXPECT_FALSE(txt.Add("flag")); // first one wins
+		EXPECT_TRUE(txt.Contains("FLAG"));
+		EXPECT_FALSE(txt.Contains("other"));
+
+		const auto parsed = TxtRecord::FromWire(txt.GetWire().data(), txt.GetWire().size());
+
+		EXPECT_EQ(parsed, txt);
+		EXPECT_EQ(GetValue(parsed.Get(0)), Bytes(binary.begin(), binary.end() - 5));
+	}
+
+	TEST(TxtRecordTest, RejectsInvalidEntries)
+	{
+		TxtRecord txt;
+		const uint8_t value[255] = {};
+
+		EXPECT_THROW(txt.Add(""), NsdError);
+		EXPECT_THROW(txt.Add("a=b"), NsdError);
+		EXPECT_THROW(txt.Add("key", value, 255 - 3), NsdError); // 256 bytes with the separator
+		EXPECT_TRUE(txt.Add("key", value, 255 - 4));
+
+		EXPECT_FALSE(txt.AddEntry(""));
+		EXPECT_FALSE(txt.AddEntry("=value"));
+		EXPECT_FALSE(txt.AddEntry(std::string(256, 'a')));
+		EXPECT_TRUE(txt.AddEntry("other=a=b")); // the value may contain '='
+		EXPECT_EQ(GetValue(txt.Get(1)), ToBytes("a=b"));
+	}
+}
@@ -0,0 +1,162 @@
+#include "trace_recorder.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+
+namespace nsd_windows {
+
+	namespace {
+
+#ifdef _WIN32
+		uint32_t GetTraceThreadId()
+		{
+			return GetCurrentThreadId();
+		}
+
+		uint32_t GetTraceProcessId()
+		{
+			return GetCurrentProcessId();
+		}
+#else
+		// numbered in order of first use, starting at 1 since 0 means unset
+		uint32_t GetTraceThreadId()
+		{
+			static std::atomic<uint32_t> nextThreadId{ 1 };
+			thread_local const uint32_t threadId = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+			return threadId;
+		}
+
+		uint32_t GetTraceProcessId()
+		{
+			return static_cast<uint32_t>(getpid());
+		}
+#endif
+
+		void AppendJsonString(std::string& json, const std::string_view value)
+		{
+			json += '"';
+			for (const auto c : value) {
+				switch (c) {
+				case '"':
+					json += "\\\"";
+					break;
+				case '\\':
+					json += "\\\\";
+					break;
+				default:
+					if (static_cast<unsigned char>(c) < 0x20) {
+						char escaped[8];
+						std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+						json += escaped;
+					}
+					else {
+						json += c; // utf-8 passes through
+					}
+				}
+			}
+			json += '"';
+		}
+	}
+
+	void TraceRecorder::Enable(const size_t capacity)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		events.clear();
+		events.shrink_to_fit(); // the capacity may have changed
+		this->capacity = capacity;
+		next = 0;
+		overwritten = 0;
+		platformThreadId = GetTraceThreadId();
+
+		enabled.store(true, std::memory_order_relaxed);
+	}
+
+	void TraceRecorder::Disable()
+	{
+		enabled.store(false, std::memory_order_relaxed);
+	}
+
+	uint64_t TraceRecorder::Now() noexcept
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	void TraceRecorder::Add(const char* category, const char* name, const std::string_view detail, const char phase, const uint64_t timestamp, const uint64_t duration)
+	{
+		Event event{ category, name, std::string(detail), phase, timestamp, duration, GetTraceThreadId() };
+
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (events.size() < capacity) {
+			events.push_back(std::move(event));
+			return;
+		}
+
+		if (capacity == 0) {
+			return;
+		}
+
+		events[next] = std::move(event);
+		next = (next + 1) % capacity;
+		overwritten++;
+	}
+
+	std::string TraceRecorder::Dump(const bool clear)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		const auto pid = std::to_string(GetTraceProcessId());
+		std::string json = "{\"traceEvents\":[";
+
+		if (platformThreadId != 0) {
+			json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + std::to_string(platformThreadId) + ",\"args\":{\"name\":\"platform\"}}";
+		}
+
+		for (size_t i = 0; i < events.size(); i++) {
+
+			const auto& event = events[(next + i) % events.size()];
+
+			if (json.back() != '[') {
+				json += ',';
+			}
+
+			json += "{\"name\":";
+			AppendJsonString(json, event.name);
+			json += ",\"cat\":";
+			AppendJsonString(json, event.category);
+			json += ",\"ph\":\"";
+			json += event.phase;
+			json += "\",\"ts\":" + std::to_string(event.timestamp);
+			if (event.phase == 'X') {
+				json += ",\"dur\":" + std::to_string(event.duration);
+			}
+			else {
+				json += ",\"s\":\"t\""; // instant events are scoped to their thread
+			}
+			json += ",\"pid\":" + pid + ",\"tid\":" + std::to_string(event.threadId);
+			if (!event.detail.empty()) {
+				json += ",\"args\":{\"detail\":";
+				AppendJsonString(json, event.detail);
+				json += '}';
+			}
+			json += '}';
+		}
+
+		json += "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"overwritten\":\"" + std::to_string(overwritten) + "\"}}";
+
+		if (clear) {
+			events.clear();
+			next = 0;
+			overwritten = 0;
+		}
+
+		return json;
+	}
+}
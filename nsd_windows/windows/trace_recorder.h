@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nsd_windows {
+
+	// opt-in timeline of spans and instant events with microsecond timestamps and thread ids, dumped as chrome
+	// trace event JSON for chrome://tracing or https://ui.perfetto.dev, see
+	// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNGGRY
+	//
+	// may be used from any thread; while disabled, recording is a relaxed load and a branch; events are kept in
+	// a ring buffer, once it is full the oldest ones are overwritten
+	class TraceRecorder {
+	public:
+
+		static constexpr size_t kDefaultCapacity = 65536; // events
+
+		TraceRecorder() = default;
+
+		TraceRecorder(const TraceRecorder&) = delete; // disallow copy
+		TraceRecorder& operator=(const TraceRecorder&) = delete; // disallow assign
+
+		// clears what has been recorded; the calling thread is named "platform" in the dump
+		void Enable(const size_t capacity);
+		void Disable(); // what has been recorded is kept for dumping
+
+		bool IsEnabled() const noexcept {
+			return enabled.load(std::memory_order_relaxed);
+		}
+
+		// categories and names must be string literals, details are copied
+		void Instant(const char* category, const char* name, const std::string_view detail = {}) {
+			if (IsEnabled()) {
+				Add(category, name, detail, 'i', Now(), 0);
+			}
+		}
+
+		// span from start (see Now()) until now
+		void Complete(const char* category, const char* name, const std::string_view detail, const uint64_t start) {
+			if (IsEnabled()) {
+				const auto now = Now();
+				Add(category, name, detail, 'X', start, now - start);
+			}
+		}
+
+		static uint64_t Now() noexcept; // microseconds, steady
+
+		// the events in the order they were recorded
+		std::string Dump(const bool clear);
+
+	private:
+
+		struct Event {
+			const char* category;
+			const char* name;
+			std::string detail;
+			char phase; // 'X' for spans, 'i' for instant events
+			uint64_t timestamp;
+			uint64_t duration;
+			uint32_t threadId;
+		};
+
+		void Add(const char* category, const char* name, const std::string_view detail, const char phase, const uint64_t timestamp, const uint64_t duration);
+
+		std::atomic<bool> enabled{ false };
+		std::mutex mutex; // guards the members below
+		std::vector<Event> events; // ring buffer
+		size_t capacity = kDefaultCapacity;
+		size_t next = 0; // oldest event once the buffer is full
+		uint64_t overwritten = 0;
+		uint32_t platformThreadId = 0;
+	};
+
+	// span from construction until End() or destruction; nothing is recorded if tracing was disabled at construction
+	class TraceSpan {
+	public:
+
+		TraceSpan(TraceRecorder& recorder, const char* category, const char* name, const std::string_view detail = {}) :
+			recorder(recorder.IsEnabled() ? &recorder : nullptr), category(category), name(name) {
+			if (this->recorder != nullptr) {
+				this->detail = detail; // the viewed string may be gone by the end
+				start = TraceRecorder::Now();
+			}
+		}
+
+		~TraceSpan() {
+			End();
+		}
+
+		TraceSpan(const TraceSpan&) = delete; // disallow copy
+		TraceSpan& operator=(const TraceSpan&) = delete; // disallow assign
+
+		// ends the span early, e.g. right after the call it measures
+		void End() {
+			if (recorder != nullptr) {
+				recorder->Complete(category, name, detail, start);
+				recorder = nullptr;
+			}
+		}
+
+	private:
+
+		TraceRecorder* recorder; // null once ended, or if tracing was disabled
+		const char* category;
+		const char* name;
+		std::string detail;
+		uint64_t start = 0;
+	};
+}
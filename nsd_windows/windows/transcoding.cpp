@@ -0,0 +1,231 @@
+#include "transcoding.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define NSD_TRANSCODING_SSE2
+#include <emmintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__)
+#define NSD_TRANSCODING_NEON
+#include <arm_neon.h>
+#endif
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr char16_t kReplacementCharacter = 0xFFFD;
+		constexpr size_t kBlockSize = 16;
+
+		// convert leading ASCII characters in blocks of 16 and return how many; the rest is left to the scalar code
+
+#if defined(NSD_TRANSCODING_SSE2)
+
+		size_t WidenAscii(const char* in, const size_t size, char16_t* out) {
+			size_t i = 0;
+			const auto zero = _mm_setzero_si128();
+
+			for (; i + kBlockSize <= size; i += kBlockSize) {
+				const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+				if (_mm_movemask_epi8(bytes) != 0) {
+					break; // a byte has its top bit set
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(bytes, zero));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+			}
+			return i;
+		}
+
+		size_t NarrowAscii(const char16_t* in, const size_t size, char* out) {
+			size_t i = 0;
+			const auto nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+			const auto zero = _mm_setzero_si128();
+
+			for (; i + kBlockSize <= size; i += kBlockSize) {
+				const auto low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+				const auto high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+				const auto masked = _mm_and_si128(_mm_or_si128(low, high), nonAscii);
+				if (_mm_movemask_epi8(_mm_cmpeq_epi16(masked, zero)) != 0xFFFF) {
+					break;
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+			}
+			return i;
+		}
+
+#elif defined(NSD_TRANSCODING_NEON)
+
+		size_t WidenAscii(const char* in, const size_t size, char16_t* out) {
+			size_t i = 0;
+
+			for (; i + kBlockSize <= size; i += kBlockSize) {
+				const auto bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(in + i));
+				if (vmaxvq_u8(bytes) >= 0x80) {
+					break;
+				}
+				vst1q_u16(reinterpret_cast<uint16_t*>(out + i), vmovl_u8(vget_low_u8(bytes)));
+				vst1q_u16(reinterpret_cast<uint16_t*>(out + i + 8), vmovl_u8(vget_high_u8(bytes)));
+			}
+			return i;
+		}
+
+		size_t NarrowAscii(const char16_t* in, const size_t size, char* out) {
+			size_t i = 0;
+
+			for (; i + kBlockSize <= size; i += kBlockSize) {
+				const auto low = vld1q_u16(reinterpret_cast<const uint16_t*>(in + i));
+				const auto high = vld1q_u16(reinterpret_cast<const uint16_t*>(in + i + 8));
+				if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80) {
+					break;
+				}
+				vst1q_u8(reinterpret_cast<uint8_t*>(out + i), vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+			}
+			return i;
+		}
+
+#else
+
+		size_t WidenAscii(const char*, const size_t, char16_t*) {
+			return 0;
+		}
+
+		size_t NarrowAscii(const char16_t*, const size_t, char*) {
+			return 0;
+		}
+
+#endif
+
+		// decodes the sequence at in[i], see https://datatracker.ietf.org/doc/html/rfc3629#section-4;
+		// malformed sequences are replaced by one U+FFFD per maximal subpart (Unicode 15, section 3.9)
+		size_t DecodeUtf8(const uint8_t* in, const size_t size, size_t i, char16_t* out, size_t& written, bool& valid) {
+
+			const auto lead = in[i];
+
+			if (lead < 0x80) {
+				out[written++] = lead;
+				return i + 1;
+			}
+
+			size_t continuations;
+			uint32_t codePoint;
+			uint8_t min = 0x80;
+			uint8_t max = 0xBF;
+
+			if (lead >= 0xC2 && lead <= 0xDF) {
+				continuations = 1;
+				codePoint = lead & 0x1F;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF) {
+				continuations = 2;
+				codePoint = lead & 0x0F;
+				min = lead == 0xE0 ? 0xA0 : 0x80; // overlong
+				max = lead == 0xED ? 0x9F : 0xBF; // surrogates
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4) {
+				continuations = 3;
+				codePoint = lead & 0x07;
+				min = lead == 0xF0 ? 0x90 : 0x80; // overlong
+				max = lead == 0xF4 ? 0x8F : 0xBF; // above U+10FFFF
+			}
+			else {
+				out[written++] = kReplacementCharacter;
+				valid = false;
+				return i + 1;
+			}
+
+			i++;
+
+			for (size_t k = 0; k < continuations; k++, i++) {
+
+				if (i >= size || in[i] < min || in[i] > max) {
+					out[written++] = kReplacementCharacter;
+					valid = false;
+					return i;
+				}
+
+				codePoint = (codePoint << 6) | (in[i] & 0x3F);
+				min = 0x80;
+				max = 0xBF;
+			}
+
+			if (codePoint >= 0x10000) {
+				codePoint -= 0x10000;
+				out[written++] = static_cast<char16_t>(0xD800 + (codePoint >> 10));
+				out[written++] = static_cast<char16_t>(0xDC00 + (codePoint & 0x3FF));
+			}
+			else {
+				out[written++] = static_cast<char16_t>(codePoint);
+			}
+			return i;
+		}
+
+		// unpaired surrogates are replaced by U+FFFD
+		size_t EncodeUtf8(const char16_t* in, const size_t size, size_t i, char* out, size_t& written, bool& valid) {
+
+			uint32_t codePoint = in[i++];
+
+			if (codePoint >= 0xD800 && codePoint <= 0xDFFF) {
+				if (codePoint <= 0xDBFF && i < size && in[i] >= 0xDC00 && in[i] <= 0xDFFF) {
+					codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (in[i++] - 0xDC00);
+				}
+				else {
+					codePoint = kReplacementCharacter;
+					valid = false;
+				}
+			}
+
+			if (codePoint < 0x80) {
+				out[written++] = static_cast<char>(codePoint);
+			}
+			else if (codePoint < 0x800) {
+				out[written++] = static_cast<char>(0xC0 | (codePoint >> 6));
+				out[written++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else if (codePoint < 0x10000) {
+				out[written++] = static_cast<char>(0xE0 | (codePoint >> 12));
+				out[written++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				out[written++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			else {
+				out[written++] = static_cast<char>(0xF0 | (codePoint >> 18));
+				out[written++] = static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+				out[written++] = static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+				out[written++] = static_cast<char>(0x80 | (codePoint & 0x3F));
+			}
+			return i;
+		}
+	}
+
+	TranscodeResult Utf8ToUtf16(const char* in, const size_t size, char16_t* out)
+	{
+		TranscodeResult result;
+		const auto bytes = reinterpret_cast<const uint8_t*>(in);
+		size_t i = 0;
+
+		while (i < size) {
+			const auto ascii = WidenAscii(in + i, size - i, out + result.size);
+			i += ascii;
+			result.size += ascii;
+
+			if (i < size) {
+				i = DecodeUtf8(bytes, size, i, out, result.size, result.valid);
+			}
+		}
+		return result;
+	}
+
+	TranscodeResult Utf16ToUtf8(const char16_t* in, const size_t size, char* out)
+	{
+		TranscodeResult result;
+		size_t i = 0;
+
+		while (i < size) {
+			const auto ascii = NarrowAscii(in + i, size - i, out + result.size);
+			i += ascii;
+			result.size += ascii;
+
+			if (i < size) {
+				i = EncodeUtf8(in, size, i, out, result.size, result.valid);
+			}
+		}
+		return result;
+	}
+}
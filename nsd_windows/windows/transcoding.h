@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nsd_windows {
+
+	// single pass UTF-8 <-> UTF-16 conversion into caller provided buffers, with a vectorized path for ASCII
+	// (SSE2 on x86 / x64, NEON on ARM64), which almost all mDNS names and TXT keys are
+
+	struct TranscodeResult {
+
+		size_t size = 0; // code units written
+		bool valid = true; // false if malformed input was replaced with U+FFFD
+	};
+
+	// UTF-16 never needs more code units than UTF-8 has bytes, so the output must hold size code units
+	TranscodeResult Utf8ToUtf16(const char* in, const size_t size, char16_t* out);
+
+	// the output must hold 3 * size bytes (a surrogate pair takes 4, everything else at most 3 per code unit)
+	TranscodeResult Utf16ToUtf8(const char16_t* in, const size_t size, char* out);
+
+	constexpr size_t GetMaxUtf16Size(const size_t utf8Size) { return utf8Size; }
+	constexpr size_t GetMaxUtf8Size(const size_t utf16Size) { return utf16Size * 3; }
+}
@@ -0,0 +1,117 @@
+#include "txt_record.h"
+#include "nsd_error.h"
+
+#include <algorithm>
+
+namespace nsd_windows {
+
+	namespace {
+
+		constexpr size_t kMaxEntrySize = 255; // length prefixed, see https://datatracker.ietf.org/doc/html/rfc1035#section-3.3.14
+
+		// keys are printable US-ASCII, see https://datatracker.ietf.org/doc/html/rfc6763#section-6.4
+		char ToLowerAscii(const char c) {
+			return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+		}
+
+		bool EqualsIgnoreCase(const std::string_view a, const std::string_view b) {
+			return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const char x, const char y) {
+				return ToLowerAscii(x) == ToLowerAscii(y);
+			});
+		}
+	}
+
+	TxtRecord TxtRecord::FromWire(const uint8_t* data, const size_t size)
+	{
+		TxtRecord txt;
+		txt.wire.reserve(size);
+
+		for (size_t offset = 0; offset < size;) {
+			const size_t length = data[offset++];
+			const auto end = std::min(offset + length, size);
+			txt.AddEntry(std::string_view(reinterpret_cast<const char*>(data + offset), end - offset));
+			offset = end;
+		}
+		return txt;
+	}
+
+	bool TxtRecord::Add(const std::string_view key, const uint8_t* value, const size_t valueSize)
+	{
+		if (key.empty() || key.find('=') != std::string_view::npos || key.size() + 1 + valueSize > kMaxEntrySize) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Invalid TXT entry: " + std::string(key));
+		}
+		return Append(key, value, valueSize, true);
+	}
+
+	bool TxtRecord::Add(const std::string_view key)
+	{
+		if (key.empty() || key.find('=') != std::string_view::npos || key.size() > kMaxEntrySize) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Invalid TXT entry: " + std::string(key));
+		}
+		return Append(key, nullptr, 0, false);
+	}
+
+	bool TxtRecord::AddEntry(const std::string_view entry)
+	{
+		if (entry.empty() || entry.size() > kMaxEntrySize) {
+			return false; // a TXT record without entries consists of a single empty string
+		}
+
+		const auto separator = entry.find('=');
+		if (separator == 0) {
+			return false; // no key, see https://datatracker.ietf.org/doc/html/rfc6763#section-6.4
+		}
+
+		if (separator == std::string_view::npos) {
+			return Append(entry, nullptr, 0, false);
+		}
+
+		const auto value = reinterpret_cast<const uint8_t*>(entry.data()) + separator + 1;
+		return Append(entry.substr(0, separator), value, entry.size() - separator - 1, true);
+	}
+
+	TxtEntry TxtRecord::Get(const size_t index) const
+	{
+		const auto& offsets = entries[index];
+		const auto entry = wire.data() + offsets.offset;
+
+		TxtEntry result;
+		result.key = std::string_view(reinterpret_cast<const char*>(entry + 1), offsets.keySize);
+		result.hasValue = entry[0] > offsets.keySize;
+
+		if (result.hasValue) {
+			result.value = entry + 1 + offsets.keySize + 1;
+			result.valueSize = entry[0] - offsets.keySize - 1;
+		}
+		return result;
+	}
+
+	bool TxtRecord::Contains(const std::string_view key) const
+	{
+		for (const auto& offsets : entries) {
+			if (EqualsIgnoreCase(key, std::string_view(reinterpret_cast<const char*>(wire.data() + offsets.offset + 1), offsets.keySize))) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool TxtRecord::Append(const std::string_view key, const uint8_t* value, const size_t valueSize, const bool hasValue)
+	{
+		if (Contains(key)) {
+			return false; // only the first occurrence of a key counts, see https://datatracker.ietf.org/doc/html/rfc6763#section-6.4
+		}
+
+		const auto size = key.size() + (hasValue ? 1 + valueSize : 0);
+
+		entries.push_back({ static_cast<uint32_t>(wire.size()), static_cast<uint8_t>(key.size()) });
+
+		wire.push_back(static_cast<uint8_t>(size));
+		wire.insert(wire.end(), key.begin(), key.end());
+		if (hasValue) {
+			wire.push_back('=');
+			wire.insert(wire.end(), value, value + valueSize);
+		}
+		return true;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nsd_windows {
+
+	struct TxtEntry {
+
+		std::string_view key;
+		bool hasValue = false; // "key" vs "key=value", see https://datatracker.ietf.org/doc/html/rfc6763#section-6.4
+		const uint8_t* value = nullptr; // opaque bytes, not necessarily UTF-8
+		size_t valueSize = 0;
+	};
+
+	// TXT record entries (see https://datatracker.ietf.org/doc/html/rfc6763#section-6) stored in their wire form:
+	// one arena of length prefixed "key=value" strings plus an offset table, so converting from and to
+	// TXT rdata is a copy and values are never transcoded
+	class TxtRecord {
+	public:
+
+		TxtRecord() = default;
+
+		// parses TXT rdata; lenient like the other platforms: empty strings are skipped, a truncated
+		// last string is clipped and only the first occurrence of a key counts
+		static TxtRecord FromWire(const uint8_t* data, const size_t size);
+
+		// "key=value" or "key"; returns false if the key is already present (the entry is ignored then),
+		// throws NsdError if the key is empty or contains '=', or if the entry is longer than 255 bytes
+		bool Add(const std::string_view key, const uint8_t* value, const size_t valueSize);
+		bool Add(const std::string_view key);
+
+		// "key=value" or "key" as a whole, e.g. from DnsQuery(); empty entries are skipped
+		bool AddEntry(const std::string_view entry);
+
+		size_t GetCount() const { return entries.size(); }
+		bool IsEmpty() const { return entries.empty(); }
+		TxtEntry Get(const size_t index) const;
+		bool Contains(const std::string_view key) const; // case insensitive
+
+		// TXT rdata; empty if there are no entries (a record on the wire then needs a single empty string)
+		const std::vector<uint8_t>& GetWire() const { return wire; }
+
+		bool operator==(const TxtRecord& other) const { return wire == other.wire; }
+		bool operator!=(const TxtRecord& other) const { return wire != other.wire; }
+
+	private:
+
+		struct Offsets {
+
+			uint32_t offset; // of the length byte in the arena
+			uint8_t keySize;
+		};
+
+		std::vector<uint8_t> wire; // the arena
+		std::vector<Offsets> entries;
+
+		bool Append(const std::string_view key, const uint8_t* value, const size_t valueSize, const bool hasValue);
+	};
+}
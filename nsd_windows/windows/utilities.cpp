@@ -1,116 +1,369 @@
 #include "utilities.h"
+#include "ip_address.h"
+#include "transcoding.h"
+
+#include <iphlpapi.h>
 
-#include <codecvt>
-#include <sstream>
 #include <algorithm>
 
+#pragma comment(lib, "iphlpapi.lib")
+
 namespace nsd_windows {
 
-	flutter::EncodableMap WindowsTxtToFlutterTxt(const DWORD count, const PWSTR* keys, const PWSTR* values) {
-		flutter::EncodableMap txt;
+	TxtRecord WindowsTxtToTxtRecord(const DWORD count, const PWSTR* keys, const PWSTR* values) {
+		TxtRecord txt;
+		std::string entry; // reused, so converting doesn't allocate per entry
 
 		for (DWORD i = 0; i < count; i++) {
 
-			auto key = ToUtf8(keys[i]);
-			auto codeUnitsString = ToUtf8(values[i]);
-			auto codeUnitsList = std::vector<unsigned char>(codeUnitsString.begin(), codeUnitsString.end());
-
-			if (codeUnitsList.empty()) {
+			entry.clear();
+			AppendUtf8(entry, keys[i]);
+			const auto keySize = entry.size();
+			entry += '=';
+			AppendUtf8(entry, values[i]);
 
-				// Windows doesn't distinguish between "empty value" ("foo=") and "no value" (e.g. "foo") as described in RFC6763,
-				// instead all "no value" will be empty. We treat both these value types as "no value" to be consistent with the other platforms.
-				// see https://datatracker.ietf.org/doc/html/rfc6763#section-6.4
+			// Windows doesn't distinguish between "empty value" ("foo=") and "no value" (e.g. "foo") as described in RFC6763,
+			// instead all "no value" will be empty. We treat both these value types as "no value" to be consistent with the other platforms.
+			// see https://datatracker.ietf.org/doc/html/rfc6763#section-6.4
 
-				txt[key] = std::monostate();
-			}
-			else {
-				txt[key] = codeUnitsList;
+			if (entry.size() == keySize + 1) {
+				entry.resize(keySize);
 			}
+			txt.AddEntry(entry);
 		}
 		return txt;
 	}
 
-	std::unique_ptr<WindowsTxt> FlutterTxtToWindowsTxt(std::optional<const flutter::EncodableMap> txt) {
+	TxtRecord DnsTxtToTxtRecord(const DWORD count, const PWSTR* strings) {
+		TxtRecord txt;
+		std::string entry;
 
-		if (!txt.has_value() || txt->size() == 0) {
-			return std::make_unique<WindowsTxt>();
+		for (DWORD i = 0; i < count; i++) {
+			entry.clear();
+			AppendUtf8(entry, strings[i]);
+			txt.AddEntry(entry);
 		}
+		return txt;
+	}
 
-		auto count = txt->size();
-		auto windowsTxt = std::make_unique<WindowsTxt>();
+	TxtRecord FlutterTxtToTxtRecord(const std::optional<flutter::EncodableMap>& txt) {
+		TxtRecord record;
 
-		for (auto it = txt->begin(); it != txt->end(); it++) {
+		if (!txt.has_value()) {
+			return record;
+		}
 
-			auto key = ToUtf16(std::get<std::string>(it->first));
-			windowsTxt->keys.push_back(key);
+		for (const auto& [key, value] : txt.value()) {
 
-			if (std::holds_alternative<std::vector<unsigned char>>(it->second)) {
+			const auto& name = std::get<std::string>(key);
 
-				auto& codeUnitsList = std::get<std::vector<unsigned char>>(it->second); // list of UTF-8 code units
-				std::string codeUnitsString(codeUnitsList.begin(), codeUnitsList.end());
-				auto value = ToUtf16(codeUnitsString); // Non-UTF-8 code units such as '255' will be replaced with U+FFFD by MultiByteToWideChar, so they will not survive the journey
-				windowsTxt->values.push_back(value);
+			if (std::holds_alternative<std::vector<unsigned char>>(value) && !std::get<std::vector<unsigned char>>(value).empty()) {
+				const auto& bytes = std::get<std::vector<unsigned char>>(value); // opaque, kept as is
+				record.Add(name, bytes.data(), bytes.size());
 			}
 			else {
-				windowsTxt->values.push_back(L"");
+				record.Add(name); // empty values count as "no value", see WindowsTxtToTxtRecord()
 			}
 		}
+		return record;
+	}
+
+	namespace {
+
+		// appends the null terminated UTF-16 string and returns where it starts
+		size_t AppendTxtString(std::wstring& strings, const std::string_view string) {
+
+			const auto offset = strings.size();
+
+			// fail instead of silently replacing non-UTF-8 code units with U+FFFD
+			if (!AppendUtf16(strings, string)) {
+				throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "TXT data must be valid UTF-8 for the system mDNS backend");
+			}
+
+			strings.push_back(L'\0');
+			return offset;
+		}
+	}
+
+	std::unique_ptr<WindowsTxt> TxtRecordToWindowsTxt(const TxtRecord& txt) {
+
+		auto windowsTxt = std::make_unique<WindowsTxt>();
+		const auto count = txt.GetCount();
+
+		if (count == 0) {
+			return windowsTxt;
+		}
+
+		// the buffer may still move while it grows, so the offsets are turned into pointers at the end
+		std::vector<size_t> offsets(count * 2);
+		windowsTxt->strings.reserve(txt.GetWire().size() + count * 2);
+
+		for (size_t i = 0; i < count; i++) {
+			const auto entry = txt.Get(i);
+			offsets[i] = AppendTxtString(windowsTxt->strings, entry.key);
+			offsets[count + i] = AppendTxtString(windowsTxt->strings, std::string_view(reinterpret_cast<const char*>(entry.value), entry.valueSize)); // Windows has no "no value", see WindowsTxtToTxtRecord()
+		}
+
+		windowsTxt->pointers.reserve(count * 2);
+		for (const auto offset : offsets) {
+			windowsTxt->pointers.push_back(windowsTxt->strings.c_str() + offset);
+		}
 
 		windowsTxt->size = static_cast<DWORD>(count);
-		windowsTxt->keyPointers = GetPointers(windowsTxt->keys);
-		windowsTxt->valuePointers = GetPointers(windowsTxt->values);
-		windowsTxt->pKeyPointers = &windowsTxt->keyPointers[0];
-		windowsTxt->pValuePointers = &windowsTxt->valuePointers[0];
+		windowsTxt->pKeyPointers = windowsTxt->pointers.data();
+		windowsTxt->pValuePointers = windowsTxt->pointers.data() + count;
 
-		return std::move(windowsTxt);
+		return windowsTxt;
 	}
 
-	std::unique_ptr<flutter::EncodableValue> CreateMethodResult(const flutter::EncodableMap values) {
-		return std::move(std::make_unique<flutter::EncodableValue>(values));
+	std::vector<std::string> DeserializeServiceTypes(const flutter::EncodableMap& arguments) {
+		auto serviceTypes = DeserializeOptional<flutter::EncodableList>(arguments, "service.types");
+		if (!serviceTypes.has_value()) {
+			return { Deserialize<std::string>(arguments, "service.type") };
+		}
+
+		std::vector<std::string> result;
+		for (const auto& serviceType : serviceTypes.value()) {
+			auto value = std::get<std::string>(serviceType);
+			if (std::find(result.begin(), result.end(), value) == result.end()) {
+				result.push_back(value);
+			}
+		}
+
+		if (result.empty()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "At least one service type is required");
+		}
+		return result;
 	}
 
-	std::wstring ToUtf16(const std::string string)
-	{
-		// see https://stackoverflow.com/a/69410299/8707976
+	IpLookupType DeserializeIpLookupType(const flutter::EncodableMap& arguments) {
+		auto value = DeserializeOptional<std::string>(arguments, "ip.lookupType");
+		if (!value.has_value()) {
+			return IpLookupType::NONE;
+		}
 
-		if (string.empty())
-		{
-			return L"";
+		auto lookupType = ParseIpLookupType(value.value());
+		if (!lookupType.has_value()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown IP lookup type: "s + value.value());
 		}
+		return lookupType.value();
+	}
 
-		auto size_needed = MultiByteToWideChar(CP_UTF8, 0, &string.at(0), (int)string.size(), nullptr, 0);
-		if (size_needed <= 0)
-		{
-			throw std::runtime_error("MultiByteToWideChar() failed: " + std::to_string(size_needed));
-			// see https://docs.microsoft.com/en-us/windows/win32/api/stringapiset/nf-stringapiset-multibytetowidechar for error codes
+	std::optional<int64_t> DeserializeLong(const flutter::EncodableMap& arguments, const std::string key) {
+
+		// the codec sends dart ints as 32 bit values if they fit, so either type can arrive
+
+		auto it = arguments.find(flutter::EncodableValue(key));
+		if (it == arguments.end() || it->second.IsNull()) {
+			return std::nullopt;
 		}
+		return it->second.LongValue();
+	}
 
-		std::wstring result(size_needed, 0);
-		MultiByteToWideChar(CP_UTF8, 0, &string.at(0), (int)string.size(), &result.at(0), size_needed);
-		return result;
+	std::vector<uint32_t> DeserializeInterfaces(const flutter::EncodableMap& arguments) {
+
+		// "all" or a list of interface indexes, absent means the OS default
+
+		auto it = arguments.find(flutter::EncodableValue("network.interfaces"));
+		if (it == arguments.end() || it->second.IsNull()) {
+			return { kAnyInterface };
+		}
+
+		InterfaceSelection selection;
+
+		if (const auto mode = std::get_if<std::string>(&it->second)) {
+			if (*mode != "all") {
+				throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Unknown interface selection: "s + *mode);
+			}
+			selection.mode = InterfaceSelection::ALL;
+		}
+		else if (const auto indexes = std::get_if<flutter::EncodableList>(&it->second)) {
+			selection.mode = InterfaceSelection::LIST;
+			for (const auto& index : *indexes) {
+
+				// indexes beyond 31 bits arrive as 64 bit values
+				std::optional<int64_t> value;
+				if (const auto index32 = std::get_if<int32_t>(&index)) {
+					value = *index32;
+				}
+				else if (const auto index64 = std::get_if<int64_t>(&index)) {
+					value = *index64;
+				}
+
+				if (!value.has_value() || value.value() < 0 || value.value() > UINT32_MAX) {
+					throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Network interface indexes must be unsigned 32 bit integers");
+				}
+				selection.indexes.push_back(static_cast<uint32_t>(value.value()));
+			}
+		}
+		else {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "Network interfaces must be \"all\" or a list of indexes");
+		}
+
+		auto interfaces = SelectInterfaces(selection, GetNetworkInterfaces());
+		if (interfaces.empty()) {
+			throw NsdError(ErrorCause::ILLEGAL_ARGUMENT, "None of the selected network interfaces is up");
+		}
+		return interfaces;
 	}
 
-	std::string ToUtf8(const std::wstring wide_string)
-	{
-		// see https://stackoverflow.com/a/69410299/8707976
+	std::vector<NetworkInterface> GetNetworkInterfaces() {
 
-		if (wide_string.empty())
-		{
-			return "";
+		// see https://learn.microsoft.com/en-us/windows/win32/api/iphlpapi/nf-iphlpapi-getadaptersaddresses
+
+		ULONG size = 16 * 1024;
+		std::vector<unsigned char> buffer;
+		ULONG status;
+
+		do {
+			buffer.resize(size);
+			status = GetAdaptersAddresses(AF_UNSPEC, GAA_FLAG_SKIP_UNICAST | GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER,
+				nullptr, reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()), &size);
+		} while (status == ERROR_BUFFER_OVERFLOW);
+
+		std::vector<NetworkInterface> interfaces;
+
+		if (status == ERROR_NO_DATA) {
+			return interfaces;
 		}
 
-		auto size_needed = WideCharToMultiByte(CP_UTF8, 0, &wide_string.at(0), (int)wide_string.size(), nullptr, 0, nullptr, nullptr);
-		if (size_needed <= 0)
-		{
-			throw std::runtime_error("WideCharToMultiByte() failed: " + std::to_string(size_needed));
-			// see https://docs.microsoft.com/en-us/windows/win32/api/stringapiset/nf-stringapiset-multibytetowidechar for error codes
+		if (status != ERROR_SUCCESS) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
 		}
 
-		std::string result(size_needed, 0);
-		WideCharToMultiByte(CP_UTF8, 0, &wide_string.at(0), (int)wide_string.size(), &result.at(0), size_needed, nullptr, nullptr);
+		for (auto adapter = reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()); adapter; adapter = adapter->Next) {
+			NetworkInterface networkInterface;
+			networkInterface.index = (adapter->IfIndex != 0) ? adapter->IfIndex : adapter->Ipv6IfIndex; // IfIndex is 0 if IPv4 is disabled
+			networkInterface.name = ToUtf8(adapter->FriendlyName);
+			networkInterface.up = adapter->OperStatus == IfOperStatusUp;
+			networkInterface.loopback = adapter->IfType == IF_TYPE_SOFTWARE_LOOPBACK;
+			interfaces.push_back(networkInterface);
+		}
+
+		return interfaces;
+	}
+
+	std::vector<std::vector<uint8_t>> GetHostAddresses() {
+
+		ULONG size = 16 * 1024;
+		std::vector<unsigned char> buffer;
+		ULONG status;
+
+		do {
+			buffer.resize(size);
+			status = GetAdaptersAddresses(AF_UNSPEC, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST | GAA_FLAG_SKIP_DNS_SERVER,
+				nullptr, reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()), &size);
+		} while (status == ERROR_BUFFER_OVERFLOW);
+
+		std::vector<std::vector<uint8_t>> addresses;
+
+		if (status == ERROR_NO_DATA) {
+			return addresses;
+		}
+
+		if (status != ERROR_SUCCESS) {
+			throw NsdError(ErrorCause::INTERNAL_ERROR, GetErrorMessage(status));
+		}
+
+		for (auto adapter = reinterpret_cast<PIP_ADAPTER_ADDRESSES>(buffer.data()); adapter; adapter = adapter->Next) {
+
+			if (adapter->OperStatus != IfOperStatusUp || adapter->IfType == IF_TYPE_SOFTWARE_LOOPBACK) {
+				continue;
+			}
+
+			for (auto unicast = adapter->FirstUnicastAddress; unicast; unicast = unicast->Next) {
+
+				const auto* address = unicast->Address.lpSockaddr;
+
+				if (address->sa_family == AF_INET) {
+					const auto* bytes = reinterpret_cast<const uint8_t*>(&reinterpret_cast<const sockaddr_in*>(address)->sin_addr);
+					addresses.emplace_back(bytes, bytes + 4);
+				}
+				else if (address->sa_family == AF_INET6) {
+					const auto* bytes = reinterpret_cast<const uint8_t*>(&reinterpret_cast<const sockaddr_in6*>(address)->sin6_addr);
+					addresses.emplace_back(bytes, bytes + 16);
+				}
+			}
+		}
+
+		return addresses;
+	}
+
+	std::vector<AddressRecord> GetAddressRecords(const PDNS_RECORD records) {
+		std::vector<AddressRecord> addressRecords;
+
+		for (auto record = records; record; record = record->pNext) {
+
+			if (record->pName == nullptr) {
+				continue;
+			}
+
+			if (record->wType == DNS_TYPE_A) {
+				addressRecords.push_back({ ToUtf8(record->pName), AddressFamily::V4, FormatIp4Address(reinterpret_cast<const uint8_t*>(&record->Data.A.IpAddress)) });
+			}
+			else if (record->wType == DNS_TYPE_AAAA) {
+				addressRecords.push_back({ ToUtf8(record->pName), AddressFamily::V6, FormatIp6Address(record->Data.AAAA.Ip6Address.IP6Byte) });
+			}
+		}
+		return addressRecords;
+	}
+
+	std::vector<AddressRecord> GetAddressRecords(const PDNS_SERVICE_INSTANCE pInstance) {
+		std::vector<AddressRecord> addressRecords;
+
+		if (pInstance->pszHostName == nullptr) {
+			return addressRecords;
+		}
+
+		auto owner = ToUtf8(pInstance->pszHostName);
+
+		if (pInstance->ip4Address != nullptr) {
+			addressRecords.push_back({ owner, AddressFamily::V4, FormatIp4Address(reinterpret_cast<const uint8_t*>(pInstance->ip4Address)) });
+		}
+
+		if (pInstance->ip6Address != nullptr) {
+			addressRecords.push_back({ owner, AddressFamily::V6, FormatIp6Address(pInstance->ip6Address->IP6Byte) });
+		}
+		return addressRecords;
+	}
+
+	static_assert(sizeof(wchar_t) == sizeof(char16_t), "wchar_t must be UTF-16");
+
+	std::wstring ToUtf16(const std::string_view string)
+	{
+		std::wstring result;
+		AppendUtf16(result, string);
+		return result;
+	}
+
+	std::string ToUtf8(const std::wstring_view wideString)
+	{
+		std::string result;
+		AppendUtf8(result, wideString);
 		return result;
 	}
 
+	bool AppendUtf16(std::wstring& out, const std::string_view string)
+	{
+		// sized for the worst case and shrunk afterwards, so the input is only read once
+		const auto offset = out.size();
+		out.resize(offset + GetMaxUtf16Size(string.size()));
+
+		const auto result = Utf8ToUtf16(string.data(), string.size(), reinterpret_cast<char16_t*>(&out[0] + offset));
+		out.resize(offset + result.size);
+		return result.valid;
+	}
+
+	bool AppendUtf8(std::string& out, const std::wstring_view wideString)
+	{
+		const auto offset = out.size();
+		out.resize(offset + GetMaxUtf8Size(wideString.size()));
+
+		const auto result = Utf16ToUtf8(reinterpret_cast<const char16_t*>(wideString.data()), wideString.size(), &out[0] + offset);
+		out.resize(offset + result.size);
+		return result.valid;
+	}
+
 	std::string GetErrorMessage(const DWORD messageId)
 	{
 		// see https://docs.microsoft.com/en-us/windows/win32/debug/retrieving-the-last-error-code
@@ -140,16 +393,6 @@ namespace nsd_windows {
 		return GetErrorMessage(GetLastError());
 	}
 
-	std::vector<std::string> Split(const std::string text, const char delimiter) {
-		std::istringstream in(text);
-		std::vector<std::string> out;
-		std::string current;
-		while (std::getline(in, current, delimiter)) {
-			out.push_back(current);
-		}
-		return out;
-	}
-
 	std::string GetTimeNow() {
 
 		// see https://stackoverflow.com/a/38034148/8707976
@@ -161,6 +404,19 @@ namespace nsd_windows {
 		return { buf, std::strftime(buf, sizeof(buf), "%F %T", &bt) };
 	}
 
+	FILETIME ToRelativeFileTime(const std::chrono::milliseconds duration)
+	{
+		// negative values are interpreted as relative to the current time, in 100 nanosecond units
+		// see https://docs.microsoft.com/en-us/windows/win32/api/threadpoolapiset/nf-threadpoolapiset-setthreadpooltimer
+
+		auto ticks = static_cast<ULONGLONG>(-std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() / 100);
+
+		FILETIME fileTime{};
+		fileTime.dwLowDateTime = static_cast<DWORD>(ticks & 0xFFFFFFFF);
+		fileTime.dwHighDateTime = static_cast<DWORD>(ticks >> 32);
+		return fileTime;
+	}
+
 	std::wstring GetComputerName() {
 		DWORD size = 0;
 		GetComputerNameEx(ComputerNameDnsHostname, nullptr, &size);
@@ -171,15 +427,6 @@ namespace nsd_windows {
 		return &computerName[0];
 	}
 
-	std::vector<PCWSTR> GetPointers(std::vector<std::wstring>& in)
-	{
-		std::vector<PCWSTR> out;
-		std::transform(in.begin(), in.end(), std::back_inserter(out), [](const std::wstring& string) -> PCWSTR {
-			return string.c_str();
-			});
-		return out;
-	}
-
 	bool CheckSystemRequirementsSatisfied()
 	{
 		// see https://stackoverflow.com/a/52122386/8707976
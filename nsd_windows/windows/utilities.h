@@ -1,14 +1,21 @@
 #pragma once
 
+#include "address_resolution.h"
+#include "network_interfaces.h"
 #include "nsd_error.h"
+#include "txt_record.h"
 
 #include <flutter/standard_method_codec.h>
 
 #include <windows.h>
+#include <windns.h>
 
+#include <chrono>
 #include <functional>
 #include <optional>
 #include <map>
+#include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -16,12 +23,13 @@ using namespace std::string_literals;
 
 namespace nsd_windows {
 
-	// provides c-style pointers but frees the values along with the parent object 
+	// provides c-style pointers but frees the values along with the parent object; keys and values are
+	// null terminated strings in one buffer, the pointers into it are in one array (keys, then values)
 	struct WindowsTxt {
 
 		WindowsTxt() {};
 		virtual ~WindowsTxt() {};
-		WindowsTxt(const WindowsTxt&) = delete; // copying would invalidate c pointersv
+		WindowsTxt(const WindowsTxt&) = delete; // copying would invalidate c pointers
 
 		DWORD size = 0;
 		PCWSTR* pKeyPointers = nullptr;
@@ -29,12 +37,10 @@ namespace nsd_windows {
 
 	private:
 
-		friend std::unique_ptr<WindowsTxt> FlutterTxtToWindowsTxt(std::optional<const flutter::EncodableMap> txt);
+		friend std::unique_ptr<WindowsTxt> TxtRecordToWindowsTxt(const TxtRecord& txt);
 
-		std::vector<std::wstring> keys;
-		std::vector<std::wstring> values;
-		std::vector<PCWSTR> keyPointers;
-		std::vector<PCWSTR> valuePointers;
+		std::wstring strings;
+		std::vector<PCWSTR> pointers;
 	};
 
 	template<class T>
@@ -67,27 +73,28 @@ namespace nsd_windows {
 		return Deserialize<T>(arguments, key, []() {});
 	}
 
-	template <class T, typename F> typename std::vector<T>::iterator FindIf(std::vector<T>& values, const F&& predicate) {
-		for (std::vector<T>::iterator it = values.begin(); it != values.end(); it++) {
-			if (predicate(*it)) {
-				return it;
-			}
-		}
-		return values.end();
-	}
-
-	flutter::EncodableMap WindowsTxtToFlutterTxt(const DWORD count, const PWSTR* keys, const PWSTR* values);
-	std::unique_ptr<WindowsTxt> FlutterTxtToWindowsTxt(std::optional<const flutter::EncodableMap> txt);
-
-	std::unique_ptr<flutter::EncodableValue> CreateMethodResult(const flutter::EncodableMap values);
-
-	std::wstring ToUtf16(const std::string string);
-	std::string ToUtf8(const std::wstring wide_string);
+	TxtRecord WindowsTxtToTxtRecord(const DWORD count, const PWSTR* keys, const PWSTR* values);
+	TxtRecord DnsTxtToTxtRecord(const DWORD count, const PWSTR* strings);
+	TxtRecord FlutterTxtToTxtRecord(const std::optional<flutter::EncodableMap>& txt);
+	std::unique_ptr<WindowsTxt> TxtRecordToWindowsTxt(const TxtRecord& txt);
+
+	std::vector<std::string> DeserializeServiceTypes(const flutter::EncodableMap& arguments);
+	IpLookupType DeserializeIpLookupType(const flutter::EncodableMap& arguments);
+	std::vector<uint32_t> DeserializeInterfaces(const flutter::EncodableMap& arguments);
+	std::optional<int64_t> DeserializeLong(const flutter::EncodableMap& arguments, const std::string key);
+	std::vector<NetworkInterface> GetNetworkInterfaces();
+	std::vector<std::vector<uint8_t>> GetHostAddresses(); // unicast addresses of the interfaces that are up, in network order
+	std::vector<AddressRecord> GetAddressRecords(const PDNS_RECORD records);
+	std::vector<AddressRecord> GetAddressRecords(const PDNS_SERVICE_INSTANCE pInstance);
+
+	std::wstring ToUtf16(const std::string_view string);
+	std::string ToUtf8(const std::wstring_view wideString);
+	bool AppendUtf16(std::wstring& out, const std::string_view string); // false if malformed input was replaced with U+FFFD
+	bool AppendUtf8(std::string& out, const std::wstring_view wideString); // same for unpaired surrogates
 	std::string GetErrorMessage(const DWORD messageId);
 	std::string GetLastErrorMessage();
-	std::vector<std::string> Split(const std::string text, const char delimiter);
 	std::string GetTimeNow();
+	FILETIME ToRelativeFileTime(const std::chrono::milliseconds duration);
 	std::wstring GetComputerName();
-	std::vector<PCWSTR> GetPointers(std::vector<std::wstring>& in);
 	bool CheckSystemRequirementsSatisfied();
 }